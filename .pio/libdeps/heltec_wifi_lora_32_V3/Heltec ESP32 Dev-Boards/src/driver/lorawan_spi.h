@@ -88,5 +88,30 @@ void SpiFormat( Spi_t *obj, int8_t bits, int8_t cpol, int8_t cpha, int8_t slave
  */
 void SpiFrequency( Spi_t *obj, uint32_t hz );
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Clocks a whole frame in one burst instead of byte by byte
+ *
+ * \remark NSS is left to the caller. The header is written and its reply
+ *         discarded, then size bytes are either written from out or, when in
+ *         is set, read into in while clocking out zeros (NOP).
+ *
+ * \param [IN]  obj        SPI object
+ * \param [IN]  header     Command / address bytes
+ * \param [IN]  headerSize Number of header bytes
+ * \param [IN]  out        Payload to write, or NULL
+ * \param [OUT] in         Buffer to read into, or NULL
+ * \param [IN]  size       Payload length
+ */
+void SpiBurst( Spi_t *obj, const uint8_t *header, uint16_t headerSize,
+               const uint8_t *out, uint8_t *in, uint16_t size );
+
+#ifdef __cplusplus
+}
+#endif
+
 
 #endif // __SPI_H__
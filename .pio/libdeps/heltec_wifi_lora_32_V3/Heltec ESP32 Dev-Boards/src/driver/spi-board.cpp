@@ -0,0 +1,40 @@
+/*!
+ * \file      spi-board.cpp
+ *
+ * \brief     Burst SPI transfers for the radio driver
+ *
+ * \remark    SpiInOut (in liblorawan) moves one byte per call, so a 64-byte
+ *            FIFO write costs 66 round trips through the SPI driver. The radio
+ *            sits on the default SPIClass bus opened by Mcu.begin (the display
+ *            has its own HSPI instance), whose writeBytes / transferBytes fill
+ *            the controller FIFO 64 bytes at a time; the longest SX126x frame
+ *            (255-byte buffer) is four FIFO loads.
+ */
+#include <Arduino.h>
+#include <SPI.h>
+#include "lorawan_spi.h"
+
+void SpiBurst( Spi_t *obj, const uint8_t *header, uint16_t headerSize,
+               const uint8_t *out, uint8_t *in, uint16_t size )
+{
+    ( void )obj;
+
+    if( headerSize > 0 )
+    {
+        SPI.writeBytes( header, headerSize );
+    }
+    if( size == 0 )
+    {
+        return;
+    }
+    if( in != NULL )
+    {
+        // Read in place: the buffer doubles as the NOP bytes clocked out
+        memset( in, 0, size );
+        SPI.transferBytes( in, in, size );
+    }
+    else
+    {
+        SPI.writeBytes( out, size );
+    }
+}
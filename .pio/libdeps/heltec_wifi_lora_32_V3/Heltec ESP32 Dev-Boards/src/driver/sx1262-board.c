@@ -28,11 +28,33 @@
 #include "Arduino.h"
 #include "../driver/board-config.h"
 #include "debug.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 RTC_DATA_ATTR uint8_t gPaOptSetting = 0;
 
-extern uint8_t SpiInOut(Spi_t *obj, uint8_t outData );
 RTC_DATA_ATTR SX126x_t SX126x;
+
+/*!
+ * BUSY usually drops within a few microseconds of NSS going high; only
+ * calibration, mode changes and TCXO start-up keep it up for longer. Poll
+ * this many times before blocking on the falling-edge interrupt.
+ */
+#define SX126X_BUSY_SPIN            32
+#define SX126X_BUSY_TIMEOUT_MS      1000
+
+static SemaphoreHandle_t BusyReleased = NULL;
+
+static void IRAM_ATTR SX126xOnBusyFall( void )
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR( BusyReleased, &woken );
+    if( woken == pdTRUE )
+    {
+        portYIELD_FROM_ISR( );
+    }
+}
+
 uint32_t SX126xGetBoardTcxoWakeupTime( void )
 {
     return BOARD_TCXO_WAKEUP_TIME;
@@ -44,6 +66,15 @@ void SX126xIoInit( void )
     GpioInit( &SX126x.Spi.Nss, RADIO_NSS, OUTPUT, PIN_PUSH_PULL, PIN_PULL_UP, 1 );
     GpioInit( &SX126x.BUSY, RADIO_BUSY, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
     GpioInit( &SX126x.DIO1, RADIO_DIO_1, INPUT, PIN_PUSH_PULL, PIN_NO_PULL, 0 );
+
+    if( BusyReleased == NULL )
+    {
+        BusyReleased = xSemaphoreCreateBinary( );
+    }
+    if( BusyReleased != NULL )
+    {
+        attachInterrupt( RADIO_BUSY, SX126xOnBusyFall, FALLING );
+    }
 }
 
 void SX126xIoIrqInit( DioIrqHandler dioIrq )
@@ -74,6 +105,33 @@ void SX126xReset( void )
 
 void SX126xWaitOnBusy( void )
 {
+    for( int i = 0; i < SX126X_BUSY_SPIN; i++ )
+    {
+        if( GpioRead( &SX126x.BUSY ) == 0 )
+        {
+            return;
+        }
+    }
+
+    // Long operation: sleep until the BUSY edge instead of spinning the CPU.
+    // Drop an edge left over from an earlier command first; if BUSY falls
+    // between that and the read below, the ISR gives the semaphore again.
+    if( BusyReleased != NULL && !xPortInIsrContext( ) &&
+        xTaskGetSchedulerState( ) == taskSCHEDULER_RUNNING )
+    {
+        xSemaphoreTake( BusyReleased, 0 );
+        if( GpioRead( &SX126x.BUSY ) == 0 )
+        {
+            return;
+        }
+        if( xSemaphoreTake( BusyReleased, pdMS_TO_TICKS( SX126X_BUSY_TIMEOUT_MS ) ) != pdTRUE &&
+            GpioRead( &SX126x.BUSY ) == 1 )
+        {
+            lora_printf("spi timeout\r\n");
+        }
+        return;
+    }
+
 	uint32_t timeout=0;
     while( GpioRead( &SX126x.BUSY ) == 1 )
     {
@@ -90,10 +148,11 @@ void SX126xWaitOnBusy( void )
 
 void SX126xWakeup( void )
 {
+    uint8_t header[2] = { RADIO_GET_STATUS, 0x00 };
+
     GpioWrite( &SX126x.Spi.Nss, 0 );
-    SpiInOut( &SX126x.Spi, RADIO_GET_STATUS );
-    SpiInOut( &SX126x.Spi, 0x00 );
-    GpioWrite( &SX126x.Spi.Nss, 1 );;
+    SpiBurst( &SX126x.Spi, header, 2, NULL, NULL, 0 );
+    GpioWrite( &SX126x.Spi.Nss, 1 );
     // Wait for chip to be ready.
     SX126xWaitOnBusy( );
 }
@@ -101,15 +160,11 @@ void SX126xWakeup( void )
 
 void SX126xWriteCommand( RadioCommands_t command, uint8_t *buffer, uint16_t size )
 {
+    uint8_t header = ( uint8_t )command;
+
     SX126xCheckDeviceReady( );
     GpioWrite( &SX126x.Spi.Nss, 0 );
-    SpiInOut( &SX126x.Spi, ( uint8_t )command );
-
-    for( uint16_t i = 0; i < size; i++ )
-    {
-        SpiInOut( &SX126x.Spi, buffer[i] );
-    }
-
+    SpiBurst( &SX126x.Spi, &header, 1, buffer, NULL, size );
     GpioWrite( &SX126x.Spi.Nss, 1 );
 
     if( command != RADIO_SET_SLEEP )
@@ -120,17 +175,11 @@ void SX126xWriteCommand( RadioCommands_t command, uint8_t *buffer, uint16_t size
 
 void SX126xReadCommand( RadioCommands_t command, uint8_t *buffer, uint16_t size )
 {
+    uint8_t header[2] = { ( uint8_t )command, 0x00 };
 
     SX126xCheckDeviceReady( );
     GpioWrite( &SX126x.Spi.Nss, 0 );
-
-    SpiInOut( &SX126x.Spi, ( uint8_t )command );
-    SpiInOut( &SX126x.Spi, 0x00 );
-    for( uint16_t i = 0; i < size; i++ )
-    {
-        buffer[i] = SpiInOut( &SX126x.Spi, 0 );
-    }
-
+    SpiBurst( &SX126x.Spi, header, 2, NULL, buffer, size );
     GpioWrite( &SX126x.Spi.Nss, 1 );
 
     SX126xWaitOnBusy( );
@@ -138,19 +187,12 @@ void SX126xReadCommand( RadioCommands_t command, uint8_t *buffer, uint16_t size
 
 void SX126xWriteRegisters( uint16_t address, uint8_t *buffer, uint16_t size )
 {
+    uint8_t header[3] = { RADIO_WRITE_REGISTER, ( address & 0xFF00 ) >> 8, address & 0x00FF };
+
     SX126xCheckDeviceReady( );
 
     GpioWrite( &SX126x.Spi.Nss, 0 );
-
-    SpiInOut( &SX126x.Spi, RADIO_WRITE_REGISTER );
-    SpiInOut( &SX126x.Spi, ( address & 0xFF00 ) >> 8 );
-    SpiInOut( &SX126x.Spi, address & 0x00FF );
-    
-    for( uint16_t i = 0; i < size; i++ )
-    {
-        SpiInOut( &SX126x.Spi, buffer[i] );
-    }
-
+    SpiBurst( &SX126x.Spi, header, 3, buffer, NULL, size );
     GpioWrite( &SX126x.Spi.Nss, 1 );
 
     SX126xWaitOnBusy( );
@@ -163,18 +205,12 @@ void SX126xWriteRegister( uint16_t address, uint8_t value )
 
 void SX126xReadRegisters( uint16_t address, uint8_t *buffer, uint16_t size )
 {
+    uint8_t header[4] = { RADIO_READ_REGISTER, ( address & 0xFF00 ) >> 8, address & 0x00FF, 0 };
+
     SX126xCheckDeviceReady( );
 
     GpioWrite( &SX126x.Spi.Nss, 0 );
-
-    SpiInOut( &SX126x.Spi, RADIO_READ_REGISTER );
-    SpiInOut( &SX126x.Spi, ( address & 0xFF00 ) >> 8 );
-    SpiInOut( &SX126x.Spi, address & 0x00FF );
-    SpiInOut( &SX126x.Spi, 0 );
-    for( uint16_t i = 0; i < size; i++ )
-    {
-        buffer[i] = SpiInOut( &SX126x.Spi, 0 );
-    }
+    SpiBurst( &SX126x.Spi, header, 4, NULL, buffer, size );
     GpioWrite( &SX126x.Spi.Nss, 1 );
 
     SX126xWaitOnBusy( );
@@ -189,17 +225,12 @@ uint8_t SX126xReadRegister( uint16_t address )
 
 void SX126xWriteBuffer( uint8_t offset, uint8_t *buffer, uint8_t size )
 {
+    uint8_t header[2] = { RADIO_WRITE_BUFFER, offset };
 
     SX126xCheckDeviceReady( );
 
     GpioWrite( &SX126x.Spi.Nss, 0 );
-
-    SpiInOut( &SX126x.Spi, RADIO_WRITE_BUFFER );
-    SpiInOut( &SX126x.Spi, offset );
-    for( uint16_t i = 0; i < size; i++ )
-    {
-        SpiInOut( &SX126x.Spi, buffer[i] );
-    }
+    SpiBurst( &SX126x.Spi, header, 2, buffer, NULL, size );
     GpioWrite( &SX126x.Spi.Nss, 1 );
 
     SX126xWaitOnBusy( );
@@ -207,17 +238,12 @@ void SX126xWriteBuffer( uint8_t offset, uint8_t *buffer, uint8_t size )
 
 void SX126xReadBuffer( uint8_t offset, uint8_t *buffer, uint8_t size )
 {
+    uint8_t header[3] = { RADIO_READ_BUFFER, offset, 0 };
+
     SX126xCheckDeviceReady( );
 
     GpioWrite( &SX126x.Spi.Nss, 0 );
-
-    SpiInOut( &SX126x.Spi, RADIO_READ_BUFFER );
-    SpiInOut( &SX126x.Spi, offset );
-    SpiInOut( &SX126x.Spi, 0 );
-    for( uint16_t i = 0; i < size; i++ )
-    {
-        buffer[i] = SpiInOut( &SX126x.Spi, 0 );
-    }
+    SpiBurst( &SX126x.Spi, header, 3, NULL, buffer, size );
     GpioWrite( &SX126x.Spi.Nss, 1 );
 
     SX126xWaitOnBusy( );
@@ -0,0 +1,341 @@
+/*!
+ * \file      timer.c
+ *
+ * \brief     Timer objects and scheduling management implementation
+ *
+ * \remark    Running timers live in a binary min-heap keyed on their expiry
+ *            time, so TimerStart / TimerStop cost O(log n) instead of a walk
+ *            of the old sorted list. A single one-shot esp_timer is armed for
+ *            the heap top; its callback (esp_timer task) pops and runs every
+ *            timer that is due, then re-arms for the next one.
+ *
+ *            This file defines the whole timer.h API so the linker never pulls
+ *            the list-based timer object from liblorawan.
+ *
+ *            Times are milliseconds of esp_timer_get_time(); expiry compares
+ *            are wrap-safe for timeouts below ~24 days.
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "../driver/timer.h"
+#include "debug.h"
+
+TimerEvent_t *TimerListHead = NULL;
+
+static TimerEvent_t *TimerHeap[TIMER_HEAP_SIZE];
+static uint16_t TimerCount = 0;
+static uint32_t TimerDropped = 0;
+static esp_timer_handle_t TimerHw = NULL;
+static portMUX_TYPE TimerMux = portMUX_INITIALIZER_UNLOCKED;
+
+/*!
+ * Epoch time minus MCU time, set by TimerSetSysTime
+ */
+static TimerSysTime_t SysTimeOffset = { 0 };
+
+static uint32_t TimerNowMs( void )
+{
+    return ( uint32_t )( esp_timer_get_time( ) / 1000 );
+}
+
+/*!
+ * True if a expires before b
+ */
+static bool TimerBefore( const TimerEvent_t *a, const TimerEvent_t *b )
+{
+    return ( int32_t )( a->Timestamp - b->Timestamp ) < 0;
+}
+
+static void TimerHeapPut( uint16_t i, TimerEvent_t *obj )
+{
+    TimerHeap[i] = obj;
+    obj->HeapIndex = i;
+}
+
+static void TimerSiftUp( uint16_t i )
+{
+    TimerEvent_t *obj = TimerHeap[i];
+
+    while( i > 0 )
+    {
+        uint16_t parent = ( i - 1 ) / 2;
+        if( !TimerBefore( obj, TimerHeap[parent] ) )
+        {
+            break;
+        }
+        TimerHeapPut( i, TimerHeap[parent] );
+        i = parent;
+    }
+    TimerHeapPut( i, obj );
+}
+
+static void TimerSiftDown( uint16_t i )
+{
+    TimerEvent_t *obj = TimerHeap[i];
+
+    for( ;; )
+    {
+        uint16_t child = 2 * i + 1;
+        if( child >= TimerCount )
+        {
+            break;
+        }
+        if( child + 1 < TimerCount && TimerBefore( TimerHeap[child + 1], TimerHeap[child] ) )
+        {
+            child++;
+        }
+        if( !TimerBefore( TimerHeap[child], obj ) )
+        {
+            break;
+        }
+        TimerHeapPut( i, TimerHeap[child] );
+        i = child;
+    }
+    TimerHeapPut( i, obj );
+}
+
+static bool TimerInHeap( const TimerEvent_t *obj )
+{
+    return obj->HeapIndex < TimerCount && TimerHeap[obj->HeapIndex] == obj;
+}
+
+static void TimerHeapRemove( TimerEvent_t *obj )
+{
+    uint16_t i = obj->HeapIndex;
+    TimerEvent_t *last = TimerHeap[--TimerCount];
+
+    obj->IsRunning = false;
+    if( i == TimerCount )
+    {
+        return;
+    }
+    // The last leaf takes the hole and moves whichever way restores order
+    TimerHeapPut( i, last );
+    TimerSiftUp( i );
+    TimerSiftDown( last->HeapIndex );
+}
+
+/*!
+ * Point the hardware timer at the heap top. Called with TimerMux held;
+ * esp_timer start/stop take their own spinlock and may nest inside it.
+ */
+static void TimerArm( void )
+{
+    TimerListHead = ( TimerCount > 0 ) ? TimerHeap[0] : NULL;
+    if( TimerHw == NULL )
+    {
+        return;
+    }
+    esp_timer_stop( TimerHw );
+    if( TimerListHead != NULL )
+    {
+        int32_t dueMs = ( int32_t )( TimerListHead->Timestamp - TimerNowMs( ) );
+        esp_timer_start_once( TimerHw, dueMs > 0 ? ( uint64_t )dueMs * 1000 : 1 );
+    }
+}
+
+static void TimerHwCallback( void *arg )
+{
+    ( void )arg;
+    TimerIrqHandler( );
+}
+
+void TimerInit( TimerEvent_t *obj, void ( *callback )( void ) )
+{
+    if( TimerHw == NULL )
+    {
+        const esp_timer_create_args_t args = {
+            .callback = TimerHwCallback,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "lora_timer",
+        };
+        if( esp_timer_create( &args, &TimerHw ) != ESP_OK )
+        {
+            TimerHw = NULL;
+            lora_printf( "timer create failed\r\n" );
+        }
+    }
+
+    portENTER_CRITICAL_SAFE( &TimerMux );
+    if( TimerInHeap( obj ) )
+    {
+        // Re-initialising a running timer: take it out first
+        TimerHeapRemove( obj );
+        TimerArm( );
+    }
+    obj->Timestamp = 0;
+    obj->ReloadValue = 0;
+    obj->IsRunning = false;
+    obj->Callback = callback;
+    obj->Next = NULL;
+    obj->HeapIndex = 0;
+    portEXIT_CRITICAL_SAFE( &TimerMux );
+}
+
+void TimerStart( TimerEvent_t *obj )
+{
+    bool full = false;
+
+    portENTER_CRITICAL_SAFE( &TimerMux );
+    if( obj->IsRunning && TimerInHeap( obj ) )
+    {
+        TimerHeapRemove( obj );
+    }
+    if( TimerCount >= TIMER_HEAP_SIZE )
+    {
+        full = true;
+        TimerDropped++;
+        obj->IsRunning = false;
+        TimerArm( );
+    }
+    else
+    {
+        obj->Timestamp = TimerNowMs( ) + obj->ReloadValue;
+        obj->IsRunning = true;
+        obj->Next = NULL;
+        TimerHeapPut( TimerCount, obj );
+        TimerCount++;
+        TimerSiftUp( TimerCount - 1 );
+
+        // Only a new or moved top needs the hardware timer touched
+        if( TimerHeap[0] == obj || TimerHeap[0] != TimerListHead )
+        {
+            TimerArm( );
+        }
+    }
+    portEXIT_CRITICAL_SAFE( &TimerMux );
+
+    if( full )
+    {
+        lora_printf( "timer heap full\r\n" );
+    }
+}
+
+uint32_t TimerGetDropCount( void )
+{
+    return TimerDropped;
+}
+
+void TimerStop( TimerEvent_t *obj )
+{
+    portENTER_CRITICAL_SAFE( &TimerMux );
+    if( obj->IsRunning && TimerInHeap( obj ) )
+    {
+        bool wasHead = ( obj == TimerListHead );
+        TimerHeapRemove( obj );
+        if( wasHead )
+        {
+            TimerArm( );
+        }
+    }
+    obj->IsRunning = false;
+    portEXIT_CRITICAL_SAFE( &TimerMux );
+}
+
+void TimerIrqHandler( void )
+{
+    // Pop one due timer at a time and run its callback unlocked, since
+    // callbacks usually start or stop timers themselves
+    for( ;; )
+    {
+        TimerEvent_t *due = NULL;
+
+        portENTER_CRITICAL_SAFE( &TimerMux );
+        if( TimerCount > 0 && ( int32_t )( TimerHeap[0]->Timestamp - TimerNowMs( ) ) <= 0 )
+        {
+            due = TimerHeap[0];
+            TimerHeapRemove( due );
+        }
+        else
+        {
+            TimerArm( );
+        }
+        portEXIT_CRITICAL_SAFE( &TimerMux );
+
+        if( due == NULL )
+        {
+            break;
+        }
+        if( due->Callback != NULL )
+        {
+            due->Callback( );
+        }
+    }
+}
+
+void TimerReset( TimerEvent_t *obj )
+{
+    TimerStop( obj );
+    TimerStart( obj );
+}
+
+void TimerSetValue( TimerEvent_t *obj, uint32_t value )
+{
+    TimerStop( obj );
+    obj->Timestamp = value;
+    obj->ReloadValue = value;
+}
+
+TimerTime_t TimerGetCurrentTime( void )
+{
+    return ( TimerTime_t )( esp_timer_get_time( ) / 1000 );
+}
+
+TimerTime_t TimerGetElapsedTime( TimerTime_t savedTime )
+{
+    if( savedTime == 0 )
+    {
+        return 0;
+    }
+    return TimerGetCurrentTime( ) - savedTime;
+}
+
+TimerTime_t TimerTempCompensation( TimerTime_t period, float temperature )
+{
+    // esp_timer runs from the main crystal, not a 32 kHz tuning fork
+    ( void )temperature;
+    return period;
+}
+
+void TimerLowPowerHandler( void )
+{
+    // Light sleep is left to the FreeRTOS idle task / power management
+}
+
+TimerSysTime_t SysTimeGetMcuTime( void )
+{
+    int64_t us = esp_timer_get_time( );
+    TimerSysTime_t t;
+
+    t.Seconds = ( uint32_t )( us / 1000000 );
+    t.SubSeconds = ( int16_t )( ( us / 1000 ) % 1000 );
+    return t;
+}
+
+void TimerSetSysTime( TimerSysTime_t sysTime )
+{
+    SysTimeOffset = TimerSubSysTime( sysTime, SysTimeGetMcuTime( ) );
+}
+
+TimerSysTime_t TimerGetSysTime( void )
+{
+    return TimerAddSysTime( SysTimeGetMcuTime( ), SysTimeOffset );
+}
+
+uint32_t SysTimeToMs( TimerSysTime_t sysTime )
+{
+    TimerSysTime_t mcu = TimerSubSysTime( sysTime, SysTimeOffset );
+    return mcu.Seconds * 1000 + mcu.SubSeconds;
+}
+
+TimerSysTime_t SysTimeFromMs( uint32_t timeMs )
+{
+    TimerSysTime_t mcu;
+
+    mcu.Seconds = timeMs / 1000;
+    mcu.SubSeconds = ( int16_t )( timeMs % 1000 );
+    return TimerAddSysTime( mcu, SysTimeOffset );
+}
@@ -53,8 +53,23 @@ typedef struct TimerEvent_s
     bool IsRunning;             //! Is the timer currently running
     void ( *Callback )( void ); //! Timer IRQ callback function
     struct TimerEvent_s *Next;  //! Pointer to the next Timer object.
+    uint16_t HeapIndex;         //! Slot in the timer heap while running
 } TimerEvent_t;
 
+/*!
+ * Running timers are kept in a binary min-heap ordered by expiry (see
+ * timer.c), so start and stop are O(log n). TimerListHead points at the
+ * earliest running timer, or is NULL when none is running; the Next chain
+ * is no longer maintained.
+ *
+ * A timer takes at most one slot (restarting a running timer moves it), so
+ * the heap only fills if more than TIMER_HEAP_SIZE distinct TimerEvent_t
+ * objects run at once. The MAC, radio and board layers declare fewer than
+ * 20. Should it ever fill, TimerStart leaves the timer stopped (IsRunning
+ * stays false) and counts it in TimerGetDropCount().
+ */
+#define TIMER_HEAP_SIZE 128
+
 extern TimerEvent_t *TimerListHead;
 #ifndef TimerTime_t
 typedef uint64_t TimerTime_t;
@@ -199,6 +214,13 @@ void TimerStart( TimerEvent_t *obj );
  */
 void TimerStop( TimerEvent_t *obj );
 
+/*!
+ * \brief Number of TimerStart calls refused because the heap was full
+ *
+ * \retval count Refused starts since boot
+ */
+uint32_t TimerGetDropCount( void );
+
 /*!
  * \brief Resets the timer object
  *
@@ -522,8 +522,16 @@ return_type lorawan_aes_set_key( const uint8_t key[], length_type keylen, aes_co
         break;
     default:
         ctx->rnd = 0;
+#if defined( AES_HW_ESP32 )
+        ctx->hw_keyed = 0;
+#endif
         return ( uint8_t )-1;
     }
+#if defined( AES_HW_ESP32 )
+    /* Key the accelerator context once here rather than on every block */
+    esp_aes_init( &ctx->hw );
+    ctx->hw_keyed = esp_aes_setkey( &ctx->hw, key, keylen * 8 ) == 0;
+#endif
     block_copy_nn(ctx->ksch, key, keylen);
     hi = (keylen + 28) << 2;//16+28   <<2      10110000(44*4=176)
     ctx->rnd = (hi >> 4) - 1;//00001010
@@ -563,10 +571,54 @@ return_type lorawan_aes_set_key( const uint8_t key[], length_type keylen, aes_co
 
 #if defined( AES_ENC_PREKEYED )
 
+#if defined( AES_HW_ESP32 )
+
+static uint8_t aes_hw_on = 1;
+
+void aes_hw_enable( uint8_t on )
+{
+    aes_hw_on = on;
+}
+
+uint8_t aes_hw_enabled( void )
+{
+    return aes_hw_on;
+}
+
+/*  The accelerator context keyed by lorawan_aes_set_key(), or NULL to use
+    the software rounds. esp_aes only writes its key_in_hardware flag */
+static esp_aes_context *aes_hw_context( const aes_context ctx[1] )
+{
+    if( !aes_hw_on || !ctx->hw_keyed )
+        return NULL;
+    return ( esp_aes_context * )&ctx->hw;
+}
+
+#else
+
+void aes_hw_enable( uint8_t on )
+{
+    ( void )on;
+}
+
+uint8_t aes_hw_enabled( void )
+{
+    return 0;
+}
+
+#endif
+
 /*  Encrypt a single block of 16 bytes */
 
 return_type lora_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK], const aes_context ctx[1] )
 {
+#if defined( AES_HW_ESP32 )
+    {
+        esp_aes_context *hw = aes_hw_context( ctx );
+        if( hw && esp_aes_crypt_ecb( hw, ESP_AES_ENCRYPT, in, out ) == 0 )
+            return 0;
+    }
+#endif
     if( ctx->rnd )
     {
         uint8_t s1[N_BLOCK], r;
@@ -597,6 +649,16 @@ return_type lora_aes_encrypt( const uint8_t in[N_BLOCK], uint8_t  out[N_BLOCK],
 return_type lorawan_aes_cbc_encrypt( const uint8_t *in, uint8_t *out,
                          int32_t n_block, uint8_t iv[N_BLOCK], const aes_context ctx[1] )
 {
+#if defined( AES_HW_ESP32 )
+    /* One engine transaction for the whole chain; leaves the last
+       ciphertext block in iv like the software loop below */
+    if( n_block > 0 )
+    {
+        esp_aes_context *hw = aes_hw_context( ctx );
+        if( hw && esp_aes_crypt_cbc( hw, ESP_AES_ENCRYPT, ( size_t )n_block * N_BLOCK, iv, in, out ) == 0 )
+            return EXIT_SUCCESS;
+    }
+#endif
 
     while(n_block--)
     {
@@ -50,6 +50,17 @@
 #  define AES_DEC_256_OTFK  /* AES decryption with 'on the fly' 256 bit keying */
 #endif
 
+/*  Run the pre-keyed encryption calls on the ESP32 AES accelerator.
+    The software key schedule is still built by lorawan_aes_set_key() and
+    is used whenever the engine rejects a key (e.g. 192 bits on the S3),
+    so callers see the same interface either way. Define AES_NO_HW to
+    build the software path only.
+*/
+#if defined( ESP_PLATFORM ) && defined( AES_ENC_PREKEYED ) && !defined( AES_NO_HW )
+#  define AES_HW_ESP32
+#  include "aes/esp_aes.h"
+#endif
+
 #define N_ROW                   4
 #define N_COL                   4
 #define N_BLOCK   (N_ROW * N_COL)
@@ -66,6 +77,10 @@ typedef uint8_t length_type;
 typedef struct
 {   uint8_t ksch[(N_MAX_ROUNDS + 1) * N_BLOCK];
     uint8_t rnd;
+#if defined( AES_HW_ESP32 )
+    uint8_t hw_keyed;       /* hw holds the key; 0 if the engine rejected it */
+    esp_aes_context hw;     /* Keyed once by lorawan_aes_set_key() */
+#endif
 } aes_context;
 
 /*  The following calls are for a precomputed key schedule
@@ -94,6 +109,11 @@ return_type lorawan_aes_cbc_encrypt( const uint8_t *in,
                          int32_t n_block,
                          uint8_t iv[N_BLOCK],
                          const aes_context ctx[1] );
+
+/*  Switch between the accelerator and the software rounds at run time
+    (for benchmarking); aes_hw_enabled() is 0 when there is no accelerator */
+void aes_hw_enable( uint8_t on );
+uint8_t aes_hw_enabled( void );
 #endif
 
 #if defined( AES_DEC_PREKEYED )
@@ -39,6 +39,10 @@ DEALINGS WITH THE SOFTWARE
 #include "cmac.h"
 #include "../loramac/utilities.h"
 
+/* Full blocks are chained through lorawan_aes_cbc_encrypt() this many at a
+   time, so an accelerator sees one request per chunk instead of per block */
+#define CMAC_CHUNK_BLOCKS 8
+
 #define LSHIFT(v, r) do {                                       \
   int32_t i;                                                  \
            for (i = 0; i < 15; i++)                                \
@@ -71,7 +75,6 @@ void AES_CMAC_SetKey(AES_CMAC_CTX *ctx, const uint8_t key[AES_CMAC_KEY_LENGTH])
 void AES_CMAC_Update(AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len)
 {
             uint32_t mlen;
-        uint8_t in[16];
     
             if (ctx->M_n > 0) {
                   mlen = MIN(16 - ctx->M_n, len);
@@ -86,16 +89,17 @@ void AES_CMAC_Update(AES_CMAC_CTX *ctx, const uint8_t *data, uint32_t len)
                     len -= mlen;
             }
             while (len > 16) {      /* not last block */
+                    /* CBC-MAC: X is the chaining value, only the last
+                       ciphertext block is kept */
+                    uint8_t chain[CMAC_CHUNK_BLOCKS * 16];
+                    uint32_t n = (len - 1) / 16;
 
-                    XOR(data, ctx->X);
-                    //rijndael_encrypt(&ctx->rijndael, ctx->X, ctx->X);
-
-                    memcpy1(in, &ctx->X[0], 16); //Bestela ez du ondo iten
-            lora_aes_encrypt( in, in, &ctx->rijndael);
-                    memcpy1(&ctx->X[0], in, 16);
+                    if (n > CMAC_CHUNK_BLOCKS)
+                            n = CMAC_CHUNK_BLOCKS;
+                    lorawan_aes_cbc_encrypt(data, chain, n, ctx->X, &ctx->rijndael);
 
-                    data += 16;
-                    len -= 16;
+                    data += n * 16;
+                    len -= n * 16;
             }
             /* potential last block, save it */
             memcpy1(ctx->M_last, data, len);
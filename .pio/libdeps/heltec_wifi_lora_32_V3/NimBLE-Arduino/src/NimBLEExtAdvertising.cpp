@@ -147,6 +147,39 @@ bool NimBLEExtAdvertising::setScanResponseData(uint8_t instId, NimBLEExtAdvertis
     return (rc == 0);
 } // setScanResponseData
 
+/**
+ * @brief Replace the advertising data of an instance configured with setInstanceData.
+ * @details The advertising parameters are left alone, so the instance may keep advertising
+ * while its payload changes. Non-legacy data must fit a single HCI command (251 bytes)
+ * while the instance is active, and scannable instances carry their data in the scan response.
+ * @param [in] instId The extended advertisement instance ID to update.
+ * @param [in] data The complete advertisement data (AD structures).
+ * @param [in] length The length of the data.
+ * @return True if the controller accepted the new data.
+ */
+bool NimBLEExtAdvertising::updateInstanceData(uint8_t instId, const uint8_t* data, size_t length) {
+    os_mbuf* buf = os_msys_get_pkthdr(length, 0);
+    if (!buf) {
+        NIMBLE_LOGE(LOG_TAG, "Data buffer allocation failed");
+        return false;
+    }
+
+    int rc = os_mbuf_append(buf, data, length);
+    if (rc != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Unable to copy data: rc = %d %s", rc, NimBLEUtils::returnCodeToString(rc));
+        os_mbuf_free_chain(buf);
+        return false;
+    }
+
+    rc = ble_gap_ext_adv_set_data(instId, buf);
+    if (rc != 0) {
+        NIMBLE_LOGE(LOG_TAG, "Invalid advertisement data: rc = %d %s", rc, NimBLEUtils::returnCodeToString(rc));
+        return false;
+    }
+
+    return true;
+} // updateInstanceData
+
 /**
  * @brief Start extended advertising.
  * @param [in] instId The extended advertisement instance ID to start.
@@ -114,6 +114,7 @@ class NimBLEExtAdvertising {
     bool start(uint8_t instId, int duration = 0, int maxEvents = 0);
     bool setInstanceData(uint8_t instId, NimBLEExtAdvertisement& adv);
     bool setScanResponseData(uint8_t instId, NimBLEExtAdvertisement& data);
+    bool updateInstanceData(uint8_t instId, const uint8_t* data, size_t length);
     bool removeInstance(uint8_t instId);
     bool removeAll();
     bool stop(uint8_t instId);
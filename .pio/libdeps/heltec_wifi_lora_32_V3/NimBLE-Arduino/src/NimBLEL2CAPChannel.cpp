@@ -17,7 +17,10 @@
 
 // L2CAP buffer block size
 # define L2CAP_BUF_BLOCK_SIZE            (250)
-# define L2CAP_BUF_SIZE_MTUS_PER_CHANNEL (3)
+// Number of MTU-sized SDUs that may be queued for transmission at once
+# ifndef L2CAP_BUF_SIZE_MTUS_PER_CHANNEL
+#  define L2CAP_BUF_SIZE_MTUS_PER_CHANNEL (3)
+# endif
 // Round-up integer division
 # define CEIL_DIVIDE(a, b)               (((a) + (b) - 1) / (b))
 # define ROUND_DIVIDE(a, b)              (((a) + (b) / 2) / (b))
@@ -83,8 +86,7 @@ void NimBLEL2CAPChannel::teardownMemPool() {
     }
 }
 
-int NimBLEL2CAPChannel::writeFragment(std::vector<uint8_t>::const_iterator begin, std::vector<uint8_t>::const_iterator end) {
-    auto toSend = end - begin;
+int NimBLEL2CAPChannel::writeFragment(const uint8_t* data, size_t toSend) {
 
     if (stalled) {
         NIMBLE_LOGD(LOG_TAG, "L2CAP Channel waiting for unstall...");
@@ -105,6 +107,15 @@ int NimBLEL2CAPChannel::writeFragment(std::vector<uint8_t>::const_iterator begin
         return -BLE_HS_EBADDATA;
     }
 
+    // Wait for earlier SDUs to drain from the pool rather than failing the allocation
+    // below and backing off for RetryTimeout
+    const uint16_t needBlocks = CEIL_DIVIDE(toSend, L2CAP_BUF_BLOCK_SIZE) + 1;
+    const uint32_t waitStart  = ble_npl_time_get();
+    while (_coc_mempool.mp_num_free < needBlocks &&
+           ble_npl_time_get() - waitStart < ble_npl_time_ms_to_ticks32(RetryTimeout)) {
+        ble_npl_time_delay(1);
+    }
+
     auto retries = RetryCounter;
 
     while (retries--) {
@@ -113,9 +124,10 @@ int NimBLEL2CAPChannel::writeFragment(std::vector<uint8_t>::const_iterator begin
             NIMBLE_LOGE(LOG_TAG, "Can't os_mbuf_get_pkthdr.");
             return -BLE_HS_ENOMEM;
         }
-        auto append = os_mbuf_append(txd, &(*begin), toSend);
+        auto append = os_mbuf_append(txd, data, toSend);
         if (append != 0) {
             NIMBLE_LOGE(LOG_TAG, "Can't os_mbuf_append: %d", append);
+            os_mbuf_free_chain(txd);
             return append;
         }
 
@@ -177,26 +189,38 @@ NimBLEL2CAPChannel* NimBLEL2CAPChannel::connect(NimBLEClient*                cli
 # endif // CONFIG_BT_NIMBLE_ROLE_CENTRAL
 
 bool NimBLEL2CAPChannel::write(const std::vector<uint8_t>& bytes) {
+    return write(bytes.data(), bytes.size());
+}
+
+bool NimBLEL2CAPChannel::write(const uint8_t* data, size_t length) {
     if (!this->channel) {
         NIMBLE_LOGW(LOG_TAG, "L2CAP Channel not open");
         return false;
     }
 
-    struct ble_l2cap_chan_info info;
-    ble_l2cap_get_chan_info(channel, &info);
-    auto mtu = info.peer_coc_mtu < info.our_coc_mtu ? info.peer_coc_mtu : info.our_coc_mtu;
+    auto mtu = getMTU();
 
-    auto start = bytes.begin();
-    while (start != bytes.end()) {
-        auto end = start + mtu < bytes.end() ? start + mtu : bytes.end();
-        if (writeFragment(start, end) < 0) {
+    while (length > 0) {
+        size_t chunk = length < mtu ? length : mtu;
+        if (writeFragment(data, chunk) < 0) {
             return false;
         }
-        start = end;
+        data   += chunk;
+        length -= chunk;
     }
     return true;
 }
 
+uint16_t NimBLEL2CAPChannel::getMTU() const {
+    if (!this->channel) {
+        return 0;
+    }
+
+    struct ble_l2cap_chan_info info;
+    ble_l2cap_get_chan_info(channel, &info);
+    return info.peer_coc_mtu < info.our_coc_mtu ? info.peer_coc_mtu : info.our_coc_mtu;
+}
+
 // private
 int NimBLEL2CAPChannel::handleConnectionEvent(struct ble_l2cap_event* event) {
     channel = event->connect.chan;
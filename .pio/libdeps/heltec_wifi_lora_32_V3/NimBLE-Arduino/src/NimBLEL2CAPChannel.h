@@ -56,6 +56,16 @@ class NimBLEL2CAPChannel {
     /// NOTE: This function will block until the data has been sent or an error occurred.
     bool write(const std::vector<uint8_t>& bytes);
 
+    /// @brief Write data to the channel straight from a caller-owned buffer.
+    ///
+    /// Same as write(const std::vector<uint8_t>&), without copying the data into a vector first:
+    /// the bytes go directly into the channel's mbuf pool.
+    /// @return true on success, after the data has been sent.
+    bool write(const uint8_t* data, size_t length);
+
+    /// @return The negotiated MTU (minimum of local and remote), or 0 if not connected.
+    uint16_t getMTU() const;
+
     /// @return True, if the channel is connected. False, otherwise.
     bool isConnected() const { return !!channel; }
 
@@ -93,7 +103,7 @@ class NimBLEL2CAPChannel {
     void teardownMemPool();
 
     // Writes data up to the size of the negotiated MTU to the channel.
-    int writeFragment(std::vector<uint8_t>::const_iterator begin, std::vector<uint8_t>::const_iterator end);
+    int writeFragment(const uint8_t* data, size_t toSend);
 
     // L2CAP event handler
     static int handleL2capEvent(struct ble_l2cap_event* event, void* arg);
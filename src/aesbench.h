@@ -0,0 +1,114 @@
+#ifndef AESBENCH_H
+#define AESBENCH_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+extern "C" {
+#include "loramac/aes.h"
+#include "loramac/cmac.h"
+}
+#include "loramac/LoRaMacCrypto.h"
+
+// LoRaMAC crypto self-test and microbenchmark (build with -DAES_BENCHMARK=1).
+// Runs once from begin(), for the AES accelerator and then the software
+// rounds: FIPS-197 / RFC 4493 known answers first, then CBC throughput in
+// bytes per second and the per-packet cost of MIC + payload encryption as
+// LoRaMAC does it for a 51-byte (DR0 US915 / EU868 SF12) and a 222-byte frame.
+
+#ifndef AES_BENCHMARK
+#define AES_BENCHMARK 0
+#endif
+
+#define AES_BENCH_BYTES      4096   // CBC throughput run
+#define AES_BENCH_PACKETS    200    // Iterations per packet size
+
+inline bool aesBenchHex(const uint8_t* got, const char* hex) {
+    for (int i = 0; hex[2 * i]; i++) {
+        char byte[3] = { hex[2 * i], hex[2 * i + 1], 0 };
+        if (got[i] != (uint8_t)strtoul(byte, nullptr, 16)) return false;
+    }
+    return true;
+}
+
+// Known-answer tests on whichever path is currently selected
+inline bool aesBenchSelfTest() {
+    static const uint8_t fipsKey[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                         0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    static const uint8_t fipsPt[16]  = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                         0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    static const uint8_t cmacKey[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                         0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+    static const uint8_t cmacMsg[64] = {
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+        0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+        0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+        0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 };
+    static const struct { uint8_t len; const char* mac; } cmacCases[] = {
+        {  0, "bb1d6929e95937287fa37d129b756746" },
+        { 16, "070a16b46b4d4144f79bdd9dd04a287c" },
+        { 40, "dfa66747de9ae63030ca32611497c827" },
+        { 64, "51f0bebf7e3b9d92fc49741779363cfe" },
+    };
+
+    aes_context ctx;
+    uint8_t out[16];
+    lorawan_aes_set_key(fipsKey, 16, &ctx);
+    lora_aes_encrypt(fipsPt, out, &ctx);
+    if (!aesBenchHex(out, "69c4e0d86a7b0430d8cdb78070b4c55a")) return false;
+
+    for (size_t i = 0; i < sizeof(cmacCases) / sizeof(cmacCases[0]); i++) {
+        AES_CMAC_CTX cmac;
+        AES_CMAC_Init(&cmac);
+        AES_CMAC_SetKey(&cmac, cmacKey);
+        AES_CMAC_Update(&cmac, cmacMsg, cmacCases[i].len);
+        AES_CMAC_Final(out, &cmac);
+        if (!aesBenchHex(out, cmacCases[i].mac)) return false;
+    }
+    return true;
+}
+
+inline void aesBenchRun(Print& out, const char* name) {
+    static uint8_t buf[AES_BENCH_BYTES];
+    static const uint8_t key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+    bool ok = aesBenchSelfTest();
+
+    // 1) Raw CBC throughput
+    aes_context ctx;
+    uint8_t iv[16] = { 0 };
+    memset(buf, 0x5a, sizeof(buf));
+    lorawan_aes_set_key(key, 16, &ctx);
+    int64_t t0 = esp_timer_get_time();
+    lorawan_aes_cbc_encrypt(buf, buf, AES_BENCH_BYTES / 16, iv, &ctx);
+    uint32_t cbcUs = (uint32_t)(esp_timer_get_time() - t0);
+
+    // 2) Per packet: MIC over the frame + FRMPayload encryption
+    static const uint16_t sizes[] = { 51, 222 };
+    uint32_t pktUs[2];
+    for (int s = 0; s < 2; s++) {
+        uint32_t mic;
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < AES_BENCH_PACKETS; i++) {
+            LoRaMacPayloadEncrypt(buf, sizes[s], key, 0x26011234, 0, i, buf + 256);
+            LoRaMacComputeMic(buf + 256, sizes[s], key, 0x26011234, 0, i, &mic);
+        }
+        pktUs[s] = (uint32_t)((esp_timer_get_time() - t0) / AES_BENCH_PACKETS);
+    }
+
+    out.printf("aes %-4s kat=%s cbc=%lu B/s pkt51=%luus pkt222=%luus\n", name, ok ? "ok" : "FAIL",
+               (unsigned long)(cbcUs ? (uint64_t)AES_BENCH_BYTES * 1000000ULL / cbcUs : 0),
+               (unsigned long)pktUs[0], (unsigned long)pktUs[1]);
+}
+
+inline void runAesBenchmark(Print& out) {
+    out.println("=== AES BENCHMARK ===");
+    aes_hw_enable(1);
+    if (aes_hw_enabled()) {
+        aesBenchRun(out, "hw");
+    }
+    aes_hw_enable(0);
+    aesBenchRun(out, "sw");
+    aes_hw_enable(1);
+}
+
+#endif // AESBENCH_H
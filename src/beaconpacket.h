@@ -0,0 +1,268 @@
+#ifndef BEACONPACKET_H
+#define BEACONPACKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compact binary position beacon, little-endian.
+// Pure encode/decode with no Arduino dependencies so the same code can be
+// reused by a host-side decoder.
+//
+// Two frame kinds share the first four bytes (type, nodeId, seq):
+//
+// Keyframe (17 bytes), self-contained:
+//  off size field
+//   0   1   type            BEACON_TYPE_FULL
+//   1   2   nodeId          16-bit hash of the sender's MAC
+//   3   1   seq             wraps at 256
+//   4   4   latE6           int32, microdegrees
+//   8   4   lonE6           int32, microdegrees
+//  12   1   speed           0.5 km/h units (0..127.5 km/h)
+//  13   1   heading         360/256 degree units, 0 = north
+//  14   1   battery         bit7 = charging, bits0-6 = percent (127 = unknown)
+//  15   1   fix             bits0-3 = GGA fix quality, bits4-7 = sats (capped at 15)
+//  16   1   rate            bits0-3 = link rate the sender asks the group for
+//                           (0x0F = none; 16-byte keyframes without it are accepted)
+//
+// Delta (8-12 bytes), position relative to the sender's last keyframe:
+//  off size field
+//   0   1   type            BEACON_TYPE_DELTA | packets since the keyframe (1..15)
+//   1   2   nodeId
+//   3   1   seq
+//   4  1-3  dLat            zigzag LEB128 varint, microdegrees
+//   .  1-3  dLon            zigzag LEB128 varint, microdegrees
+//   .   1   speed
+//   .   1   heading
+// Battery, fix/sats and rate are carried by keyframes only. A receiver that missed
+// the keyframe cannot place the delta and drops it until the next keyframe.
+
+#define BEACON_TYPE_FULL     0xB1
+#define BEACON_TYPE_DELTA    0xC0      // High nibble; low nibble = offset to keyframe seq
+#define BEACON_PACKET_LEN    17
+#define BEACON_PACKET_MIN    16        // Keyframe without the rate byte
+#define BEACON_DELTA_MAX_LEN 12
+#define BEACON_DELTA_MAX_OFF 15
+#define BEACON_DELTA_MAX_UD  ((1UL << 21) - 1)  // 3 varint bytes after zigzag (±1.05°, ~116 km)
+#define BEACON_BATT_UNKNOWN  0x7F
+
+struct BeaconFix {
+    uint16_t nodeId;
+    uint8_t seq;
+    int32_t latE6;
+    int32_t lonE6;
+    uint16_t speedHalfKmh;     // Saturates at 255 on the wire
+    uint8_t heading256;
+    uint8_t batteryPct;        // 0..100, BEACON_BATT_UNKNOWN if not known
+    bool charging;
+    uint8_t fixQuality;
+    uint8_t sats;
+    uint8_t rateReq;           // 0x0F = no request
+};
+
+inline void beaconPutI32(uint8_t* p, int32_t v) {
+    uint32_t u = (uint32_t)v;
+    p[0] = (uint8_t)u; p[1] = (uint8_t)(u >> 8); p[2] = (uint8_t)(u >> 16); p[3] = (uint8_t)(u >> 24);
+}
+
+inline int32_t beaconGetI32(const uint8_t* p) {
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+enum BeaconKind {
+    BEACON_INVALID = 0,
+    BEACON_KEYFRAME,
+    BEACON_DELTA
+};
+
+// Common header of either frame kind
+struct BeaconHeader {
+    BeaconKind kind;
+    uint16_t nodeId;
+    uint8_t seq;
+    uint8_t keySeq;            // Keyframe a delta refers to (== seq for keyframes)
+};
+
+inline uint32_t beaconZigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t beaconUnzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+// LEB128: 7 bits per byte, high bit = more; returns bytes written
+inline size_t beaconPutVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Reads at most 3 bytes (21 bits); false on truncation or overlong value
+inline bool beaconGetVarint(const uint8_t* in, size_t len, size_t& pos, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 21; shift += 7) {
+        if (pos >= len) return false;
+        uint8_t b = in[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// Encode into out (at least BEACON_PACKET_LEN bytes); returns the length written
+inline size_t beaconEncode(const BeaconFix& fix, uint8_t* out) {
+    out[0] = BEACON_TYPE_FULL;
+    out[1] = (uint8_t)fix.nodeId;
+    out[2] = (uint8_t)(fix.nodeId >> 8);
+    out[3] = fix.seq;
+    beaconPutI32(out + 4, fix.latE6);
+    beaconPutI32(out + 8, fix.lonE6);
+    out[12] = fix.speedHalfKmh > 255 ? 255 : (uint8_t)fix.speedHalfKmh;
+    out[13] = fix.heading256;
+    out[14] = (uint8_t)((fix.batteryPct > BEACON_BATT_UNKNOWN ? BEACON_BATT_UNKNOWN : fix.batteryPct) |
+                        (fix.charging ? 0x80 : 0x00));
+    out[15] = (uint8_t)((fix.fixQuality & 0x0F) | ((fix.sats > 15 ? 15 : fix.sats) << 4));
+    out[16] = (uint8_t)(fix.rateReq & 0x0F);
+    return BEACON_PACKET_LEN;
+}
+
+// Decode a received frame; false if it is not a valid full beacon
+inline bool beaconDecode(const uint8_t* in, size_t len, BeaconFix& fix) {
+    if (len < BEACON_PACKET_MIN || in[0] != BEACON_TYPE_FULL) {
+        return false;
+    }
+    fix.nodeId = (uint16_t)(in[1] | (in[2] << 8));
+    fix.seq = in[3];
+    fix.latE6 = beaconGetI32(in + 4);
+    fix.lonE6 = beaconGetI32(in + 8);
+    if (fix.latE6 < -90000000 || fix.latE6 > 90000000 ||
+        fix.lonE6 < -180000000 || fix.lonE6 > 180000000) {
+        return false;
+    }
+    fix.speedHalfKmh = in[12];
+    fix.heading256 = in[13];
+    fix.batteryPct = in[14] & 0x7F;
+    fix.charging = (in[14] & 0x80) != 0;
+    fix.fixQuality = in[15] & 0x0F;
+    fix.sats = in[15] >> 4;
+    fix.rateReq = len > BEACON_PACKET_MIN ? (in[16] & 0x0F) : 0x0F;
+    return true;
+}
+
+// Classify a received frame without decoding the payload
+inline bool beaconPeek(const uint8_t* in, size_t len, BeaconHeader& hdr) {
+    hdr.kind = BEACON_INVALID;
+    if (len < 4) {
+        return false;
+    }
+    hdr.nodeId = (uint16_t)(in[1] | (in[2] << 8));
+    hdr.seq = in[3];
+    if (in[0] == BEACON_TYPE_FULL && len >= BEACON_PACKET_MIN) {
+        hdr.kind = BEACON_KEYFRAME;
+        hdr.keySeq = hdr.seq;
+    } else if ((in[0] & 0xF0) == BEACON_TYPE_DELTA && (in[0] & 0x0F) != 0) {
+        hdr.kind = BEACON_DELTA;
+        hdr.keySeq = (uint8_t)(hdr.seq - (in[0] & 0x0F));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Encode fix as a delta against key; returns 0 if it cannot be expressed
+// (keyframe too old or position moved too far) and a keyframe must be sent
+inline size_t beaconEncodeDelta(const BeaconFix& fix, const BeaconFix& key, uint8_t* out) {
+    uint8_t off = (uint8_t)(fix.seq - key.seq);
+    int32_t dLat = fix.latE6 - key.latE6;
+    int32_t dLon = fix.lonE6 - key.lonE6;
+    if (off == 0 || off > BEACON_DELTA_MAX_OFF ||
+        beaconZigzag(dLat) > (uint32_t)BEACON_DELTA_MAX_UD ||
+        beaconZigzag(dLon) > (uint32_t)BEACON_DELTA_MAX_UD) {
+        return 0;
+    }
+    out[0] = (uint8_t)(BEACON_TYPE_DELTA | off);
+    out[1] = (uint8_t)fix.nodeId;
+    out[2] = (uint8_t)(fix.nodeId >> 8);
+    out[3] = fix.seq;
+    size_t n = 4;
+    n += beaconPutVarint(out + n, beaconZigzag(dLat));
+    n += beaconPutVarint(out + n, beaconZigzag(dLon));
+    out[n++] = fix.speedHalfKmh > 255 ? 255 : (uint8_t)fix.speedHalfKmh;
+    out[n++] = fix.heading256;
+    return n;
+}
+
+// Rebuild a fix from a delta and the keyframe it refers to; fields not
+// carried by deltas (battery, fix quality, sats) are taken from key
+inline bool beaconDecodeDelta(const uint8_t* in, size_t len, const BeaconFix& key, BeaconFix& fix) {
+    BeaconHeader hdr;
+    if (!beaconPeek(in, len, hdr) || hdr.kind != BEACON_DELTA ||
+        hdr.nodeId != key.nodeId || hdr.keySeq != key.seq) {
+        return false;
+    }
+    size_t pos = 4;
+    uint32_t zLat, zLon;
+    if (!beaconGetVarint(in, len, pos, zLat) || !beaconGetVarint(in, len, pos, zLon) || pos + 2 > len) {
+        return false;
+    }
+    fix = key;
+    fix.seq = hdr.seq;
+    fix.latE6 = key.latE6 + beaconUnzigzag(zLat);
+    fix.lonE6 = key.lonE6 + beaconUnzigzag(zLon);
+    if (fix.latE6 < -90000000 || fix.latE6 > 90000000 ||
+        fix.lonE6 < -180000000 || fix.lonE6 > 180000000) {
+        return false;
+    }
+    fix.speedHalfKmh = in[pos];
+    fix.heading256 = in[pos + 1];
+    return true;
+}
+
+// Fold a 48-bit MAC into a 16-bit node id (FNV-1a over the six bytes)
+inline uint16_t beaconNodeIdFromMac(uint64_t mac) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        h ^= (uint8_t)(mac >> (8 * i));
+        h *= 16777619u;
+    }
+    uint16_t id = (uint16_t)(h ^ (h >> 16));
+    return id == 0 ? 1 : id;   // 0 is reserved for "no node"
+}
+
+// BLE advertising wrapper: a keyframe carried as one Manufacturer Specific
+// Data AD structure
+//   [len = 3 + frame] [0xFF] [company id, little-endian] [keyframe]
+#define BEACON_ADV_COMPANY   0xFFFF    // Bluetooth SIG id reserved for testing
+#define BEACON_ADV_AD_MFG    0xFF
+#define BEACON_ADV_LEN       (4 + BEACON_PACKET_LEN)
+
+// Wrap a fix for advertising into out (at least BEACON_ADV_LEN bytes)
+inline size_t beaconAdvEncode(const BeaconFix& fix, uint8_t* out) {
+    size_t n = beaconEncode(fix, out + 4);
+    out[0] = (uint8_t)(3 + n);
+    out[1] = BEACON_ADV_AD_MFG;
+    out[2] = (uint8_t)(BEACON_ADV_COMPANY & 0xFF);
+    out[3] = (uint8_t)(BEACON_ADV_COMPANY >> 8);
+    return 4 + n;
+}
+
+// Walk the AD structures of an advertising payload and decode the first
+// beacon keyframe found; false if there is none
+inline bool beaconAdvDecode(const uint8_t* ad, size_t len, BeaconFix& fix) {
+    size_t pos = 0;
+    while (pos < len) {
+        uint8_t adLen = ad[pos];
+        if (adLen == 0 || pos + 1 + adLen > len) {
+            return false;      // Padding or truncated structure
+        }
+        const uint8_t* field = ad + pos + 1;
+        if (field[0] == BEACON_ADV_AD_MFG && adLen >= 3 + BEACON_PACKET_MIN &&
+            (uint16_t)(field[1] | (field[2] << 8)) == BEACON_ADV_COMPANY &&
+            beaconDecode(field + 3, adLen - 3, fix)) {
+            return true;
+        }
+        pos += 1 + adLen;
+    }
+    return false;
+}
+
+#endif // BEACONPACKET_H
@@ -0,0 +1,161 @@
+#ifndef BLEBCAST_H
+#define BLEBCAST_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include "beaconpacket.h"
+#include "navsnapshot.h"
+#include "lorabeacon.h"
+
+// Connectionless position broadcast on a BLE extended advertising set.
+// The same 17-byte keyframe the LoRa beacon sends is wrapped in a
+// Manufacturer Specific Data structure (beaconAdvEncode) and advertised
+// non-connectable and non-scannable, so any number of phones or base
+// stations can follow the tracker without a connection.
+// The set is configured once in begin(); each fix replaces only its data
+// (NimBLEExtAdvertising::updateInstanceData), which the controller accepts
+// while the set keeps advertising. Fixes that would not change anything
+// but the sequence number are not pushed at all.
+// Radio time is set by the advertising interval and PHYs:
+// dutyPpm() estimates it from the on-air size of one event.
+
+#if CONFIG_BT_NIMBLE_EXT_ADV
+
+#ifndef BLE_BCAST_INTERVAL_MS
+#define BLE_BCAST_INTERVAL_MS  1000
+#endif
+#ifndef BLE_BCAST_PRI_PHY
+#define BLE_BCAST_PRI_PHY      BLE_HCI_LE_PHY_1M      // Or BLE_HCI_LE_PHY_CODED for range
+#endif
+#ifndef BLE_BCAST_SEC_PHY
+#define BLE_BCAST_SEC_PHY      BLE_HCI_LE_PHY_1M      // BLE_HCI_LE_PHY_2M halves the AUX airtime
+#endif
+#ifndef BLE_BCAST_TX_DBM
+#define BLE_BCAST_TX_DBM       0
+#endif
+#define BLE_BCAST_INSTANCE     1                      // Instance 0 is the connectable LNS set
+#define BLE_BCAST_MIN_MS       100
+#define BLE_BCAST_MAX_MS       10240
+
+class BleBroadcast {
+private:
+    uint8_t payload[BEACON_ADV_LEN];
+    uint8_t payloadLen;
+    uint16_t nodeId;
+    uint8_t seq;
+    uint16_t intervalMs;
+    bool running;
+
+    bool configure();
+
+    // Microseconds per byte on air for an HCI PHY value (coded: S=8)
+    static uint32_t usPerByte(uint8_t phy) {
+        return phy == BLE_HCI_LE_PHY_2M ? 4 : (phy == BLE_HCI_LE_PHY_CODED ? 64 : 8);
+    }
+
+public:
+    uint32_t updates;                   // Payloads handed to the controller
+    uint32_t unchanged;                 // Fixes skipped because the payload was the same
+    uint32_t failures;
+
+    BleBroadcast() : payloadLen(0), nodeId(0), seq(0), intervalMs(BLE_BCAST_INTERVAL_MS),
+                     running(false), updates(0), unchanged(0), failures(0) {
+        memset(payload, 0, sizeof(payload));
+    }
+
+    // Configure and start the advertising set; NimBLEDevice::init() must have run
+    bool begin(uint16_t id);
+
+    // Refresh the advertised position from a new fix
+    void update(const NavSnapshot& nav, int batteryPct, bool charging);
+
+    // Change the advertising interval (reconfigures the set)
+    bool setInterval(uint16_t ms);
+    uint16_t getInterval() const { return intervalMs; }
+    bool isRunning() const { return running; }
+
+    // Air time of one advertising event: ADV_EXT_IND on the three primary
+    // channels plus one AUX_ADV_IND with the payload
+    uint32_t eventAirUs() const {
+        return 3 * 17 * usPerByte(BLE_BCAST_PRI_PHY) + (payloadLen + 20) * usPerByte(BLE_BCAST_SEC_PHY);
+    }
+    uint32_t dutyPpm() const { return intervalMs ? eventAirUs() * 1000 / intervalMs : 0; }
+};
+
+inline bool BleBroadcast::begin(uint16_t id) {
+    nodeId = id;
+
+    // Start with an empty fix so scanners see the node before the first position
+    BeaconFix fix;
+    memset(&fix, 0, sizeof(fix));
+    fix.nodeId = nodeId;
+    fix.batteryPct = BEACON_BATT_UNKNOWN;
+    fix.rateReq = LINK_RATE_NONE;
+    payloadLen = (uint8_t)beaconAdvEncode(fix, payload);
+
+    running = configure();
+    if (running) {
+        Serial.printf("→ BLE broadcast every %ums (~%lu ppm radio time)\n", intervalMs, (unsigned long)dutyPpm());
+    }
+    return running;
+}
+
+inline bool BleBroadcast::configure() {
+    NimBLEExtAdvertising* ext = NimBLEDevice::getAdvertising();
+    NimBLEExtAdvertisement adv(BLE_BCAST_PRI_PHY, BLE_BCAST_SEC_PHY);
+    adv.setLegacyAdvertising(false);
+    adv.setConnectable(false);
+    adv.setScannable(false);
+    adv.setMinInterval((uint32_t)intervalMs * 8 / 5);      // 0.625 ms units
+    adv.setMaxInterval((uint32_t)intervalMs * 8 / 5);
+    adv.setTxPower(BLE_BCAST_TX_DBM);
+    adv.setData(payload, payloadLen);
+
+    if (ext->isActive(BLE_BCAST_INSTANCE)) {
+        ext->stop(BLE_BCAST_INSTANCE);
+    }
+    return ext->setInstanceData(BLE_BCAST_INSTANCE, adv) && ext->start(BLE_BCAST_INSTANCE);
+}
+
+inline void BleBroadcast::update(const NavSnapshot& nav, int batteryPct, bool charging) {
+    if (!running || !nav.hasPosition) {
+        return;
+    }
+
+    // 1) Pack the fix the same way the LoRa beacon does
+    BeaconFix fix;
+    memset(&fix, 0, sizeof(fix));
+    LoRaBeacon::fillFix(fix, nav, batteryPct, charging);
+    fix.nodeId = nodeId;
+    fix.seq = seq;
+    fix.rateReq = LINK_RATE_NONE;
+    uint8_t next[BEACON_ADV_LEN];
+    size_t len = beaconAdvEncode(fix, next);
+
+    // 2) Skip fixes that would only bump the sequence number (byte 7 = seq)
+    next[7] = payload[7];
+    if (len == payloadLen && memcmp(next, payload, len) == 0) {
+        unchanged++;
+        return;
+    }
+    next[7] = ++seq;
+
+    // 3) Swap the data in place; the set keeps advertising
+    if (NimBLEDevice::getAdvertising()->updateInstanceData(BLE_BCAST_INSTANCE, next, len)) {
+        memcpy(payload, next, len);
+        payloadLen = (uint8_t)len;
+        updates++;
+    } else {
+        failures++;
+    }
+}
+
+inline bool BleBroadcast::setInterval(uint16_t ms) {
+    intervalMs = ms < BLE_BCAST_MIN_MS ? BLE_BCAST_MIN_MS : (ms > BLE_BCAST_MAX_MS ? BLE_BCAST_MAX_MS : ms);
+    running = configure();
+    return running;
+}
+
+#endif // CONFIG_BT_NIMBLE_EXT_ADV
+
+#endif // BLEBCAST_H
@@ -0,0 +1,434 @@
+#ifndef BLENAV_H
+#define BLENAV_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include "navsnapshot.h"
+
+// Bluetooth LE Location and Navigation Service (LNS, 0x1819) peripheral.
+// Phones and watches subscribe to Location and Speed (position, speed,
+// heading, fix status) and Navigation (bearing / distance to the target the
+// tracker is currently navigating to). Position Quality and LN Feature are
+// plain reads; the LN Control Point supports content masking and starting
+// or stopping navigation updates.
+//
+// update() only marks new data pending; service() sends it at most once per
+// connection interval, both characteristics back to back so they leave in
+// the same connection event. Each notification carries only the fields whose
+// wire value changed since the last one (the LNS flags say which fields are
+// present), and nothing is sent when nothing changed. With slave latency the
+// radio can then skip connection events while we are idle, yet every fix
+// still reaches the central at the full GNSS rate.
+
+#ifndef BLE_NAV_DEVICE_PREFIX
+#define BLE_NAV_DEVICE_PREFIX  "HTIT-Tracker"
+#endif
+
+// Connection parameters requested after connect (1.25 ms / 10 ms units)
+#define BLE_NAV_CONN_MIN       80     // 100 ms
+#define BLE_NAV_CONN_MAX       160    // 200 ms
+#define BLE_NAV_CONN_LATENCY   4      // Events we may skip when there is nothing to send
+#define BLE_NAV_CONN_TIMEOUT   400    // 4 s supervision timeout
+#define BLE_NAV_BULK_CONN_MIN  6      // 7.5 ms while a bulk transfer runs
+#define BLE_NAV_BULK_CONN_MAX  12     // 15 ms
+#define BLE_NAV_BULK_DATA_LEN  251    // LL payload octets (data length extension)
+#define BLE_NAV_ADV_MIN        800    // 500 ms (0.625 ms units)
+#define BLE_NAV_ADV_MAX        1600   // 1 s
+#define BLE_NAV_ADV_INSTANCE   0      // Advertising set when extended advertising is enabled
+#define BLE_NAV_APPEARANCE     0x1443 // Location and Navigation Pod
+#define BLE_NAV_REACHED_M      10.0f  // Target counts as reached inside this radius
+
+// LN Feature bits we implement
+#define LN_FEAT_SPEED          (1UL << 0)
+#define LN_FEAT_LOCATION       (1UL << 2)
+#define LN_FEAT_HEADING        (1UL << 4)
+#define LN_FEAT_REMAINING_DIST (1UL << 7)
+#define LN_FEAT_IN_VIEW        (1UL << 11)
+#define LN_FEAT_HDOP           (1UL << 15)
+#define LN_FEAT_MASKING        (1UL << 17)
+#define LN_FEAT_POS_STATUS     (1UL << 20)
+
+// Location and Speed flags / content mask bits (same positions)
+#define LN_LS_SPEED            0x0001
+#define LN_LS_LOCATION         0x0004
+#define LN_LS_HEADING          0x0010
+#define LN_LS_STATUS_SHIFT     7
+
+// Navigation flags
+#define LN_NAV_REMAINING_DIST  0x0001
+#define LN_NAV_STATUS_SHIFT    3
+#define LN_NAV_WAYPOINT_REACHED 0x0080
+
+// Position status field
+#define LN_POS_NONE            0
+#define LN_POS_OK              1
+#define LN_POS_LAST_KNOWN      3
+
+// Control Point
+#define LN_CP_MASK_CONTENT     0x02
+#define LN_CP_NAV_CONTROL      0x03
+#define LN_CP_RESPONSE         0x20
+#define LN_CP_SUCCESS          0x01
+#define LN_CP_NOT_SUPPORTED    0x02
+#define LN_CP_INVALID_PARAM    0x03
+
+// Adds further GATT services while the server is being set up
+typedef void (*BleServiceHook)(NimBLEServer* server, void* ctx);
+
+// Where the tracker is currently navigating to
+struct BleNavTarget {
+    bool valid;
+    float bearingDeg;
+    float distanceM;
+};
+
+class BleNavService : public NimBLEServerCallbacks, public NimBLECharacteristicCallbacks {
+private:
+    NimBLEServer* server;
+    NimBLECharacteristic* locChr;
+    NimBLECharacteristic* navChr;
+    NimBLECharacteristic* qualChr;
+    NimBLECharacteristic* cpChr;
+
+    // Written from the NimBLE host task, read by service()
+    volatile bool connected;
+    volatile bool locSubscribed;
+    volatile bool navSubscribed;
+    volatile bool forceFull;            // Next flush sends every field
+    volatile bool navRunning;           // Control Point start/stop
+    volatile uint16_t contentMask;      // Location and Speed fields turned off
+    volatile uint16_t connIntervalMs;
+    volatile uint16_t connHandle;
+
+    // Latest data and what was last put on the air (wire units)
+    NavSnapshot latest;
+    BleNavTarget target;
+    bool pending;
+    uint32_t lastFlushMs;
+    uint16_t sentSpeed, sentHeading, sentBearing, sentNavHeading;
+    int32_t sentLat, sentLon;
+    uint32_t sentDist;
+    uint8_t sentLocStatus, sentNavStatus;
+    bool sentTargetValid;
+
+    static uint8_t positionStatus(const NavSnapshot& nav) {
+        if (nav.hasPosition && nav.haveFix) return LN_POS_OK;
+        if (nav.hasPosition) return LN_POS_LAST_KNOWN;
+        return LN_POS_NONE;
+    }
+    static uint16_t headingWire(const NavSnapshot& nav) {
+        return nav.hasCourse ? (uint16_t)(fmodf(nav.courseDeg, 360.0f) * 100.0f) : 0;
+    }
+    static uint8_t putLE(uint8_t* p, uint32_t v, uint8_t bytes) {
+        for (uint8_t i = 0; i < bytes; i++) p[i] = (uint8_t)(v >> (8 * i));
+        return bytes;
+    }
+
+    bool flushLocation(bool full);
+    bool flushNavigation(bool full);
+    void refreshQuality();
+
+public:
+    uint32_t notifications;
+    uint32_t bytesSent;
+    uint32_t batches;                   // Flushes that sent at least one notification
+    uint32_t coalesced;                 // Updates folded into a pending flush
+
+    BleNavService() : server(nullptr), locChr(nullptr), navChr(nullptr), qualChr(nullptr), cpChr(nullptr),
+                      connected(false), locSubscribed(false), navSubscribed(false), forceFull(true),
+                      navRunning(true), contentMask(0), connIntervalMs(BLE_NAV_CONN_MAX * 5 / 4), connHandle(0),
+                      pending(false), lastFlushMs(0), sentSpeed(0), sentHeading(0), sentBearing(0), sentNavHeading(0),
+                      sentLat(0), sentLon(0), sentDist(0), sentLocStatus(0), sentNavStatus(0),
+                      sentTargetValid(false), notifications(0), bytesSent(0), batches(0), coalesced(0) {
+        memset(&latest, 0, sizeof(latest));
+        memset(&target, 0, sizeof(target));
+    }
+
+    // Start the GATT server and advertise; false if the stack failed to start.
+    // extra runs after the LNS is created, before the server starts
+    bool begin(uint16_t nodeId, BleServiceHook extra = nullptr, void* ctx = nullptr);
+
+    // Hand over a new fix and navigation target; sent on the next service()
+    void update(const NavSnapshot& nav, const BleNavTarget& tgt);
+
+    // Send pending data if a connection interval has passed since the last batch
+    void service(uint32_t nowMs);
+
+    // Fast link for bulk transfers, then back to the low-duty navigation parameters
+    void setBulkMode(bool on);
+
+    bool isConnected() const { return connected; }
+    uint16_t getConnIntervalMs() const { return connIntervalMs; }
+
+    // NimBLE callbacks (host task)
+    void onConnect(NimBLEServer* s, NimBLEConnInfo& info) override;
+    void onDisconnect(NimBLEServer* s, NimBLEConnInfo& info, int reason) override;
+    void onConnParamsUpdate(NimBLEConnInfo& info) override;
+    void onSubscribe(NimBLECharacteristic* chr, NimBLEConnInfo& info, uint16_t subValue) override;
+    void onWrite(NimBLECharacteristic* chr, NimBLEConnInfo& info) override;
+};
+
+inline bool BleNavService::begin(uint16_t nodeId, BleServiceHook extra, void* ctx) {
+    char name[24];
+    snprintf(name, sizeof(name), "%s %04X", BLE_NAV_DEVICE_PREFIX, nodeId);
+    if (!NimBLEDevice::init(name)) {
+        return false;
+    }
+
+    // 1) Server and LNS characteristics
+    server = NimBLEDevice::createServer();
+    server->setCallbacks(this, false);
+    NimBLEService* lns = server->createService(NimBLEUUID((uint16_t)0x1819));
+
+    NimBLECharacteristic* feature = lns->createCharacteristic(NimBLEUUID((uint16_t)0x2A6A), NIMBLE_PROPERTY::READ);
+    uint8_t feat[4];
+    putLE(feat, LN_FEAT_SPEED | LN_FEAT_LOCATION | LN_FEAT_HEADING | LN_FEAT_REMAINING_DIST |
+                LN_FEAT_IN_VIEW | LN_FEAT_HDOP | LN_FEAT_MASKING | LN_FEAT_POS_STATUS, 4);
+    feature->setValue(feat, sizeof(feat));
+
+    locChr  = lns->createCharacteristic(NimBLEUUID((uint16_t)0x2A67), NIMBLE_PROPERTY::NOTIFY);
+    navChr  = lns->createCharacteristic(NimBLEUUID((uint16_t)0x2A68), NIMBLE_PROPERTY::NOTIFY);
+    qualChr = lns->createCharacteristic(NimBLEUUID((uint16_t)0x2A69), NIMBLE_PROPERTY::READ);
+    cpChr   = lns->createCharacteristic(NimBLEUUID((uint16_t)0x2A6B),
+                                        NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::INDICATE);
+    locChr->setCallbacks(this);
+    navChr->setCallbacks(this);
+    cpChr->setCallbacks(this);
+    refreshQuality();
+    lns->start();
+    if (extra) {
+        extra(server, ctx);
+    }
+
+    // 2) Slow advertising: nobody is waiting on a tracker to be discovered
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    // Legacy connectable PDUs on set BLE_NAV_ADV_INSTANCE, so every phone
+    // can find us while other sets broadcast alongside
+    NimBLEExtAdvertisement adv;
+    adv.setLegacyAdvertising(true);
+    adv.setConnectable(true);
+    adv.setFlags(BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP);
+    adv.addServiceUUID(NimBLEUUID((uint16_t)0x1819));
+    adv.setAppearance(BLE_NAV_APPEARANCE);
+    adv.setName(name);
+    adv.setMinInterval(BLE_NAV_ADV_MIN);
+    adv.setMaxInterval(BLE_NAV_ADV_MAX);
+    NimBLEExtAdvertising* ext = NimBLEDevice::getAdvertising();
+    if (!ext->setInstanceData(BLE_NAV_ADV_INSTANCE, adv) || !ext->start(BLE_NAV_ADV_INSTANCE)) {
+        return false;
+    }
+#else
+    NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+    adv->addServiceUUID(NimBLEUUID((uint16_t)0x1819));
+    adv->setAppearance(BLE_NAV_APPEARANCE);
+    adv->setName(name);
+    adv->setMinInterval(BLE_NAV_ADV_MIN);
+    adv->setMaxInterval(BLE_NAV_ADV_MAX);
+    server->advertiseOnDisconnect(true);
+    if (!adv->start()) {
+        return false;
+    }
+#endif
+    Serial.printf("→ BLE LNS advertising as \"%s\"\n", name);
+    return true;
+}
+
+inline void BleNavService::update(const NavSnapshot& nav, const BleNavTarget& tgt) {
+    if (pending) {
+        coalesced++;
+    }
+    latest = nav;
+    target = tgt;
+    pending = true;
+}
+
+inline void BleNavService::service(uint32_t nowMs) {
+    if ((!pending && !forceFull) || !connected) {
+        return;
+    }
+    if (nowMs - lastFlushMs < connIntervalMs) {
+        return;  // Fold into the next connection event
+    }
+    lastFlushMs = nowMs;
+    pending = false;
+
+    bool full = forceFull;
+    forceFull = false;
+    refreshQuality();
+
+    // Both notifications are queued together and leave in one event
+    bool sent = false;
+    if (locSubscribed) sent |= flushLocation(full);
+    if (navSubscribed && navRunning) sent |= flushNavigation(full);
+    if (sent) batches++;
+}
+
+inline bool BleNavService::flushLocation(bool full) {
+    uint8_t status = positionStatus(latest);
+    uint16_t speed = latest.hasSpeed ? (uint16_t)(latest.speedKmh / 3.6f * 100.0f + 0.5f) : 0;
+    uint16_t heading = headingWire(latest);
+    int32_t lat = (int32_t)lround(latest.lat * 1e7);
+    int32_t lon = (int32_t)lround(latest.lon * 1e7);
+
+    // 1) Flags for the fields that changed and are not masked off
+    uint16_t flags = (uint16_t)(status << LN_LS_STATUS_SHIFT);
+    if (latest.hasSpeed && (full || speed != sentSpeed)) flags |= LN_LS_SPEED;
+    if (latest.hasPosition && (full || lat != sentLat || lon != sentLon)) flags |= LN_LS_LOCATION;
+    if (latest.hasCourse && (full || heading != sentHeading)) flags |= LN_LS_HEADING;
+    flags &= ~contentMask;
+    if (!full && status == sentLocStatus &&
+        !(flags & (LN_LS_SPEED | LN_LS_LOCATION | LN_LS_HEADING))) {
+        return false;
+    }
+
+    // 2) Fields in LNS order
+    uint8_t buf[16];
+    uint8_t len = putLE(buf, flags, 2);
+    if (flags & LN_LS_SPEED) { len += putLE(buf + len, speed, 2); sentSpeed = speed; }
+    if (flags & LN_LS_LOCATION) {
+        len += putLE(buf + len, (uint32_t)lat, 4);
+        len += putLE(buf + len, (uint32_t)lon, 4);
+        sentLat = lat;
+        sentLon = lon;
+    }
+    if (flags & LN_LS_HEADING) { len += putLE(buf + len, heading, 2); sentHeading = heading; }
+    sentLocStatus = status;
+
+    locChr->setValue(buf, len);
+    locChr->notify();
+    notifications++;
+    bytesSent += len;
+    return true;
+}
+
+inline bool BleNavService::flushNavigation(bool full) {
+    uint8_t status = target.valid ? positionStatus(latest) : LN_POS_NONE;
+    uint16_t bearing = target.valid ? (uint16_t)(fmodf(target.bearingDeg, 360.0f) * 100.0f) : 0;
+    uint16_t heading = headingWire(latest);
+    uint32_t dist = target.valid ? (uint32_t)(target.distanceM * 10.0f + 0.5f) : 0;
+    if (dist > 0xFFFFFF) dist = 0xFFFFFF;
+
+    // Bearing and heading are mandatory, so only remaining distance is optional
+    bool distChanged = target.valid && (full || dist != sentDist || !sentTargetValid);
+    if (!full && status == sentNavStatus && target.valid == sentTargetValid &&
+        bearing == sentBearing && heading == sentNavHeading && !distChanged) {
+        return false;
+    }
+
+    uint16_t flags = (uint16_t)(status << LN_NAV_STATUS_SHIFT);
+    if (distChanged) flags |= LN_NAV_REMAINING_DIST;
+    if (target.valid && target.distanceM < BLE_NAV_REACHED_M) flags |= LN_NAV_WAYPOINT_REACHED;
+
+    uint8_t buf[9];
+    uint8_t len = putLE(buf, flags, 2);
+    len += putLE(buf + len, bearing, 2);
+    len += putLE(buf + len, heading, 2);
+    if (flags & LN_NAV_REMAINING_DIST) { len += putLE(buf + len, dist, 3); sentDist = dist; }
+    sentBearing = bearing;
+    sentNavHeading = heading;
+    sentNavStatus = status;
+    sentTargetValid = target.valid;
+
+    navChr->setValue(buf, len);
+    navChr->notify();
+    notifications++;
+    bytesSent += len;
+    return true;
+}
+
+inline void BleNavService::refreshQuality() {
+    // Read on demand, so it is only kept current, never notified
+    uint16_t flags = 0x0002 | 0x0020 | (uint16_t)(positionStatus(latest) << 7);
+    float hdop2 = latest.hdop * 2.0f + 0.5f;    // HDOP in units of 0.5
+    uint8_t buf[4];
+    uint8_t len = putLE(buf, flags, 2);
+    buf[len++] = latest.satsInView;
+    buf[len++] = hdop2 > 255.0f ? 255 : (uint8_t)hdop2;
+    qualChr->setValue(buf, len);
+}
+
+inline void BleNavService::onConnect(NimBLEServer* s, NimBLEConnInfo& info) {
+    connected = true;
+    forceFull = true;
+    connIntervalMs = info.getConnInterval() * 5 / 4;
+    connHandle = info.getConnHandle();
+    s->updateConnParams(info.getConnHandle(), BLE_NAV_CONN_MIN, BLE_NAV_CONN_MAX,
+                        BLE_NAV_CONN_LATENCY, BLE_NAV_CONN_TIMEOUT);
+}
+
+inline void BleNavService::setBulkMode(bool on) {
+    if (!connected || !server) {
+        return;
+    }
+    if (on) {
+        server->setDataLen(connHandle, BLE_NAV_BULK_DATA_LEN);
+        server->updatePhy(connHandle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, 0);
+        server->updateConnParams(connHandle, BLE_NAV_BULK_CONN_MIN, BLE_NAV_BULK_CONN_MAX, 0, BLE_NAV_CONN_TIMEOUT);
+    } else {
+        server->updateConnParams(connHandle, BLE_NAV_CONN_MIN, BLE_NAV_CONN_MAX,
+                                 BLE_NAV_CONN_LATENCY, BLE_NAV_CONN_TIMEOUT);
+    }
+}
+
+inline void BleNavService::onDisconnect(NimBLEServer*, NimBLEConnInfo&, int) {
+    connected = false;
+    locSubscribed = false;
+    navSubscribed = false;
+    contentMask = 0;
+    navRunning = true;
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    // Extended sets stop on connect and are not restarted by the server
+    NimBLEDevice::getAdvertising()->start(BLE_NAV_ADV_INSTANCE);
+#endif
+}
+
+inline void BleNavService::onConnParamsUpdate(NimBLEConnInfo& info) {
+    connIntervalMs = info.getConnInterval() * 5 / 4;
+}
+
+inline void BleNavService::onSubscribe(NimBLECharacteristic* chr, NimBLEConnInfo&, uint16_t subValue) {
+    bool on = (subValue & 0x0001) != 0;
+    if (chr == locChr) locSubscribed = on;
+    else if (chr == navChr) navSubscribed = on;
+    if (on) {
+        forceFull = true;   // A new subscriber has no previous values to merge with
+    }
+}
+
+inline void BleNavService::onWrite(NimBLECharacteristic* chr, NimBLEConnInfo&) {
+    if (chr != cpChr) {
+        return;
+    }
+    NimBLEAttValue v = chr->getValue();
+    const uint8_t* req = v.data();
+    uint8_t op = v.size() > 0 ? req[0] : 0;
+    uint8_t result = LN_CP_NOT_SUPPORTED;
+
+    switch (op) {
+        case LN_CP_MASK_CONTENT:
+            if (v.size() == 3) {
+                contentMask = (uint16_t)(req[1] | (req[2] << 8));
+                forceFull = true;
+                result = LN_CP_SUCCESS;
+            } else {
+                result = LN_CP_INVALID_PARAM;
+            }
+            break;
+        case LN_CP_NAV_CONTROL:
+            // 0 stop, 1 start, 2 pause, 3 continue; route skipping needs a route
+            if (v.size() == 2 && req[1] <= 0x03) {
+                navRunning = (req[1] == 0x01 || req[1] == 0x03);
+                forceFull = true;
+                result = LN_CP_SUCCESS;
+            } else {
+                result = LN_CP_INVALID_PARAM;
+            }
+            break;
+    }
+
+    uint8_t resp[3] = { LN_CP_RESPONSE, op, result };
+    cpChr->setValue(resp, sizeof(resp));
+    cpChr->indicate();
+}
+
+#endif // BLENAV_H
@@ -0,0 +1,205 @@
+#ifndef BLETRACK_H
+#define BLETRACK_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "tracklog.h"
+#include "blenav.h"
+
+// Bulk download of the track log over an LE L2CAP connection-oriented
+// channel (credit-based flow control, no ATT round trips or 20-byte
+// notifications).
+// A client opens the channel on BLE_TRACK_PSM and writes 'T' plus a
+// little-endian uint32 byte offset to resume from (0 for everything). The
+// tracker answers with "HTRK" and the uint32 number of bytes that follow,
+// then streams the old and current log files back to back.
+// Streaming runs in its own task: each chunk is read from flash into one
+// MTU-sized buffer owned by this object and handed to the channel, which
+// copies it into its own mbuf pool, so no chunk touches the heap. The
+// channel keeps up to L2CAP_BUF_SIZE_MTUS_PER_CHANNEL SDUs queued and
+// blocks when the peer's credits run out until it hands out more. For the
+// length of a download the link is switched to BleNavService's bulk mode
+// (short connection interval, 2M PHY, 251-byte data packets).
+
+#define BLE_TRACK_PSM          0x0081
+#define BLE_TRACK_MTU          1024
+#define BLE_TRACK_TASK_STACK   4096
+#define BLE_TRACK_TASK_PRIO    2
+#define BLE_TRACK_TASK_CORE    0    // With the NimBLE host, away from the loop
+
+#define BLE_TRACK_CMD_GET      'T'
+#define BLE_TRACK_MAGIC        "HTRK"
+#define BLE_TRACK_HEADER_BYTES 8
+
+class BleTrackTransfer {
+private:
+    // Owned and deleted by the channel
+    class ChannelCallbacks : public NimBLEL2CAPChannelCallbacks {
+    private:
+        BleTrackTransfer* owner;
+    public:
+        explicit ChannelCallbacks(BleTrackTransfer* o) : owner(o) {}
+        void onConnect(NimBLEL2CAPChannel*, uint16_t mtu) override { owner->mtu = mtu; }
+        void onRead(NimBLEL2CAPChannel*, std::vector<uint8_t>& data) override { owner->onRequest(data); }
+        void onDisconnect(NimBLEL2CAPChannel*) override { owner->mtu = 0; }
+    };
+
+    NimBLEL2CAPChannel* channel;
+    TrackLog* log;
+    BleNavService* link;
+    TaskHandle_t task;
+    volatile uint16_t mtu;              // Negotiated SDU size, 0 while closed
+    volatile uint32_t requestOffset;
+    volatile bool busy;
+    uint8_t chunk[BLE_TRACK_MTU];
+
+    void onRequest(const std::vector<uint8_t>& data);
+    static uint32_t fileSize(const char* path);
+    bool sendFile(const char* path, uint32_t size, uint32_t& skip, uint32_t& sent);
+    void stream();
+
+    static void taskMain(void* arg);
+
+public:
+    // Results of the last download
+    uint32_t transfers;
+    uint32_t lastBytes;
+    uint32_t lastMs;
+    uint32_t failures;
+
+    BleTrackTransfer() : channel(nullptr), log(nullptr), link(nullptr), task(nullptr), mtu(0), requestOffset(0),
+                         busy(false), transfers(0), lastBytes(0), lastMs(0), failures(0) {}
+
+    // Register the L2CAP service; needs NimBLEDevice::init() to have run
+    bool begin(TrackLog& trackLog, BleNavService& ble);
+
+    bool isBusy() const { return busy; }
+    TaskHandle_t getTask() const { return task; }
+
+    // Throughput of the last download in bytes/s, and milliseconds per MB
+    uint32_t lastRate() const { return lastMs ? (uint32_t)((uint64_t)lastBytes * 1000 / lastMs) : 0; }
+    uint32_t lastMsPerMB() const { return lastBytes ? (uint32_t)((uint64_t)lastMs * 1048576ULL / lastBytes) : 0; }
+};
+
+inline bool BleTrackTransfer::begin(TrackLog& trackLog, BleNavService& ble) {
+    log = &trackLog;
+    link = &ble;
+    NimBLEL2CAPServer* l2cap = NimBLEDevice::createL2CAPServer();
+    channel = l2cap ? l2cap->createService(BLE_TRACK_PSM, BLE_TRACK_MTU, new ChannelCallbacks(this)) : nullptr;
+    if (!channel) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(taskMain, "bletrack", BLE_TRACK_TASK_STACK, this,
+                                BLE_TRACK_TASK_PRIO, &task, BLE_TRACK_TASK_CORE) != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    Serial.printf("→ Track download on L2CAP PSM 0x%04X (MTU %d)\n", BLE_TRACK_PSM, BLE_TRACK_MTU);
+    return true;
+}
+
+inline void BleTrackTransfer::onRequest(const std::vector<uint8_t>& data) {
+    // NimBLE host task: just hand the request to the streaming task
+    if (data.size() != 5 || data[0] != BLE_TRACK_CMD_GET || busy) {
+        return;
+    }
+    requestOffset = data[1] | (data[2] << 8) | (data[3] << 16) | ((uint32_t)data[4] << 24);
+    busy = true;
+    xTaskNotifyGive(task);
+}
+
+inline void BleTrackTransfer::taskMain(void* arg) {
+    BleTrackTransfer* self = static_cast<BleTrackTransfer*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->stream();
+        self->busy = false;
+    }
+}
+
+inline void BleTrackTransfer::stream() {
+    // 1) Size the download from what is on flash now; the logger may append
+    //    while we stream, but the files are not rotated until endRead()
+    log->beginRead();
+    uint32_t oldSize = fileSize(TRACK_OLD_PATH);
+    uint32_t curSize = fileSize(TRACK_LOG_PATH);
+    uint32_t total = oldSize + curSize;
+    uint32_t skip = requestOffset < total ? requestOffset : total;
+
+    uint8_t header[BLE_TRACK_HEADER_BYTES];
+    memcpy(header, BLE_TRACK_MAGIC, 4);
+    uint32_t remaining = total - skip;
+    for (int i = 0; i < 4; i++) header[4 + i] = (uint8_t)(remaining >> (8 * i));
+
+    // 2) Stream old file then current file
+    link->setBulkMode(true);
+    int64_t t0 = esp_timer_get_time();
+    uint32_t sent = 0;
+    bool ok = channel->write(header, sizeof(header)) &&
+              sendFile(TRACK_OLD_PATH, oldSize, skip, sent) &&
+              sendFile(TRACK_LOG_PATH, curSize, skip, sent);
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+    link->setBulkMode(false);
+    log->endRead();
+
+    // 3) Report
+    if (!ok) {
+        failures++;
+        Serial.printf("→ Track download aborted after %lu bytes\n", (unsigned long)sent);
+        return;
+    }
+    transfers++;
+    lastBytes = sent;
+    lastMs = ms;
+    Serial.printf("→ Track download %lu bytes in %lums (%lu B/s, %lu ms/MB)\n",
+                  (unsigned long)sent, (unsigned long)ms, (unsigned long)lastRate(),
+                  (unsigned long)lastMsPerMB());
+}
+
+inline uint32_t BleTrackTransfer::fileSize(const char* path) {
+    if (!LittleFS.exists(path)) {
+        return 0;
+    }
+    File f = LittleFS.open(path, FILE_READ);
+    uint32_t size = f ? f.size() : 0;
+    f.close();
+    return size;
+}
+
+inline bool BleTrackTransfer::sendFile(const char* path, uint32_t size, uint32_t& skip, uint32_t& sent) {
+    if (skip >= size) {
+        skip -= size;
+        return true;
+    }
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) {
+        return false;
+    }
+    f.seek(skip);
+    uint32_t left = size - skip;
+    skip = 0;
+
+    bool ok = true;
+    while (left > 0) {
+        uint16_t sdu = mtu;
+        if (sdu == 0) {
+            ok = false;    // Channel closed
+            break;
+        }
+        if (sdu > sizeof(chunk)) sdu = sizeof(chunk);
+        size_t n = f.read(chunk, left < sdu ? left : sdu);
+        if (n == 0 || !channel->write(chunk, n)) {
+            ok = false;
+            break;
+        }
+        left -= n;
+        sent += n;
+    }
+    f.close();
+    return ok;
+}
+
+#endif // BLETRACK_H
@@ -0,0 +1,451 @@
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "routeframe.h"
+#include "routestore.h"
+
+// Keep-in / keep-out zones checked on every fix.
+// Zones come from ZONE_PATH (uploaded like a route, see routeframe.h) and
+// are held in RAM in a flat frame of their own: decimetres east and north
+// of the zone's first point, so every test after the conversion is integer
+// arithmetic. Each polygon's edges are sorted into ZONE_SLABS horizontal
+// bands; a point only meets the edges of its own band when it counts
+// crossings, and only those of the bands within ZONE_HYSTERESIS_M when it
+// measures how far the edge is.
+// A zone changes state only once the fix is ZONE_HYSTERESIS_M past its
+// edge, so GNSS wander along a boundary does not chatter. Zones start in
+// their allowed state (inside a keep-in, outside a keep-out), so the first
+// fix already reports a violation.
+// update() only looks at the zones whose box lies within ZONE_NEAR_M of
+// where the near list was last built, and rebuilds it after moving half
+// that, so most fixes cost a few zones however many are loaded.
+// Events are appended to ZONE_LOG_PATH, 16 bytes each:
+//   uint32 uptime seconds, int32 lat, int32 lon (1e-7 degrees),
+//   uint8 zone index, uint8 ZONE_ENTER / ZONE_EXIT, uint8 rule, uint8 0.
+
+#define ZONE_LOG_PATH        "/zones.log"
+#define ZONE_LOG_OLD_PATH    "/zones.old"
+#define ZONE_LOG_MAX_BYTES   (16UL * 1024UL)
+#define ZONE_LOG_RECORD      16
+#define ZONE_MAX_ZONES       16
+#define ZONE_MAX_VERTICES    512       // Over all polygons
+#define ZONE_SLABS           16        // Edge bands per polygon
+#define ZONE_SLAB_ENTRIES    1024      // Edge entries over all bands
+#define ZONE_UNITS_PER_M     10
+#define ZONE_MAX_SPAN_M      200000    // Widest zone: keeps the frame flat and products in int64
+#define ZONE_HYSTERESIS_M    15
+#define ZONE_NEAR_M          1000
+#define ZONE_M_PER_E7        0.011119493   // Metres per 1e-7 degree of latitude
+
+enum ZoneEventType : uint8_t {
+    ZONE_ENTER = 1,
+    ZONE_EXIT = 2,
+};
+
+struct ZoneEvent {
+    uint8_t zone;
+    uint8_t type;                      // ZoneEventType
+    bool violation;                    // Entered a keep-out or left a keep-in
+    int32_t latE7, lonE7;
+};
+
+struct Zone {
+    char name[ROUTE_NAME_LEN];
+    uint8_t shape;                     // ZONE_SHAPE_*
+    uint8_t rule;                      // ZONE_RULE_*
+    bool inside;                       // State after hysteresis
+    int32_t latE7, lonE7;              // Frame origin: the centre or first vertex
+    int32_t kx, ky;                    // Decimetres per 1e-7 degree, Q24
+    int32_t x0, y0, x1, y1;            // Bounding box, decimetres
+    int32_t radius;                    // Circles, decimetres
+    uint16_t first, count;             // Polygon vertices in verts[]
+    uint16_t slabs;                    // Polygon band offsets in slabStart[]
+    int32_t slabH;                     // Band height, decimetres
+};
+
+class Geofence {
+private:
+    Zone zones[ZONE_MAX_ZONES];
+    uint8_t zoneCount;
+    int32_t vx[ZONE_MAX_VERTICES], vy[ZONE_MAX_VERTICES];
+    uint16_t vertCount;
+    uint16_t slabStart[ZONE_MAX_ZONES * (ZONE_SLABS + 1)];
+    uint16_t slabEdges[ZONE_SLAB_ENTRIES];     // Edge i runs from vertex i to i + 1 of its polygon
+    uint16_t slabUsed;
+
+    uint8_t nearList[ZONE_MAX_ZONES];
+    uint8_t nearCount;
+    bool haveNear;
+    int32_t nearLatE7, nearLonE7;      // Where the near list was built
+
+    static int32_t wrapLonE7(int64_t d) {
+        if (d > 1800000000LL) d -= 3600000000LL;
+        if (d < -1800000000LL) d += 3600000000LL;
+        return (int32_t)d;
+    }
+    static int64_t segDist2(int32_t px, int32_t py, int32_t ax, int32_t ay, int32_t bx, int32_t by);
+
+    void toLocal(const Zone& z, int32_t latE7, int32_t lonE7, int32_t& x, int32_t& y) const {
+        x = (int32_t)(((int64_t)wrapLonE7((int64_t)lonE7 - z.lonE7) * z.kx) >> 24);
+        y = (int32_t)(((int64_t)latE7 - z.latE7) * z.ky >> 24);
+    }
+    int32_t band(const Zone& z, int32_t y) const {
+        int32_t b = (y - z.y0) / z.slabH;
+        return b < 0 ? 0 : (b >= ZONE_SLABS ? ZONE_SLABS - 1 : b);
+    }
+    bool addZone(const ZoneHeader& h, RouteStore& file, uint32_t at);
+    bool indexEdges(Zone& z);
+    bool contains(const Zone& z, int32_t x, int32_t y);
+    int64_t edgeDist2(const Zone& z, int32_t x, int32_t y, int32_t reach, int64_t enough);
+    bool evaluate(uint8_t i, int32_t x, int32_t y);
+    void emit(uint8_t i, int32_t latE7, int32_t lonE7, ZoneEvent* events, uint8_t& n, uint8_t max);
+
+public:
+    uint32_t fixes;                    // update() calls
+    uint32_t zoneTests;                // Zones evaluated by them
+    uint32_t edgeTests;                // Polygon edges looked at by them
+    uint32_t rebuilds;                 // Near list rebuilds
+
+    Geofence() : zoneCount(0), vertCount(0), slabUsed(0), nearCount(0), haveNear(false), nearLatE7(0),
+                 nearLonE7(0), fixes(0), zoneTests(0), edgeTests(0), rebuilds(0) {}
+
+    // (Re)read ZONE_PATH; LittleFS must be mounted. Returns the zones kept
+    uint8_t load();
+
+    // Evaluate a fix; fills events (up to max) and returns how many.
+    // A zone flips at most once per fix, so max = ZONE_MAX_ZONES loses none;
+    // with less, the flips past max go unreported
+    uint8_t update(double lat, double lon, ZoneEvent* events, uint8_t max);
+
+    // Append an event to ZONE_LOG_PATH
+    void logEvent(const ZoneEvent& e, uint32_t uptimeSec);
+
+    uint8_t count() const { return zoneCount; }
+    const Zone& zone(uint8_t i) const { return zones[i]; }
+    bool isViolated(uint8_t i) const {
+        return zones[i].rule == ZONE_RULE_KEEP_OUT ? zones[i].inside : !zones[i].inside;
+    }
+
+    // Distance and bearing to the nearest point of a zone's edge (the way out
+    // of a keep-out, back into a keep-in); measures every edge
+    bool nearestEdge(uint8_t i, double lat, double lon, float& distM, float& bearingDeg) const;
+};
+
+inline int64_t Geofence::segDist2(int32_t px, int32_t py, int32_t ax, int32_t ay, int32_t bx, int32_t by) {
+    int64_t abx = (int64_t)bx - ax, aby = (int64_t)by - ay;
+    int64_t apx = (int64_t)px - ax, apy = (int64_t)py - ay;
+    int64_t len2 = abx * abx + aby * aby;
+    int64_t t = apx * abx + apy * aby;
+    if (len2 == 0 || t <= 0) return apx * apx + apy * apy;
+    if (t >= len2) {
+        int64_t bpx = (int64_t)px - bx, bpy = (int64_t)py - by;
+        return bpx * bpx + bpy * bpy;
+    }
+    // Perpendicular distance: cross² / len², in float to stay clear of overflow
+    float cross = (float)(apx * aby - apy * abx);
+    return (int64_t)(cross * cross / (float)len2);
+}
+
+inline uint8_t Geofence::load() {
+    zoneCount = 0;
+    vertCount = 0;
+    slabUsed = 0;
+    nearCount = 0;
+    haveNear = false;
+    RouteStore file(ZONE_PATH);
+    uint32_t records = file.load();
+
+    // 1) Header, then its points; a zone that does not fit is skipped, not the file
+    uint32_t at = 0;
+    RoutePoint rec;
+    while (at < records && file.get(at, rec)) {
+        ZoneHeader h;
+        zoneHeaderFromPoint(rec, h);
+        at++;
+        if (h.points == 0 || at + h.points > records) {
+            Serial.printf("→ Zone %u: bad point count, rest of file ignored\n", zoneCount);
+            break;
+        }
+        if (!addZone(h, file, at)) {
+            Serial.printf("→ Zone '%s' skipped (shape, size or no room)\n", h.name);
+        }
+        at += h.points;
+    }
+    return zoneCount;
+}
+
+inline bool Geofence::addZone(const ZoneHeader& h, RouteStore& file, uint32_t at) {
+    bool circle = h.shape == ZONE_SHAPE_CIRCLE && h.points == 1 && h.radiusM > 0 && h.radiusM <= ZONE_MAX_SPAN_M / 2;
+    bool polygon = h.shape == ZONE_SHAPE_POLYGON && h.points >= 3 && vertCount + h.points <= ZONE_MAX_VERTICES;
+    if (zoneCount >= ZONE_MAX_ZONES || (!circle && !polygon) ||
+        (h.rule != ZONE_RULE_KEEP_IN && h.rule != ZONE_RULE_KEEP_OUT)) {
+        return false;
+    }
+
+    // 1) Frame around the first point
+    Zone& z = zones[zoneCount];
+    RoutePoint pt;
+    if (!file.get(at, pt)) return false;
+    memcpy(z.name, h.name, sizeof(z.name));
+    z.shape = h.shape;
+    z.rule = h.rule;
+    z.inside = h.rule == ZONE_RULE_KEEP_IN;
+    z.latE7 = pt.latE7;
+    z.lonE7 = pt.lonE7;
+    double q = ZONE_M_PER_E7 * ZONE_UNITS_PER_M * 16777216.0;
+    z.ky = (int32_t)lround(q);
+    z.kx = (int32_t)lround(q * cos(pt.latE7 / 1e7 * PI / 180.0));
+    z.first = vertCount;
+    z.count = 0;
+    if (circle) {
+        z.radius = (int32_t)h.radiusM * ZONE_UNITS_PER_M;
+        z.x0 = z.y0 = -z.radius;
+        z.x1 = z.y1 = z.radius;
+        zoneCount++;
+        return true;
+    }
+
+    // 2) Polygon vertices and their box
+    z.x0 = z.y0 = INT32_MAX;
+    z.x1 = z.y1 = INT32_MIN;
+    const int32_t span = ZONE_MAX_SPAN_M * ZONE_UNITS_PER_M;
+    for (uint16_t k = 0; k < h.points; k++) {
+        if (!file.get(at + k, pt)) return false;
+        int32_t x, y;
+        toLocal(z, pt.latE7, pt.lonE7, x, y);
+        if (x < -span || x > span || y < -span || y > span) return false;
+        vx[vertCount + k] = x;
+        vy[vertCount + k] = y;
+        z.x0 = min(z.x0, x);
+        z.x1 = max(z.x1, x);
+        z.y0 = min(z.y0, y);
+        z.y1 = max(z.y1, y);
+    }
+    z.count = h.points;
+    if (z.x1 - z.x0 > span || z.y1 - z.y0 > span || !indexEdges(z)) return false;
+    vertCount += z.count;
+    zoneCount++;
+    return true;
+}
+
+inline bool Geofence::indexEdges(Zone& z) {
+    // Counting pass, prefix sums, then the edges into their bands
+    z.slabs = zoneCount * (ZONE_SLABS + 1);
+    z.slabH = (z.y1 - z.y0) / ZONE_SLABS + 1;
+    uint16_t* start = slabStart + z.slabs;
+    uint16_t fill[ZONE_SLABS + 1];
+    memset(fill, 0, sizeof(fill));
+    for (uint16_t e = 0; e < z.count; e++) {
+        uint16_t a = z.first + e, b = z.first + (e + 1) % z.count;
+        int32_t b0 = band(z, min(vy[a], vy[b])), b1 = band(z, max(vy[a], vy[b]));
+        for (int32_t s = b0; s <= b1; s++) fill[s + 1]++;
+    }
+    start[0] = slabUsed;
+    for (uint8_t s = 0; s < ZONE_SLABS; s++) {
+        start[s + 1] = start[s] + fill[s + 1];
+    }
+    if (start[ZONE_SLABS] > ZONE_SLAB_ENTRIES) return false;
+    memcpy(fill, start, sizeof(fill));
+    for (uint16_t e = 0; e < z.count; e++) {
+        uint16_t a = z.first + e, b = z.first + (e + 1) % z.count;
+        int32_t b0 = band(z, min(vy[a], vy[b])), b1 = band(z, max(vy[a], vy[b]));
+        for (int32_t s = b0; s <= b1; s++) slabEdges[fill[s]++] = e;
+    }
+    slabUsed = start[ZONE_SLABS];
+    return true;
+}
+
+inline bool Geofence::contains(const Zone& z, int32_t x, int32_t y) {
+    if (y < z.y0 || y > z.y1 || x < z.x0 || x > z.x1) return false;
+
+    // Crossings of a ray towards +x, counted over the edges of this band only
+    const uint16_t* start = slabStart + z.slabs;
+    int32_t s = band(z, y);
+    bool in = false;
+    for (uint16_t k = start[s]; k < start[s + 1]; k++) {
+        uint16_t e = slabEdges[k];
+        uint16_t a = z.first + e, b = z.first + (e + 1) % z.count;
+        edgeTests++;
+        if ((vy[a] > y) == (vy[b] > y)) continue;
+        // x < ax + (bx - ax)(y - ay) / (by - ay), without the division
+        int64_t lhs = ((int64_t)x - vx[a]) * ((int64_t)vy[b] - vy[a]);
+        int64_t rhs = ((int64_t)vx[b] - vx[a]) * ((int64_t)y - vy[a]);
+        if (vy[b] > vy[a] ? lhs < rhs : lhs > rhs) in = !in;
+    }
+    return in;
+}
+
+inline int64_t Geofence::edgeDist2(const Zone& z, int32_t x, int32_t y, int32_t reach, int64_t enough) {
+    // Only bands within reach of y can hold an edge nearer than reach
+    const uint16_t* start = slabStart + z.slabs;
+    int64_t best = INT64_MAX;
+    int32_t s1 = band(z, y + reach);
+    for (int32_t s = band(z, y - reach); s <= s1; s++) {
+        for (uint16_t k = start[s]; k < start[s + 1]; k++) {
+            uint16_t e = slabEdges[k];
+            uint16_t a = z.first + e, b = z.first + (e + 1) % z.count;
+            edgeTests++;
+            int64_t d = segDist2(x, y, vx[a], vy[a], vx[b], vy[b]);
+            if (d < best) {
+                best = d;
+                if (best < enough) return best;
+            }
+        }
+    }
+    return best;
+}
+
+inline bool Geofence::evaluate(uint8_t i, int32_t x, int32_t y) {
+    Zone& z = zones[i];
+    const int32_t h = ZONE_HYSTERESIS_M * ZONE_UNITS_PER_M;
+    const int64_t h2 = (int64_t)h * h;
+    zoneTests++;
+    bool flip;
+    if (z.shape == ZONE_SHAPE_CIRCLE) {
+        // Radius plus or minus the hysteresis, compared squared
+        int64_t d2 = (int64_t)x * x + (int64_t)y * y;
+        int64_t out = (int64_t)(z.radius + h) * (z.radius + h);
+        int64_t in = z.radius > h ? (int64_t)(z.radius - h) * (z.radius - h) : -1;
+        flip = z.inside ? d2 > out : d2 < in;
+    } else if (x < z.x0 - h || x > z.x1 + h || y < z.y0 - h || y > z.y1 + h) {
+        flip = z.inside;               // Well clear of the box: outside
+    } else {
+        // The edge must be the hysteresis behind us too
+        flip = contains(z, x, y) != z.inside && edgeDist2(z, x, y, h, h2) >= h2;
+    }
+    if (flip) {
+        z.inside = !z.inside;
+    }
+    return flip;
+}
+
+inline void Geofence::emit(uint8_t i, int32_t latE7, int32_t lonE7, ZoneEvent* events, uint8_t& n, uint8_t max) {
+    if (n >= max) return;
+    ZoneEvent& e = events[n++];
+    e.zone = i;
+    e.type = zones[i].inside ? ZONE_ENTER : ZONE_EXIT;
+    e.violation = isViolated(i);
+    e.latE7 = latE7;
+    e.lonE7 = lonE7;
+}
+
+inline uint8_t Geofence::update(double lat, double lon, ZoneEvent* events, uint8_t max) {
+    uint8_t n = 0;
+    if (zoneCount == 0) {
+        return 0;
+    }
+    fixes++;
+    int32_t latE7 = (int32_t)lround(lat * 1e7);
+    int32_t lonE7 = (int32_t)lround(lon * 1e7);
+
+    // 1) Rebuild the near list after moving half its margin; zones left out
+    //    of it are more than ZONE_NEAR_M / 2 away, so outside
+    bool rebuild = !haveNear;
+    if (!rebuild) {
+        float dy = (float)((latE7 - nearLatE7) * ZONE_M_PER_E7);
+        float dx = (float)(wrapLonE7((int64_t)lonE7 - nearLonE7) * ZONE_M_PER_E7) * cosf(lat * PI / 180.0);
+        rebuild = dx * dx + dy * dy > (ZONE_NEAR_M / 2.0f) * (ZONE_NEAR_M / 2.0f);
+    }
+    if (rebuild) {
+        const int64_t reach = (int64_t)ZONE_NEAR_M * ZONE_UNITS_PER_M;
+        nearCount = 0;
+        for (uint8_t i = 0; i < zoneCount; i++) {
+            Zone& z = zones[i];
+            int32_t x, y;
+            toLocal(z, latE7, lonE7, x, y);
+            int64_t dx = x < z.x0 ? (int64_t)z.x0 - x : (x > z.x1 ? (int64_t)x - z.x1 : 0);
+            int64_t dy = y < z.y0 ? (int64_t)z.y0 - y : (y > z.y1 ? (int64_t)y - z.y1 : 0);
+            if (dx * dx + dy * dy <= reach * reach) {
+                nearList[nearCount++] = i;
+            } else if (z.inside) {
+                z.inside = false;
+                emit(i, latE7, lonE7, events, n, max);
+            }
+        }
+        nearLatE7 = latE7;
+        nearLonE7 = lonE7;
+        haveNear = true;
+        rebuilds++;
+    }
+
+    // 2) The zones nearby, in their own frames
+    for (uint8_t k = 0; k < nearCount; k++) {
+        int32_t x, y;
+        toLocal(zones[nearList[k]], latE7, lonE7, x, y);
+        if (evaluate(nearList[k], x, y)) {
+            emit(nearList[k], latE7, lonE7, events, n, max);
+        }
+    }
+    return n;
+}
+
+inline bool Geofence::nearestEdge(uint8_t i, double lat, double lon, float& distM, float& bearingDeg) const {
+    if (i >= zoneCount) {
+        return false;
+    }
+    const Zone& z = zones[i];
+    int32_t x, y;
+    toLocal(z, (int32_t)lround(lat * 1e7), (int32_t)lround(lon * 1e7), x, y);
+
+    // 1) Nearest point of the edge, as an offset from the position
+    float ex = 0.0f, ey = 0.0f;
+    if (z.shape == ZONE_SHAPE_CIRCLE) {
+        float d = sqrtf((float)x * x + (float)y * y);
+        float k = d > 0.0f ? z.radius / d - 1.0f : 0.0f;
+        ex = x * k;
+        ey = y * k;
+        if (d == 0.0f) ey = (float)z.radius;
+    } else {
+        float best = -1.0f;
+        for (uint16_t e = 0; e < z.count; e++) {
+            uint16_t a = z.first + e, b = z.first + (e + 1) % z.count;
+            float abx = (float)(vx[b] - vx[a]), aby = (float)(vy[b] - vy[a]);
+            float len2 = abx * abx + aby * aby;
+            float t = len2 > 0.0f ? ((float)(x - vx[a]) * abx + (float)(y - vy[a]) * aby) / len2 : 0.0f;
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+            float dx = vx[a] + t * abx - x, dy = vy[a] + t * aby - y;
+            float d2 = dx * dx + dy * dy;
+            if (best < 0.0f || d2 < best) {
+                best = d2;
+                ex = dx;
+                ey = dy;
+            }
+        }
+    }
+
+    // 2) Metres, and the bearing of that point
+    distM = sqrtf(ex * ex + ey * ey) / ZONE_UNITS_PER_M;
+    bearingDeg = atan2f(ex, ey) * 180.0f / (float)PI;
+    if (bearingDeg < 0.0f) bearingDeg += 360.0f;
+    return true;
+}
+
+inline void Geofence::logEvent(const ZoneEvent& e, uint32_t uptimeSec) {
+    // 1) Keep one old file, as the track log does
+    File f = LittleFS.open(ZONE_LOG_PATH, FILE_APPEND);
+    if (f && f.size() + ZONE_LOG_RECORD > ZONE_LOG_MAX_BYTES) {
+        f.close();
+        LittleFS.remove(ZONE_LOG_OLD_PATH);
+        LittleFS.rename(ZONE_LOG_PATH, ZONE_LOG_OLD_PATH);
+        f = LittleFS.open(ZONE_LOG_PATH, FILE_APPEND);
+    }
+    if (!f) {
+        return;
+    }
+
+    // 2) One fixed-size record
+    uint8_t rec[ZONE_LOG_RECORD];
+    memset(rec, 0, sizeof(rec));
+    routePut32(rec, uptimeSec);
+    routePut32(rec + 4, (uint32_t)e.latE7);
+    routePut32(rec + 8, (uint32_t)e.lonE7);
+    rec[12] = e.zone;
+    rec[13] = e.type;
+    rec[14] = zones[e.zone].rule;
+    f.write(rec, sizeof(rec));
+    f.close();
+}
+
+#endif // GEOFENCE_H
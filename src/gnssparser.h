@@ -0,0 +1,603 @@
+#ifndef GNSSPARSER_H
+#define GNSSPARSER_H
+
+#include <Arduino.h>
+#include <limits.h>
+
+// Streaming NMEA 0183 parser with the TinyGPSPlus interface (encode() one
+// character at a time, location/date/time/speed/course/altitude/satellites/
+// hdop with isValid()/isUpdated()/age(), custom fields), extended for a
+// multi-constellation receiver:
+//  - every talker (GP, GL, GA, GB/BD, GQ/QZ, GI, GN) and GGA, RMC, VTG, GSA
+//    and GSV, with satellites in view per system and the GSA fix mode and
+//    DOPs
+//  - the address field is identified by packing its characters into
+//    integers while they arrive and switching on them, never by strcmp
+//  - custom fields live in a fixed table sorted by (sentence hash, term);
+//    a sentence finds its range once, then each term is one compare against
+//    a cursor, since terms arrive in ascending order
+//  - numbers are converted in place without atol()/atof(), and nothing is
+//    allocated
+// Values are staged while a sentence streams in and committed only when its
+// checksum matches, so a corrupted or cut-off sentence changes nothing.
+
+#define GNSS_MAX_TERM       16      // Longest term kept, including the NUL
+#define GNSS_MAX_CUSTOM     16
+#define GNSS_KMPH_PER_KNOT  1.852
+#define GNSS_MPS_PER_KNOT   0.51444444
+
+enum GnssSystem : uint8_t {
+    GNSS_GPS,
+    GNSS_GLONASS,
+    GNSS_GALILEO,
+    GNSS_BEIDOU,
+    GNSS_QZSS,
+    GNSS_NAVIC,
+    GNSS_SYSTEMS,
+    GNSS_MULTI = GNSS_SYSTEMS,      // GN talker
+    GNSS_OTHER
+};
+
+struct GnssRawDegrees {
+    uint16_t deg;
+    uint32_t billionths;
+    bool negative;
+};
+
+class GnssValue {
+protected:
+    bool valid, updated;
+    uint32_t lastCommitTime;
+    void stamp() {
+        lastCommitTime = millis();
+        valid = updated = true;
+    }
+
+public:
+    GnssValue() : valid(false), updated(false), lastCommitTime(0) {}
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
+};
+
+// Fixed point, hundredths (like TinyGPSDecimal)
+class GnssDecimal : public GnssValue {
+private:
+    friend class GnssParser;
+    int32_t val, newval;
+    void commit() { val = newval; stamp(); }
+
+public:
+    GnssDecimal() : val(0), newval(0) {}
+    int32_t value() { updated = false; return val; }
+};
+
+class GnssInteger : public GnssValue {
+private:
+    friend class GnssParser;
+    uint32_t val, newval;
+    void commit() { val = newval; stamp(); }
+
+public:
+    GnssInteger() : val(0), newval(0) {}
+    uint32_t value() { updated = false; return val; }
+};
+
+class GnssSpeed : public GnssDecimal {
+public:
+    double knots() { return value() / 100.0; }
+    double kmph() { return GNSS_KMPH_PER_KNOT * value() / 100.0; }
+    double mps() { return GNSS_MPS_PER_KNOT * value() / 100.0; }
+};
+
+class GnssCourse : public GnssDecimal {
+public:
+    double deg() { return value() / 100.0; }
+};
+
+class GnssAltitude : public GnssDecimal {
+public:
+    double meters() { return value() / 100.0; }
+};
+
+class GnssDop : public GnssDecimal {
+public:
+    double hdop() { return value() / 100.0; }
+    double dop() { return value() / 100.0; }
+};
+
+class GnssLocation : public GnssValue {
+private:
+    friend class GnssParser;
+    GnssRawDegrees latData, lngData, newLat, newLng;
+    void commit() {
+        latData = newLat;
+        lngData = newLng;
+        stamp();
+    }
+
+public:
+    GnssLocation() { memset(&latData, 0, sizeof(latData)); lngData = newLat = newLng = latData; }
+    const GnssRawDegrees& rawLat() { updated = false; return latData; }
+    const GnssRawDegrees& rawLng() { updated = false; return lngData; }
+    double lat() {
+        updated = false;
+        double v = latData.deg + latData.billionths / 1000000000.0;
+        return latData.negative ? -v : v;
+    }
+    double lng() {
+        updated = false;
+        double v = lngData.deg + lngData.billionths / 1000000000.0;
+        return lngData.negative ? -v : v;
+    }
+};
+
+// ddmmyy
+class GnssDate : public GnssValue {
+private:
+    friend class GnssParser;
+    uint32_t date, newDate;
+    void commit() { date = newDate; stamp(); }
+
+public:
+    GnssDate() : date(0), newDate(0) {}
+    uint32_t value() { updated = false; return date; }
+    uint16_t year() { updated = false; return 2000 + date % 100; }
+    uint8_t month() { updated = false; return (date / 100) % 100; }
+    uint8_t day() { updated = false; return date / 10000; }
+};
+
+// hhmmsscc
+class GnssTime : public GnssValue {
+private:
+    friend class GnssParser;
+    uint32_t time, newTime;
+    void commit() { time = newTime; stamp(); }
+
+public:
+    GnssTime() : time(0), newTime(0) {}
+    uint32_t value() { updated = false; return time; }
+    uint8_t hour() { updated = false; return time / 1000000; }
+    uint8_t minute() { updated = false; return (time / 10000) % 100; }
+    uint8_t second() { updated = false; return (time / 100) % 100; }
+    uint8_t centisecond() { updated = false; return time % 100; }
+};
+
+class GnssParser;
+
+// One raw term of any sentence, e.g. GnssCustom pdop(gps, "GNGSA", 15)
+class GnssCustom : public GnssValue {
+private:
+    friend class GnssParser;
+    char staging[GNSS_MAX_TERM];
+    char buffer[GNSS_MAX_TERM];
+    void commit() {
+        memcpy(buffer, staging, sizeof(buffer));
+        stamp();
+    }
+
+public:
+    GnssCustom() { staging[0] = buffer[0] = '\0'; }
+    GnssCustom(GnssParser& gps, const char* sentenceName, int termNumber);
+    bool begin(GnssParser& gps, const char* sentenceName, int termNumber);
+    const char* value() { updated = false; return buffer; }
+};
+
+class GnssParser {
+private:
+    enum {
+        SENTENCE_OTHER,
+        SENTENCE_GGA,
+        SENTENCE_RMC,
+        SENTENCE_VTG,
+        SENTENCE_GSA,
+        SENTENCE_GSV
+    };
+
+    struct CustomSlot {
+        uint32_t hash;
+        uint8_t term;
+        GnssCustom* elt;
+    };
+
+    // 1) Parsing state
+    char term[GNSS_MAX_TERM];
+    uint8_t termLen;
+    uint8_t termNumber;
+    uint8_t parity;
+    bool inSentence;
+    bool checksumTerm;
+    uint8_t sentenceType;
+    uint8_t system;             // GnssSystem of the talker
+    uint32_t addressHash;       // FNV-1a of the address field
+    bool sentenceHasFix;
+    uint8_t haveLatLon;         // Bit 0 latitude, bit 1 longitude seen
+    uint8_t newFixQuality, newFixMode;
+    uint8_t newInView;
+
+    // 2) Custom fields, sorted by (hash, term)
+    CustomSlot customs[GNSS_MAX_CUSTOM];
+    uint8_t customCount;
+    uint8_t customFirst, customCursor, customEnd;
+
+    // 3) Statistics
+    uint32_t encodedCharCount;
+    uint32_t sentencesWithFixCount;
+    uint32_t failedChecksumCount;
+    uint32_t passedChecksumCount;
+
+    static uint32_t fnv1a(uint32_t h, char c) { return (h ^ (uint8_t)c) * 16777619u; }
+    static uint32_t hashName(const char* s) {
+        uint32_t h = 2166136261u;
+        while (*s) h = fnv1a(h, *s++);
+        return h;
+    }
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    static uint32_t parseUnsigned(const char* t) {
+        uint32_t v = 0;
+        while (isDigit(*t)) v = v * 10 + (uint32_t)(*t++ - '0');
+        return v;
+    }
+
+    void identify();
+    bool endOfTerm();
+    void sentenceTerm();
+    void commitSentence();
+
+public:
+    GnssLocation location;
+    GnssDate date;
+    GnssTime time;
+    GnssSpeed speed;
+    GnssCourse course;
+    GnssAltitude altitude;
+    GnssInteger satellites;             // Used in the fix (GGA)
+    GnssDop hdop;                       // GGA
+    GnssInteger fixQuality;             // GGA: 0 invalid, 1 GPS, 2 DGPS, 4/5 RTK, 6 dead reckoning
+    GnssInteger fixMode;                // GSA: 1 none, 2 2D, 3 3D
+    GnssDop pdop, vdop;                 // GSA
+    GnssInteger satsInView[GNSS_SYSTEMS];  // GSV, per talker
+
+    GnssParser() : GnssParser(0) {}
+
+    // Forget everything except the registered custom fields
+    void reset() {
+        GnssParser fresh(0);
+        memcpy(fresh.customs, customs, sizeof(customs));
+        fresh.customCount = customCount;
+        *this = fresh;
+    }
+
+    bool encode(char c);
+    GnssParser& operator<<(char c) { encode(c); return *this; }
+
+    uint32_t charsProcessed() const { return encodedCharCount; }
+    uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
+    uint32_t failedChecksum() const { return failedChecksumCount; }
+    uint32_t passedChecksum() const { return passedChecksumCount; }
+
+    // Sum of the per-system GSV counts
+    uint16_t totalInView() const {
+        uint16_t n = 0;
+        for (uint8_t s = 0; s < GNSS_SYSTEMS; s++) n += satsInView[s].val;
+        return n;
+    }
+
+    // Hundredths, -xxxx.yy (like TinyGPSPlus::parseDecimal)
+    static int32_t parseDecimal(const char* t) {
+        bool negative = *t == '-';
+        if (negative) t++;
+        int32_t v = 100 * (int32_t)parseUnsigned(t);
+        while (isDigit(*t)) t++;
+        if (*t == '.' && isDigit(t[1])) {
+            v += 10 * (t[1] - '0');
+            if (isDigit(t[2])) v += t[2] - '0';
+        }
+        return negative ? -v : v;
+    }
+
+    // NMEA (d)ddmm.mmmm into degrees and billionths, exactly as TinyGPSPlus
+    static void parseDegrees(const char* t, GnssRawDegrees& deg) {
+        uint32_t left = parseUnsigned(t);
+        uint32_t multiplier = 10000000UL;
+        uint32_t tenMillionthsOfMinutes = (left % 100) * multiplier;
+        deg.deg = (uint16_t)(left / 100);
+        while (isDigit(*t)) t++;
+        if (*t == '.') {
+            while (isDigit(*++t)) {
+                multiplier /= 10;
+                tenMillionthsOfMinutes += (uint32_t)(*t - '0') * multiplier;
+            }
+        }
+        deg.billionths = (5 * tenMillionthsOfMinutes + 1) / 3;
+        deg.negative = false;
+    }
+
+private:
+    friend class GnssCustom;
+    explicit GnssParser(int)
+        : termLen(0), termNumber(0), parity(0), inSentence(false), checksumTerm(false),
+          sentenceType(SENTENCE_OTHER), system(GNSS_OTHER), addressHash(0), sentenceHasFix(false),
+          haveLatLon(0), newFixQuality(0), newFixMode(0), newInView(0), customCount(0), customFirst(0),
+          customCursor(0), customEnd(0), encodedCharCount(0), sentencesWithFixCount(0),
+          failedChecksumCount(0), passedChecksumCount(0) {
+        term[0] = '\0';
+    }
+
+    bool insertCustom(GnssCustom* elt, const char* sentenceName, int termNumber);
+};
+
+inline GnssCustom::GnssCustom(GnssParser& gps, const char* sentenceName, int termNumber) {
+    staging[0] = buffer[0] = '\0';
+    begin(gps, sentenceName, termNumber);
+}
+
+inline bool GnssCustom::begin(GnssParser& gps, const char* sentenceName, int termNumber) {
+    staging[0] = buffer[0] = '\0';
+    valid = updated = false;
+    return gps.insertCustom(this, sentenceName, termNumber);
+}
+
+inline bool GnssParser::insertCustom(GnssCustom* elt, const char* sentenceName, int termNumber) {
+    if (customCount >= GNSS_MAX_CUSTOM || termNumber < 1 || termNumber > 255) return false;
+    CustomSlot slot = { hashName(sentenceName), (uint8_t)termNumber, elt };
+
+    // Insertion sort: registration is rare, lookups are per character
+    uint8_t i = customCount++;
+    while (i > 0 && (customs[i - 1].hash > slot.hash ||
+                     (customs[i - 1].hash == slot.hash && customs[i - 1].term > slot.term))) {
+        customs[i] = customs[i - 1];
+        i--;
+    }
+    customs[i] = slot;
+    return true;
+}
+
+inline bool GnssParser::encode(char c) {
+    encodedCharCount++;
+
+    switch (c) {
+    case '$':
+        inSentence = true;
+        termLen = termNumber = 0;
+        parity = 0;
+        checksumTerm = false;
+        sentenceType = SENTENCE_OTHER;
+        system = GNSS_OTHER;
+        addressHash = 2166136261u;
+        sentenceHasFix = false;
+        haveLatLon = 0;
+        newFixQuality = newFixMode = newInView = 0;
+        customFirst = customCursor = customEnd = 0;
+        return false;
+
+    case ',':
+        if (!inSentence) return false;
+        parity ^= (uint8_t)c;
+        return endOfTerm();
+
+    case '*':
+        if (!inSentence) return false;
+        endOfTerm();
+        checksumTerm = true;
+        return false;
+
+    case '\r':
+    case '\n': {
+        // A sentence cut short by CR/LF never reaches its checksum
+        if (!inSentence) return false;
+        bool ok = endOfTerm();
+        inSentence = false;
+        return ok;
+    }
+
+    default:
+        if (!inSentence) return false;
+        if (termLen < GNSS_MAX_TERM - 1) term[termLen++] = c;
+        if (!checksumTerm) {
+            parity ^= (uint8_t)c;
+            if (termNumber == 0) addressHash = fnv1a(addressHash, c);
+        }
+        return false;
+    }
+}
+
+// Sentence type and talker from the address field ("GNGGA", "GPGSV", ...)
+inline void GnssParser::identify() {
+    sentenceType = SENTENCE_OTHER;
+    if (termLen == 5) {
+        uint32_t type = (uint32_t)(uint8_t)term[2] << 16 | (uint32_t)(uint8_t)term[3] << 8 | (uint8_t)term[4];
+        switch (type) {
+        case 0x474741: sentenceType = SENTENCE_GGA; break;     // "GGA"
+        case 0x524D43: sentenceType = SENTENCE_RMC; break;     // "RMC"
+        case 0x565447: sentenceType = SENTENCE_VTG; break;     // "VTG"
+        case 0x475341: sentenceType = SENTENCE_GSA; break;     // "GSA"
+        case 0x475356: sentenceType = SENTENCE_GSV; break;     // "GSV"
+        }
+        switch ((uint16_t)((uint8_t)term[0] << 8 | (uint8_t)term[1])) {
+        case 0x4750: system = GNSS_GPS; break;                 // "GP"
+        case 0x474C: system = GNSS_GLONASS; break;             // "GL"
+        case 0x4741: system = GNSS_GALILEO; break;             // "GA"
+        case 0x4742:                                           // "GB"
+        case 0x4244: system = GNSS_BEIDOU; break;              // "BD"
+        case 0x4751:                                           // "GQ"
+        case 0x515A: system = GNSS_QZSS; break;                // "QZ"
+        case 0x4749: system = GNSS_NAVIC; break;               // "GI"
+        case 0x474E: system = GNSS_MULTI; break;               // "GN"
+        default: sentenceType = SENTENCE_OTHER; break;
+        }
+    }
+
+    // Custom fields of this sentence: binary search for the first slot
+    uint8_t lo = 0, hi = customCount;
+    while (lo < hi) {
+        uint8_t mid = (uint8_t)((lo + hi) / 2);
+        if (customs[mid].hash < addressHash) lo = (uint8_t)(mid + 1);
+        else hi = mid;
+    }
+    customFirst = customCursor = customEnd = lo;
+    while (customEnd < customCount && customs[customEnd].hash == addressHash) customEnd++;
+}
+
+// Called at every ',', '*', CR and LF; true when a sentence passed its checksum
+inline bool GnssParser::endOfTerm() {
+    term[termLen] = '\0';
+
+    if (checksumTerm) {
+        inSentence = false;
+        int hi = hexValue(term[0]), lo = termLen == 2 ? hexValue(term[1]) : -1;
+        if (hi < 0 || lo < 0 || (uint8_t)(hi << 4 | lo) != parity) {
+            failedChecksumCount++;
+            return false;
+        }
+        passedChecksumCount++;
+        if (sentenceHasFix && (sentenceType == SENTENCE_GGA || sentenceType == SENTENCE_RMC)) {
+            sentencesWithFixCount++;
+        }
+        commitSentence();
+        return true;
+    }
+
+    if (termNumber == 0) identify();
+    else {
+        if (sentenceType != SENTENCE_OTHER && termLen > 0) sentenceTerm();
+        while (customCursor < customEnd && customs[customCursor].term < termNumber) customCursor++;
+        if (customCursor < customEnd && customs[customCursor].term == termNumber) {
+            memcpy(customs[customCursor].elt->staging, term, termLen + 1);
+        }
+    }
+
+    termNumber++;
+    termLen = 0;
+    return false;
+}
+
+#define GNSS_TERM(type, n)  ((unsigned)(type) << 5 | (n))
+
+// Stage one non-empty term of a known sentence
+inline void GnssParser::sentenceTerm() {
+    if (termNumber > 31) return;
+    switch (GNSS_TERM(sentenceType, termNumber)) {
+    case GNSS_TERM(SENTENCE_GGA, 1):
+    case GNSS_TERM(SENTENCE_RMC, 1):
+        time.newTime = (uint32_t)parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_RMC, 2):                // A = valid, V = warning
+        sentenceHasFix = term[0] == 'A';
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 2):
+    case GNSS_TERM(SENTENCE_RMC, 3):
+        parseDegrees(term, location.newLat);
+        haveLatLon |= 1;
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 3):
+    case GNSS_TERM(SENTENCE_RMC, 4):
+        location.newLat.negative = term[0] == 'S';
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 4):
+    case GNSS_TERM(SENTENCE_RMC, 5):
+        parseDegrees(term, location.newLng);
+        haveLatLon |= 2;
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 5):
+    case GNSS_TERM(SENTENCE_RMC, 6):
+        location.newLng.negative = term[0] == 'W';
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 6):
+        newFixQuality = (uint8_t)parseUnsigned(term);
+        sentenceHasFix = newFixQuality > 0;
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 7):
+        satellites.newval = parseUnsigned(term);
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 8):
+        hdop.newval = parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_GGA, 9):
+        altitude.newval = parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_RMC, 7):                // Knots
+    case GNSS_TERM(SENTENCE_VTG, 5):
+        speed.newval = parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_RMC, 8):                // Degrees true
+    case GNSS_TERM(SENTENCE_VTG, 1):
+        course.newval = parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_RMC, 9):
+        date.newDate = parseUnsigned(term);
+        break;
+    case GNSS_TERM(SENTENCE_VTG, 9):                // Mode, N = not valid
+        sentenceHasFix = term[0] != 'N';
+        break;
+    case GNSS_TERM(SENTENCE_GSA, 2):
+        newFixMode = (uint8_t)parseUnsigned(term);
+        sentenceHasFix = newFixMode >= 2;
+        break;
+    case GNSS_TERM(SENTENCE_GSA, 15):
+        pdop.newval = parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_GSA, 17):
+        vdop.newval = parseDecimal(term);
+        break;
+    case GNSS_TERM(SENTENCE_GSV, 3):
+        newInView = (uint8_t)parseUnsigned(term);
+        break;
+    }
+}
+
+inline void GnssParser::commitSentence() {
+    switch (sentenceType) {
+    case SENTENCE_GGA:
+        time.commit();
+        fixQuality.newval = newFixQuality;
+        fixQuality.commit();
+        if (sentenceHasFix && haveLatLon == 3) {
+            location.commit();
+            altitude.commit();
+        }
+        satellites.commit();
+        hdop.commit();
+        break;
+    case SENTENCE_RMC:
+        time.commit();
+        date.commit();
+        if (sentenceHasFix && haveLatLon == 3) {
+            location.commit();
+            speed.commit();
+            course.commit();
+        }
+        break;
+    case SENTENCE_VTG:
+        if (sentenceHasFix) {
+            speed.commit();
+            course.commit();
+        }
+        break;
+    case SENTENCE_GSA:
+        fixMode.newval = newFixMode;
+        fixMode.commit();
+        if (sentenceHasFix) {
+            pdop.commit();
+            vdop.commit();
+        }
+        break;
+    case SENTENCE_GSV:
+        if (system < GNSS_SYSTEMS) {
+            satsInView[system].newval = newInView;
+            satsInView[system].commit();
+        }
+        break;
+    }
+
+    for (uint8_t i = customFirst; i < customEnd; i++) customs[i].elt->commit();
+}
+
+#endif // GNSSPARSER_H
@@ -0,0 +1,153 @@
+#ifndef LINKADAPT_H
+#define LINKADAPT_H
+
+#include <Arduino.h>
+#include "peertable.h"
+
+// LoRa link adaptation for the beacon group.
+// Rates form a ladder from fastest (index 0) to most robust. For every
+// fresh peer the adapter keeps an SNR average referred to 125 kHz and a
+// frame-loss average, and picks the fastest rate whose demodulation floor
+// plus LINK_MARGIN_DB10 stays below that SNR (one step slower if loss is
+// above target). The slowest rate any peer needs is what we ask for.
+//
+// LoRa only decodes frames sent at the rate it listens on, so the group has
+// to agree. Every keyframe carries the sender's request; each node runs at
+// the slowest rate requested by itself or any fresh peer, which converges
+// to the same choice everywhere. A node only acts on its own request once
+// that request has gone out in a keyframe. A node that hears nobody falls
+// back to the slowest rate, where it still catches the group's periodic
+// rendezvous keyframes (see LoRaBeacon).
+
+struct LoRaRate {
+    uint8_t sf;
+    uint8_t bw;                 // Radio API index: 0 = 125, 1 = 250, 2 = 500 kHz
+    int16_t snrFloor10;         // Demodulation floor, 0.1 dB referred to 125 kHz
+};
+
+// Floors are the SX126x datasheet values (-7.5 dB at SF7 down to -20 dB at
+// SF12); doubling the bandwidth costs 3 dB of SNR
+static const LoRaRate LINK_RATES[] = {
+    {  7, 1,  -45 },
+    {  7, 0,  -75 },
+    {  8, 0, -100 },
+    {  9, 0, -125 },
+    { 10, 0, -150 },
+    { 11, 0, -175 },
+    { 12, 0, -200 },
+};
+#define LINK_RATE_COUNT ((uint8_t)(sizeof(LINK_RATES) / sizeof(LINK_RATES[0])))
+#define LINK_RATE_NONE  0x0F    // "No request" on the wire
+
+#define LINK_MARGIN_DB10     30                    // Fade margin above the floor
+#define LINK_TARGET_LOSS_Q8  26                    // ~10 % frames missed
+#define LINK_FRESH_MS        (3UL * 60UL * 1000UL) // Peers older than this don't vote
+#define LINK_EVAL_MS         15000UL
+#define LINK_DOWN_VOTES      3                     // Evaluations in a row before speeding up
+
+class LinkAdapter {
+private:
+    uint8_t maxRate;            // Slowest rate the radio may use (dwell / SF cap)
+    uint8_t rate;               // Rate in use
+    uint8_t request;            // Rate we ask the group for
+    uint8_t downVotes;
+    uint32_t lastEval;
+
+    uint8_t requiredRate(const Peer& p) const;
+
+public:
+    uint32_t changes;
+
+    LinkAdapter() : maxRate(LINK_RATE_COUNT - 1), rate(LINK_RATE_COUNT - 1),
+                    request(LINK_RATE_COUNT - 1), downVotes(0), lastEval(0), changes(0) {}
+
+    void begin(uint8_t slowest) { maxRate = slowest; rate = slowest; request = slowest; }
+
+    // Fold one received frame into the peer's link history
+    void observe(Peer& p, int8_t snr) const;
+
+    // Re-plan at most every LINK_EVAL_MS; true if the rate in use changed.
+    // requestSent: our current request has already gone out in a keyframe
+    bool evaluate(const PeerTable& peers, uint32_t nowMs, bool requestSent);
+
+    uint8_t current() const { return rate; }
+    uint8_t requested() const { return request; }
+    uint8_t slowest() const { return maxRate; }
+};
+
+inline void LinkAdapter::observe(Peer& p, int8_t snr) const {
+    // Measured SNR is relative to the noise in the current bandwidth
+    int16_t snr125 = snr * 10 + 30 * LINK_RATES[rate].bw;
+    if (p.packets <= 1) {
+        p.snrAvg10 = snr125;
+    } else {
+        p.snrAvg10 += (snr125 - p.snrAvg10) / 4;
+    }
+}
+
+inline uint8_t LinkAdapter::requiredRate(const Peer& p) const {
+    uint8_t r = 0;
+    while (r < maxRate && LINK_RATES[r].snrFloor10 + LINK_MARGIN_DB10 > p.snrAvg10) {
+        r++;
+    }
+    if (p.lossQ8 > LINK_TARGET_LOSS_Q8 && r < maxRate) {
+        r++;
+    }
+    return r;
+}
+
+inline bool LinkAdapter::evaluate(const PeerTable& peers, uint32_t nowMs, bool requestSent) {
+    if (nowMs - lastEval < LINK_EVAL_MS) {
+        return false;
+    }
+    lastEval = nowMs;
+
+    // 1) Our own request: the slowest rate any fresh link needs
+    uint8_t own = 0;
+    uint8_t group = 0;
+    int fresh = 0;
+    for (int i = 0; i < peers.count(); i++) {
+        const Peer* p = peers.at(i);
+        if (!p || nowMs - p->lastSeenMs > LINK_FRESH_MS) continue;
+        fresh++;
+        uint8_t need = requiredRate(*p);
+        if (need > own) own = need;
+        if (p->fix.rateReq != LINK_RATE_NONE && p->fix.rateReq > group) {
+            group = p->fix.rateReq > maxRate ? maxRate : p->fix.rateReq;
+        }
+    }
+    request = fresh ? own : maxRate;
+
+    // 2) Target: slowest of every request, ours only once it has been heard.
+    //    Alone, go to the rendezvous rate.
+    uint8_t target;
+    if (!fresh) {
+        target = maxRate;
+    } else {
+        target = group;
+        if (requestSent && request > target) target = request;
+    }
+
+    // 3) Slow down at once, speed up one step after a few calm evaluations
+    uint8_t next = rate;
+    if (target > rate) {
+        next = target;
+        downVotes = 0;
+    } else if (target < rate) {
+        if (++downVotes >= LINK_DOWN_VOTES) {
+            next = rate - 1;
+            downVotes = 0;
+        }
+    } else {
+        downVotes = 0;
+    }
+
+    if (next == rate) {
+        return false;
+    }
+    rate = next;
+    changes++;
+    return true;
+}
+
+#endif // LINKADAPT_H
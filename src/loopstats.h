@@ -0,0 +1,201 @@
+#ifndef LOOPSTATS_H
+#define LOOPSTATS_H
+
+#include <Arduino.h>
+
+// Main-loop latency instrumentation.
+// Uses the CPU cycle counter (ESP.getCycleCount) so a measurement costs a
+// couple of instructions. Loop period and per-phase time feed fixed-bucket
+// histograms; any pass that stays busy longer than LOOP_STALL_US is counted
+// as a stall and tagged with the phase that consumed the most time.
+// The 32-bit counter wraps after ~17 s at 240 MHz, which bounds the
+// longest interval that can be measured.
+
+#define LOOP_STALL_US 20000UL   // 20 ms ≈ one UART RX FIFO of NMEA at 115200 baud
+
+enum LoopPhase {
+    PHASE_INPUT = 0,
+    PHASE_INGEST,
+    PHASE_BATTERY,
+    PHASE_RENDER,
+    PHASE_RADIO,
+    PHASE_OTHER,
+    PHASE_COUNT
+};
+
+// Bucket upper edges in µs; the last bucket collects everything above
+static const uint32_t LOOP_HIST_EDGES_US[] = { 100, 500, 1000, 5000, 10000, 20000, 50000, 100000 };
+#define LOOP_HIST_BUCKETS (sizeof(LOOP_HIST_EDGES_US) / sizeof(LOOP_HIST_EDGES_US[0]) + 1)
+
+struct LatencyHistogram {
+    uint32_t buckets[LOOP_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs;
+
+    void reset() { memset(this, 0, sizeof(*this)); }
+
+    void add(uint32_t us) {
+        size_t b = 0;
+        while (b < LOOP_HIST_BUCKETS - 1 && us > LOOP_HIST_EDGES_US[b]) b++;
+        buckets[b]++;
+        count++;
+        sumUs += us;
+        if (us > maxUs) maxUs = us;
+    }
+
+    uint32_t meanUs() const { return count ? (uint32_t)(sumUs / count) : 0; }
+
+    // name count mean max | bucket counts
+    void print(Print& out, const char* name) const {
+        out.printf("%-6s n=%lu mean=%lu max=%lu |", name, (unsigned long)count,
+                   (unsigned long)meanUs(), (unsigned long)maxUs);
+        for (size_t b = 0; b < LOOP_HIST_BUCKETS; b++) {
+            out.print(' '); out.print(buckets[b]);
+        }
+        out.println();
+    }
+};
+
+class LoopStats {
+private:
+    uint32_t cyclesPerUs;
+    uint32_t passStartCycles;
+    uint32_t lastPassStartCycles;
+    bool havePrevPass;
+    uint32_t phaseStartCycles;
+    uint32_t passPhaseUs[PHASE_COUNT];   // Time per phase within the current pass
+
+    uint32_t cyclesToUs(uint32_t cycles) const { return cycles / cyclesPerUs; }
+
+public:
+    LatencyHistogram periodHist;              // Start-to-start spacing of update() passes
+    LatencyHistogram busyHist;                // Busy time of one pass (excludes idle sleep)
+    LatencyHistogram phaseHist[PHASE_COUNT];  // Per-phase execution time
+    uint32_t stallCount;
+    uint32_t maxStallUs;
+    LoopPhase maxStallCause;
+    uint32_t maxStallAtMs;
+
+    LoopStats() : cyclesPerUs(240) { reset(); }
+
+    void begin() {
+        uint32_t mhz = ESP.getCpuFreqMHz();
+        cyclesPerUs = mhz > 0 ? mhz : 240;
+        reset();
+    }
+
+    void reset();
+
+    void beginPass();
+    void endPass();
+    void beginPhase() { phaseStartCycles = ESP.getCycleCount(); }
+    void endPhase(LoopPhase phase);
+
+    static const char* phaseName(LoopPhase phase);
+    void print(Print& out) const;
+};
+
+// RAII helper: times one phase for the lifetime of the scope
+class LoopPhaseScope {
+private:
+    LoopStats& stats;
+    LoopPhase phase;
+public:
+    LoopPhaseScope(LoopStats& s, LoopPhase p) : stats(s), phase(p) { stats.beginPhase(); }
+    ~LoopPhaseScope() { stats.endPhase(phase); }
+};
+
+inline void LoopStats::reset() {
+    passStartCycles = 0;
+    lastPassStartCycles = 0;
+    havePrevPass = false;
+    phaseStartCycles = 0;
+    memset(passPhaseUs, 0, sizeof(passPhaseUs));
+    periodHist.reset();
+    busyHist.reset();
+    for (int i = 0; i < PHASE_COUNT; i++) phaseHist[i].reset();
+    stallCount = 0;
+    maxStallUs = 0;
+    maxStallCause = PHASE_OTHER;
+    maxStallAtMs = 0;
+}
+
+inline void LoopStats::beginPass() {
+    passStartCycles = ESP.getCycleCount();
+    if (havePrevPass) {
+        periodHist.add(cyclesToUs(passStartCycles - lastPassStartCycles));
+    }
+    lastPassStartCycles = passStartCycles;
+    havePrevPass = true;
+    memset(passPhaseUs, 0, sizeof(passPhaseUs));
+}
+
+inline void LoopStats::endPhase(LoopPhase phase) {
+    uint32_t us = cyclesToUs(ESP.getCycleCount() - phaseStartCycles);
+    phaseHist[phase].add(us);
+    passPhaseUs[phase] += us;
+}
+
+inline void LoopStats::endPass() {
+    uint32_t busyUs = cyclesToUs(ESP.getCycleCount() - passStartCycles);
+    busyHist.add(busyUs);
+    if (busyUs < LOOP_STALL_US) {
+        return;
+    }
+
+    // Stall: blame the phase that ate most of this pass
+    stallCount++;
+    if (busyUs > maxStallUs) {
+        LoopPhase cause = PHASE_OTHER;
+        uint32_t worst = 0;
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            if (passPhaseUs[i] > worst) {
+                worst = passPhaseUs[i];
+                cause = (LoopPhase)i;
+            }
+        }
+        maxStallUs = busyUs;
+        maxStallCause = cause;
+        maxStallAtMs = millis();
+    }
+}
+
+inline const char* LoopStats::phaseName(LoopPhase phase) {
+    switch (phase) {
+        case PHASE_INPUT:   return "INP";
+        case PHASE_INGEST:  return "GPS";
+        case PHASE_BATTERY: return "BAT";
+        case PHASE_RENDER:  return "LCD";
+        case PHASE_RADIO:   return "RF";
+        default:            return "OTH";
+    }
+}
+
+inline void LoopStats::print(Print& out) const {
+    // One line per histogram
+    out.println("=== LOOP STATS (us) ===");
+    out.print("edges:");
+    for (size_t b = 0; b < LOOP_HIST_BUCKETS - 1; b++) {
+        out.print(' '); out.print(LOOP_HIST_EDGES_US[b]);
+    }
+    out.println(" +");
+
+    const LatencyHistogram* hists[2 + PHASE_COUNT];
+    const char* names[2 + PHASE_COUNT];
+    hists[0] = &periodHist; names[0] = "period";
+    hists[1] = &busyHist;   names[1] = "busy";
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        hists[2 + i] = &phaseHist[i];
+        names[2 + i] = phaseName((LoopPhase)i);
+    }
+
+    for (int h = 0; h < 2 + PHASE_COUNT; h++) {
+        hists[h]->print(out, names[h]);
+    }
+    out.printf("stalls=%lu max=%luus cause=%s at=%lums\n",
+               (unsigned long)stallCount, (unsigned long)maxStallUs,
+               phaseName(maxStallCause), (unsigned long)maxStallAtMs);
+}
+
+#endif // LOOPSTATS_H
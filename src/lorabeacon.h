@@ -0,0 +1,652 @@
+#ifndef LORABEACON_H
+#define LORABEACON_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include "LoRaWan_APP.h"
+#include "beaconpacket.h"
+#include "navsnapshot.h"
+#include "linkadapt.h"
+#include "loopstats.h"
+
+// LoRa position beacon on the onboard SX1262.
+// Packs the current NavSnapshot into a BeaconFix frame and sends it with
+// Radio.Send: a 17-byte keyframe every BEACON_KEYFRAME_EVERY packets and
+// 8-12 byte deltas against that keyframe in between. Transmissions are
+// paced by an airtime credit bucket: credit accrues at BEACON_DUTY_PERMILLE
+// of wall time (capped at one hour's allowance) and each frame spends its
+// Radio.TimeOnAir, so the beacon stays inside the regional duty-cycle limit
+// whatever the interval is set to.
+// When a receive handler is installed the radio listens for peers between
+// its own transmissions (see BEACON_LISTEN_MODE) and hands every frame to
+// that handler.
+// SF and bandwidth come from the LINK_RATES ladder and may be changed at
+// run time with setRate(); preamble, frame airtime and beacon interval are
+// recomputed from RadioSymbTime / Radio.TimeOnAir for each rate.
+// Radio events are not polled: the DIO1 interrupt wakes a dedicated
+// high-priority task that runs Radio.IrqProcess(), so TX/RX completion
+// does not wait for whatever the main loop is drawing. A mutex serialises
+// that task against service() and setRate() on the shared SPI/driver state.
+
+// RADIO SETTINGS (override with -D build flags)
+#ifdef BEACON_REGION_EU868
+#ifndef BEACON_FREQUENCY_HZ
+#define BEACON_FREQUENCY_HZ   869525000   // g3 sub-band
+#endif
+#ifndef BEACON_DUTY_PERMILLE
+#define BEACON_DUTY_PERMILLE  100         // 10 % on g3
+#endif
+#ifndef BEACON_MAX_DWELL_MS
+#define BEACON_MAX_DWELL_MS   0           // No dwell limit
+#endif
+#else  // US915 (board ships with a 902-928 MHz antenna)
+#ifndef BEACON_FREQUENCY_HZ
+#define BEACON_FREQUENCY_HZ   915000000
+#endif
+#ifndef BEACON_DUTY_PERMILLE
+#define BEACON_DUTY_PERMILLE  10          // Self-imposed 1 % to share the channel
+#endif
+#ifndef BEACON_MAX_DWELL_MS
+#define BEACON_MAX_DWELL_MS   400         // FCC 15.247 dwell time
+#endif
+#endif
+
+#ifndef BEACON_TX_POWER_DBM
+#define BEACON_TX_POWER_DBM   14
+#endif
+#ifndef BEACON_SF_MAX
+#define BEACON_SF_MAX         10          // Slowest (rendezvous) rate; dwell may cap it lower
+#endif
+#define BEACON_CODINGRATE     1           // [1: 4/5, 2: 4/6, 3: 4/7, 4: 4/8]
+#define BEACON_TX_TIMEOUT_MS  3000
+
+// LISTEN MODES (how peers are heard between our own beacons)
+#define BEACON_LISTEN_CONTINUOUS 0   // Radio.Rx(0): always in RX, ~5 mA
+#define BEACON_LISTEN_SNIFF      1   // SX126x RX duty cycle: chip alternates short RX windows and sleep
+#define BEACON_LISTEN_CAD        2   // Timed CAD; full receive only after channel activity
+#ifndef BEACON_LISTEN_MODE
+#define BEACON_LISTEN_MODE       BEACON_LISTEN_SNIFF
+#endif
+#ifndef BEACON_LISTEN_PERIOD_MS
+#define BEACON_LISTEN_PERIOD_MS  80   // Radio sleep between windows / CAD checks
+#endif
+#define BEACON_LISTEN_WINDOW_SYMBOLS 2   // RX window or CAD length
+
+#define BEACON_PREAMBLE_MIN   8
+
+// DIO1 service task
+#define BEACON_IRQ_TASK_STACK 4096
+#define BEACON_IRQ_TASK_PRIO  5           // Above the Arduino loop task (1)
+#define BEACON_IRQ_TASK_CORE  1           // Loop core: preempts rendering instead of racing it
+
+#ifndef BEACON_INTERVAL_MS
+#define BEACON_INTERVAL_MS    30000UL     // Longest interval (slow rates)
+#endif
+#ifndef BEACON_MIN_INTERVAL_MS
+#define BEACON_MIN_INTERVAL_MS 5000UL     // Shortest interval (fast rates)
+#endif
+#define BEACON_TYPICAL_DELTA  10          // Bytes, for the interval estimate
+#define BEACON_RENDEZVOUS_EVERY 4         // Every 4th keyframe goes out at the slowest rate
+
+#ifndef BEACON_KEYFRAME_EVERY
+#define BEACON_KEYFRAME_EVERY 8           // 1 keyframe + 7 deltas
+#endif
+static_assert(BEACON_KEYFRAME_EVERY >= 1 && BEACON_KEYFRAME_EVERY <= BEACON_DELTA_MAX_OFF + 1,
+              "delta offset must fit the 4-bit type nibble");
+
+// Received-frame hook: runs inside Radio.IrqProcess(), i.e. in the DIO1
+// service task with the radio lock held
+typedef void (*BeaconRxFn)(void* ctx, const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr);
+
+// Symbol time in ms for an SX126x bandwidth code (radio.c, not in the Radio struct)
+extern "C" double RadioSymbTime(uint8_t bw, uint8_t sf);
+// Flag Radio.IrqProcess() checks (radio.c). RadioOnDioIrq() only sets it but
+// lives in flash, so onDio1() sets it itself
+extern "C" bool IrqFired;
+
+class LoRaBeacon {
+private:
+    // Radio callbacks are plain C function pointers. A function-local static
+    // keeps the header safe to include from several translation units, and
+    // forced inlining puts the lookup into onDio1() itself, which is in IRAM
+    static inline __attribute__((always_inline)) LoRaBeacon*& active() {
+        static LoRaBeacon* instance = nullptr;
+        return instance;
+    }
+    RadioEvents_t events;
+
+    uint16_t nodeId;
+    uint8_t seq;
+    bool radioReady;
+    bool txBusy;
+    uint32_t nextTxAt;                 // millis() of the next release
+    uint32_t creditUs;                 // Airtime allowance left, µs
+    uint32_t lastCreditUpdate;
+    uint8_t frame[BEACON_PACKET_LEN];
+    BeaconFix keyFix;                  // Reference for deltas
+    bool haveKey;
+    BeaconRxFn rxHandler;
+    void* rxCtx;
+
+    // DIO1 service task
+    TaskHandle_t irqTask;
+    SemaphoreHandle_t radioLock;
+    volatile uint32_t irqAtUs;         // esp_timer time of the first unserviced DIO1 edge
+    volatile bool irqStamped;
+
+    // Holds radioLock for a scope (no-op before begin() creates it)
+    class RadioGuard {
+    private:
+        SemaphoreHandle_t m;
+    public:
+        explicit RadioGuard(SemaphoreHandle_t h) : m(h) { if (m) xSemaphoreTake(m, portMAX_DELAY); }
+        ~RadioGuard() { if (m) xSemaphoreGive(m); }
+    };
+
+    // CAD listen state (BEACON_LISTEN_CAD only)
+    enum CadState { CAD_IDLE, CAD_RUNNING, CAD_RECEIVING };
+    volatile CadState cadState;
+    uint32_t nextCadAt;
+    uint32_t rxUntil;                  // Give up on a CAD-triggered receive after this
+    uint32_t keyToaMs;                 // Keyframe time on air at the current rate
+
+    // Link rate (index into LINK_RATES)
+    uint8_t rate;
+    uint8_t maxRate;                   // Slowest rate that fits the dwell limit
+    uint8_t pendingRate;               // Requested while busy, LINK_RATE_NONE if none
+    uint8_t announce;                  // Rate request carried in our keyframes
+    bool announceSent;
+    bool rendezvousDue;                // Repeat the last keyframe at maxRate
+    bool rendezvousTx;                 // Current TX is at maxRate; restore rate after
+    uint8_t rendezvousLen;
+    uint32_t rendezvousToaMs;
+    uint32_t symbolUs;
+    uint16_t preambleLen;
+    uint32_t intervalMs;
+
+    static void onTxDone();
+    static void onTxTimeout();
+    static void onRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr);
+    static void onRxError();
+    static void onCadDone(bool detected);
+    static void onDio1();
+    static void irqTaskMain(void* arg);
+
+    // Back to listening if someone wants frames, otherwise sleep
+    void idleRadio();
+    void serviceCad(uint32_t now);
+
+    void refillCredit(uint32_t now);
+    void scheduleNext(uint32_t now);
+
+    // Program SF/BW/preamble for rate r; returns the keyframe time on air
+    uint32_t applyRate(uint8_t r);
+    void switchRate(uint8_t r);
+
+public:
+    // Statistics
+    uint32_t txCount;
+    uint32_t txTimeouts;
+    uint32_t skippedNoFix;
+    uint32_t deferredDuty;             // Releases held back by the airtime budget
+    uint32_t lastToaMs;
+    uint32_t airtimeTotalMs;
+    uint32_t keyframes;
+    uint32_t deltas;
+    uint32_t bytesSent;
+    uint32_t rxCount;
+    uint32_t rxErrors;
+    uint32_t cadRuns;
+    uint32_t cadHits;                  // CAD saw activity and a receive was opened
+    uint32_t cadFalse;                 // ...but no frame arrived
+    LatencyHistogram irqLatency;       // DIO1 edge → Radio.IrqProcess() start, µs
+    LatencyHistogram irqService;       // Radio.IrqProcess() incl. callbacks, µs
+
+    LoRaBeacon();
+
+    // Configure the radio; Mcu.begin() must already have run
+    bool begin(uint16_t id);
+
+    // Install a receive handler and start listening between transmissions
+    void setReceiveHandler(BeaconRxFn fn, void* ctx);
+
+    // Call from the main loop every few ms: sends a beacon when one is due
+    // and the airtime budget allows it (and polls radio IRQs if the DIO1
+    // task could not be started)
+    void service(const NavSnapshot& nav, int batteryPct, bool charging);
+
+    uint16_t getNodeId() const { return nodeId; }
+    uint8_t getSeq() const { return seq; }
+    uint32_t msUntilNext() const;
+    TaskHandle_t getIrqTask() const { return irqTask; }
+
+    // Link rate control (see LinkAdapter)
+    void setRate(uint8_t r);
+    uint8_t getRate() const { return rate; }
+    uint8_t getMaxRate() const { return maxRate; }
+    uint32_t getIntervalMs() const { return intervalMs; }
+    void setAnnouncedRate(uint8_t r);
+    bool announcementSent() const { return announceSent; }
+
+    // Pack a snapshot into the wire struct
+    static void fillFix(BeaconFix& fix, const NavSnapshot& nav, int batteryPct, bool charging);
+};
+
+inline LoRaBeacon::LoRaBeacon()
+    : nodeId(0), seq(0), radioReady(false), txBusy(false), nextTxAt(0),
+      creditUs(0), lastCreditUpdate(0), haveKey(false),
+      rxHandler(nullptr), rxCtx(nullptr), irqTask(nullptr), radioLock(nullptr),
+      irqAtUs(0), irqStamped(false),
+      cadState(CAD_IDLE), nextCadAt(0), rxUntil(0), keyToaMs(0),
+      rate(LINK_RATE_COUNT - 1), maxRate(LINK_RATE_COUNT - 1), pendingRate(LINK_RATE_NONE),
+      announce(LINK_RATE_NONE), announceSent(false),
+      rendezvousDue(false), rendezvousTx(false), rendezvousLen(0), rendezvousToaMs(0),
+      symbolUs(1000), preambleLen(BEACON_PREAMBLE_MIN), intervalMs(BEACON_INTERVAL_MS),
+      txCount(0), txTimeouts(0), skippedNoFix(0), deferredDuty(0), lastToaMs(0), airtimeTotalMs(0),
+      keyframes(0), deltas(0), bytesSent(0), rxCount(0), rxErrors(0),
+      cadRuns(0), cadHits(0), cadFalse(0) {
+    memset(&events, 0, sizeof(events));
+    memset(frame, 0, sizeof(frame));
+    memset(&keyFix, 0, sizeof(keyFix));
+    irqLatency.reset();
+    irqService.reset();
+}
+
+inline bool LoRaBeacon::begin(uint16_t id) {
+    active() = this;
+    nodeId = id;
+
+    events.TxDone = onTxDone;
+    events.TxTimeout = onTxTimeout;
+    events.RxDone = onRxDone;
+    events.RxError = onRxError;
+    events.RxTimeout = onRxError;   // Header error: same recovery as a CRC error
+    events.CadDone = onCadDone;
+    Radio.Init(&events);
+    Radio.SetChannel(BEACON_FREQUENCY_HZ);
+    Radio.SetPublicNetwork(false);  // Private sync word: stay off LoRaWAN gateways
+
+    // Slowest rate within BEACON_SF_MAX whose keyframe fits the dwell limit
+    int slowest = -1;
+    for (int r = LINK_RATE_COUNT - 1; r >= 0; r--) {
+        if (LINK_RATES[r].sf > BEACON_SF_MAX) continue;
+        uint32_t toa = applyRate((uint8_t)r);
+        if (BEACON_MAX_DWELL_MS == 0 || toa <= BEACON_MAX_DWELL_MS) {
+            slowest = r;
+            break;
+        }
+    }
+    if (slowest < 0) {
+        Serial.printf("→ Beacon disabled: no rate fits the %dms dwell limit\n", BEACON_MAX_DWELL_MS);
+        Radio.Sleep();
+        return false;
+    }
+    maxRate = (uint8_t)slowest;
+    announce = maxRate;
+
+    // Start at the rendezvous rate; the link adapter speeds up from there
+    switchRate(maxRate);
+    rendezvousToaMs = keyToaMs;
+    lastToaMs = keyToaMs;
+    Radio.Sleep();
+
+    uint32_t now = millis();
+    lastCreditUpdate = now;
+    creditUs = lastToaMs * 1000;      // Enough for the first frame
+    scheduleNext(now);
+    radioReady = true;
+
+    // Route DIO1 to the service task; without it service() keeps polling
+    radioLock = xSemaphoreCreateMutex();
+    if (radioLock && xTaskCreatePinnedToCore(irqTaskMain, "radio", BEACON_IRQ_TASK_STACK, this,
+                                             BEACON_IRQ_TASK_PRIO, &irqTask, BEACON_IRQ_TASK_CORE) == pdPASS) {
+        SX126xIoIrqInit(onDio1);
+    } else {
+        irqTask = nullptr;
+        Serial.println("→ LoRa IRQ task not started, polling instead");
+    }
+
+    Serial.printf("→ LoRa beacon: node %04X, %lu Hz, SF%d..SF%d, %lums/frame, %d‰ duty\n",
+                  nodeId, (unsigned long)BEACON_FREQUENCY_HZ, LINK_RATES[0].sf,
+                  LINK_RATES[maxRate].sf, (unsigned long)lastToaMs, BEACON_DUTY_PERMILLE);
+    return true;
+}
+
+inline uint32_t LoRaBeacon::applyRate(uint8_t r) {
+    static const uint8_t sx126xBw[] = { 4, 5, 6 };   // LORA_BW_125 / 250 / 500
+    const LoRaRate& lr = LINK_RATES[r];
+    symbolUs = (uint32_t)(RadioSymbTime(sx126xBw[lr.bw], lr.sf) * 1000.0);
+
+    // A sleeping receiver only catches a frame whose preamble outlasts one
+    // full sleep + window cycle, so the preamble is stretched to cover it
+    // (SF9: 25 symbols ≈ 100 ms, for a ~9 % receive duty)
+#if BEACON_LISTEN_MODE == BEACON_LISTEN_CONTINUOUS
+    preambleLen = BEACON_PREAMBLE_MIN;
+#else
+    preambleLen = (uint16_t)(BEACON_LISTEN_PERIOD_MS * 1000UL / symbolUs + 2 * BEACON_LISTEN_WINDOW_SYMBOLS + 2);
+    if (preambleLen < BEACON_PREAMBLE_MIN) preambleLen = BEACON_PREAMBLE_MIN;
+#endif
+
+    Radio.Standby();
+    Radio.SetTxConfig(MODEM_LORA, BEACON_TX_POWER_DBM, 0, lr.bw,
+                      lr.sf, BEACON_CODINGRATE, preambleLen,
+                      false, true, 0, 0, false, BEACON_TX_TIMEOUT_MS);
+    Radio.SetRxConfig(MODEM_LORA, lr.bw, lr.sf, BEACON_CODINGRATE,
+                      0, preambleLen, 0, false, 0, true, 0, 0, false, true);
+    return Radio.TimeOnAir(MODEM_LORA, BEACON_PACKET_LEN);
+}
+
+inline void LoRaBeacon::switchRate(uint8_t r) {
+    rate = r;
+    pendingRate = LINK_RATE_NONE;
+    keyToaMs = applyRate(r);
+
+    // Interval: spend about half the duty allowance on the expected keyframe/delta mix
+    uint32_t deltaToaMs = Radio.TimeOnAir(MODEM_LORA, BEACON_TYPICAL_DELTA);
+    uint32_t avgToaMs = (keyToaMs + (BEACON_KEYFRAME_EVERY - 1) * deltaToaMs) / BEACON_KEYFRAME_EVERY;
+    intervalMs = avgToaMs * 1000UL / BEACON_DUTY_PERMILLE * 2;
+    if (intervalMs < BEACON_MIN_INTERVAL_MS) intervalMs = BEACON_MIN_INTERVAL_MS;
+    if (intervalMs > BEACON_INTERVAL_MS) intervalMs = BEACON_INTERVAL_MS;
+
+    if (radioReady) {
+        Serial.printf("→ LoRa rate SF%d/%dkHz: preamble %u, %lums/key, every %lus\n",
+                      LINK_RATES[r].sf, 125 << LINK_RATES[r].bw, preambleLen,
+                      (unsigned long)keyToaMs, (unsigned long)(intervalMs / 1000));
+        if (!txBusy) {
+            idleRadio();
+        }
+    }
+}
+
+inline void LoRaBeacon::setRate(uint8_t r) {
+    if (!radioReady) return;
+    RadioGuard guard(radioLock);
+    if (r > maxRate) r = maxRate;
+    if (r == rate) {
+        pendingRate = LINK_RATE_NONE;
+        return;
+    }
+    if (txBusy || cadState != CAD_IDLE) {
+        pendingRate = r;   // Applied by service() once the radio is free
+    } else {
+        switchRate(r);
+    }
+}
+
+inline void LoRaBeacon::setAnnouncedRate(uint8_t r) {
+    if (r > maxRate) r = maxRate;
+    if (r != announce) {
+        announce = r;
+        announceSent = false;   // Next frame becomes a keyframe carrying it
+    }
+}
+
+inline void LoRaBeacon::setReceiveHandler(BeaconRxFn fn, void* ctx) {
+    RadioGuard guard(radioLock);
+    rxHandler = fn;
+    rxCtx = ctx;
+    if (radioReady && !txBusy) {
+        idleRadio();
+    }
+}
+
+inline void LoRaBeacon::idleRadio() {
+    if (!rxHandler) {
+        Radio.Sleep();
+        return;
+    }
+#if BEACON_LISTEN_MODE == BEACON_LISTEN_SNIFF
+    // Rx(0) arms the RX interrupts; the duty-cycle command then replaces
+    // continuous RX. Times are in 15.625 µs steps.
+    const uint32_t rxSteps = BEACON_LISTEN_WINDOW_SYMBOLS * symbolUs * 64 / 1000;
+    const uint32_t sleepSteps = BEACON_LISTEN_PERIOD_MS * 64;
+    Radio.Rx(0);
+    Radio.SetRxDutyCycle(rxSteps, sleepSteps);
+#elif BEACON_LISTEN_MODE == BEACON_LISTEN_CAD
+    Radio.Sleep();
+    cadState = CAD_IDLE;
+    nextCadAt = millis() + BEACON_LISTEN_PERIOD_MS;
+#else
+    Radio.Rx(0);      // Continuous receive
+#endif
+}
+
+inline void LoRaBeacon::serviceCad(uint32_t now) {
+    if (!rxHandler || txBusy) return;
+    if (cadState == CAD_IDLE && (int32_t)(now - nextCadAt) >= 0) {
+        cadState = CAD_RUNNING;
+        cadRuns++;
+        Radio.StartCad(BEACON_LISTEN_WINDOW_SYMBOLS);
+    } else if (cadState == CAD_RECEIVING && (int32_t)(now - rxUntil) >= 0) {
+        // Activity was noise or someone else's modulation
+        cadFalse++;
+        idleRadio();
+    }
+}
+
+inline void LoRaBeacon::onCadDone(bool detected) {
+    LoRaBeacon* self = active();
+    if (!self) return;
+    if (detected && self->cadState == CAD_RUNNING) {
+        // A preamble is on air: stay in RX long enough for a whole frame
+        self->cadHits++;
+        self->cadState = CAD_RECEIVING;
+        self->rxUntil = millis() + self->keyToaMs + BEACON_LISTEN_PERIOD_MS;
+        Radio.Rx(0);
+    } else {
+        self->idleRadio();
+    }
+}
+
+inline void IRAM_ATTR LoRaBeacon::onDio1() {
+    IrqFired = true;   // What RadioOnDioIrq() does, without its call into flash
+    LoRaBeacon* self = active();
+    if (!self || !self->irqTask) return;
+    if (!self->irqStamped) {
+        self->irqAtUs = (uint32_t)esp_timer_get_time();
+        self->irqStamped = true;
+    }
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->irqTask, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+inline void LoRaBeacon::irqTaskMain(void* arg) {
+    LoRaBeacon* self = static_cast<LoRaBeacon*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Latency includes any wait for service() to release the radio
+        RadioGuard guard(self->radioLock);
+        uint32_t startUs = (uint32_t)esp_timer_get_time();
+        self->irqLatency.add(startUs - self->irqAtUs);
+        self->irqStamped = false;
+        Radio.IrqProcess();
+        self->irqService.add((uint32_t)esp_timer_get_time() - startUs);
+    }
+}
+
+inline void LoRaBeacon::onTxDone() {
+    LoRaBeacon* self = active();
+    if (!self) return;
+    self->txBusy = false;
+    self->txCount++;
+    if (self->rendezvousTx) {
+        self->rendezvousTx = false;
+        self->applyRate(self->rate);
+    }
+    self->idleRadio();
+}
+
+inline void LoRaBeacon::onTxTimeout() {
+    LoRaBeacon* self = active();
+    if (!self) return;
+    self->txBusy = false;
+    self->txTimeouts++;
+    if (self->rendezvousTx) {
+        self->rendezvousTx = false;
+        self->applyRate(self->rate);
+    }
+    self->idleRadio();
+}
+
+inline void LoRaBeacon::onRxDone(uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr) {
+    LoRaBeacon* self = active();
+    if (!self) return;
+    self->rxCount++;
+    if (self->rxHandler) {
+        self->rxHandler(self->rxCtx, payload, size, rssi, snr);
+    }
+    // Sniff and CAD receives end in standby; rearm the listen cycle
+    if (!self->txBusy) {
+        self->idleRadio();
+    }
+}
+
+inline void LoRaBeacon::onRxError() {
+    LoRaBeacon* self = active();
+    if (!self) return;
+    self->rxErrors++;
+    if (!self->txBusy) {
+        self->idleRadio();
+    }
+}
+
+inline void LoRaBeacon::refillCredit(uint32_t now) {
+    // elapsed ms × permille = µs of airtime earned
+    const uint32_t capUs = 3600UL * 1000UL * BEACON_DUTY_PERMILLE;
+    uint64_t credit = (uint64_t)creditUs + (uint64_t)(now - lastCreditUpdate) * BEACON_DUTY_PERMILLE;
+    creditUs = credit > capUs ? capUs : (uint32_t)credit;
+    lastCreditUpdate = now;
+}
+
+inline void LoRaBeacon::scheduleNext(uint32_t now) {
+    // ±1/16 jitter de-synchronises trackers
+    uint32_t jitter = intervalMs / 8;
+    nextTxAt = now + intervalMs - jitter / 2 + (uint32_t)random(jitter);
+}
+
+inline uint32_t LoRaBeacon::msUntilNext() const {
+    int32_t d = (int32_t)(nextTxAt - millis());
+    return d > 0 ? (uint32_t)d : 0;
+}
+
+inline void LoRaBeacon::fillFix(BeaconFix& fix, const NavSnapshot& nav, int batteryPct, bool charging) {
+    fix.latE6 = (int32_t)lround(nav.lat * 1e6);
+    fix.lonE6 = (int32_t)lround(nav.lon * 1e6);
+    fix.speedHalfKmh = nav.hasSpeed ? (uint16_t)lroundf(constrain(nav.speedKmh, 0.0f, 127.5f) * 2.0f) : 0;
+    fix.heading256 = nav.hasCourse ? (uint8_t)((uint32_t)lroundf(nav.courseDeg * 256.0f / 360.0f) & 0xFF) : 0;
+    fix.batteryPct = batteryPct < 0 ? BEACON_BATT_UNKNOWN : (uint8_t)constrain(batteryPct, 0, 100);
+    fix.charging = charging;
+    fix.fixQuality = nav.fixQuality;
+    fix.sats = nav.satsInView;
+}
+
+inline void LoRaBeacon::service(const NavSnapshot& nav, int batteryPct, bool charging) {
+    if (!radioReady) return;
+    RadioGuard guard(radioLock);
+
+    // 1) Dispatch pending DIO1 events ourselves if there is no IRQ task
+    if (!irqTask) {
+        Radio.IrqProcess();
+    }
+
+    uint32_t now = millis();
+    refillCredit(now);
+    if (pendingRate != LINK_RATE_NONE && !txBusy && cadState == CAD_IDLE) {
+        switchRate(pendingRate);
+    }
+#if BEACON_LISTEN_MODE == BEACON_LISTEN_CAD
+    serviceCad(now);
+    if (cadState != CAD_IDLE) {
+        return;   // Don't transmit over a CAD or a frame being received
+    }
+#endif
+    if (txBusy) {
+        return;
+    }
+
+    // Rendezvous copy of the keyframe just sent (frame still holds it)
+    if (rendezvousDue) {
+        rendezvousDue = false;
+        uint32_t needUs = rendezvousToaMs * 1000;
+        if (creditUs >= needUs) {
+            creditUs -= needUs;
+            airtimeTotalMs += rendezvousToaMs;
+            rendezvousTx = true;
+            txBusy = true;
+            applyRate(maxRate);   // Also leaves the listen cycle
+            Radio.Send(frame, rendezvousLen);
+        }
+        return;
+    }
+
+    if ((int32_t)(now - nextTxAt) < 0) {
+        return;
+    }
+
+    // 2) Nothing worth sending without a position
+    if (!nav.haveFix || !nav.hasPosition) {
+        skippedNoFix++;
+        scheduleNext(now);
+        return;
+    }
+
+    // 3) Build: delta against the last keyframe when possible, otherwise a
+    //    fresh keyframe (first packet, every BEACON_KEYFRAME_EVERY, a jump,
+    //    or a new rate request to announce)
+    BeaconFix fix;
+    fix.nodeId = nodeId;
+    fix.seq = seq;
+    fillFix(fix, nav, batteryPct, charging);
+    fix.rateReq = announce;
+    size_t len = 0;
+    bool key = !haveKey || !announceSent || (uint8_t)(seq - keyFix.seq) >= BEACON_KEYFRAME_EVERY;
+    if (!key) {
+        len = beaconEncodeDelta(fix, keyFix, frame);
+        key = (len == 0);
+    }
+    if (key) {
+        len = beaconEncode(fix, frame);
+    }
+    uint32_t toaMs = Radio.TimeOnAir(MODEM_LORA, (uint8_t)len);
+
+    // 4) Respect the airtime budget; retry once enough credit has accrued
+    uint32_t needUs = toaMs * 1000;
+    if (creditUs < needUs) {
+        deferredDuty++;
+        nextTxAt = now + (needUs - creditUs) / BEACON_DUTY_PERMILLE + 1;
+        return;
+    }
+
+    // 5) Send
+    if (key) {
+        keyFix = fix;
+        haveKey = true;
+        announceSent = true;
+        keyframes++;
+        // Every few keyframes are repeated at the slowest rate so a node
+        // that lost the group (and fell back there) can find it again
+        rendezvousDue = rate < maxRate && keyframes % BEACON_RENDEZVOUS_EVERY == 0;
+        rendezvousLen = (uint8_t)len;
+    } else {
+        deltas++;
+    }
+    seq++;
+    lastToaMs = toaMs;
+    bytesSent += len;
+
+    creditUs -= needUs < creditUs ? needUs : creditUs;
+    airtimeTotalMs += lastToaMs;
+    txBusy = true;
+    Radio.Standby();   // Leave the listen cycle before switching to TX
+    Radio.Send(frame, (uint8_t)len);
+    scheduleNext(now);
+}
+
+#endif // LORABEACON_H
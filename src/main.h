@@ -5,6 +5,25 @@
 #include <HT_st7735.h>
 #include <EEPROM.h>
 #include <esp_sleep.h>
+#include "scheduler.h"
+#include "loopstats.h"
+#include "navsnapshot.h"
+#include "gnssparser.h"
+#include "taskhealth.h"
+#include "lorabeacon.h"
+#include "peertable.h"
+#include "aesbench.h"
+#include "microbench.h"
+#include "blenav.h"
+#include "tracklog.h"
+#include "bletrack.h"
+#include "blebcast.h"
+#include "routestore.h"
+#include "routeupload.h"
+#include "trailview.h"
+#include "tracback.h"
+#include "geofence.h"
+#include "tripcomputer.h"
 
 // PIN DEFINITIONS
 #define VGNSS_CTRL   3    // GPIO 3 → Vext (active-low) powers UC6580 + ST7735
@@ -15,6 +34,27 @@
 #define BL_CTRL_PIN  21   // GPIO 21 enables ST7735 backlight (HIGH = on)
 #define USER_BTN_PIN  0   // GPIO 0 is the USER button (active-low)
 
+// Arduino loop task stack (sdkconfig default when not overridden)
+#ifndef CONFIG_ARDUINO_LOOP_STACK_SIZE
+#define CONFIG_ARDUINO_LOOP_STACK_SIZE 8192
+#endif
+
+// LoRa position beacon (set to 0 to keep the radio asleep)
+#ifndef LORA_BEACON_ENABLED
+#define LORA_BEACON_ENABLED 1
+#endif
+
+// BLE Location and Navigation service (set to 0 to keep BLE off)
+#ifndef BLE_NAV_ENABLED
+#define BLE_NAV_ENABLED 1
+#endif
+
+// Connectionless position broadcast on an extended advertising set
+// (needs CONFIG_BT_NIMBLE_EXT_ADV; set to 0 to advertise the LNS only)
+#ifndef BLE_BCAST_ENABLED
+#define BLE_BCAST_ENABLED CONFIG_BT_NIMBLE_EXT_ADV
+#endif
+
 // EEPROM ADDRESSES
 #define EEPROM_SIZE 512
 #define EEPROM_MAGIC 0xA5B4
@@ -43,6 +83,13 @@ enum ScreenType {
     SCREEN_SYSTEM_INFO,
     SCREEN_POWER_MENU,
     SCREEN_WAYPOINT_RESET,     // Ask to reset waypoint or navigate
+    SCREEN_DIAGNOSTICS,        // Task stacks, CPU load, heap (from System Info)
+    SCREEN_PEER_LIST,          // Trackers heard over LoRa
+    SCREEN_PEER_NAV,           // Navigate to the selected peer
+    SCREEN_ROUTE_NAV,          // Follow the uploaded route leg by leg
+    SCREEN_TRAIL,              // Breadcrumb trail map with home and waypoints
+    SCREEN_ZONE_ALERT,         // Entered a keep-out or left a keep-in zone
+    SCREEN_TRIP,               // Trip computer: distance, times, speeds, climb
     SCREEN_COUNT
 };
 
@@ -63,6 +110,10 @@ struct Waypoint {
 
 class HTITTracker {
 private:
+#ifdef HOST_HARNESS
+    friend class HostHarness;          // Host tools (tools/*.cpp) drive private state directly
+#endif
+    
     // Display instance
     HT_st7735 st7735;
     
@@ -76,6 +127,7 @@ private:
     
     // GNSS fix flag and HDOP → accuracy
     bool haveFix;
+    uint8_t lastFixQuality;
     float lastHDOP;
     
     // Home navigation variables
@@ -112,6 +164,16 @@ private:
     unsigned long lastSpeedTime;      // Time of last speed calculation
     float currentSpeed;                // Current speed in km/h
     bool hasValidSpeed;                // Speed calculation valid
+    float currentCourse;               // Course over ground in degrees (0 = north)
+    bool hasValidCourse;               // Course calculation valid
+    float currentAltitude;             // GGA altitude in metres
+    bool hasValidAltitude;
+    unsigned long lastFixMillis;       // millis() of the last position update
+    
+    // Navigation state published by the ingest side; UI code reads only
+    // the consistent copy in nav, never the loose fields above
+    NavPublisher navState;
+    NavSnapshot nav;
     
     // Battery monitoring improvements
     float batteryReadings[5];          // Rolling buffer for battery percentage
@@ -130,20 +192,192 @@ private:
     char prevSpeedBuf[16];
     bool prevDisplayValid;
     
-    // Buffer for NMEA line accumulation
-    char lineBuf[128];
-    int linePos;
+    // Streaming NMEA parser (checksummed sentences only)
+    GnssParser gnss;
+    
+    // Latest battery sample (refreshed by the battery task)
+    int lastRawADC;
+    float lastVbat;
+    float lastVbatCal;
+    int batteryPercent;
+    
+    // Cooperative scheduler driving update()
+    TaskScheduler scheduler;
+    static const unsigned long INPUT_INTERVAL = 10;     // ms, button polling
+    static const unsigned long NMEA_INTERVAL = 10;      // ms, UART drain (256 B RX FIFO ≈ 22 ms @115200)
+    static const unsigned long BATTERY_INTERVAL = 1000; // ms
+    static const unsigned long DEBUG_INTERVAL = 2000;   // ms
+    static const unsigned long LCD_INTERVAL = 1000;     // ms
+    static const unsigned long STATS_INTERVAL = 60000;  // ms, serial dump of loop/scheduler stats
+    static const unsigned long HEALTH_INTERVAL = 1000;  // ms, stack/CPU sampling + watchdog feed
+    static const unsigned long LOOP_CHECKIN_TIMEOUT = 3000; // ms
+    static const unsigned long RADIO_INTERVAL = 10;     // ms, beacon release (IRQs run in the beacon's task)
+    static const unsigned long BLE_INTERVAL = 20;       // ms, LNS batch release (well under any connection interval)
+    static const unsigned long TRACK_INTERVAL = 1000;   // ms, breadcrumb sampling (the log thins it further)
+    static const unsigned long ROUTE_INTERVAL = 20;     // ms, USB console drain + route leg advance
+    
+    // Main-loop latency histograms and stall detector
+    LoopStats loopStats;
+    
+    // FreeRTOS task health (stack, CPU, watchdog)
+    TaskHealthMonitor health;
+    int loopHealthId;
+    
+    // LoRa position beacon
+    LoRaBeacon beacon;
+    
+    // Other trackers heard over LoRa
+    PeerTable peers;
+    LinkAdapter linkAdapt;             // Group SF/BW selection from peer link quality
+    uint16_t activePeer;               // Node id of the peer being navigated to (0 = none)
+    
+    // BLE Location and Navigation service
+    BleNavService ble;
+    uint32_t bleNavGeneration;         // Last snapshot handed to the service
+    
+    // Breadcrumb log in flash and its BLE bulk download
+    TrackLog trackLog;
+    BleTrackTransfer trackTx;
+    
+#if BLE_BCAST_ENABLED
+    // Position broadcast to anyone scanning
+    BleBroadcast bcast;
+#endif
+    
+    // Uploaded route in flash, its receiver (USB console + BLE) and the leg follower
+    RouteStore route;
+    RouteUpload routeUp;
+    RouteFollower routeNav;
+    uint32_t routeGeneration;          // Last upload loaded into route
+    uint32_t routeNavGeneration;       // Last snapshot the follower saw
+    TracBack tracBack;                 // The logged track as a route back to its start
+    bool tracBackActive;               // routeNav is following tracBack, not route
+    
+    // Geofence zones from flash, checked on each new fix; a violation takes the screen
+    Geofence zones;
+    uint32_t zoneGeneration;           // Last zone upload loaded
+    unsigned long zoneFixMillis;       // Last fix checked against the zones
+    uint8_t alertZone;                 // Zone the alert screen shows
+    ScreenType alertReturn;            // Screen (and menu position) to go back to
+    int alertReturnIndex;
+    
+    // Trail since power-on, simplified for the track screen, and its map
+    TrailStore trail;
+    TrailRenderer trailView;
+    uint8_t trailZoom;                 // 1 = whole trail, 2/4/8 = around the current position
+    
+    // Trip totals, updated on each new fix
+    TripComputer trip;
+    uint8_t tripPage;                  // 0 = distance and speed, 1 = climb, 2 = reset?
+    
+    // Scheduler task bodies (each one is timed as a loop phase)
+    static void taskInput(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_INPUT);
+        self->checkButton();
+    }
+    static void taskIngest(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_INGEST);
+        self->drainNMEA();
+    }
+    static void taskBattery(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_BATTERY);
+        self->sampleBattery();
+    }
+    static void taskDebug(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_OTHER);
+        self->printDebugStatus();
+    }
+    static void taskRender(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_RENDER);
+        self->updateLCD(self->batteryPercent);
+    }
+    static void taskHealth(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_OTHER);
+        self->health.sample();
+        self->health.feedWatchdog();
+    }
+    static void taskRadio(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_RADIO);
+        NavSnapshot snap;
+        self->navState.read(snap);
+        bool rateChanged;
+        {
+            PeerTableLock lock(self->peers);
+            rateChanged = self->linkAdapt.evaluate(self->peers, millis(), self->beacon.announcementSent());
+        }
+        if (rateChanged) {
+            self->beacon.setRate(self->linkAdapt.current());
+        }
+        self->beacon.setAnnouncedRate(self->linkAdapt.requested());
+        self->beacon.service(snap, self->batteryPercent, self->isCharging);
+    }
+    static void taskBle(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_RADIO);
+        uint32_t gen = self->navState.generation();
+        if (gen != self->bleNavGeneration) {
+            self->bleNavGeneration = gen;
+            NavSnapshot snap;
+            self->navState.read(snap);
+            BleNavTarget target;
+            self->getBleNavTarget(snap, target);
+            self->ble.update(snap, target);
+#if BLE_BCAST_ENABLED
+            self->bcast.update(snap, self->batteryPercent, self->isCharging);
+#endif
+        }
+        self->ble.service(millis());
+    }
+    static void taskTrack(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_OTHER);
+        NavSnapshot snap;
+        self->navState.read(snap);
+        self->trackLog.record(snap, millis());
+        if (snap.hasPosition && snap.haveFix) {
+            self->trail.add(snap.lat, snap.lon);
+        }
+    }
+    static void taskRoute(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_INPUT);
+        self->serviceRoute();
+        self->serviceZones();
+        NavSnapshot snap;
+        self->navState.read(snap);
+        self->trip.update(snap);       // Once per new fix
+    }
+    static void taskStats(void* ctx) {
+        HTITTracker* self = static_cast<HTITTracker*>(ctx);
+        LoopPhaseScope phase(self->loopStats, PHASE_OTHER);
+        self->printLoopStats();
+    }
+    
+    // Beacon receive hook (called from the beacon's DIO1 task)
+    static void onBeaconRx(void* ctx, const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr) {
+        static_cast<HTITTracker*>(ctx)->handlePeerBeacon(payload, size, rssi, snr);
+    }
     
-    // Timing for LCD refresh (once per second)
-    unsigned long lastLCDupdate;
-    static const unsigned long LCD_INTERVAL = 1000; // ms
     
     // Private helper methods
+    void drainNMEA();
+    void sampleBattery();
+    void printDebugStatus();
+    void printLoopStats();
     void processNMEALine(const char* line);
-    int parseGSVinView(const char* gsvLine);
-    int parseGGAfixQuality(const char* ggaLine);
-    float parseGGAHDOP(const char* ggaLine);
-    bool parseGGAPosition(const char* ggaLine, double &lat, double &lon);
+    void applyGnssSentence();
+    void publishNavSnapshot();
+    void handlePeerBeacon(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr);
+    void getBleNavTarget(const NavSnapshot& snap, BleNavTarget& target);
+    void serviceRoute();
+    void serviceZones();
     float readBatteryVoltageRaw(int &rawADC);
     int voltageToPercent(float vb);
     void updateLCD(int pct_cal);
@@ -158,6 +392,13 @@ private:
     void updateSystemInfoScreen(int pct_cal);
     void updatePowerMenuScreen();
     void updateWaypointResetScreen();
+    void updateDiagnosticsScreen();
+    void updatePeerListScreen();
+    void updatePeerNavScreen(int pct_cal);
+    void updateRouteNavScreen(int pct_cal);
+    void updateTrailScreen();
+    void updateZoneAlertScreen();
+    void updateTripScreen();
     
     void checkButton();
     void calculateSpeed();
@@ -170,11 +411,21 @@ private:
     float calculateBearingToWaypoint(int waypointIndex);
     float calculateDistanceToWaypoint(int waypointIndex);
     const char* getCardinalDirection(float bearingToHome);
+    float calculateBearingToPoint(double lat, double lon);
+    float calculateDistanceToPoint(double lat, double lon);
+    static float greatCircleBearing(double lat1, double lon1, double lat2, double lon2);
+    static float greatCircleDistance(double lat1, double lon1, double lat2, double lon2);
+    static const char* bearingToCardinal(float bearing);
+    static void formatShortDistance(char* out, size_t len, float meters);
     
     // Waypoint management
     void setWaypoint(int index, double lat, double lon, const char* name);
     void loadWaypointsFromEEPROM();
     void saveWaypointsToEEPROM();
+    
+#if MICRO_BENCHMARK
+    void runMicroBenchmark(Print& out);
+#endif
 
 public:
     // Constructor
@@ -184,36 +435,43 @@ public:
     void begin();
     void update();
     
+    // Consistent copy of the navigation state; safe from any task
+    void getNavSnapshot(NavSnapshot& out) const { navState.read(out); }
+    uint32_t getNavGeneration() const { return navState.generation(); }
+    
     // Getters for status information
-    bool getFixStatus() const { return haveFix; }
-    int getTotalSatellites() const { return totalInView; }
-    float getHDOP() const { return lastHDOP; }
-    int getGPSCount() const { return gpsCount; }
-    int getGLONASSCount() const { return glonassCount; }
-    int getBeidouCount() const { return beidouCount; }
-    int getGalileoCount() const { return galileoCount; }
-    int getQZSSCount() const { return qzssCount; }
+    bool getFixStatus() const { NavSnapshot s; navState.read(s); return s.haveFix; }
+    int getTotalSatellites() const { NavSnapshot s; navState.read(s); return s.satsInView; }
+    float getHDOP() const { NavSnapshot s; navState.read(s); return s.hdop; }
+    int getGPSCount() const { NavSnapshot s; navState.read(s); return s.gpsCount; }
+    int getGLONASSCount() const { NavSnapshot s; navState.read(s); return s.glonassCount; }
+    int getBeidouCount() const { NavSnapshot s; navState.read(s); return s.beidouCount; }
+    int getGalileoCount() const { NavSnapshot s; navState.read(s); return s.galileoCount; }
+    int getQZSSCount() const { NavSnapshot s; navState.read(s); return s.qzssCount; }
     
     // Home navigation getters
-    bool isHomeEstablished() const { return homeEstablished; }
-    bool hasCurrentPosition() const { return hasValidPosition; }
+    bool isHomeEstablished() const { NavSnapshot s; navState.read(s); return s.homeEstablished; }
+    bool hasCurrentPosition() const { NavSnapshot s; navState.read(s); return s.hasPosition; }
 };
 
 // Implementation of HTITTracker class methods
 
 inline HTITTracker::HTITTracker() 
     : gpsCount(0), glonassCount(0), beidouCount(0), galileoCount(0), 
-      qzssCount(0), totalInView(0), haveFix(false), lastHDOP(99.99f),
-      linePos(0), lastLCDupdate(0), homeEstablished(false),
+      qzssCount(0), totalInView(0), haveFix(false), lastFixQuality(0), lastHDOP(99.99f), homeEstablished(false),
       homeLat(0.0), homeLon(0.0), currentLat(0.0), currentLon(0.0),
       hasValidPosition(false), activeWaypoint(0), waypointToSet(0), waypointToReset(0),
       currentScreen(SCREEN_MAIN_MENU), lastScreen(SCREEN_MAIN_MENU),
       menuIndex(0), menuItemCount(0), inMenu(false), buttonPressed(false),
       lastButtonPress(0), buttonPressStart(0), longPressHandled(false),
       lastActivity(0), forceScreenRedraw(false), lastLat(0.0), lastLon(0.0), 
-      lastSpeedTime(0), currentSpeed(0.0f), hasValidSpeed(false), 
-      prevDisplayValid(false), batteryIndex(0), batteryBufferFull(false), 
-      lastBatteryVoltage(0.0f), isCharging(false), lastChargingCheck(0) {
+      lastSpeedTime(0), currentSpeed(0.0f), hasValidSpeed(false), currentCourse(0.0f), hasValidCourse(false),
+      currentAltitude(0.0f), hasValidAltitude(false), lastFixMillis(0),
+      batteryIndex(0), batteryBufferFull(false), lastBatteryVoltage(0.0f), isCharging(false),
+      lastChargingCheck(0), prevDisplayValid(false), lastRawADC(0), lastVbat(0.0f), lastVbatCal(0.0f),
+      batteryPercent(0), loopHealthId(-1), activePeer(0), bleNavGeneration(0), routeGeneration(0),
+      routeNavGeneration(0), tracBackActive(false), zoneGeneration(0), zoneFixMillis(0), alertZone(0),
+      alertReturn(SCREEN_STATUS), alertReturnIndex(0), trailZoom(1), tripPage(0) {
     
     // Initialize waypoints as unset
     for (int i = 0; i < 3; i++) {
@@ -222,7 +480,6 @@ inline HTITTracker::HTITTracker()
         waypoints[i].lon = 0.0;
         strcpy(waypoints[i].name, "");
     }
-    memset(lineBuf, 0, sizeof(lineBuf));
     memset(prevFixBuf, 0, sizeof(prevFixBuf));
     memset(prevDistBuf, 0, sizeof(prevDistBuf));
     memset(prevSatBuf, 0, sizeof(prevSatBuf));
@@ -234,10 +491,15 @@ inline HTITTracker::HTITTracker()
     for (int i = 0; i < 5; i++) {
         batteryReadings[i] = 0.0f;
     }
+    
+    // Publish the initial (no fix) state so readers start from a valid copy
+    publishNavSnapshot();
+    navState.read(nav);
 }
 
 inline void HTITTracker::begin() {
-    // 1) USB-Serial for debugging
+    // 1) USB-Serial for debugging (and route uploads, hence the larger RX buffer)
+    Serial.setRxBufferSize(ROUTE_USB_RX_BUFFER);
     Serial.begin(115200);
     while (!Serial) { delay(10); }
     Serial.println();
@@ -277,188 +539,436 @@ inline void HTITTracker::begin() {
     EEPROM.begin(512);  // Initialize EEPROM with 512 bytes
     Serial.println("→ EEPROM initialized (512 bytes)");
     loadWaypointsFromEEPROM();
+    if (trip.restore()) {
+        Serial.printf("→ Trip restored after deep sleep: %.2f km\n", trip.distanceM() / 1000.0);
+    }
+#if MICRO_BENCHMARK
+    runMicroBenchmark(Serial);         // Before any other task competes for the CPU
+#endif
+    trackLog.begin();
+    if (trackLog.isMounted()) {
+        Serial.printf("→ Route: %lu points\n", (unsigned long)route.load());
+        Serial.printf("→ Zones: %u\n", zones.load());
+        if (!routeUp.begin(&ble)) {
+            Serial.println("→ Route upload task failed to start");
+        }
+    }
+    
+    // 10) Register periodic tasks (registration order = run order within a pass)
+    //                name       body         ctx   period            deadline  budget(us)
+    scheduler.add("input",   taskInput,   this, INPUT_INTERVAL,   20,       500);
+    scheduler.add("ingest",  taskIngest,  this, NMEA_INTERVAL,    10,       5000);
+    scheduler.add("battery", taskBattery, this, BATTERY_INTERVAL, 100,      500);
+    scheduler.add("debug",   taskDebug,   this, DEBUG_INTERVAL,   500,      2000);
+    scheduler.add("render",  taskRender,  this, LCD_INTERVAL,     100,      50000);
+    scheduler.add("stats",   taskStats,   this, STATS_INTERVAL,   1000,     20000);
+    scheduler.add("health",  taskHealth,  this, HEALTH_INTERVAL,  500,      2000);
+    scheduler.add("track",   taskTrack,   this, TRACK_INTERVAL,   500,      20000);
+    scheduler.add("route",   taskRoute,   this, ROUTE_INTERVAL,   20,       2000);
+    loopStats.begin();
+    
+    // 11) Watch the loop task and subscribe it to the task watchdog
+    loopHealthId = health.watch("loop", xTaskGetCurrentTaskHandle(),
+                                CONFIG_ARDUINO_LOOP_STACK_SIZE, LOOP_CHECKIN_TIMEOUT);
+    if (routeUp.getTask()) {
+        health.watch("routeup", routeUp.getTask(), ROUTE_TASK_STACK, 0);  // Sleeps until bytes arrive
+    }
+    health.begin();
+    
+#if LORA_BEACON_ENABLED
+    // 12) Bring up the SX1262 and start the position beacon
+    Mcu.begin(HELTEC_BOARD, SLOW_CLK_TPYE);
+    peers.begin();
+    if (beacon.begin(beaconNodeIdFromMac(ESP.getEfuseMac()))) {
+        linkAdapt.begin(beacon.getMaxRate());
+        if (beacon.getIrqTask()) {
+            health.watch("radio", beacon.getIrqTask(), BEACON_IRQ_TASK_STACK, 0);  // Stack/CPU only: sleeps until DIO1
+        }
+        beacon.setReceiveHandler(onBeaconRx, this);   // Listen for peers between beacons
+        scheduler.add("radio", taskRadio, this, RADIO_INTERVAL, 20, 5000);
+    }
+#endif
+#if BLE_NAV_ENABLED
+    // 13) Advertise the Location and Navigation service (plus route upload)
+    if (ble.begin(beaconNodeIdFromMac(ESP.getEfuseMac()),
+                  routeUp.getTask() ? RouteUpload::addBleServiceHook : nullptr, &routeUp)) {
+        scheduler.add("ble", taskBle, this, BLE_INTERVAL, 20, 2000);
+        if (trackLog.isMounted() && trackTx.begin(trackLog, ble)) {
+            health.watch("bletrack", trackTx.getTask(), BLE_TRACK_TASK_STACK, 0);  // Sleeps until a download
+        }
+#if BLE_BCAST_ENABLED
+        if (!bcast.begin(beaconNodeIdFromMac(ESP.getEfuseMac()))) {
+            Serial.println("→ BLE broadcast set failed to start");
+        }
+#endif
+    } else {
+        Serial.println("→ BLE init failed, LNS disabled");
+    }
+#endif
+#if AES_BENCHMARK
+    runAesBenchmark(Serial);
+#endif
+    Serial.println("→ Scheduler started");
 }
 
 inline void HTITTracker::update() {
-    // A) Check button for screen switching
-    checkButton();
-    
-    // B) Read raw NMEA from Serial1, echo to USB-Serial, accumulate lines
+    // Run every subsystem whose period has elapsed, then idle until the next one
+    loopStats.beginPass();
+    scheduler.runDue();
+    loopStats.endPass();
+    health.checkIn(loopHealthId);
+    
+    uint32_t idleMs = scheduler.msUntilNextDue();
+    if (idleMs > 0) {
+        // delay() blocks in vTaskDelay, letting the idle task (and light sleep) run;
+        // UART bytes keep landing in the RX FIFO meanwhile
+        delay(idleMs);
+    }
+}
+
+inline void HTITTracker::drainNMEA() {
+    // Read raw NMEA from Serial1, echo to USB-Serial, parse as it streams in
     while (Serial1.available() > 0) {
         char c = (char)Serial1.read();
         Serial.write(c);  // echo raw NMEA
-        if (c == '\r' || c == '\n') {
-            if (linePos > 0) {
-                lineBuf[linePos] = '\0';
-                processNMEALine(lineBuf);
-                linePos = 0;
-            }
-        }
-        else if (linePos < (int)sizeof(lineBuf) - 1) {
-            lineBuf[linePos++] = c;
+        if (gnss.encode(c)) {
+            applyGnssSentence();
         }
     }
+}
 
-    // C) Once per second, update display
-    unsigned long now = millis();
-    if (now - lastLCDupdate >= LCD_INTERVAL) {
-        lastLCDupdate = now;
-
-        // 1) Read raw ADC + true VBAT (volts)
-        int rawADC = 0;
-        float vb = readBatteryVoltageRaw(rawADC);
-
-        // 2) Compute "calibrated VBAT" using 5.05× instead of 4.90×
-        float vb_cal = (rawADC / 4095.0f) * 3.3f * 5.05f;
-
-        // 3) Update charging status and get stable battery percentage
-        updateChargingStatus(vb_cal);
-        int pct_cal = getStableBatteryPercent(vb_cal);
-
-        // 4) Debug print every 2 s
-        static unsigned long lastPrint = 0;
-        static bool firstTime = true;
-        if (firstTime || (now - lastPrint >= 2000)) {
-            firstTime = false;
-            lastPrint = now;
-            float vAD = (rawADC / 4095.0f) * 3.3f;
-            Serial.print("Raw ADC = "); Serial.print(rawADC);
-            Serial.print("    V_ADC = "); Serial.print(vAD, 3); Serial.print(" V");
-            Serial.print("    VBAT = "); Serial.print(vb, 2); Serial.print(" V");
-            Serial.print("    VBAT_cal = "); Serial.print(vb_cal, 2); Serial.print(" V");
-            Serial.print("    Batt% = "); Serial.print(pct_cal); 
-            Serial.print(" %    Charging: "); Serial.println(isCharging ? "Yes" : "No");
-        }
+inline void HTITTracker::sampleBattery() {
+    // 1) Read raw ADC + true VBAT (volts)
+    lastVbat = readBatteryVoltageRaw(lastRawADC);
 
-        // 5) Draw display based on current screen
-        updateLCD(pct_cal);
-    }
+    // 2) Compute "calibrated VBAT" using 5.05× instead of 4.90×
+    lastVbatCal = (lastRawADC / 4095.0f) * 3.3f * 5.05f;
+
+    // 3) Update charging status and get stable battery percentage
+    updateChargingStatus(lastVbatCal);
+    batteryPercent = getStableBatteryPercent(lastVbatCal);
 }
 
-inline void HTITTracker::processNMEALine(const char* line) {
-    if (strncmp(line, "$GPGSV", 6) == 0) {
-        gpsCount = parseGSVinView(line);
-    }
-    else if (strncmp(line, "$GLGSV", 6) == 0) {
-        glonassCount = parseGSVinView(line);
-    }
-    else if (strncmp(line, "$GBGSV", 6) == 0) {
-        beidouCount = parseGSVinView(line);
+inline void HTITTracker::printDebugStatus() {
+    float vAD = (lastRawADC / 4095.0f) * 3.3f;
+    Serial.print("Raw ADC = "); Serial.print(lastRawADC);
+    Serial.print("    V_ADC = "); Serial.print(vAD, 3); Serial.print(" V");
+    Serial.print("    VBAT = "); Serial.print(lastVbat, 2); Serial.print(" V");
+    Serial.print("    VBAT_cal = "); Serial.print(lastVbatCal, 2); Serial.print(" V");
+    Serial.print("    Batt% = "); Serial.print(batteryPercent); 
+    Serial.print(" %    Charging: "); Serial.println(isCharging ? "Yes" : "No");
+}
+
+inline void HTITTracker::printLoopStats() {
+    loopStats.print(Serial);
+    scheduler.print(Serial);
+    health.print(Serial);
+    Serial.printf("beacon tx=%lu (key=%lu delta=%lu %luB %lums) rx=%lu rxerr=%lu\n",
+                  (unsigned long)beacon.txCount, (unsigned long)beacon.keyframes,
+                  (unsigned long)beacon.deltas, (unsigned long)beacon.bytesSent,
+                  (unsigned long)beacon.airtimeTotalMs, (unsigned long)beacon.rxCount,
+                  (unsigned long)beacon.rxErrors);
+    Serial.printf("link SF%d/%dkHz ask=SF%d every=%lums changes=%lu\n",
+                  LINK_RATES[beacon.getRate()].sf, 125 << LINK_RATES[beacon.getRate()].bw,
+                  LINK_RATES[linkAdapt.requested()].sf, (unsigned long)beacon.getIntervalMs(),
+                  (unsigned long)linkAdapt.changes);
+    Serial.printf("listen mode=%d cad=%lu hits=%lu false=%lu\n", BEACON_LISTEN_MODE,
+                  (unsigned long)beacon.cadRuns, (unsigned long)beacon.cadHits,
+                  (unsigned long)beacon.cadFalse);
+    beacon.irqLatency.print(Serial, "rfirq");
+    beacon.irqService.print(Serial, "rfsvc");
+    Serial.printf("peers=%d/%d evicted=%lu orphan=%lu\n", peers.count(), peers.capacity(),
+                  (unsigned long)peers.evictions, (unsigned long)peers.orphanDeltas);
+    Serial.printf("ble conn=%d ci=%ums notify=%lu (%luB) batches=%lu coalesced=%lu\n",
+                  ble.isConnected(), ble.getConnIntervalMs(), (unsigned long)ble.notifications,
+                  (unsigned long)ble.bytesSent, (unsigned long)ble.batches, (unsigned long)ble.coalesced);
+#if BLE_BCAST_ENABLED
+    Serial.printf("bcast every=%ums air=%luus duty=%luppm updates=%lu same=%lu fail=%lu\n",
+                  bcast.getInterval(), (unsigned long)bcast.eventAirUs(), (unsigned long)bcast.dutyPpm(),
+                  (unsigned long)bcast.updates, (unsigned long)bcast.unchanged, (unsigned long)bcast.failures);
+#endif
+    Serial.printf("route points=%lu leg=%lu/%lu uploads=%lu fail=%lu last=%lu pts %lums frameerr=%lu drop=%luB\n",
+                  (unsigned long)route.size(), (unsigned long)routeNav.getLeg(), (unsigned long)routeNav.getTotal(),
+                  (unsigned long)routeUp.uploads, (unsigned long)routeUp.failures,
+                  (unsigned long)routeUp.lastPoints, (unsigned long)routeUp.lastMs,
+                  (unsigned long)routeUp.frameErrors(), (unsigned long)routeUp.dropped);
+    Serial.printf("zones=%u fixes=%lu tests=%lu edges=%lu rebuilds=%lu\n", zones.count(),
+                  (unsigned long)zones.fixes, (unsigned long)zones.zoneTests, (unsigned long)zones.edgeTests,
+                  (unsigned long)zones.rebuilds);
+    Serial.printf("track points=%lu pages=%lu dl=%lu fail=%lu last=%luB %lu B/s %lu ms/MB\n",
+                  (unsigned long)trackLog.points, (unsigned long)trackLog.pageWrites,
+                  (unsigned long)trackTx.transfers, (unsigned long)trackTx.failures,
+                  (unsigned long)trackTx.lastBytes, (unsigned long)trackTx.lastRate(),
+                  (unsigned long)trackTx.lastMsPerMB());
+}
+
+inline void HTITTracker::getBleNavTarget(const NavSnapshot& snap, BleNavTarget& target) {
+    // Follow whatever the screen is navigating to; home otherwise
+    double lat = snap.homeLat, lon = snap.homeLon;
+    bool valid = snap.homeEstablished;
+    Peer peer;
+    
+    switch (currentScreen) {
+        case SCREEN_WAYPOINT1_NAV:
+        case SCREEN_WAYPOINT2_NAV:
+        case SCREEN_WAYPOINT3_NAV: {
+            const Waypoint& wp = waypoints[currentScreen - SCREEN_WAYPOINT1_NAV];
+            valid = wp.isSet;
+            lat = wp.lat;
+            lon = wp.lon;
+            break;
+        }
+        case SCREEN_PEER_NAV:
+            valid = peers.snapshot(activePeer, peer);
+            lat = peer.fix.latE6 / 1e6;
+            lon = peer.fix.lonE6 / 1e6;
+            break;
+        case SCREEN_ROUTE_NAV:
+            valid = routeNav.isActive();
+            lat = routeNav.targetLat();
+            lon = routeNav.targetLon();
+            break;
+        default:
+            break;
     }
-    else if (strncmp(line, "$GAGSV", 6) == 0) {
-        galileoCount = parseGSVinView(line);
+    
+    target.valid = valid && snap.hasPosition;
+    target.bearingDeg = target.valid ? greatCircleBearing(snap.lat, snap.lon, lat, lon) : 0.0f;
+    target.distanceM = target.valid ? greatCircleDistance(snap.lat, snap.lon, lat, lon) : 0.0f;
+}
+
+inline void HTITTracker::serviceRoute() {
+    // 1) USB console bytes go to the upload task as they are; it does the parsing
+    uint8_t buf[256];
+    int avail;
+    while ((avail = Serial.available()) > 0) {
+        size_t n = Serial.read(buf, avail < (int)sizeof(buf) ? avail : sizeof(buf));
+        if (n == 0) break;
+        routeUp.feed(ROUTE_IN_USB, buf, n);
+    }
+    
+    // 2) A committed upload replaces the route; a follower restarts on it
+    uint32_t gen = routeUp.generation();
+    if (gen != routeGeneration) {
+        routeGeneration = gen;
+        route.load();
+        if ((routeNav.isActive() || routeNav.isFinished()) && !tracBackActive) {
+            routeNav.start(route);
+        }
+        Serial.printf("→ Route reloaded: %lu points\n", (unsigned long)route.size());
     }
-    else if (strncmp(line, "$GQGSV", 6) == 0) {
-        qzssCount = parseGSVinView(line);
+    
+    // 3) TracBack reads the log a piece per pass, then joins the way back at the nearest leg
+    if (tracBack.isBuilding() && !tracBack.step()) {
+        NavSnapshot snap;
+        navState.read(snap);
+        uint32_t leg = 0;
+        float dist = 0.0f;
+        if (snap.hasPosition) {
+            tracBack.nearestLeg(snap.lat, snap.lon, leg, dist);
+        }
+        if (tracBack.size() >= 2) {
+            routeNav.start(tracBack, leg);
+        }
+        Serial.printf("→ TracBack: %lu log points, %lu route points (%ld m), joining leg %lu\n",
+                      (unsigned long)tracBack.decoded, (unsigned long)tracBack.size(),
+                      (long)tracBack.tolerance(), (unsigned long)leg + 1);
+    }
+    
+    // 4) Advance the leg on each new fix; on TracBack, skip to a later leg we are already on
+    uint32_t navGen = navState.generation();
+    if (navGen != routeNavGeneration && routeNav.isActive()) {
+        routeNavGeneration = navGen;
+        NavSnapshot snap;
+        navState.read(snap);
+        if (snap.hasPosition && snap.haveFix && routeNav.update(snap.lat, snap.lon)) {
+            Serial.printf("→ Route leg %lu/%lu\n", (unsigned long)routeNav.getLeg() + 1,
+                          (unsigned long)routeNav.getTotal());
+        }
+        uint32_t leg;
+        float dist;
+        if (tracBackActive && routeNav.isActive() && snap.hasPosition && snap.haveFix &&
+            tracBack.nearestLeg(snap.lat, snap.lon, leg, dist) && leg > routeNav.getLeg() + 1 &&
+            dist < TRACBACK_REJOIN_M) {
+            routeNav.start(tracBack, leg);
+            Serial.printf("→ TracBack: skipped ahead to leg %lu/%lu\n", (unsigned long)leg + 1,
+                          (unsigned long)routeNav.getTotal());
+        }
     }
-    else if (strncmp(line, "$GNGGA", 6) == 0) {
-        // 1) Fix quality (7th field)
-        int fixQual = parseGGAfixQuality(line);
-        haveFix = (fixQual > 0);
+}
 
-        // 2) HDOP (9th field) → update lastHDOP if valid
-        float hdop = parseGGAHDOP(line);
-        if (hdop > 0.0f && hdop < 100.0f) {
-            lastHDOP = hdop;
+inline void HTITTracker::serviceZones() {
+    // 1) A committed zone upload replaces the zones
+    uint32_t gen = routeUp.zoneGeneration();
+    if (gen != zoneGeneration) {
+        zoneGeneration = gen;
+        Serial.printf("→ Zones reloaded: %u\n", zones.load());
+        if (currentScreen == SCREEN_ZONE_ALERT) {
+            currentScreen = alertReturn;
+            menuIndex = alertReturnIndex;
         }
-        
-        // 3) Parse position (latitude and longitude)
-        double lat, lon;
-        if (parseGGAPosition(line, lat, lon)) {
-            currentLat = lat;
-            currentLon = lon;
-            hasValidPosition = true;
-            
-            // Calculate speed if we have a previous position
-            calculateSpeed();
-            
-            // Establish home if we have a fix and haven't set home yet
-            if (haveFix && !homeEstablished) {
-                homeLat = lat;
-                homeLon = lon;
-                homeEstablished = true;
-                Serial.println("→ HOME ESTABLISHED!");
-                Serial.print("   Home coordinates: ");
-                Serial.print(homeLat, 6); Serial.print(", "); Serial.println(homeLon, 6);
+    }
+    
+    // 2) Each new fix once
+    NavSnapshot snap;
+    navState.read(snap);
+    if (!snap.haveFix || !snap.hasPosition || snap.fixMillis == zoneFixMillis) {
+        return;
+    }
+    zoneFixMillis = snap.fixMillis;
+    ZoneEvent events[ZONE_MAX_ZONES];
+    uint8_t n = zones.update(snap.lat, snap.lon, events, ZONE_MAX_ZONES);
+    
+    // 3) Log every event; a violation takes the screen until acknowledged
+    for (uint8_t i = 0; i < n; i++) {
+        const Zone& z = zones.zone(events[i].zone);
+        zones.logEvent(events[i], millis() / 1000);
+        Serial.printf("→ Zone '%s' (%s): %s at %.6f,%.6f\n", z.name,
+                      z.rule == ZONE_RULE_KEEP_OUT ? "keep-out" : "keep-in",
+                      events[i].type == ZONE_ENTER ? "entered" : "left", snap.lat, snap.lon);
+        if (events[i].violation) {
+            if (currentScreen != SCREEN_ZONE_ALERT) {
+                alertReturn = currentScreen;
+                alertReturnIndex = menuIndex;
             }
+            alertZone = events[i].zone;
+            currentScreen = SCREEN_ZONE_ALERT;
+            forceScreenRedraw = true;
         }
     }
-    // Sum satellites in view
-    totalInView = gpsCount + glonassCount + beidouCount + galileoCount + qzssCount;
-}
-
-inline int HTITTracker::parseGSVinView(const char* gsvLine) {
-    // Extract 4th field (<totalInView>) from "$GxGSV"
-    const char* p = strchr(gsvLine, ',');
-    if (!p) return 0;
-    p = strchr(p + 1, ','); if (!p) return 0;
-    p = strchr(p + 1, ','); if (!p) return 0;
-    return atoi(p + 1);
 }
 
-inline int HTITTracker::parseGGAfixQuality(const char* ggaLine) {
-    // Extract 7th field (<fixQuality>) from "$GNGGA"
-    int commaCount = 0;
-    const char* p = ggaLine;
-    while (*p && commaCount < 6) {
-        if (*p == ',') commaCount++;
-        p++;
+inline void HTITTracker::handlePeerBeacon(const uint8_t* payload, uint16_t size, int16_t rssi, int8_t snr) {
+    // 1) Classify; anything that is not one of our beacons is dropped
+    BeaconHeader hdr;
+    if (!beaconPeek(payload, size, hdr)) {
+        Serial.printf("→ LoRa RX: %u bytes ignored (RSSI %d)\n", size, rssi);
+        return;
+    }
+    
+    // 2) Ignore our own node id (another unit with a colliding hash, or a relay)
+    if (hdr.nodeId == beacon.getNodeId()) {
+        return;
     }
-    if (!*p) return 0;
-    return atoi(p);
+    
+    // 3) Decode; a delta needs the keyframe it was built against
+    BeaconFix fix;
+    bool keyframe = (hdr.kind == BEACON_KEYFRAME);
+    unsigned long packets, lost;
+    {
+        PeerTableLock lock(peers);
+        if (keyframe) {
+            if (!beaconDecode(payload, size, fix)) return;
+        } else {
+            const BeaconFix* key = peers.keyFor(hdr.nodeId, hdr.keySeq);
+            if (!key || !beaconDecodeDelta(payload, size, *key, fix)) {
+                peers.orphanDeltas++;
+                Serial.printf("→ Peer %04X: delta #%u without keyframe #%u, dropped\n",
+                              hdr.nodeId, hdr.seq, hdr.keySeq);
+                return;
+            }
+        }
+        
+        // 4) Update the peer table
+        Peer* p = peers.update(fix, keyframe, rssi, snr, millis());
+        linkAdapt.observe(*p, snr);
+        packets = p->packets;
+        lost = p->lost;
+    }
+    Serial.printf("→ Peer %04X: %.6f,%.6f %s %uB RSSI %d SNR %d (%lu rx, %lu lost)\n",
+                  fix.nodeId, fix.latE6 / 1e6, fix.lonE6 / 1e6, keyframe ? "key" : "delta",
+                  size, rssi, snr, packets, lost);
 }
 
-inline float HTITTracker::parseGGAHDOP(const char* ggaLine) {
-    // Extract 9th field (<HDOP>) from "$GNGGA"
-    int commaCount = 0;
-    const char* p = ggaLine;
-    while (*p && commaCount < 8) {
-        if (*p == ',') commaCount++;
-        p++;
+// One whole sentence from a line-based source, e.g. "$GNGGA,...*7D"
+inline void HTITTracker::processNMEALine(const char* line) {
+    while (*line) {
+        if (gnss.encode(*line++)) applyGnssSentence();
     }
-    if (!*p || *p == ',') return -1.0f;
-    return atof(p);
+    if (gnss.encode('\r')) applyGnssSentence();
 }
 
-inline bool HTITTracker::parseGGAPosition(const char* ggaLine, double &lat, double &lon) {
-    // Parse $GNGGA format: $GNGGA,time,lat,N/S,lon,E/W,fix,sats,hdop,alt,M,geoid,M,dgps_age,dgps_id*checksum
-    // Fields: 0=GNGGA, 1=time, 2=lat, 3=N/S, 4=lon, 5=E/W, 6=fix_quality
-    
-    const char* fields[15];
-    int fieldCount = 0;
-    const char* start = ggaLine;
-    
-    // Split the line by commas
-    for (const char* p = ggaLine; *p && fieldCount < 15; p++) {
-        if (*p == ',' || *p == '*') {
-            fields[fieldCount++] = start;
-            start = p + 1;
+// Called once per sentence that passed its checksum
+inline void HTITTracker::applyGnssSentence() {
+    // 1) Satellites in view per constellation (GSV, any talker)
+    if (gnss.satsInView[GNSS_GPS].isUpdated()) gpsCount = gnss.satsInView[GNSS_GPS].value();
+    if (gnss.satsInView[GNSS_GLONASS].isUpdated()) glonassCount = gnss.satsInView[GNSS_GLONASS].value();
+    if (gnss.satsInView[GNSS_BEIDOU].isUpdated()) beidouCount = gnss.satsInView[GNSS_BEIDOU].value();
+    if (gnss.satsInView[GNSS_GALILEO].isUpdated()) galileoCount = gnss.satsInView[GNSS_GALILEO].value();
+    if (gnss.satsInView[GNSS_QZSS].isUpdated()) qzssCount = gnss.satsInView[GNSS_QZSS].value();
+
+    // 2) Fix quality and HDOP (GGA) → update lastHDOP if valid
+    if (gnss.fixQuality.isUpdated()) {
+        uint32_t fixQual = gnss.fixQuality.value();
+        haveFix = (fixQual > 0);
+        lastFixQuality = (uint8_t)(fixQual > 255u ? 255u : fixQual);
+    }
+    if (gnss.hdop.isUpdated()) {
+        float hdop = (float)gnss.hdop.hdop();
+        if (hdop > 0.0f && hdop < 100.0f) {
+            lastHDOP = hdop;
         }
     }
     
-    if (fieldCount < 6) return false;
-    
-    // Parse latitude (field 2, format: ddmm.mmmmm)
-    const char* latStr = fields[2];
-    const char* latDir = fields[3];
-    if (strlen(latStr) < 7 || strlen(latDir) < 1) return false;
-    
-    double latDeg = (latStr[0] - '0') * 10 + (latStr[1] - '0');
-    double latMin = atof(latStr + 2);
-    lat = latDeg + latMin / 60.0;
-    if (latDir[0] == 'S') lat = -lat;
-    
-    // Parse longitude (field 4, format: dddmm.mmmmm)
-    const char* lonStr = fields[4];
-    const char* lonDir = fields[5];
-    if (strlen(lonStr) < 8 || strlen(lonDir) < 1) return false;
-    
-    double lonDeg = (lonStr[0] - '0') * 100 + (lonStr[1] - '0') * 10 + (lonStr[2] - '0');
-    double lonMin = atof(lonStr + 3);
-    lon = lonDeg + lonMin / 60.0;
-    if (lonDir[0] == 'W') lon = -lon;
+    // 3) Position (GGA or RMC with a fix)
+    if (gnss.location.isUpdated()) {
+        double lat = gnss.location.lat();
+        double lon = gnss.location.lng();
+        currentLat = lat;
+        currentLon = lon;
+        hasValidPosition = true;
+        lastFixMillis = millis();
+        if (gnss.altitude.isUpdated()) {
+            currentAltitude = (float)gnss.altitude.meters();
+            hasValidAltitude = true;
+        }
+        
+        // Calculate speed if we have a previous position
+        calculateSpeed();
+        
+        // Establish home if we have a fix and haven't set home yet
+        if (haveFix && !homeEstablished) {
+            homeLat = lat;
+            homeLon = lon;
+            homeEstablished = true;
+            Serial.println("→ HOME ESTABLISHED!");
+            Serial.print("   Home coordinates: ");
+            Serial.print(homeLat, 6); Serial.print(", "); Serial.println(homeLon, 6);
+        }
+    }
+    // Sum satellites in view
+    totalInView = gpsCount + glonassCount + beidouCount + galileoCount + qzssCount;
     
-    return true;
+    // Publish the whole sentence's effect at once
+    publishNavSnapshot();
+}
+
+inline void HTITTracker::publishNavSnapshot() {
+    NavSnapshot snap;
+    memset(&snap, 0, sizeof(snap));
+    snap.fixMillis = lastFixMillis;
+    snap.lat = currentLat;
+    snap.lon = currentLon;
+    snap.hdop = lastHDOP;
+    snap.fixQuality = lastFixQuality;
+    snap.haveFix = haveFix;
+    snap.hasPosition = hasValidPosition;
+    snap.altitudeM = currentAltitude;
+    snap.hasAltitude = hasValidAltitude;
+    snap.speedKmh = currentSpeed;
+    snap.hasSpeed = hasValidSpeed;
+    snap.courseDeg = currentCourse;
+    snap.hasCourse = hasValidCourse;
+    snap.satsInView = (uint8_t)constrain(totalInView, 0, 255);
+    snap.gpsCount = (uint8_t)constrain(gpsCount, 0, 255);
+    snap.glonassCount = (uint8_t)constrain(glonassCount, 0, 255);
+    snap.beidouCount = (uint8_t)constrain(beidouCount, 0, 255);
+    snap.galileoCount = (uint8_t)constrain(galileoCount, 0, 255);
+    snap.qzssCount = (uint8_t)constrain(qzssCount, 0, 255);
+    snap.homeEstablished = homeEstablished;
+    snap.homeLat = homeLat;
+    snap.homeLon = homeLon;
+    navState.publish(snap);
 }
 
 inline float HTITTracker::readBatteryVoltageRaw(int &rawADC) {
@@ -517,15 +1027,15 @@ inline int HTITTracker::voltageToPercent(float vb) {
 
 // Home navigation helper methods implementation
 inline float HTITTracker::calculateBearingToHome() {
-    if (!homeEstablished || !hasValidPosition) {
+    if (!nav.homeEstablished || !nav.hasPosition) {
         return 0.0f;  // Default to North
     }
     
     // Calculate bearing from current position to home
-    double lat1 = currentLat * PI / 180.0;
-    double lon1 = currentLon * PI / 180.0;
-    double lat2 = homeLat * PI / 180.0;
-    double lon2 = homeLon * PI / 180.0;
+    double lat1 = nav.lat * PI / 180.0;
+    double lon1 = nav.lon * PI / 180.0;
+    double lat2 = nav.homeLat * PI / 180.0;
+    double lon2 = nav.homeLon * PI / 180.0;
     
     double dLon = lon2 - lon1;
     
@@ -539,15 +1049,15 @@ inline float HTITTracker::calculateBearingToHome() {
 }
 
 inline float HTITTracker::calculateDistanceToHome() {
-    if (!homeEstablished || !hasValidPosition) {
+    if (!nav.homeEstablished || !nav.hasPosition) {
         return 0.0f;  // No distance if no home or position
     }
     
     // Calculate distance using Haversine formula
-    double lat1 = currentLat * PI / 180.0;
-    double lon1 = currentLon * PI / 180.0;
-    double lat2 = homeLat * PI / 180.0;
-    double lon2 = homeLon * PI / 180.0;
+    double lat1 = nav.lat * PI / 180.0;
+    double lon1 = nav.lon * PI / 180.0;
+    double lat2 = nav.homeLat * PI / 180.0;
+    double lon2 = nav.homeLon * PI / 180.0;
     
     double dLat = lat2 - lat1;
     double dLon = lon2 - lon1;
@@ -588,10 +1098,10 @@ inline void HTITTracker::checkButton() {
         
         // Long press actions - scroll through menu or return to main menu
         if (currentScreen == SCREEN_MAIN_MENU) {
-            menuIndex = (menuIndex + 1) % 4;  // 4 items in main menu now (removed Navigation)
+            menuIndex = (menuIndex + 1) % 7;  // 7 items: Status, Waypoints, Track, Trip, Peers, System Info, Power
             Serial.println("→ Main menu scroll (long press)");
         } else if (currentScreen == SCREEN_WAYPOINT_MENU) {
-            menuIndex = (menuIndex + 1) % 4;  // 4 items in waypoint menu
+            menuIndex = (menuIndex + 1) % 6;  // WP1-3, Route, TracBack, Back
             Serial.println("→ Waypoint menu scroll (long press)");
         } else if (currentScreen == SCREEN_WAYPOINT_RESET) {
             menuIndex = (menuIndex + 1) % 3;  // 3 options: Navigate, Reset, Cancel
@@ -599,6 +1109,9 @@ inline void HTITTracker::checkButton() {
         } else if (currentScreen == SCREEN_POWER_MENU) {
             menuIndex = (menuIndex + 1) % 4;  // 4 options: Sleep, Deep Sleep, Screen Off, Back
             Serial.println("→ Power menu scroll (long press)");
+        } else if (currentScreen == SCREEN_PEER_LIST) {
+            menuIndex = (menuIndex + 1) % (peers.count() + 1);  // Peers + Back
+            Serial.println("→ Peer list scroll (long press)");
         } else {
             // From any other screen, long press returns to main menu
             currentScreen = SCREEN_MAIN_MENU;
@@ -616,7 +1129,7 @@ inline void HTITTracker::checkButton() {
             lastActivity = now;
             
             if (currentScreen == SCREEN_MAIN_MENU) {
-                // Handle main menu selection (now has 4 items - removed Navigation)
+                // Handle main menu selection (7 items)
                 if (menuIndex == 0) {  // Status
                     currentScreen = SCREEN_STATUS;
                     Serial.println("→ Entered Status Screen");
@@ -624,10 +1137,22 @@ inline void HTITTracker::checkButton() {
                     currentScreen = SCREEN_WAYPOINT_MENU;
                     menuIndex = 0;
                     Serial.println("→ Entered Waypoint Menu");
-                } else if (menuIndex == 2) {  // System Info
+                } else if (menuIndex == 2) {  // Track
+                    currentScreen = SCREEN_TRAIL;
+                    trailZoom = 1;
+                    Serial.println("→ Entered Track View");
+                } else if (menuIndex == 3) {  // Trip
+                    currentScreen = SCREEN_TRIP;
+                    tripPage = 0;
+                    Serial.println("→ Entered Trip");
+                } else if (menuIndex == 4) {  // Peers
+                    currentScreen = SCREEN_PEER_LIST;
+                    menuIndex = 0;
+                    Serial.println("→ Entered Peer List");
+                } else if (menuIndex == 5) {  // System Info
                     currentScreen = SCREEN_SYSTEM_INFO;
                     Serial.println("→ Entered System Info");
-                } else if (menuIndex == 3) {  // Power Menu
+                } else if (menuIndex == 6) {  // Power Menu
                     currentScreen = SCREEN_POWER_MENU;
                     Serial.println("→ Entered Power Menu");
                 }
@@ -667,18 +1192,38 @@ inline void HTITTracker::checkButton() {
                         waypointToSet = 2;
                         Serial.println("→ Set WP3");
                     }
-                } else if (menuIndex == 3) {  // Back
+                } else if (menuIndex == 3) {  // Route
+                    if (route.size() > 0) {
+                        tracBack.cancel();
+                        tracBackActive = false;
+                        routeNav.start(route);
+                        currentScreen = SCREEN_ROUTE_NAV;
+                        Serial.printf("→ Following route (%lu points)\n", (unsigned long)route.size());
+                    } else {
+                        Serial.println("→ No route uploaded");
+                    }
+                } else if (menuIndex == 4) {  // TracBack
+                    routeNav.stop();
+                    if (tracBack.begin(trackLog)) {
+                        tracBackActive = true;
+                        currentScreen = SCREEN_ROUTE_NAV;
+                        Serial.println("→ TracBack: reading the track log");
+                    } else {
+                        Serial.println("→ TracBack needs the track log");
+                    }
+                } else if (menuIndex == 5) {  // Back
                     currentScreen = SCREEN_MAIN_MENU;
-                    menuIndex = 2;  // Return to Waypoints item
+                    menuIndex = 1;  // Return to Waypoints item
                     Serial.println("→ Back to Main Menu");
                 }
                 
             } else if (currentScreen == SCREEN_SET_WAYPOINT) {
                 // Save waypoint if GPS is ready
-                if (hasValidPosition && haveFix) {
+                navState.read(nav);
+                if (nav.hasPosition && nav.haveFix) {
                     char name[12];
                     snprintf(name, sizeof(name), "WP%d", waypointToSet + 1);
-                    setWaypoint(waypointToSet, currentLat, currentLon, name);
+                    setWaypoint(waypointToSet, nav.lat, nav.lon, name);
                     Serial.println("→ Waypoint saved!");
                     currentScreen = SCREEN_WAYPOINT_MENU;
                     menuIndex = waypointToSet;
@@ -733,6 +1278,9 @@ inline void HTITTracker::checkButton() {
                     st7735.st7735_write_str(0, 32, "to wake up");
                     delay(2000);
                     
+                    trackLog.flush();
+                    trip.save();       // RTC memory outlives deep sleep
+                    
                     // Enter deep sleep - only wakes on button press
                     esp_sleep_enable_ext0_wakeup(GPIO_NUM_0, 0);  // Wake on button press (LOW)
                     esp_deep_sleep_start();
@@ -745,10 +1293,62 @@ inline void HTITTracker::checkButton() {
                     
                 } else if (menuIndex == 3) {  // Back
                     currentScreen = SCREEN_MAIN_MENU;
-                    menuIndex = 4;  // Return to Power Menu item in main menu
+                    menuIndex = 6;  // Return to Power Menu item in main menu
                     Serial.println("→ Back to Main Menu");
                 }
                 
+            } else if (currentScreen == SCREEN_PEER_LIST) {
+                // Handle peer list selection (peers, then Back)
+                Peer p;
+                if (peers.snapshotAt(menuIndex, p)) {
+                    activePeer = p.nodeId;
+                    currentScreen = SCREEN_PEER_NAV;
+                    Serial.printf("→ Navigating to peer %04X\n", activePeer);
+                } else {  // Back
+                    currentScreen = SCREEN_MAIN_MENU;
+                    menuIndex = 4;  // Return to Peers item
+                    Serial.println("→ Back to Main Menu");
+                }
+                
+            } else if (currentScreen == SCREEN_PEER_NAV) {
+                // Peer navigation → back to the list
+                currentScreen = SCREEN_PEER_LIST;
+                menuIndex = 0;
+                Serial.println("→ Back to Peer List");
+                
+            } else if (currentScreen == SCREEN_ROUTE_NAV) {
+                // Route navigation → back to the waypoint menu
+                routeNav.stop();
+                currentScreen = SCREEN_WAYPOINT_MENU;
+                menuIndex = tracBackActive ? 4 : 3;  // Return to the TracBack or Route item
+                tracBack.cancel();
+                tracBackActive = false;
+                Serial.println("→ Back to Waypoint Menu");
+                
+            } else if (currentScreen == SCREEN_ZONE_ALERT) {
+                // Zone alert → acknowledged, back to what was on screen
+                currentScreen = alertReturn;
+                menuIndex = alertReturnIndex;
+                Serial.println("→ Zone alert acknowledged");
+                
+            } else if (currentScreen == SCREEN_TRIP) {
+                // Trip → next page; a press on the last one resets the trip
+                if (tripPage == 2) {
+                    trip.reset();
+                    Serial.println("→ Trip reset");
+                }
+                tripPage = (tripPage + 1) % 3;
+                
+            } else if (currentScreen == SCREEN_TRAIL) {
+                // Track view → next zoom step (whole trail, then 2x, 4x, 8x around us)
+                trailZoom = trailZoom >= 8 ? 1 : trailZoom * 2;
+                Serial.printf("→ Track view zoom %ux\n", trailZoom);
+                
+            } else if (currentScreen == SCREEN_SYSTEM_INFO) {
+                // System Info → Diagnostics page
+                currentScreen = SCREEN_DIAGNOSTICS;
+                Serial.println("→ Entered Diagnostics");
+                
             } else {
                 // From any other screen, return to main menu
                 currentScreen = SCREEN_MAIN_MENU;
@@ -805,6 +1405,14 @@ inline void HTITTracker::calculateSpeed() {
             hasValidSpeed = true;
         }
         
+        // Course over ground from the same two points (ignore GPS jitter when standing still)
+        if (distance > 3.0) {
+            double y = sin(lon2 - lon1) * cos(lat2);
+            double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(lon2 - lon1);
+            currentCourse = fmod(atan2(y, x) * 180.0 / PI + 360.0, 360.0);
+            hasValidCourse = true;
+        }
+        
         // Update for next calculation
         lastLat = currentLat;
         lastLon = currentLon;
@@ -877,6 +1485,9 @@ inline void HTITTracker::updateChargingStatus(float voltage) {
 }
 
 inline void HTITTracker::updateLCD(int pct_cal) {
+    // Take one consistent copy of the navigation state for this frame
+    navState.read(nav);
+    
     // Reset screen state when switching screens
     static ScreenType lastDisplayedScreen = SCREEN_MAIN_MENU;
     if (currentScreen != lastDisplayedScreen) {
@@ -915,6 +1526,27 @@ inline void HTITTracker::updateLCD(int pct_cal) {
         case SCREEN_POWER_MENU:
             updatePowerMenuScreen();
             break;
+        case SCREEN_DIAGNOSTICS:
+            updateDiagnosticsScreen();
+            break;
+        case SCREEN_PEER_LIST:
+            updatePeerListScreen();
+            break;
+        case SCREEN_PEER_NAV:
+            updatePeerNavScreen(pct_cal);
+            break;
+        case SCREEN_ROUTE_NAV:
+            updateRouteNavScreen(pct_cal);
+            break;
+        case SCREEN_TRAIL:
+            updateTrailScreen();
+            break;
+        case SCREEN_ZONE_ALERT:
+            updateZoneAlertScreen();
+            break;
+        case SCREEN_TRIP:
+            updateTripScreen();
+            break;
         default:
             updateStatusScreen(pct_cal);
             break;
@@ -926,21 +1558,21 @@ inline void HTITTracker::updateStatusScreen(int pct_cal) {
     
     // 1) Generate new strings
     char fixBuf[16];
-    if (haveFix) {
+    if (nav.haveFix) {
         sprintf(fixBuf, "Fix: Yes     ");
     } else {
         sprintf(fixBuf, "Fix: No      ");
     }
     
     char satBuf[16];
-    sprintf(satBuf, "Sats:%3d     ", totalInView);
+    sprintf(satBuf, "Sats:%3d     ", nav.satsInView);
     
     char battBuf[16];
     sprintf(battBuf, "Batt:%3d%%    ", pct_cal);  // Consistent with GitHub - no charging indicator
     
-    float accuracy = lastHDOP * 5.0f;  // HDOP × 5 m
+    float accuracy = nav.hdop * 5.0f;  // HDOP × 5 m
     char accBuf[16];
-    if (haveFix && lastHDOP > 0.0f && lastHDOP < 100.0f) {
+    if (nav.haveFix && nav.hdop > 0.0f && nav.hdop < 100.0f) {
         sprintf(accBuf, "Acc:%4.1fm   ", accuracy);
     } else {
         sprintf(accBuf, "Acc: --.-m   ");
@@ -981,7 +1613,7 @@ inline void HTITTracker::updateNavigationScreen(int pct_cal) {
     
     // 1) Generate new strings
     char dirBuf[16];
-    if (haveFix) {
+    if (nav.haveFix) {
         float bearingToHome = calculateBearingToHome();
         const char* direction = getCardinalDirection(bearingToHome);
         sprintf(dirBuf, "Dir: %s      ", direction);
@@ -990,7 +1622,7 @@ inline void HTITTracker::updateNavigationScreen(int pct_cal) {
     }
     
     char distBuf[16];
-    if (homeEstablished && hasValidPosition) {
+    if (nav.homeEstablished && nav.hasPosition) {
         float distanceToHome = calculateDistanceToHome();
         if (distanceToHome < 1000) {
             sprintf(distBuf, "Home:%3.0fm   ", distanceToHome);
@@ -1002,8 +1634,8 @@ inline void HTITTracker::updateNavigationScreen(int pct_cal) {
     }
     
     char speedBuf[16];
-    if (hasValidSpeed && currentSpeed < 99.9) {
-        sprintf(speedBuf, "Spd:%4.1fkm/h ", currentSpeed);
+    if (nav.hasSpeed && nav.speedKmh < 99.9) {
+        sprintf(speedBuf, "Spd:%4.1fkm/h ", nav.speedKmh);
     } else {
         sprintf(speedBuf, "Spd: -.-km/h ");
     }
@@ -1042,11 +1674,11 @@ inline void HTITTracker::updateNavigationScreen(int pct_cal) {
 }
 
 inline const char* HTITTracker::getCardinalDirection(float bearingToHome) {
-    if (!haveFix) {
+    if (!nav.haveFix) {
         return "O";  // Show "O" when no GPS fix yet
     }
     
-    if (!homeEstablished) {
+    if (!nav.homeEstablished) {
         return "N";  // Point North when no home established but have fix
     }
     
@@ -1087,16 +1719,16 @@ inline void HTITTracker::updateMainMenuScreen() {
         st7735.st7735_fill_screen(ST7735_BLACK);
         st7735.st7735_write_str(0, 0, "MAIN MENU");
         
-        // Menu items with selection indicator (4 items total - removed Navigation)
-        String item0 = (menuIndex == 0) ? "> Status" : "  Status";
-        String item1 = (menuIndex == 1) ? "> Waypoints" : "  Waypoints";
-        String item2 = (menuIndex == 2) ? "> System Info" : "  System Info";
-        String item3 = (menuIndex == 3) ? "> Power Menu" : "  Power Menu";
-        
-        st7735.st7735_write_str(0, 16, item0);
-        st7735.st7735_write_str(0, 32, item1);
-        st7735.st7735_write_str(0, 48, item2);
-        st7735.st7735_write_str(0, 64, item3);
+        // 7 items, 4 rows: scroll the window so the selection stays visible
+        static const char* const items[] = { "Status", "Waypoints", "Track", "Trip", "Peers", "System Info",
+                                             "Power Menu" };
+        const int itemCount = sizeof(items) / sizeof(items[0]);
+        int top = menuIndex > 3 ? menuIndex - 3 : 0;
+        for (int row = 0; row < 4 && top + row < itemCount; row++) {
+            int i = top + row;
+            String item = String(i == menuIndex ? "> " : "  ") + items[i];
+            st7735.st7735_write_str(0, 16 * (row + 1), item);
+        }
         
         lastMenuIndex = menuIndex;
         screenInitialized = true;
@@ -1108,6 +1740,7 @@ inline void HTITTracker::updateWaypointMenuScreen() {
     static int lastMenuIndex = -1;
     static bool screenInitialized = false;
     static bool lastWaypointStates[3] = {false, false, false};
+    static uint32_t lastRouteSize = 0;
     
     // Reset if forced
     if (forceScreenRedraw) {
@@ -1125,40 +1758,30 @@ inline void HTITTracker::updateWaypointMenuScreen() {
         }
     }
     
-    // Only redraw if menu selection changed, waypoint states changed, or first time
-    if (!screenInitialized || lastMenuIndex != menuIndex || waypointStatesChanged) {
+    // Only redraw if menu selection changed, waypoint states changed, a route arrived, or first time
+    if (!screenInitialized || lastMenuIndex != menuIndex || waypointStatesChanged ||
+        route.size() != lastRouteSize) {
         st7735.st7735_fill_screen(ST7735_BLACK);
         st7735.st7735_write_str(0, 0, "WAYPOINTS");
         
         // Show waypoint status with X for unset waypoints
-        String item0, item1, item2, item3;
-        
-        if (waypoints[0].isSet) {
-            item0 = (menuIndex == 0) ? "> Nav WP1" : "  Nav WP1";
-        } else {
-            item0 = (menuIndex == 0) ? "> Set WP1 X" : "  Set WP1 X";
-        }
-        
-        if (waypoints[1].isSet) {
-            item1 = (menuIndex == 1) ? "> Nav WP2" : "  Nav WP2";
-        } else {
-            item1 = (menuIndex == 1) ? "> Set WP2 X" : "  Set WP2 X";
+        String items[6];
+        for (int i = 0; i < 3; i++) {
+            items[i] = waypoints[i].isSet ? String("Nav WP") + (i + 1) : String("Set WP") + (i + 1) + " X";
         }
+        items[3] = route.size() > 0 ? String("Route ") + route.size() : String("Route X");
+        items[4] = "TracBack";
+        items[5] = "Back";
         
-        if (waypoints[2].isSet) {
-            item2 = (menuIndex == 2) ? "> Nav WP3" : "  Nav WP3";
-        } else {
-            item2 = (menuIndex == 2) ? "> Set WP3 X" : "  Set WP3 X";
+        // 6 items, 4 rows: scroll the window so the selection stays visible
+        int top = menuIndex > 3 ? menuIndex - 3 : 0;
+        for (int row = 0; row < 4; row++) {
+            int i = top + row;
+            st7735.st7735_write_str(0, 16 * (row + 1), String(i == menuIndex ? "> " : "  ") + items[i]);
         }
         
-        item3 = (menuIndex == 3) ? "> Back" : "  Back";
-        
-        st7735.st7735_write_str(0, 16, item0);
-        st7735.st7735_write_str(0, 32, item1);
-        st7735.st7735_write_str(0, 48, item2);
-        st7735.st7735_write_str(0, 64, item3);
-        
         lastMenuIndex = menuIndex;
+        lastRouteSize = route.size();
         screenInitialized = true;
         forceScreenRedraw = false;  // Clear the force flag
     }
@@ -1180,7 +1803,7 @@ inline void HTITTracker::updateWaypointNavigationScreen(int pct_cal) {
     
     // 1) Generate new strings EVERY time (for real-time updates) - using EXACT GitHub format
     char dirBuf[16];
-    if (haveFix && waypointIndex >= 0 && waypointIndex < 3 && waypoints[waypointIndex].isSet) {
+    if (nav.haveFix && waypointIndex >= 0 && waypointIndex < 3 && waypoints[waypointIndex].isSet) {
         float bearingToWaypoint = calculateBearingToWaypoint(waypointIndex);
         
         // Use EXACT GitHub cardinal direction logic (but for waypoints)
@@ -1209,7 +1832,7 @@ inline void HTITTracker::updateWaypointNavigationScreen(int pct_cal) {
     }
     
     char distBuf[16];
-    if (hasValidPosition && waypointIndex >= 0 && waypointIndex < 3 && waypoints[waypointIndex].isSet) {
+    if (nav.hasPosition && waypointIndex >= 0 && waypointIndex < 3 && waypoints[waypointIndex].isSet) {
         float distanceToWaypoint = calculateDistanceToWaypoint(waypointIndex);
         if (distanceToWaypoint < 1000) {
             sprintf(distBuf, "WP%d:%3.0fm   ", activeWaypoint, distanceToWaypoint);  // EXACT GitHub format
@@ -1221,8 +1844,8 @@ inline void HTITTracker::updateWaypointNavigationScreen(int pct_cal) {
     }
     
     char speedBuf[16];
-    if (hasValidSpeed && currentSpeed < 99.9) {
-        sprintf(speedBuf, "Spd:%4.1fkm/h ", currentSpeed);  // EXACT GitHub format
+    if (nav.hasSpeed && nav.speedKmh < 99.9) {
+        sprintf(speedBuf, "Spd:%4.1fkm/h ", nav.speedKmh);  // EXACT GitHub format
     } else {
         sprintf(speedBuf, "Spd: -.-km/h ");  // EXACT GitHub spacing
     }
@@ -1296,12 +1919,12 @@ inline void HTITTracker::updateSetWaypointScreen() {
     
     if (forceScreenRedraw) {
         screenInitialized = false;
-        lastGPSReady = !hasValidPosition;  // Force change
+        lastGPSReady = !nav.hasPosition;  // Force change
         lastSatCount = -1;
     }
     
-    bool gpsReady = (hasValidPosition && haveFix);
-    bool needsRedraw = !screenInitialized || (gpsReady != lastGPSReady) || (totalInView != lastSatCount);
+    bool gpsReady = (nav.hasPosition && nav.haveFix);
+    bool needsRedraw = !screenInitialized || (gpsReady != lastGPSReady) || (nav.satsInView != lastSatCount);
     
     if (needsRedraw) {
         st7735.st7735_fill_screen(ST7735_BLACK);
@@ -1315,11 +1938,11 @@ inline void HTITTracker::updateSetWaypointScreen() {
             st7735.st7735_write_str(0, 32, "Press to save");
         } else {
             st7735.st7735_write_str(0, 16, "Wait for GPS...");
-            st7735.st7735_write_str(0, 32, String("Sats: " + String(totalInView)));
+            st7735.st7735_write_str(0, 32, String("Sats: " + String(nav.satsInView)));
         }
         
         lastGPSReady = gpsReady;
-        lastSatCount = totalInView;
+        lastSatCount = nav.satsInView;
         screenInitialized = true;
         forceScreenRedraw = false;
     }
@@ -1329,18 +1952,28 @@ inline void HTITTracker::updateSystemInfoScreen(int pct_cal) {
     static bool screenInitialized = false;
     static int lastSatCount = -1;
     static int lastBattPercent = -1;
+    static uint32_t lastStallMs = UINT32_MAX;
     
-    bool needsRedraw = !screenInitialized || (totalInView != lastSatCount) || (pct_cal != lastBattPercent);
+    uint32_t stallMs = loopStats.maxStallUs / 1000;
+    bool needsRedraw = !screenInitialized || (nav.satsInView != lastSatCount) || (pct_cal != lastBattPercent) ||
+                       (stallMs != lastStallMs);
     
     if (needsRedraw) {
         st7735.st7735_fill_screen(ST7735_BLACK);
         st7735.st7735_write_str(0, 0, "SYSTEM INFO");
         st7735.st7735_write_str(0, 16, "FW: v1.2 Enh");
-        st7735.st7735_write_str(0, 32, String("Sats: " + String(totalInView)));
+        st7735.st7735_write_str(0, 32, String("Sats: " + String(nav.satsInView)));
         st7735.st7735_write_str(0, 48, String("Batt: " + String(pct_cal) + "%"));
         
-        lastSatCount = totalInView;
+        // Worst main-loop stall and the phase that caused it
+        char stallBuf[16];
+        snprintf(stallBuf, sizeof(stallBuf), "Stl:%4lums %.3s", (unsigned long)min(stallMs, (uint32_t)9999),
+                 LoopStats::phaseName(loopStats.maxStallCause));
+        st7735.st7735_write_str(0, 64, stallBuf);
+        
+        lastSatCount = nav.satsInView;
         lastBattPercent = pct_cal;
+        lastStallMs = stallMs;
         screenInitialized = true;
     }
 }
@@ -1370,6 +2003,377 @@ inline void HTITTracker::updatePowerMenuScreen() {
     }
 }
 
+inline void HTITTracker::updateDiagnosticsScreen() {
+    static bool screenInitialized = false;
+    static uint32_t lastSamples = 0;
+    
+    // Redraw once per health sample (1 s)
+    if (!screenInitialized || forceScreenRedraw || health.samples != lastSamples) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        st7735.st7735_write_str(0, 0, "DIAGNOSTICS");
+        
+        char buf[16];
+        if (health.coreIdlePercent[0] >= 0) {
+            snprintf(buf, sizeof(buf), "Idle %3d/%3d%%", health.coreIdlePercent[0],
+                     portNUM_PROCESSORS > 1 ? health.coreIdlePercent[portNUM_PROCESSORS - 1] : 0);
+        } else {
+            snprintf(buf, sizeof(buf), "Idle: n/a");
+        }
+        st7735.st7735_write_str(0, 16, buf);
+        
+        int tight = health.tightestStack();
+        if (tight >= 0) {
+            const WatchedTask& t = health.task(tight);
+            snprintf(buf, sizeof(buf), "%-5.5s%5luB", t.name, (unsigned long)min(t.stackFreeMin, (uint32_t)99999));
+        } else {
+            snprintf(buf, sizeof(buf), "Stack: n/a");
+        }
+        st7735.st7735_write_str(0, 32, buf);
+        
+        snprintf(buf, sizeof(buf), "Heap:%4luk", (unsigned long)(health.freeHeap / 1024));
+        st7735.st7735_write_str(0, 48, buf);
+        
+        snprintf(buf, sizeof(buf), "WDT miss:%4lu", (unsigned long)min(health.withheldFeeds, (uint32_t)9999));
+        st7735.st7735_write_str(0, 64, buf);
+        
+        lastSamples = health.samples;
+        screenInitialized = true;
+        forceScreenRedraw = false;
+    }
+}
+
+inline void HTITTracker::updatePeerListScreen() {
+    static int lastMenuIndex = -1;
+    static bool screenInitialized = false;
+    static uint32_t lastUpdates = 0;
+    static unsigned long lastDrawn = 0;
+    
+    int itemCount = peers.count() + 1;   // Peers, then Back
+    if (menuIndex >= itemCount) menuIndex = itemCount - 1;
+    
+    // Redraw on selection change, on any received beacon, and every 5 s so
+    // distances and staleness follow our own movement
+    if (!screenInitialized || forceScreenRedraw || lastMenuIndex != menuIndex ||
+        peers.updates != lastUpdates || millis() - lastDrawn > 5000) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        
+        char buf[16];
+        snprintf(buf, sizeof(buf), "PEERS %d", peers.count());
+        st7735.st7735_write_str(0, 0, buf);
+        
+        // 4 rows: scroll the window so the selection stays visible
+        int top = menuIndex > 3 ? menuIndex - 3 : 0;
+        uint32_t now = millis();
+        for (int row = 0; row < 4 && top + row < itemCount; row++) {
+            int i = top + row;
+            char sel = (i == menuIndex) ? '>' : ' ';
+            Peer peer;
+            const Peer* p = peers.snapshotAt(i, peer) ? &peer : nullptr;
+            if (p) {
+                // ">A1B2 350m -87"; '?' after the id marks a stale peer
+                char dist[8];
+                if (nav.hasPosition) {
+                    formatShortDistance(dist, sizeof(dist),
+                                        calculateDistanceToPoint(p->fix.latE6 / 1e6, p->fix.lonE6 / 1e6));
+                } else {
+                    strcpy(dist, "----");
+                }
+                snprintf(buf, sizeof(buf), "%c%04X%c%s%4d", sel, p->nodeId,
+                         PeerTable::isStale(*p, now) ? '?' : ' ', dist, p->rssi);
+            } else {
+                snprintf(buf, sizeof(buf), "%c Back", sel);
+            }
+            st7735.st7735_write_str(0, 16 * (row + 1), buf);
+        }
+        
+        lastMenuIndex = menuIndex;
+        lastUpdates = peers.updates;
+        lastDrawn = millis();
+        screenInitialized = true;
+        forceScreenRedraw = false;
+    }
+}
+
+inline void HTITTracker::updatePeerNavScreen(int pct_cal) {
+    // 1) Look the peer up by id each frame; its slot may have been reused
+    Peer peer;
+    const Peer* p = peers.snapshot(activePeer, peer) ? &peer : nullptr;
+    
+    // 2) Generate new strings every frame (peer and we are both moving)
+    char dirBuf[16];
+    char distBuf[16];
+    char ageBuf[16];
+    char spdBuf[16];
+    char battBuf[16];
+    
+    if (p) {
+        double peerLat = p->fix.latE6 / 1e6;
+        double peerLon = p->fix.lonE6 / 1e6;
+        
+        if (nav.haveFix && nav.hasPosition) {
+            snprintf(dirBuf, sizeof(dirBuf), "Dir: %-2.2s      ", bearingToCardinal(calculateBearingToPoint(peerLat, peerLon)));
+            char dist[8];
+            formatShortDistance(dist, sizeof(dist), calculateDistanceToPoint(peerLat, peerLon));
+            snprintf(distBuf, sizeof(distBuf), "%04X: %.4s    ", activePeer, dist);
+        } else {
+            snprintf(dirBuf, sizeof(dirBuf), "Dir: O       ");
+            snprintf(distBuf, sizeof(distBuf), "%04X: ----    ", activePeer);
+        }
+        
+        unsigned long age = (millis() - p->lastSeenMs) / 1000;
+        if (age > 999) age = 999;
+        snprintf(ageBuf, sizeof(ageBuf), "Age:%3lus %4d ", age, constrain((int)p->rssi, -999, 0));
+        snprintf(spdBuf, sizeof(spdBuf), "PSpd:%4.1fkm/h", p->fix.speedHalfKmh / 2.0f);
+        if (p->fix.batteryPct == BEACON_BATT_UNKNOWN) {
+            snprintf(battBuf, sizeof(battBuf), "PBat: --%%    ");
+        } else {
+            snprintf(battBuf, sizeof(battBuf), "PBat:%3d%%%c   ", p->fix.batteryPct, p->fix.charging ? '+' : ' ');
+        }
+    } else {
+        snprintf(dirBuf, sizeof(dirBuf), "Dir: O       ");
+        snprintf(distBuf, sizeof(distBuf), "%04X: lost    ", activePeer);
+        snprintf(ageBuf, sizeof(ageBuf), "Age: ---      ");
+        snprintf(spdBuf, sizeof(spdBuf), "PSpd: -.-km/h");
+        snprintf(battBuf, sizeof(battBuf), "Batt:%3d%%    ", pct_cal);
+    }
+    
+    // 3) Full clear only on entry; rows are padded to overwrite in place
+    static bool needsFullRedraw = true;
+    if (forceScreenRedraw) {
+        needsFullRedraw = true;
+        forceScreenRedraw = false;
+    }
+    if (needsFullRedraw) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        needsFullRedraw = false;
+    }
+    
+    st7735.st7735_write_str(0, 0, String(dirBuf));
+    st7735.st7735_write_str(0, 16, String(distBuf));
+    st7735.st7735_write_str(0, 32, String(ageBuf));
+    st7735.st7735_write_str(0, 48, String(spdBuf));
+    st7735.st7735_write_str(0, 64, String(battBuf));
+}
+
+inline void HTITTracker::updateRouteNavScreen(int pct_cal) {
+    // 1) Generate new strings every frame (the target moves on by itself)
+    char dirBuf[16];
+    char distBuf[16];
+    char nameBuf[16];
+    char spdBuf[16];
+    char battBuf[16];
+    
+    if (tracBackActive && !routeNav.isActive() && !routeNav.isFinished()) {
+        snprintf(dirBuf, sizeof(dirBuf), "Dir: O       ");
+        snprintf(distBuf, sizeof(distBuf), "%s", tracBack.isBuilding() ? "Reading log  " : "No track yet ");
+        snprintf(nameBuf, sizeof(nameBuf), "%-13s", "TracBack");
+    } else if (routeNav.isFinished()) {
+        snprintf(dirBuf, sizeof(dirBuf), "Dir: O       ");
+        snprintf(distBuf, sizeof(distBuf), "Route done    ");
+        snprintf(nameBuf, sizeof(nameBuf), "%-13s", "");
+    } else {
+        double lat = routeNav.targetLat();
+        double lon = routeNav.targetLon();
+        unsigned long leg = min((unsigned long)routeNav.getLeg() + 1, 999UL);
+        if (nav.haveFix && nav.hasPosition) {
+            snprintf(dirBuf, sizeof(dirBuf), "Dir: %-2.2s      ", bearingToCardinal(calculateBearingToPoint(lat, lon)));
+            char dist[8];
+            formatShortDistance(dist, sizeof(dist), calculateDistanceToPoint(lat, lon));
+            snprintf(distBuf, sizeof(distBuf), "%lu:%.4s      ", leg, dist);
+        } else {
+            snprintf(dirBuf, sizeof(dirBuf), "Dir: O       ");
+            snprintf(distBuf, sizeof(distBuf), "%lu: ----      ", leg);
+        }
+        snprintf(nameBuf, sizeof(nameBuf), "%-13.13s", routeNav.getTarget().name);
+    }
+    if (nav.hasSpeed) {
+        snprintf(spdBuf, sizeof(spdBuf), "Spd:%5.1fkm/h", nav.speedKmh);
+    } else {
+        snprintf(spdBuf, sizeof(spdBuf), "Spd: -.-km/h ");
+    }
+    snprintf(battBuf, sizeof(battBuf), "Batt:%3d%%    ", pct_cal);
+    
+    // 2) Full clear only on entry; rows are padded to overwrite in place
+    static bool needsFullRedraw = true;
+    if (forceScreenRedraw) {
+        needsFullRedraw = true;
+        forceScreenRedraw = false;
+    }
+    if (needsFullRedraw) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        needsFullRedraw = false;
+    }
+    
+    st7735.st7735_write_str(0, 0, String(dirBuf));
+    st7735.st7735_write_str(0, 16, String(distBuf));
+    st7735.st7735_write_str(0, 32, String(nameBuf));
+    st7735.st7735_write_str(0, 48, String(spdBuf));
+    st7735.st7735_write_str(0, 64, String(battBuf));
+}
+
+inline void HTITTracker::updateTrailScreen() {
+    // 1) Marks: our position and home set the whole-trail extent with the
+    //    trail itself; waypoints and the route target show when in view
+    TrailMark marks[6];
+    uint8_t markCount = 0;
+    TrailPoint here = { 0, 0 };
+    if (nav.hasPosition && trail.toLocal(nav.lat, nav.lon, marks[markCount].at)) {
+        here = marks[markCount].at;
+        marks[markCount].label = 0;
+        marks[markCount].color = TRAIL_COLOR_HERE;
+        markCount++;
+    }
+    if (nav.homeEstablished && trail.toLocal(nav.homeLat, nav.homeLon, marks[markCount].at)) {
+        marks[markCount].label = 'H';
+        marks[markCount].color = TRAIL_COLOR_HOME;
+        markCount++;
+    }
+    uint8_t fitCount = markCount;
+    for (int i = 0; i < 3; i++) {
+        if (waypoints[i].isSet && trail.toLocal(waypoints[i].lat, waypoints[i].lon, marks[markCount].at)) {
+            marks[markCount].label = (char)('1' + i);
+            marks[markCount].color = TRAIL_COLOR_WAYPOINT;
+            markCount++;
+        }
+    }
+    if (routeNav.isActive() && trail.toLocal(routeNav.targetLat(), routeNav.targetLon(), marks[markCount].at)) {
+        marks[markCount].label = 'R';
+        marks[markCount].color = TRAIL_COLOR_ROUTE;
+        markCount++;
+    }
+    
+    // 2) Full clear only on entry; after that only the map bands that changed go out
+    static bool needsFullRedraw = true;
+    static char prevInfoBuf[16];
+    if (forceScreenRedraw) {
+        needsFullRedraw = true;
+        forceScreenRedraw = false;
+    }
+    if (needsFullRedraw) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        trailView.invalidate();
+        prevInfoBuf[0] = '\0';
+        needsFullRedraw = false;
+    }
+    
+    // 3) Map rows 0-63, then the zoom and map width underneath
+    char infoBuf[16];
+    if (trail.isEmpty()) {
+        sprintf(infoBuf, "No track yet ");
+    } else {
+        trailView.setView(trail, marks, fitCount, here, trailZoom);
+        trailView.render(trail, marks, markCount);
+        trailView.flush(st7735, 0);
+        char dist[8];
+        formatShortDistance(dist, sizeof(dist), (float)trailView.viewWidth());
+        char zoom[5];
+        snprintf(zoom, sizeof(zoom), "x%u", trailZoom);
+        snprintf(infoBuf, sizeof(infoBuf), "%-3s W:%-7s", trailZoom == 1 ? "All" : zoom, dist);
+    }
+    if (strcmp(infoBuf, prevInfoBuf) != 0) {
+        st7735.st7735_write_str(0, 64, String(infoBuf));
+        strcpy(prevInfoBuf, infoBuf);
+    }
+}
+
+inline void HTITTracker::updateZoneAlertScreen() {
+    // 1) Generate new strings every frame (the way out changes as we move)
+    char titleBuf[16];
+    char nameBuf[16];
+    char edgeBuf[16];
+    char spdBuf[16];
+    const Zone& z = zones.zone(alertZone);
+    bool violated = alertZone < zones.count() && zones.isViolated(alertZone);
+    
+    if (!violated) {
+        sprintf(titleBuf, "Zone clear   ");
+    } else if (z.rule == ZONE_RULE_KEEP_OUT) {
+        sprintf(titleBuf, "KEEP OUT!    ");
+    } else {
+        sprintf(titleBuf, "OUT OF ZONE! ");
+    }
+    snprintf(nameBuf, sizeof(nameBuf), "%-13.13s", alertZone < zones.count() ? z.name : "");
+    float distM, bearing;
+    if (violated && nav.hasPosition && zones.nearestEdge(alertZone, nav.lat, nav.lon, distM, bearing)) {
+        char dist[8];
+        formatShortDistance(dist, sizeof(dist), distM);
+        snprintf(edgeBuf, sizeof(edgeBuf), "Edge:%.4s %-2.2s ", dist, bearingToCardinal(bearing));
+    } else {
+        sprintf(edgeBuf, "Edge: ----   ");
+    }
+    if (nav.hasSpeed) {
+        sprintf(spdBuf, "Spd:%5.1fkm/h", nav.speedKmh);
+    } else {
+        sprintf(spdBuf, "Spd: -.-km/h ");
+    }
+    
+    // 2) Full clear only on entry; rows are padded to overwrite in place
+    static bool needsFullRedraw = true;
+    if (forceScreenRedraw) {
+        needsFullRedraw = true;
+        forceScreenRedraw = false;
+    }
+    if (needsFullRedraw) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        needsFullRedraw = false;
+    }
+    
+    st7735.st7735_write_str(0, 0, String(titleBuf));
+    st7735.st7735_write_str(0, 16, String(nameBuf));
+    st7735.st7735_write_str(0, 32, String(edgeBuf));
+    st7735.st7735_write_str(0, 48, String(spdBuf));
+    st7735.st7735_write_str(0, 64, String("Press: OK    "));
+}
+
+inline void HTITTracker::updateTripScreen() {
+    // 1) Generate new strings from the running totals (nothing is summed here)
+    char rowBuf[5][16];
+    if (tripPage == 0) {
+        double km = trip.distanceM() / 1000.0;
+        snprintf(rowBuf[0], sizeof(rowBuf[0]), km < 100.0 ? "Dist:%6.2fkm" : "Dist:%6.1fkm", km);
+        uint32_t mv = trip.movingMs() / 1000, st = trip.stoppedMs() / 1000;
+        snprintf(rowBuf[1], sizeof(rowBuf[1]), "Move:%2lu:%02lu:%02lu", (unsigned long)(mv / 3600),
+                 (unsigned long)(mv / 60 % 60), (unsigned long)(mv % 60));
+        snprintf(rowBuf[2], sizeof(rowBuf[2]), "Stop:%2lu:%02lu:%02lu", (unsigned long)(st / 3600),
+                 (unsigned long)(st / 60 % 60), (unsigned long)(st % 60));
+        snprintf(rowBuf[3], sizeof(rowBuf[3]), "Avg:%5.1fkm/h", trip.avgKmh());
+        snprintf(rowBuf[4], sizeof(rowBuf[4]), "Max:%5.1fkm/h", trip.maxKmh());
+    } else if (tripPage == 1) {
+        sprintf(rowBuf[0], "CLIMB        ");
+        snprintf(rowBuf[1], sizeof(rowBuf[1]), "Up:  %6.0fm ", trip.ascentM());
+        snprintf(rowBuf[2], sizeof(rowBuf[2]), "Down:%6.0fm ", trip.descentM());
+        if (nav.hasAltitude && nav.haveFix) {
+            snprintf(rowBuf[3], sizeof(rowBuf[3]), "Alt: %6.0fm ", nav.altitudeM);
+        } else {
+            sprintf(rowBuf[3], "Alt:   ----  ");
+        }
+        sprintf(rowBuf[4], "Press: more  ");
+    } else {
+        sprintf(rowBuf[0], "RESET TRIP?  ");
+        sprintf(rowBuf[1], "             ");
+        sprintf(rowBuf[2], "Press: reset ");
+        sprintf(rowBuf[3], "Hold: keep   ");
+        sprintf(rowBuf[4], "             ");
+    }
+    
+    // 2) Full clear on entry and on a page change; rows are padded to overwrite in place
+    static bool needsFullRedraw = true;
+    static uint8_t lastPage = 0;
+    if (forceScreenRedraw || tripPage != lastPage) {
+        needsFullRedraw = true;
+        forceScreenRedraw = false;
+        lastPage = tripPage;
+    }
+    if (needsFullRedraw) {
+        st7735.st7735_fill_screen(ST7735_BLACK);
+        needsFullRedraw = false;
+    }
+    
+    for (int row = 0; row < 5; row++) {
+        st7735.st7735_write_str(0, 16 * row, String(rowBuf[row]));
+    }
+}
+
 // ========================== WAYPOINT MANAGEMENT ==========================
 
 inline void HTITTracker::setWaypoint(int index, double lat, double lon, const char* name) {
@@ -1428,13 +2432,13 @@ inline void HTITTracker::saveWaypointsToEEPROM() {
 }
 
 inline float HTITTracker::calculateBearingToWaypoint(int waypointIndex) {
-    if (waypointIndex < 0 || waypointIndex >= 3 || !waypoints[waypointIndex].isSet || !hasValidPosition) {
+    if (waypointIndex < 0 || waypointIndex >= 3 || !waypoints[waypointIndex].isSet || !nav.hasPosition) {
         return 0.0f;  // Default to North
     }
     
     // Calculate bearing from current position to waypoint
-    double lat1 = currentLat * PI / 180.0;
-    double lon1 = currentLon * PI / 180.0;
+    double lat1 = nav.lat * PI / 180.0;
+    double lon1 = nav.lon * PI / 180.0;
     double lat2 = waypoints[waypointIndex].lat * PI / 180.0;
     double lon2 = waypoints[waypointIndex].lon * PI / 180.0;
     
@@ -1450,13 +2454,13 @@ inline float HTITTracker::calculateBearingToWaypoint(int waypointIndex) {
 }
 
 inline float HTITTracker::calculateDistanceToWaypoint(int waypointIndex) {
-    if (waypointIndex < 0 || waypointIndex >= 3 || !waypoints[waypointIndex].isSet || !hasValidPosition) {
+    if (waypointIndex < 0 || waypointIndex >= 3 || !waypoints[waypointIndex].isSet || !nav.hasPosition) {
         return 0.0f;  // No distance if waypoint not set or no position
     }
     
     // Calculate distance using Haversine formula
-    double lat1 = currentLat * PI / 180.0;
-    double lon1 = currentLon * PI / 180.0;
+    double lat1 = nav.lat * PI / 180.0;
+    double lon1 = nav.lon * PI / 180.0;
     double lat2 = waypoints[waypointIndex].lat * PI / 180.0;
     double lon2 = waypoints[waypointIndex].lon * PI / 180.0;
     
@@ -1474,4 +2478,127 @@ inline float HTITTracker::calculateDistanceToWaypoint(int waypointIndex) {
     return EARTH_RADIUS * c;  // Distance in meters
 }
 
+inline float HTITTracker::calculateBearingToPoint(double lat, double lon) {
+    if (!nav.hasPosition) {
+        return 0.0f;  // Default to North
+    }
+    return greatCircleBearing(nav.lat, nav.lon, lat, lon);
+}
+
+inline float HTITTracker::calculateDistanceToPoint(double lat, double lon) {
+    if (!nav.hasPosition) {
+        return 0.0f;  // No distance without a position
+    }
+    return greatCircleDistance(nav.lat, nav.lon, lat, lon);
+}
+
+inline float HTITTracker::greatCircleBearing(double lat1, double lon1, double lat2, double lon2) {
+    // Initial great-circle bearing from point 1 to point 2
+    lat1 = lat1 * PI / 180.0;
+    lon1 = lon1 * PI / 180.0;
+    lat2 = lat2 * PI / 180.0;
+    lon2 = lon2 * PI / 180.0;
+    
+    double dLon = lon2 - lon1;
+    
+    double y = sin(dLon) * cos(lat2);
+    double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dLon);
+    
+    double bearing = atan2(y, x) * 180.0 / PI;
+    bearing = fmod(bearing + 360.0, 360.0);  // Normalize to 0-360
+    
+    return bearing;
+}
+
+inline float HTITTracker::greatCircleDistance(double lat1, double lon1, double lat2, double lon2) {
+    // Calculate distance using Haversine formula
+    lat1 = lat1 * PI / 180.0;
+    lon1 = lon1 * PI / 180.0;
+    lat2 = lat2 * PI / 180.0;
+    lon2 = lon2 * PI / 180.0;
+    
+    double dLat = lat2 - lat1;
+    double dLon = lon2 - lon1;
+    
+    double a = sin(dLat/2) * sin(dLat/2) + 
+               cos(lat1) * cos(lat2) * 
+               sin(dLon/2) * sin(dLon/2);
+    double c = 2 * atan2(sqrt(a), sqrt(1-a));
+    
+    // Earth's radius in meters
+    const double EARTH_RADIUS = 6371000.0;
+    
+    return EARTH_RADIUS * c;  // Distance in meters
+}
+
+inline const char* HTITTracker::bearingToCardinal(float bearing) {
+    // 8 sectors of 45°, sector 0 centred on north
+    static const char* const names[] = { "N", "NE", "E", "SE", "S", "SW", "W", "NW" };
+    int sector = (int)((bearing + 22.5f) / 45.0f) & 7;
+    return names[sector];
+}
+
+inline void HTITTracker::formatShortDistance(char* out, size_t len, float meters) {
+    // Always 4 characters: "350m", "2.4k", " 18k", "far "
+    if (meters < 999.5f) {
+        snprintf(out, len, "%3.0fm", meters);
+    } else if (meters < 9950.0f) {
+        snprintf(out, len, "%3.1fk", meters / 1000.0f);
+    } else if (meters < 999500.0f) {
+        snprintf(out, len, "%3.0fk", meters / 1000.0f);
+    } else {
+        snprintf(out, len, "far ");
+    }
+}
+
+#if MICRO_BENCHMARK
+// ========================== MICROBENCHMARKS ==========================
+
+inline void HTITTracker::runMicroBenchmark(Print& out) {
+    static const char gga[] = "$GNGGA,120000.00,4722.61400,N,00832.50200,E,1,14,0.8,408.0,M,47.0,M,,*7D\r\n";
+    static const char rmc[] = "$GNRMC,120000.00,A,4722.61400,N,00832.50200,E,2.890,65.21,170926,,,A,V*3F\r\n";
+    static const char gsv[] = "$GPGSV,3,1,11,01,45,123,38,03,12,045,30,08,67,300,44,10,05,210,22,1*62\r\n";
+    static const float volts[8] = { 4.25f, 4.15f, 4.05f, 3.95f, 3.85f, 3.75f, 3.62f, 3.40f };
+    
+    out.println("=== MICRO BENCHMARK ===");
+    MicroBench bench(out);
+    bench.run("empty", 1000, [](uint32_t i) { microBenchSink() += i; });
+    
+    // 1) NMEA parser, one whole sentence per call
+    GnssParser parser;
+    auto encodeAll = [&parser](const char* p) -> uint32_t {
+        uint32_t ok = 0;
+        while (*p) ok += parser.encode(*p++);
+        return ok;
+    };
+    bench.run("nmea_gga", 1000, [&encodeAll](uint32_t) { microBenchSink() += encodeAll(gga); });
+    bench.run("nmea_rmc", 1000, [&encodeAll](uint32_t) { microBenchSink() += encodeAll(rmc); });
+    bench.run("nmea_gsv", 1000, [&encodeAll](uint32_t) { microBenchSink() += encodeAll(gsv); });
+    
+    // 2) Navigation maths (double precision, in software on this core)
+    bench.run("haversine", 1000, [](uint32_t i) {
+        microBenchSink() += (uint32_t)greatCircleDistance(47.3769, 8.5417, 47.3769 + i * 1e-6, 8.5517);
+    });
+    bench.run("bearing", 1000, [](uint32_t i) {
+        microBenchSink() += (uint32_t)greatCircleBearing(47.3769, 8.5417, 47.3769 + i * 1e-6, 8.5517);
+    });
+    bench.run("voltage_to_percent", 1000, [this](uint32_t i) { microBenchSink() += voltageToPercent(volts[i & 7]); });
+    
+    // 3) Display: one glyph per font, a padded text row, a row clear, the whole screen
+    bench.run("glyph_7x10", 20, [this](uint32_t) { st7735.st7735_write_str(0, 0, "W", Font_7x10); });
+    bench.run("glyph_11x18", 20, [this](uint32_t) { st7735.st7735_write_str(0, 0, "W", Font_11x18); });
+    bench.run("glyph_16x26", 20, [this](uint32_t) { st7735.st7735_write_str(0, 0, "W", Font_16x26); });
+    bench.run("text_row", 5, [this](uint32_t) { st7735.st7735_write_str(0, 16, "Sats: 14     "); });
+    bench.run("fill_row", 5, [this](uint32_t) { st7735.st7735_fill_rectangle(0, 0, 160, 16, ST7735_BLACK); });
+    bench.run("fill_screen", 1, [this](uint32_t) { st7735.st7735_fill_screen(ST7735_BLACK); }, 5);
+    
+    // 4) EEPROM commit; put() marks the buffer dirty, so flash really is written
+    bench.run("eeprom_commit", 1, [](uint32_t) {
+        uint32_t magic = EEPROM_MAGIC;
+        EEPROM.put(ADDR_MAGIC, magic);
+        EEPROM.commit();
+    }, 3);
+}
+#endif
+
 #endif // MAIN_H
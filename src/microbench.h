@@ -0,0 +1,78 @@
+#ifndef MICROBENCH_H
+#define MICROBENCH_H
+
+#include <Arduino.h>
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include <esp_cpu.h>
+#endif
+
+// On-target microbenchmarks in CPU cycles (build with -DMICRO_BENCHMARK=1,
+// or flash the "bench" PlatformIO environment). Host timings say nothing
+// about soft-float doubles on the Xtensa, flash cache misses or SPI waits,
+// so these run on the chip itself, once from begin() before the radio and
+// BLE start. Each case is timed over a number of rounds of iters calls; the
+// fastest and the median round are reported per call. One line per case:
+//   bench name=<case> iters=<n> rounds=<n> min=<cycles> med=<cycles> ns=<median ns>
+// "empty" is the loop overhead alone, to subtract from the short cases.
+
+#ifndef MICRO_BENCHMARK
+#define MICRO_BENCHMARK 0
+#endif
+
+#define MICRO_BENCH_ROUNDS  15
+
+inline uint32_t microBenchCycles() {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    return (uint32_t)esp_cpu_get_cycle_count();
+#else
+    return ESP.getCycleCount();     // The same CCOUNT register on IDF 4.x
+#endif
+}
+
+// Results are folded in here so the compiler cannot drop the work being timed
+inline volatile uint32_t& microBenchSink() {
+    static volatile uint32_t sink = 0;
+    return sink;
+}
+
+class MicroBench {
+private:
+    Print& out;
+    uint32_t mhz;
+
+public:
+    explicit MicroBench(Print& o) : out(o), mhz(ESP.getCpuFreqMHz()) {
+        out.printf("bench cpu_mhz=%lu\n", (unsigned long)mhz);
+    }
+
+    // fn(i) is called iters times per round with i = 0..iters-1
+    template <class F>
+    void run(const char* name, uint32_t iters, F fn, uint8_t rounds = MICRO_BENCH_ROUNDS) {
+        uint32_t perCall[MICRO_BENCH_ROUNDS];
+        if (rounds > MICRO_BENCH_ROUNDS) rounds = MICRO_BENCH_ROUNDS;
+
+        // 1) Time each round
+        for (uint8_t r = 0; r < rounds; r++) {
+            uint32_t t0 = microBenchCycles();
+            for (uint32_t i = 0; i < iters; i++) {
+                fn(i);
+            }
+            perCall[r] = (microBenchCycles() - t0) / iters;
+        }
+
+        // 2) Sort (a handful of values) for min and median
+        for (uint8_t a = 1; a < rounds; a++) {
+            uint32_t v = perCall[a];
+            uint8_t b = a;
+            for (; b > 0 && perCall[b - 1] > v; b--) perCall[b] = perCall[b - 1];
+            perCall[b] = v;
+        }
+        uint32_t med = perCall[rounds / 2];
+        out.printf("bench name=%s iters=%lu rounds=%u min=%lu med=%lu ns=%lu\n", name, (unsigned long)iters,
+                   rounds, (unsigned long)perCall[0], (unsigned long)med,
+                   (unsigned long)((uint64_t)med * 1000 / (mhz ? mhz : 1)));
+    }
+};
+
+#endif // MICROBENCH_H
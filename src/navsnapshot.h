@@ -0,0 +1,100 @@
+#ifndef NAVSNAPSHOT_H
+#define NAVSNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Navigation state shared between the NMEA ingest side (single writer) and
+// any number of readers (screens, radio, BLE, logger).
+// Published through a seqlock: the writer bumps the sequence to odd, copies
+// the struct, then bumps it back to even. Readers copy optimistically and
+// retry if the sequence was odd or changed underneath them, so they never
+// block the writer and never see a half-updated fix.
+
+struct NavSnapshot {
+    uint32_t generation;       // Increments on every publish
+    uint32_t fixMillis;        // millis() when the position was last updated
+
+    // Position / fix
+    double lat, lon;
+    float hdop;
+    uint8_t fixQuality;        // GGA field 6 (0 = invalid)
+    bool haveFix;
+    bool hasPosition;
+    float altitudeM;           // GGA, above mean sea level
+    bool hasAltitude;
+
+    // Motion
+    float speedKmh;
+    float courseDeg;           // Course over ground, 0 = north
+    bool hasSpeed;
+    bool hasCourse;
+
+    // Satellites in view per constellation
+    uint8_t satsInView;
+    uint8_t gpsCount;
+    uint8_t glonassCount;
+    uint8_t beidouCount;
+    uint8_t galileoCount;
+    uint8_t qzssCount;
+
+    // Home
+    bool homeEstablished;
+    double homeLat, homeLon;
+};
+
+class NavPublisher {
+private:
+    std::atomic<uint32_t> seq;
+    NavSnapshot data;
+
+public:
+    NavPublisher() : seq(0) { memset(&data, 0, sizeof(data)); }
+
+    // Writer side (one writer only)
+    void publish(const NavSnapshot& snap);
+
+    // Reader side: one attempt, false if a write was in progress
+    bool tryRead(NavSnapshot& out) const;
+
+    // Reader side: retry until a consistent copy is obtained
+    void read(NavSnapshot& out) const;
+
+    uint32_t generation() const { return seq.load(std::memory_order_acquire) >> 1; }
+};
+
+inline void NavPublisher::publish(const NavSnapshot& snap) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);          // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data, &snap, sizeof(data));
+    data.generation = (s >> 1) + 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    seq.store(s + 2, std::memory_order_release);          // even: stable
+}
+
+inline bool NavPublisher::tryRead(NavSnapshot& out) const {
+    uint32_t s1 = seq.load(std::memory_order_acquire);
+    if (s1 & 1) {
+        return false;
+    }
+    memcpy(&out, &data, sizeof(out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t s2 = seq.load(std::memory_order_relaxed);
+    return s1 == s2;
+}
+
+inline void NavPublisher::read(NavSnapshot& out) const {
+    // Writer holds the slot for a ~100-byte memcpy, so spinning is normally
+    // cheaper than yielding; back off only if a lower-priority writer on this
+    // core was preempted mid-publish.
+    int spins = 0;
+    while (!tryRead(out)) {
+        if (++spins >= 100) {
+            delay(1);
+            spins = 0;
+        }
+    }
+}
+
+#endif // NAVSNAPSHOT_H
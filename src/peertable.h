@@ -0,0 +1,181 @@
+#ifndef PEERTABLE_H
+#define PEERTABLE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "beaconpacket.h"
+
+// Fixed-size table of other trackers heard over LoRa.
+// Slots are addressed by a hash of the 16-bit node id with a bounded probe
+// of PEER_PROBE slots, so an update costs O(1) no matter how full the table
+// is. When every probed slot is taken by another node, the one heard least
+// recently is evicted.
+// Beacons are decoded in the radio's DIO1 task while screens and the link
+// adapter read from the main loop: writers and in-place readers hold
+// PeerTableLock, and UI code takes copies with snapshot()/snapshotAt() so
+// the lock is never held across a redraw.
+
+#define PEER_TABLE_BITS 4
+#define PEER_TABLE_SIZE (1 << PEER_TABLE_BITS)
+#define PEER_PROBE      4
+#define PEER_STALE_MS   (10UL * 60UL * 1000UL)   // Shown as stale after 10 min
+
+struct Peer {
+    uint16_t nodeId;            // 0 = empty slot
+    BeaconFix fix;              // Latest decoded position
+    BeaconFix key;              // Last keyframe, the base for the peer's deltas
+    bool haveKey;
+    uint32_t lastSeenMs;
+    int16_t rssi;
+    int8_t snr;
+    uint32_t packets;
+    uint32_t lost;              // Sequence gaps
+    uint8_t lossQ8;             // Recent fraction of frames missed, /256 (EWMA)
+    int16_t snrAvg10;           // Recent SNR referred to 125 kHz, 0.1 dB (see LinkAdapter)
+};
+
+class PeerTable {
+private:
+    Peer slots[PEER_TABLE_SIZE];
+    int used;
+    SemaphoreHandle_t mutex;
+
+    static uint32_t hashId(uint16_t id) {
+        // Fibonacci hashing spreads sequential ids across the table
+        return ((uint32_t)id * 2654435769u) >> (32 - PEER_TABLE_BITS);
+    }
+
+public:
+    uint32_t updates;
+    uint32_t evictions;
+    uint32_t orphanDeltas;      // Deltas dropped because their keyframe was missed
+
+    PeerTable() : used(0), mutex(nullptr), updates(0), evictions(0), orphanDeltas(0) { memset(slots, 0, sizeof(slots)); }
+
+    // Create the lock; call before the radio starts delivering beacons
+    void begin() { if (!mutex) mutex = xSemaphoreCreateMutex(); }
+    void lock() const { if (mutex) xSemaphoreTake(mutex, portMAX_DELAY); }
+    void unlock() const { if (mutex) xSemaphoreGive(mutex); }
+
+    // Record a decoded beacon; keyframes also become the base for later deltas
+    Peer* update(const BeaconFix& fix, bool keyframe, int16_t rssi, int8_t snr, uint32_t nowMs);
+
+    // Keyframe a delta from nodeId must be applied to, or nullptr if we missed it
+    const BeaconFix* keyFor(uint16_t nodeId, uint8_t keySeq) const;
+
+    const Peer* find(uint16_t nodeId) const;
+
+    int count() const { return used; }
+    int capacity() const { return PEER_TABLE_SIZE; }
+
+    // n-th occupied slot in table order, or nullptr
+    const Peer* at(int n) const;
+
+    // Locked copies of find() / at(); false if there is no such peer
+    bool snapshot(uint16_t nodeId, Peer& out) const;
+    bool snapshotAt(int n, Peer& out) const;
+
+    static bool isStale(const Peer& p, uint32_t nowMs) { return nowMs - p.lastSeenMs > PEER_STALE_MS; }
+};
+
+inline Peer* PeerTable::update(const BeaconFix& fix, bool keyframe, int16_t rssi, int8_t snr, uint32_t nowMs) {
+    uint32_t base = hashId(fix.nodeId);
+    Peer* empty = nullptr;
+    Peer* oldest = nullptr;
+    Peer* p = nullptr;
+
+    for (uint32_t i = 0; i < PEER_PROBE; i++) {
+        Peer* s = &slots[(base + i) & (PEER_TABLE_SIZE - 1)];
+        if (s->nodeId == fix.nodeId) { p = s; break; }
+        if (s->nodeId == 0) {
+            if (!empty) empty = s;
+        } else if (!oldest || (int32_t)(s->lastSeenMs - oldest->lastSeenMs) < 0) {
+            oldest = s;
+        }
+    }
+
+    if (p) {
+        // Known peer: count sequence gaps (ignore reboots / reordering)
+        uint8_t gap = (uint8_t)(fix.seq - p->fix.seq - 1);
+        if (gap < 128) {
+            p->lost += gap;
+            int sample = gap * 256 / (gap + 1);
+            p->lossQ8 = (uint8_t)(p->lossQ8 + (sample - p->lossQ8) / 8);
+        }
+    } else {
+        p = empty ? empty : oldest;
+        if (!empty) {
+            evictions++;
+        } else {
+            used++;
+        }
+        memset(p, 0, sizeof(*p));
+        p->nodeId = fix.nodeId;
+    }
+
+    p->fix = fix;
+    if (keyframe) {
+        p->key = fix;
+        p->haveKey = true;
+    }
+    p->lastSeenMs = nowMs;
+    p->rssi = rssi;
+    p->snr = snr;
+    p->packets++;
+    updates++;
+    return p;
+}
+
+inline const Peer* PeerTable::find(uint16_t nodeId) const {
+    if (nodeId == 0) return nullptr;
+    uint32_t base = hashId(nodeId);
+    for (uint32_t i = 0; i < PEER_PROBE; i++) {
+        const Peer* s = &slots[(base + i) & (PEER_TABLE_SIZE - 1)];
+        if (s->nodeId == nodeId) return s;
+    }
+    return nullptr;
+}
+
+inline const BeaconFix* PeerTable::keyFor(uint16_t nodeId, uint8_t keySeq) const {
+    const Peer* p = find(nodeId);
+    if (!p || !p->haveKey || p->key.seq != keySeq) {
+        return nullptr;
+    }
+    return &p->key;
+}
+
+inline const Peer* PeerTable::at(int n) const {
+    for (int i = 0; i < PEER_TABLE_SIZE; i++) {
+        if (slots[i].nodeId == 0) continue;
+        if (n-- == 0) return &slots[i];
+    }
+    return nullptr;
+}
+
+inline bool PeerTable::snapshot(uint16_t nodeId, Peer& out) const {
+    lock();
+    const Peer* p = find(nodeId);
+    if (p) out = *p;
+    unlock();
+    return p != nullptr;
+}
+
+inline bool PeerTable::snapshotAt(int n, Peer& out) const {
+    lock();
+    const Peer* p = at(n);
+    if (p) out = *p;
+    unlock();
+    return p != nullptr;
+}
+
+// Holds the table lock for a scope
+class PeerTableLock {
+private:
+    const PeerTable& table;
+public:
+    explicit PeerTableLock(const PeerTable& t) : table(t) { table.lock(); }
+    ~PeerTableLock() { table.unlock(); }
+};
+
+#endif // PEERTABLE_H
@@ -0,0 +1,215 @@
+#ifndef ROUTEFRAME_H
+#define ROUTEFRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Framing for bulk waypoint / route uploads, little-endian.
+// Pure encode/decode with no Arduino dependencies so the same code runs in
+// the host-side uploader (tools/routeup.cpp). The tracker accepts the same
+// byte stream on the USB console and on a BLE write-without-response
+// characteristic; frames may be split across writes or packed several to a
+// write, only the byte order matters.
+//
+// Frame:
+//  off size field
+//   0   1   sync            ROUTE_FRAME_SYNC
+//   1   1   type            ROUTE_MSG_*
+//   2   2   length          payload bytes (0..ROUTE_FRAME_MAX_PAYLOAD)
+//   4   n   payload
+//  4+n  2   crc             CRC-16/CCITT-FALSE over type, length and payload
+//
+// Host → tracker:
+//   BEGIN   u32 point count[, u8 file]        opens a new route, or with
+//                                             ROUTE_FILE_ZONES a new zone file
+//   DATA    u32 index of the first record,    records in order; a gap is
+//           then 1..ROUTE_FRAME_MAX_RECORDS   answered with OUT_OF_SEQ and
+//           RoutePoint records                the index to resend from
+//   COMMIT  u32 count, u32 CRC-32 of all      makes the new route current
+//           record bytes (zlib polynomial)
+//   ABORT   (empty)                           drops the upload
+//
+// Tracker → host:
+//   ACK     u8 status, u8 type acknowledged,  after BEGIN, COMMIT and ABORT,
+//           u32 next record index expected    for every ROUTE_PAGE_RECORDS
+//                                             records stored, and on errors
+//
+// A host may have at most ROUTE_WINDOW_RECORDS records beyond the last
+// acknowledged index in flight.
+//
+// A zone file (geofence.h) uses the same records: each zone is a header
+// record followed by its points as RoutePoint records (names unused).
+//  off size field
+//   0   1   shape           ZONE_SHAPE_*
+//   1   1   rule            ZONE_RULE_*
+//   2   2   points          1 for a circle (its centre), 3.. for a polygon
+//   4   4   radius          metres, circles only
+//   8  24   name
+
+#define ROUTE_FRAME_SYNC        0xA5
+#define ROUTE_FRAME_HEADER      4
+#define ROUTE_FRAME_OVERHEAD    (ROUTE_FRAME_HEADER + 2)
+#define ROUTE_RECORD_BYTES      32
+#define ROUTE_FRAME_MAX_RECORDS 16
+#define ROUTE_FRAME_MAX_PAYLOAD (4 + ROUTE_FRAME_MAX_RECORDS * ROUTE_RECORD_BYTES)
+#define ROUTE_FRAME_MAX_BYTES   (ROUTE_FRAME_OVERHEAD + ROUTE_FRAME_MAX_PAYLOAD)
+#define ROUTE_PAGE_BYTES        4096  // One flash sector / LittleFS block
+#define ROUTE_PAGE_RECORDS      (ROUTE_PAGE_BYTES / ROUTE_RECORD_BYTES)
+#define ROUTE_WINDOW_RECORDS    (2 * ROUTE_PAGE_RECORDS)
+#define ROUTE_MAX_POINTS        20000UL
+#define ROUTE_NAME_LEN          24
+#define ZONE_MAX_RECORDS        1024
+
+#define ROUTE_FILE_ROUTE        0
+#define ROUTE_FILE_ZONES        1
+
+#define ZONE_SHAPE_CIRCLE       1
+#define ZONE_SHAPE_POLYGON      2
+#define ZONE_RULE_KEEP_IN       1     // Alert on leaving
+#define ZONE_RULE_KEEP_OUT      2     // Alert on entering
+
+#define ROUTE_MSG_BEGIN         0x01
+#define ROUTE_MSG_DATA          0x02
+#define ROUTE_MSG_COMMIT        0x03
+#define ROUTE_MSG_ABORT         0x04
+#define ROUTE_MSG_ACK           0x81
+
+#define ROUTE_OK                0
+#define ROUTE_ERR_STATE         1     // DATA/COMMIT without BEGIN
+#define ROUTE_ERR_SEQUENCE      2     // Resend from the index in the ACK
+#define ROUTE_ERR_COUNT         3     // Too many points, or more than announced
+#define ROUTE_ERR_SPACE         4     // Not enough free flash
+#define ROUTE_ERR_FLASH         5     // Write or rename failed
+#define ROUTE_ERR_VERIFY        6     // CRC-32 mismatch at COMMIT
+#define ROUTE_ERR_FORMAT        7     // Malformed payload
+
+// One stored point; the record layout on the wire and in flash
+struct RoutePoint {
+    int32_t latE7;                  // 1e-7 degrees
+    int32_t lonE7;
+    char name[ROUTE_NAME_LEN];      // NUL-padded, need not be terminated on the wire
+};
+
+// A zone header as it sits in a RoutePoint record (layout above)
+struct ZoneHeader {
+    uint8_t shape;
+    uint8_t rule;
+    uint16_t points;
+    uint32_t radiusM;
+    char name[ROUTE_NAME_LEN];
+};
+
+static inline void zoneHeaderToPoint(const ZoneHeader& h, RoutePoint& pt) {
+    pt.latE7 = (int32_t)(h.shape | (h.rule << 8) | ((uint32_t)h.points << 16));
+    pt.lonE7 = (int32_t)h.radiusM;
+    memcpy(pt.name, h.name, ROUTE_NAME_LEN);
+}
+
+static inline void zoneHeaderFromPoint(const RoutePoint& pt, ZoneHeader& h) {
+    h.shape = (uint8_t)pt.latE7;
+    h.rule = (uint8_t)(pt.latE7 >> 8);
+    h.points = (uint16_t)((uint32_t)pt.latE7 >> 16);
+    h.radiusM = (uint32_t)pt.lonE7;
+    memcpy(h.name, pt.name, ROUTE_NAME_LEN);
+    h.name[ROUTE_NAME_LEN - 1] = '\0';
+}
+
+static inline uint16_t routeCrc16(uint16_t crc, const uint8_t* data, size_t len) {
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline void routePut32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint32_t routeGet32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void routePackPoint(const RoutePoint& pt, uint8_t* out) {
+    routePut32(out, (uint32_t)pt.latE7);
+    routePut32(out + 4, (uint32_t)pt.lonE7);
+    memcpy(out + 8, pt.name, ROUTE_NAME_LEN);
+}
+
+static inline void routeUnpackPoint(const uint8_t* in, RoutePoint& pt) {
+    pt.latE7 = (int32_t)routeGet32(in);
+    pt.lonE7 = (int32_t)routeGet32(in + 4);
+    memcpy(pt.name, in + 8, ROUTE_NAME_LEN);
+    pt.name[ROUTE_NAME_LEN - 1] = '\0';
+}
+
+// Build one frame into out (ROUTE_FRAME_OVERHEAD + len bytes); returns its size
+static inline size_t routeFrameEncode(uint8_t type, const uint8_t* payload, uint16_t len, uint8_t* out) {
+    out[0] = ROUTE_FRAME_SYNC;
+    out[1] = type;
+    out[2] = (uint8_t)len;
+    out[3] = (uint8_t)(len >> 8);
+    if (len) memcpy(out + ROUTE_FRAME_HEADER, payload, len);
+    uint16_t crc = routeCrc16(0xFFFF, out + 1, 3 + len);
+    out[ROUTE_FRAME_HEADER + len] = (uint8_t)crc;
+    out[ROUTE_FRAME_HEADER + len + 1] = (uint8_t)(crc >> 8);
+    return ROUTE_FRAME_OVERHEAD + len;
+}
+
+// Byte-at-a-time frame parser; resynchronises on the next sync byte after
+// a bad length or CRC
+class RouteFrameParser {
+private:
+    uint8_t buf[ROUTE_FRAME_MAX_BYTES];
+    uint16_t pos;
+    uint16_t need;                  // Total frame size once the header is in
+
+public:
+    uint32_t frames;
+    uint32_t errors;
+
+    RouteFrameParser() : pos(0), need(0), frames(0), errors(0) {}
+
+    void reset() { pos = 0; need = 0; }
+
+    // Returns true when b completes a valid frame
+    bool feed(uint8_t b) {
+        if (pos == 0 && b != ROUTE_FRAME_SYNC) {
+            return false;  // Between frames (or console noise)
+        }
+        buf[pos++] = b;
+        if (pos == ROUTE_FRAME_HEADER) {
+            uint16_t len = (uint16_t)(buf[2] | (buf[3] << 8));
+            if (len > ROUTE_FRAME_MAX_PAYLOAD) {
+                errors++;
+                reset();
+                return false;
+            }
+            need = (uint16_t)(ROUTE_FRAME_OVERHEAD + len);
+        }
+        if (need == 0 || pos < need) {
+            return false;
+        }
+        uint16_t len = length();
+        uint16_t crc = (uint16_t)(buf[ROUTE_FRAME_HEADER + len] | (buf[ROUTE_FRAME_HEADER + len + 1] << 8));
+        bool ok = routeCrc16(0xFFFF, buf + 1, 3 + len) == crc;
+        pos = 0;
+        need = 0;
+        if (!ok) {
+            errors++;
+            return false;
+        }
+        frames++;
+        return true;
+    }
+
+    // The last completed frame (valid until the next feed())
+    uint8_t type() const { return buf[1]; }
+    uint16_t length() const { return (uint16_t)(buf[2] | (buf[3] << 8)); }
+    const uint8_t* payload() const { return buf + ROUTE_FRAME_HEADER; }
+};
+
+#endif // ROUTEFRAME_H
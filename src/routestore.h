@@ -0,0 +1,236 @@
+#ifndef ROUTESTORE_H
+#define ROUTESTORE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "routeframe.h"
+
+// Planned route / waypoint list in LittleFS, filled by RouteUpload.
+// ROUTE_PATH holds the RoutePoint records back to back, ROUTE_RECORD_BYTES
+// each, followed by one index record of the same size:
+//   "HRTE", uint32 count, uint32 CRC-32 of the records, zero padding.
+// A file whose index record is missing or does not match its size is
+// ignored, so a half-written route can never be loaded; uploads go to
+// ROUTE_TMP_PATH and replace the route with a single rename.
+// Points are read on demand through a small cache of consecutive records,
+// so following a 10,000 point route costs no more RAM than a short one.
+// The geofence zone file (ZONE_PATH) is stored and read the same way.
+
+#define ROUTE_PATH             "/route.bin"
+#define ROUTE_TMP_PATH         "/route.new"
+#define ZONE_PATH              "/zones.bin"    // Geofence zones, same layout
+#define ZONE_TMP_PATH          "/zones.new"
+#define ROUTE_INDEX_MAGIC      "HRTE"
+#define ROUTE_CACHE_RECORDS    8
+#define ROUTE_ARRIVE_M         25.0f     // Leg is done inside this radius
+
+// Anything the follower can walk: the stored route, or a route built in RAM
+class RouteSource {
+public:
+    virtual ~RouteSource() {}
+    virtual uint32_t size() const = 0;
+    virtual bool get(uint32_t index, RoutePoint& out) = 0;
+};
+
+class RouteStore : public RouteSource {
+private:
+    const char* path;
+    uint32_t count;
+    uint32_t crc;
+    RoutePoint cache[ROUTE_CACHE_RECORDS];
+    uint32_t cacheFirst;
+    uint8_t cacheCount;
+
+public:
+    explicit RouteStore(const char* file = ROUTE_PATH) : path(file), count(0), crc(0), cacheFirst(0), cacheCount(0) {}
+
+    // (Re)read the index record; LittleFS must be mounted. Returns the point count
+    uint32_t load();
+
+    uint32_t size() const override { return count; }
+    uint32_t getCrc() const { return crc; }
+    bool get(uint32_t index, RoutePoint& out) override;
+
+    // Index record for a route of count points (ROUTE_RECORD_BYTES)
+    static void makeIndex(uint8_t* out, uint32_t count, uint32_t crc) {
+        memset(out, 0, ROUTE_RECORD_BYTES);
+        memcpy(out, ROUTE_INDEX_MAGIC, 4);
+        routePut32(out + 4, count);
+        routePut32(out + 8, crc);
+    }
+};
+
+inline uint32_t RouteStore::load() {
+    count = 0;
+    crc = 0;
+    cacheCount = 0;
+    if (!LittleFS.exists(path)) {
+        return 0;
+    }
+    File f = LittleFS.open(path, FILE_READ);
+    if (!f) {
+        return 0;
+    }
+    uint32_t fileSize = f.size();
+    uint8_t index[ROUTE_RECORD_BYTES];
+    bool ok = fileSize >= ROUTE_RECORD_BYTES && fileSize % ROUTE_RECORD_BYTES == 0 &&
+              f.seek(fileSize - ROUTE_RECORD_BYTES) && f.read(index, sizeof(index)) == sizeof(index) &&
+              memcmp(index, ROUTE_INDEX_MAGIC, 4) == 0 &&
+              routeGet32(index + 4) == fileSize / ROUTE_RECORD_BYTES - 1;
+    f.close();
+    if (!ok) {
+        Serial.printf("→ %s has no valid index, ignored\n", path);
+        return 0;
+    }
+    count = routeGet32(index + 4);
+    crc = routeGet32(index + 8);
+    return count;
+}
+
+inline bool RouteStore::get(uint32_t index, RoutePoint& out) {
+    if (index >= count) {
+        return false;
+    }
+    // Refill the cache with the records starting at index
+    if (index < cacheFirst || index >= cacheFirst + cacheCount) {
+        File f = LittleFS.open(path, FILE_READ);
+        if (!f || !f.seek(index * ROUTE_RECORD_BYTES)) {
+            f.close();
+            return false;
+        }
+        uint8_t raw[ROUTE_RECORD_BYTES];
+        cacheFirst = index;
+        cacheCount = 0;
+        while (cacheCount < ROUTE_CACHE_RECORDS && index + cacheCount < count &&
+               f.read(raw, sizeof(raw)) == sizeof(raw)) {
+            routeUnpackPoint(raw, cache[cacheCount++]);
+        }
+        f.close();
+        if (cacheCount == 0) {
+            return false;
+        }
+    }
+    out = cache[index - cacheFirst];
+    return true;
+}
+
+// Walks a RouteSource leg by leg. The target is the next point; a leg ends
+// when we come within ROUTE_ARRIVE_M of it, or when we are already closer
+// to the following leg than to the one we are on (a cut corner). Only the
+// previous, current and next points are kept, so update() is O(1) and
+// reads from the source only when a leg changes.
+class RouteFollower {
+private:
+    RouteSource* route;
+    uint32_t leg;                       // Index of the target point
+    uint32_t total;
+    RoutePoint prev, target, next;
+    bool havePrev, haveNext;
+
+    void loadLeg();
+
+    // Distance from (x, y) to segment a-b, local metres
+    static float segmentDistance(float x, float y, float ax, float ay, float bx, float by, float* t);
+    static void toLocal(const RoutePoint& p, const RoutePoint& origin, float cosLat, float& x, float& y);
+
+public:
+    uint32_t advances;
+
+    RouteFollower() : route(nullptr), leg(0), total(0), havePrev(false), haveNext(false), advances(0) {
+        memset(&prev, 0, sizeof(prev));
+        memset(&target, 0, sizeof(target));
+        memset(&next, 0, sizeof(next));
+    }
+
+    // Start at point firstLeg of the route
+    void start(RouteSource& source, uint32_t firstLeg = 0);
+    void stop() { route = nullptr; }
+
+    // Feed a position; returns true if the target moved on
+    bool update(double lat, double lon);
+
+    bool isActive() const { return route != nullptr && leg < total; }
+    bool isFinished() const { return route != nullptr && leg >= total; }
+    uint32_t getLeg() const { return leg; }
+    uint32_t getTotal() const { return total; }
+    const RoutePoint& getTarget() const { return target; }
+    double targetLat() const { return target.latE7 / 1e7; }
+    double targetLon() const { return target.lonE7 / 1e7; }
+};
+
+inline void RouteFollower::start(RouteSource& source, uint32_t firstLeg) {
+    route = &source;
+    total = source.size();
+    leg = firstLeg;
+    loadLeg();
+}
+
+inline void RouteFollower::loadLeg() {
+    if (!route || leg >= total) {
+        return;
+    }
+    havePrev = leg > 0 && route->get(leg - 1, prev);
+    route->get(leg, target);
+    haveNext = leg + 1 < total && route->get(leg + 1, next);
+}
+
+inline void RouteFollower::toLocal(const RoutePoint& p, const RoutePoint& origin, float cosLat, float& x, float& y) {
+    // Equirectangular around the target: plenty for legs of a few km
+    const float M_PER_E7 = 6371000.0f * (float)PI / 180.0f / 1e7f;
+    int64_t dLon = (int64_t)p.lonE7 - origin.lonE7;
+    if (dLon > 1800000000LL) dLon -= 3600000000LL;        // Across the date line
+    else if (dLon < -1800000000LL) dLon += 3600000000LL;
+    x = (float)dLon * M_PER_E7 * cosLat;
+    y = (float)((int64_t)p.latE7 - origin.latE7) * M_PER_E7;
+}
+
+inline float RouteFollower::segmentDistance(float x, float y, float ax, float ay, float bx, float by, float* t) {
+    float dx = bx - ax, dy = by - ay;
+    float len2 = dx * dx + dy * dy;
+    float u = len2 > 0.0f ? ((x - ax) * dx + (y - ay) * dy) / len2 : 0.0f;
+    if (t) *t = u;
+    u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+    float ex = ax + u * dx - x, ey = ay + u * dy - y;
+    return sqrtf(ex * ex + ey * ey);
+}
+
+inline bool RouteFollower::update(double lat, double lon) {
+    if (!isActive()) {
+        return false;
+    }
+
+    // 1) Everything in metres around the target
+    RoutePoint here;
+    here.latE7 = (int32_t)lround(lat * 1e7);
+    here.lonE7 = (int32_t)lround(lon * 1e7);
+    float cosLat = cosf(target.latE7 / 1e7f * (float)PI / 180.0f);
+    float x, y;
+    toLocal(here, target, cosLat, x, y);
+    bool done = sqrtf(x * x + y * y) < ROUTE_ARRIVE_M;
+
+    // 2) Cut corner: past the start of the next leg and nearer to it than to this one
+    if (!done && haveNext) {
+        float nx, ny, px = 0.0f, py = 0.0f, t;
+        toLocal(next, target, cosLat, nx, ny);
+        if (havePrev) toLocal(prev, target, cosLat, px, py);
+        float dNext = segmentDistance(x, y, 0.0f, 0.0f, nx, ny, &t);
+        float dThis = havePrev ? segmentDistance(x, y, px, py, 0.0f, 0.0f, nullptr) : sqrtf(x * x + y * y);
+        done = t > 0.0f && dNext < dThis;
+    }
+    if (!done) {
+        return false;
+    }
+
+    // 3) Next leg
+    leg++;
+    advances++;
+    if (leg < total) {
+        prev = target;
+        havePrev = true;
+        target = next;
+        haveNext = leg + 1 < total && route->get(leg + 1, next);
+    }
+    return true;
+}
+
+#endif // ROUTESTORE_H
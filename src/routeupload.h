@@ -0,0 +1,420 @@
+#ifndef ROUTEUPLOAD_H
+#define ROUTEUPLOAD_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <NimBLEDevice.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/stream_buffer.h>
+#include <esp_rom_crc.h>
+#include <atomic>
+#include "routeframe.h"
+#include "routestore.h"
+#include "blenav.h"
+
+// Receives route uploads (routeframe.h) from the USB console and from a
+// BLE write-without-response characteristic.
+// feed() only copies bytes into a stream buffer and never blocks, so it is
+// safe from the NimBLE host task and from the main loop. A task of its own
+// parses frames and gathers records into one ROUTE_PAGE_BYTES page, written
+// to ROUTE_TMP_PATH whenever it fills, so every write is a whole flash
+// block at a block-aligned offset. COMMIT appends the index record, checks
+// the CRC-32 and renames the file over ROUTE_PATH; LittleFS renames
+// atomically, so the old route stays loadable until the new one is
+// complete. The loop picks the new route up through generation().
+// A BEGIN for ROUTE_FILE_ZONES does the same with ZONE_TMP_PATH and
+// ZONE_PATH, and bumps zoneGeneration() instead.
+// One source owns an upload at a time; bytes from the other are dropped
+// until it has been idle for ROUTE_IDLE_MS.
+
+#define ROUTE_BLE_SERVICE_UUID "6b8e0001-2d5c-4c1e-9f3a-48544954524b"
+#define ROUTE_BLE_CHAR_UUID    "6b8e0002-2d5c-4c1e-9f3a-48544954524b"
+#define ROUTE_BLE_MTU          517
+#define ROUTE_RX_BUFFER        (ROUTE_WINDOW_RECORDS * ROUTE_RECORD_BYTES * 3 / 2)
+#define ROUTE_USB_RX_BUFFER    4096      // Console driver buffer between loop drains
+#define ROUTE_TASK_STACK       4096
+#define ROUTE_TASK_PRIO        1
+#define ROUTE_TASK_CORE        0    // Away from the loop; flash writes wait here
+#define ROUTE_IDLE_MS          1000UL    // Source released after this much silence
+#define ROUTE_SESSION_MS       15000UL   // An upload stalled this long is dropped
+
+enum RouteInput : uint8_t {
+    ROUTE_IN_NONE = 0,
+    ROUTE_IN_USB,
+    ROUTE_IN_BLE,
+};
+
+class RouteUpload : public NimBLECharacteristicCallbacks {
+private:
+    StreamBufferHandle_t rx;
+    TaskHandle_t task;
+    NimBLECharacteristic* chr;
+    BleNavService* link;
+    std::atomic<uint8_t> owner;         // RouteInput that may feed bytes
+    volatile uint32_t lastRxMs;
+    std::atomic<uint32_t> generation_;  // Completed route uploads
+    std::atomic<uint32_t> zoneGeneration_;
+
+    // Upload task state
+    RouteFrameParser parser;
+    File out;
+    bool active;
+    uint8_t session;                    // RouteInput of the running upload
+    uint8_t file;                       // ROUTE_FILE_* it writes
+    uint32_t expected;                  // Points announced by BEGIN
+    uint32_t received;                  // Next record index we accept
+    uint32_t crc;                       // Running CRC-32 of the records
+    bool nakSent;                       // One OUT_OF_SEQ per gap
+    uint32_t startMs;
+    uint16_t pageLen;
+    uint8_t page[ROUTE_PAGE_BYTES];
+
+    static void taskMain(void* arg);
+    void handleFrame();
+    void onBegin(const uint8_t* p, uint16_t len);
+    void onData(const uint8_t* p, uint16_t len);
+    void onCommit(const uint8_t* p, uint16_t len);
+    void finish(bool keep);
+    bool flushPage();
+    void reply(uint8_t status, uint8_t type);
+    const char* tmpPath() const { return file == ROUTE_FILE_ZONES ? ZONE_TMP_PATH : ROUTE_TMP_PATH; }
+
+public:
+    // Results
+    uint32_t uploads;
+    uint32_t failures;
+    uint32_t dropped;                   // Bytes refused (buffer full or other source)
+    uint32_t lastPoints;
+    uint32_t lastMs;
+
+    RouteUpload() : rx(nullptr), task(nullptr), chr(nullptr), link(nullptr), owner(ROUTE_IN_NONE), lastRxMs(0),
+                    generation_(0), zoneGeneration_(0), active(false), session(ROUTE_IN_NONE),
+                    file(ROUTE_FILE_ROUTE), expected(0), received(0), crc(0),
+                    nakSent(false), startMs(0), pageLen(0), uploads(0), failures(0), dropped(0),
+                    lastPoints(0), lastMs(0) {}
+
+    // Start the receive task; LittleFS must be mounted. BLE uploads switch
+    // ble (if given) to its bulk link parameters while they run
+    bool begin(BleNavService* ble);
+
+    // Add the upload characteristic; BleNavService::begin() calls this
+    // before the GATT server starts
+    void addBleService(NimBLEServer* server);
+    static void addBleServiceHook(NimBLEServer* server, void* ctx) {
+        static_cast<RouteUpload*>(ctx)->addBleService(server);
+    }
+
+    // Queue received bytes; any task, never blocks
+    void feed(RouteInput src, const uint8_t* data, size_t len);
+
+    // Bumped after every committed route / zone file upload
+    uint32_t generation() const { return generation_; }
+    uint32_t zoneGeneration() const { return zoneGeneration_; }
+    bool isActive() const { return active; }
+    uint32_t progress() const { return received; }
+    TaskHandle_t getTask() const { return task; }
+    uint32_t frameErrors() const { return parser.errors; }
+
+    // NimBLE host task
+    void onWrite(NimBLECharacteristic* c, NimBLEConnInfo& info) override;
+};
+
+inline bool RouteUpload::begin(BleNavService* ble) {
+    link = ble;
+    rx = xStreamBufferCreate(ROUTE_RX_BUFFER, 1);
+    if (!rx) {
+        return false;
+    }
+    if (xTaskCreatePinnedToCore(taskMain, "routeup", ROUTE_TASK_STACK, this,
+                                ROUTE_TASK_PRIO, &task, ROUTE_TASK_CORE) != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+inline void RouteUpload::addBleService(NimBLEServer* server) {
+    NimBLEDevice::setMTU(ROUTE_BLE_MTU);
+    NimBLEService* svc = server->createService(ROUTE_BLE_SERVICE_UUID);
+    chr = svc->createCharacteristic(ROUTE_BLE_CHAR_UUID, NIMBLE_PROPERTY::WRITE_NR | NIMBLE_PROPERTY::NOTIFY);
+    chr->setCallbacks(this);
+    svc->start();
+}
+
+inline void RouteUpload::onWrite(NimBLECharacteristic* c, NimBLEConnInfo&) {
+    NimBLEAttValue v = c->getValue();
+    feed(ROUTE_IN_BLE, v.data(), v.size());
+}
+
+inline void RouteUpload::feed(RouteInput src, const uint8_t* data, size_t len) {
+    if (!rx || len == 0) {
+        return;
+    }
+    // 1) Claim the receiver, or drop bytes from a second source
+    uint8_t cur = owner.load();
+    if (cur != src) {
+        uint8_t none = ROUTE_IN_NONE;
+        if (cur != ROUTE_IN_NONE || !owner.compare_exchange_strong(none, (uint8_t)src)) {
+            dropped += len;
+            return;
+        }
+    }
+    lastRxMs = millis();
+
+    // 2) Copy without waiting; a full buffer loses bytes, which the host
+    //    sees as an OUT_OF_SEQ reply and resends
+    size_t n = xStreamBufferSend(rx, data, len, 0);
+    dropped += len - n;
+}
+
+inline void RouteUpload::taskMain(void* arg) {
+    RouteUpload* self = static_cast<RouteUpload*>(arg);
+    uint8_t buf[256];
+    for (;;) {
+        size_t n = xStreamBufferReceive(self->rx, buf, sizeof(buf), pdMS_TO_TICKS(ROUTE_IDLE_MS / 4));
+        for (size_t i = 0; i < n; i++) {
+            if (self->parser.feed(buf[i])) {
+                self->handleFrame();
+            }
+        }
+        if (n > 0) {
+            continue;
+        }
+
+        // Idle: repeat an unanswered resend request, give a stalled upload
+        // up, then let either source start one
+        uint32_t quiet = millis() - self->lastRxMs;
+        if (self->active && self->nakSent) {
+            self->reply(ROUTE_ERR_SEQUENCE, ROUTE_MSG_DATA);
+        }
+        if (self->active && quiet > ROUTE_SESSION_MS) {
+            Serial.printf("→ Route upload timed out at %lu/%lu\n",
+                          (unsigned long)self->received, (unsigned long)self->expected);
+            self->finish(false);
+        }
+        if (!self->active && quiet > ROUTE_IDLE_MS && self->owner.load() != ROUTE_IN_NONE) {
+            self->parser.reset();
+            self->owner.store(ROUTE_IN_NONE);
+        }
+    }
+}
+
+inline void RouteUpload::handleFrame() {
+    const uint8_t* p = parser.payload();
+    uint16_t len = parser.length();
+    switch (parser.type()) {
+        case ROUTE_MSG_BEGIN:
+            onBegin(p, len);
+            break;
+        case ROUTE_MSG_DATA:
+            onData(p, len);
+            break;
+        case ROUTE_MSG_COMMIT:
+            onCommit(p, len);
+            break;
+        case ROUTE_MSG_ABORT:
+            if (active) finish(false);
+            reply(ROUTE_OK, ROUTE_MSG_ABORT);
+            break;
+        default:
+            break;
+    }
+}
+
+inline void RouteUpload::onBegin(const uint8_t* p, uint16_t len) {
+    if (active) {
+        finish(false);  // A new BEGIN replaces an unfinished upload
+    }
+    received = 0;
+    file = len == 5 ? p[4] : ROUTE_FILE_ROUTE;
+    if ((len != 4 && len != 5) || file > ROUTE_FILE_ZONES) {
+        file = ROUTE_FILE_ROUTE;
+        reply(ROUTE_ERR_FORMAT, ROUTE_MSG_BEGIN);
+        return;
+    }
+    uint32_t count = routeGet32(p);
+    if (count == 0 || count > (file == ROUTE_FILE_ZONES ? ZONE_MAX_RECORDS : ROUTE_MAX_POINTS)) {
+        reply(ROUTE_ERR_COUNT, ROUTE_MSG_BEGIN);
+        return;
+    }
+
+    // 1) Room for the new file next to the current one (freed by the rename)
+    size_t need = (size_t)(count + 1) * ROUTE_RECORD_BYTES + ROUTE_PAGE_BYTES;
+    if (LittleFS.totalBytes() - LittleFS.usedBytes() < need) {
+        reply(ROUTE_ERR_SPACE, ROUTE_MSG_BEGIN);
+        return;
+    }
+
+    // 2) Fresh temporary file
+    LittleFS.remove(tmpPath());
+    out = LittleFS.open(tmpPath(), FILE_WRITE);
+    if (!out) {
+        reply(ROUTE_ERR_FLASH, ROUTE_MSG_BEGIN);
+        return;
+    }
+    active = true;
+    session = owner.load();
+    expected = count;
+    crc = 0;
+    pageLen = 0;
+    nakSent = false;
+    startMs = millis();
+    if (session == ROUTE_IN_BLE && link) {
+        link->setBulkMode(true);
+    }
+    Serial.printf("→ %s upload: %lu records\n", file == ROUTE_FILE_ZONES ? "Zone" : "Route", (unsigned long)count);
+    reply(ROUTE_OK, ROUTE_MSG_BEGIN);
+}
+
+inline void RouteUpload::onData(const uint8_t* p, uint16_t len) {
+    if (!active) {
+        reply(ROUTE_ERR_STATE, ROUTE_MSG_DATA);
+        return;
+    }
+    if (len < 4 + ROUTE_RECORD_BYTES || (len - 4) % ROUTE_RECORD_BYTES != 0) {
+        reply(ROUTE_ERR_FORMAT, ROUTE_MSG_DATA);
+        return;
+    }
+    uint32_t first = routeGet32(p);
+    uint32_t n = (len - 4) / ROUTE_RECORD_BYTES;
+
+    // 1) In order only; tell the host once where to resume
+    if (first != received) {
+        if (!nakSent && first > received) {
+            nakSent = true;
+            reply(ROUTE_ERR_SEQUENCE, ROUTE_MSG_DATA);
+        }
+        return;  // Duplicates of stored records are ignored silently
+    }
+    nakSent = false;
+    if (received + n > expected) {
+        reply(ROUTE_ERR_COUNT, ROUTE_MSG_DATA);
+        finish(false);
+        return;
+    }
+
+    // 2) Gather into the page; whole pages go to flash
+    p += 4;
+    bool flushed = false;
+    while (n > 0) {
+        uint32_t room = (ROUTE_PAGE_BYTES - pageLen) / ROUTE_RECORD_BYTES;
+        uint32_t take = n < room ? n : room;
+        size_t bytes = take * ROUTE_RECORD_BYTES;
+        memcpy(page + pageLen, p, bytes);
+        crc = esp_rom_crc32_le(crc, page + pageLen, bytes);
+        pageLen += bytes;
+        p += bytes;
+        n -= take;
+        received += take;
+        if (pageLen == ROUTE_PAGE_BYTES) {
+            if (!flushPage()) {
+                reply(ROUTE_ERR_FLASH, ROUTE_MSG_DATA);
+                finish(false);
+                return;
+            }
+            flushed = true;
+        }
+    }
+
+    // 3) Progress (opens the host's window) once per page
+    if (flushed) {
+        reply(ROUTE_OK, ROUTE_MSG_DATA);
+    }
+}
+
+inline void RouteUpload::onCommit(const uint8_t* p, uint16_t len) {
+    if (!active) {
+        reply(ROUTE_ERR_STATE, ROUTE_MSG_COMMIT);
+        return;
+    }
+    if (len != 8) {
+        reply(ROUTE_ERR_FORMAT, ROUTE_MSG_COMMIT);
+        return;
+    }
+    if (routeGet32(p) != expected || received != expected) {
+        reply(ROUTE_ERR_SEQUENCE, ROUTE_MSG_COMMIT);
+        return;
+    }
+    if (routeGet32(p + 4) != crc) {
+        reply(ROUTE_ERR_VERIFY, ROUTE_MSG_COMMIT);
+        finish(false);
+        return;
+    }
+
+    // 1) Index record last, so only a complete file ever validates
+    if (pageLen + ROUTE_RECORD_BYTES > ROUTE_PAGE_BYTES && !flushPage()) {
+        reply(ROUTE_ERR_FLASH, ROUTE_MSG_COMMIT);
+        finish(false);
+        return;
+    }
+    RouteStore::makeIndex(page + pageLen, expected, crc);
+    pageLen += ROUTE_RECORD_BYTES;
+    bool ok = flushPage();
+    out.close();
+
+    // 2) Swap it in
+    ok = ok && LittleFS.rename(tmpPath(), file == ROUTE_FILE_ZONES ? ZONE_PATH : ROUTE_PATH);
+    if (!ok) {
+        reply(ROUTE_ERR_FLASH, ROUTE_MSG_COMMIT);
+        finish(false);
+        return;
+    }
+    lastPoints = expected;
+    lastMs = millis() - startMs;
+    uploads++;
+    if (file == ROUTE_FILE_ZONES) {
+        zoneGeneration_++;
+    } else {
+        generation_++;
+    }
+    Serial.printf("→ %s stored: %lu records in %lums\n", file == ROUTE_FILE_ZONES ? "Zones" : "Route",
+                  (unsigned long)lastPoints, (unsigned long)lastMs);
+    finish(true);
+    reply(ROUTE_OK, ROUTE_MSG_COMMIT);
+}
+
+inline bool RouteUpload::flushPage() {
+    if (pageLen == 0) {
+        return true;
+    }
+    bool ok = out.write(page, pageLen) == pageLen;
+    pageLen = 0;
+    return ok;
+}
+
+inline void RouteUpload::finish(bool keep) {
+    if (!keep) {
+        if (out) out.close();
+        LittleFS.remove(tmpPath());
+        failures++;
+    }
+    if (session == ROUTE_IN_BLE && link) {
+        link->setBulkMode(false);
+    }
+    active = false;
+    session = ROUTE_IN_NONE;
+    pageLen = 0;
+}
+
+inline void RouteUpload::reply(uint8_t status, uint8_t type) {
+    uint8_t payload[6];
+    payload[0] = status;
+    payload[1] = type;
+    routePut32(payload + 2, received);
+    uint8_t frame[ROUTE_FRAME_OVERHEAD + sizeof(payload)];
+    size_t n = routeFrameEncode(ROUTE_MSG_ACK, payload, sizeof(payload), frame);
+
+    // Back to whichever side is talking; the console gets it in one write so
+    // log lines from other tasks cannot land inside the frame
+    if (owner.load() == ROUTE_IN_BLE) {
+        if (chr) {
+            chr->setValue(frame, n);
+            chr->notify();
+        }
+    } else {
+        Serial.write(frame, n);
+    }
+}
+
+#endif // ROUTEUPLOAD_H
@@ -0,0 +1,177 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative periodic scheduler for the main loop.
+// Each subsystem registers a period, a deadline (how late it may start
+// before counting as a miss) and a budget (how long one run may take).
+// runDue() executes every task whose time has come, in registration order,
+// and msUntilNextDue() tells the idle path how long it may sleep.
+
+#define SCHED_MAX_TASKS 12
+#define SCHED_MAX_IDLE_MS 1000     // Longest idle, even with no task enabled
+
+typedef void (*SchedTaskFn)(void* ctx);
+
+struct SchedTask {
+    const char* name;
+    SchedTaskFn fn;
+    void* ctx;
+    uint32_t periodMs;         // Release interval
+    uint32_t deadlineMs;       // Max tolerated start lateness
+    uint32_t budgetUs;         // Max expected execution time
+    uint32_t nextDue;          // millis() timestamp of next release
+    bool enabled;
+
+    // Statistics
+    uint32_t runs;             // Completed executions
+    uint32_t overruns;         // Executions longer than budgetUs
+    uint32_t deadlineMisses;   // Starts later than deadlineMs
+    uint32_t skipped;          // Whole periods dropped after falling behind
+    uint32_t lastJitterMs;     // Start lateness of the most recent run
+    uint32_t maxJitterMs;      // Worst start lateness seen
+    uint32_t lastExecUs;       // Duration of the most recent run
+    uint32_t maxExecUs;        // Worst duration seen
+};
+
+class TaskScheduler {
+private:
+    SchedTask tasks[SCHED_MAX_TASKS];
+    int taskCount;
+
+    // Wrap-safe "a is at or after b" for millis() timestamps
+    static bool reached(uint32_t now, uint32_t due) { return (int32_t)(now - due) >= 0; }
+
+public:
+    TaskScheduler() : taskCount(0) { memset(tasks, 0, sizeof(tasks)); }
+
+    // Register a task; it is released immediately and then every periodMs.
+    // Returns the task id, or -1 if the table is full.
+    int add(const char* name, SchedTaskFn fn, void* ctx,
+            uint32_t periodMs, uint32_t deadlineMs, uint32_t budgetUs);
+
+    void setEnabled(int id, bool enabled);
+    void setPeriod(int id, uint32_t periodMs);
+
+    // Run all due tasks once; returns how many ran
+    int runDue();
+
+    // Milliseconds until the earliest enabled task is due (0 = something is due now),
+    // at most SCHED_MAX_IDLE_MS
+    uint32_t msUntilNextDue() const;
+
+    int count() const { return taskCount; }
+    const SchedTask& task(int id) const { return tasks[id]; }
+    void resetStats();
+    void print(Print& out) const;
+};
+
+inline int TaskScheduler::add(const char* name, SchedTaskFn fn, void* ctx,
+                              uint32_t periodMs, uint32_t deadlineMs, uint32_t budgetUs) {
+    if (taskCount >= SCHED_MAX_TASKS || fn == nullptr) {
+        return -1;
+    }
+    SchedTask& t = tasks[taskCount];
+    memset(&t, 0, sizeof(t));
+    t.name = name;
+    t.fn = fn;
+    t.ctx = ctx;
+    t.periodMs = periodMs;
+    t.deadlineMs = deadlineMs;
+    t.budgetUs = budgetUs;
+    t.nextDue = millis();
+    t.enabled = true;
+    return taskCount++;
+}
+
+inline void TaskScheduler::setEnabled(int id, bool enabled) {
+    if (id < 0 || id >= taskCount) return;
+    if (enabled && !tasks[id].enabled) {
+        tasks[id].nextDue = millis();  // Release right away when re-enabled
+    }
+    tasks[id].enabled = enabled;
+}
+
+inline void TaskScheduler::setPeriod(int id, uint32_t periodMs) {
+    if (id < 0 || id >= taskCount) return;
+    tasks[id].periodMs = periodMs;
+}
+
+inline int TaskScheduler::runDue() {
+    int ran = 0;
+    for (int i = 0; i < taskCount; i++) {
+        SchedTask& t = tasks[i];
+        uint32_t now = millis();
+        if (!t.enabled || !reached(now, t.nextDue)) {
+            continue;
+        }
+
+        // 1) Jitter = how late we started relative to the release time
+        uint32_t lateness = now - t.nextDue;
+        t.lastJitterMs = lateness;
+        if (lateness > t.maxJitterMs) t.maxJitterMs = lateness;
+        if (lateness > t.deadlineMs) t.deadlineMisses++;
+
+        // 2) Execute and measure
+        uint32_t startUs = micros();
+        t.fn(t.ctx);
+        uint32_t execUs = micros() - startUs;
+        t.lastExecUs = execUs;
+        if (execUs > t.maxExecUs) t.maxExecUs = execUs;
+        if (t.budgetUs > 0 && execUs > t.budgetUs) t.overruns++;
+        t.runs++;
+        ran++;
+
+        // 3) Schedule next release on the fixed grid; if we fell a whole
+        //    period behind, drop the missed releases instead of bursting
+        now = millis();
+        if (t.periodMs == 0) {
+            t.nextDue = now;  // Polled task: due again on the next pass
+            continue;
+        }
+        t.nextDue += t.periodMs;
+        if (reached(now, t.nextDue + t.periodMs)) {
+            t.skipped += (now - t.nextDue) / t.periodMs;
+            t.nextDue = now + t.periodMs;
+        }
+    }
+    return ran;
+}
+
+inline uint32_t TaskScheduler::msUntilNextDue() const {
+    uint32_t now = millis();
+    uint32_t best = SCHED_MAX_IDLE_MS;
+    for (int i = 0; i < taskCount; i++) {
+        const SchedTask& t = tasks[i];
+        if (!t.enabled) continue;
+        if (reached(now, t.nextDue)) return 0;
+        uint32_t wait = t.nextDue - now;
+        if (wait < best) best = wait;
+    }
+    return best;
+}
+
+inline void TaskScheduler::resetStats() {
+    for (int i = 0; i < taskCount; i++) {
+        SchedTask& t = tasks[i];
+        t.runs = t.overruns = t.deadlineMisses = t.skipped = 0;
+        t.lastJitterMs = t.maxJitterMs = 0;
+        t.lastExecUs = t.maxExecUs = 0;
+    }
+}
+
+inline void TaskScheduler::print(Print& out) const {
+    out.println("=== SCHEDULER ===");
+    for (int i = 0; i < taskCount; i++) {
+        const SchedTask& t = tasks[i];
+        out.printf("%-8s per=%lums runs=%lu ovr=%lu miss=%lu skip=%lu jit=%lu/%lums exec=%lu/%luus\n",
+                   t.name, (unsigned long)t.periodMs, (unsigned long)t.runs,
+                   (unsigned long)t.overruns, (unsigned long)t.deadlineMisses,
+                   (unsigned long)t.skipped, (unsigned long)t.lastJitterMs,
+                   (unsigned long)t.maxJitterMs, (unsigned long)t.lastExecUs,
+                   (unsigned long)t.maxExecUs);
+    }
+}
+
+#endif // SCHEDULER_H
@@ -0,0 +1,285 @@
+#ifndef TASKHEALTH_H
+#define TASKHEALTH_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_task_wdt.h>
+#include <esp_idf_version.h>
+
+// FreeRTOS task health monitor.
+// Watched tasks (main loop, and later ingest/render/radio tasks) register a
+// handle, their stack size and a check-in timeout. sample() records each
+// task's stack high-water mark, its CPU share since the previous sample and
+// the idle share of each core. feedWatchdog() resets the task watchdog only
+// while every watched task has checked in on time, so a starved task stops
+// the feed and the TWDT fires instead of the fault going unnoticed.
+// CPU figures come from the FreeRTOS run-time counters when the framework
+// is built with configGENERATE_RUN_TIME_STATS. The prebuilt Arduino-ESP32
+// sdkconfig leaves it off, so there the per-core idle share comes from idle
+// hooks instead: each core's idle task stamps esp_timer_get_time() on every
+// pass, and a gap of at most HEALTH_IDLE_GAP_US between two passes counts as
+// idle. Work shorter than that gap counts as idle too, so the figure is an
+// upper bound. Per-task CPU then reads -1.
+
+#define HEALTH_MAX_TASKS 8
+#define HEALTH_STATUS_SLOTS 24   // uxTaskGetSystemState() scratch entries (no heap use)
+
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+#define HEALTH_HAVE_RUNTIME_STATS 1
+#else
+#define HEALTH_HAVE_RUNTIME_STATS 0
+#include <esp_freertos_hooks.h>
+#include <esp_timer.h>
+#define HEALTH_IDLE_GAP_US (2000000UL / configTICK_RATE_HZ)   // Two ticks: idle wakes on every tick
+#endif
+
+struct WatchedTask {
+    const char* name;
+    TaskHandle_t handle;
+    uint32_t stackBytes;        // Stack size given at creation (0 = unknown)
+    uint32_t timeoutMs;         // Max gap between check-ins (0 = not watched)
+    uint32_t lastCheckIn;       // millis() of last check-in
+    uint32_t stackFreeMin;      // High-water mark: least free stack ever (bytes)
+    uint32_t lastRunTime;       // Run-time counter at previous sample
+    int8_t cpuPercent;          // Share of total CPU time over the last window, -1 = n/a
+    bool starved;               // Missed its check-in deadline at the last feed
+};
+
+class TaskHealthMonitor {
+private:
+    WatchedTask tasks[HEALTH_MAX_TASKS];
+    int taskCount;
+    bool wdtSubscribed;
+
+#if HEALTH_HAVE_RUNTIME_STATS
+    TaskStatus_t statusBuf[HEALTH_STATUS_SLOTS];
+    uint32_t lastTotalRunTime;
+    uint32_t lastIdleRunTime[portNUM_PROCESSORS];
+#else
+    struct IdleClock {
+        volatile uint32_t lastUs;      // esp_timer_get_time() at the last idle pass
+        volatile uint32_t idleUs;      // Idle time so far (wraps; only differences count)
+    };
+    bool idleHooked;
+    uint32_t lastSampleUs;
+    uint32_t lastIdleUs[portNUM_PROCESSORS];
+
+    static IdleClock* idleClocks() {
+        static IdleClock clocks[portNUM_PROCESSORS];
+        return clocks;
+    }
+    static bool onIdle(int core);
+    static bool onIdle0() { return onIdle(0); }
+#if portNUM_PROCESSORS > 1
+    static bool onIdle1() { return onIdle(1); }
+#endif
+#endif
+
+    static TaskHandle_t idleHandle(int core);
+
+public:
+    int8_t coreIdlePercent[portNUM_PROCESSORS];   // -1 = n/a
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    uint32_t feeds;
+    uint32_t withheldFeeds;
+    uint32_t samples;
+
+    TaskHealthMonitor();
+
+    // Subscribe the calling task to the task watchdog
+    void begin();
+
+    // Register a task; returns its id or -1 when full
+    int watch(const char* name, TaskHandle_t handle, uint32_t stackBytes, uint32_t timeoutMs);
+
+    // Called by a watched task to prove it is still making progress
+    void checkIn(int id) { if (id >= 0 && id < taskCount) tasks[id].lastCheckIn = millis(); }
+
+    void sample();
+    bool feedWatchdog();
+
+    int count() const { return taskCount; }
+    const WatchedTask& task(int id) const { return tasks[id]; }
+
+    // Watched task with the least stack headroom, or -1
+    int tightestStack() const;
+
+    void print(Print& out) const;
+};
+
+inline TaskHealthMonitor::TaskHealthMonitor()
+    : taskCount(0), wdtSubscribed(false), freeHeap(0), minFreeHeap(0),
+      feeds(0), withheldFeeds(0), samples(0) {
+    memset(tasks, 0, sizeof(tasks));
+#if HEALTH_HAVE_RUNTIME_STATS
+    lastTotalRunTime = 0;
+    memset(lastIdleRunTime, 0, sizeof(lastIdleRunTime));
+#else
+    idleHooked = false;
+    lastSampleUs = 0;
+    memset(lastIdleUs, 0, sizeof(lastIdleUs));
+#endif
+    for (int c = 0; c < portNUM_PROCESSORS; c++) coreIdlePercent[c] = -1;
+}
+
+inline TaskHandle_t TaskHealthMonitor::idleHandle(int core) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    return xTaskGetIdleTaskHandleForCore(core);
+#else
+    return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+}
+
+#if !HEALTH_HAVE_RUNTIME_STATS
+inline bool TaskHealthMonitor::onIdle(int core) {
+    IdleClock& c = idleClocks()[core];
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    if (now - c.lastUs <= HEALTH_IDLE_GAP_US) c.idleUs += now - c.lastUs;
+    c.lastUs = now;
+    return true;                       // Wait for the next interrupt before the next pass
+}
+#endif
+
+inline void TaskHealthMonitor::begin() {
+    wdtSubscribed = (esp_task_wdt_add(NULL) == ESP_OK);
+#if !HEALTH_HAVE_RUNTIME_STATS
+    idleHooked = esp_register_freertos_idle_hook_for_cpu(onIdle0, 0) == ESP_OK;
+#if portNUM_PROCESSORS > 1
+    idleHooked = idleHooked && esp_register_freertos_idle_hook_for_cpu(onIdle1, 1) == ESP_OK;
+#endif
+#endif
+    sample();
+}
+
+inline int TaskHealthMonitor::watch(const char* name, TaskHandle_t handle, uint32_t stackBytes, uint32_t timeoutMs) {
+    if (taskCount >= HEALTH_MAX_TASKS || handle == NULL) {
+        return -1;
+    }
+    WatchedTask& t = tasks[taskCount];
+    memset(&t, 0, sizeof(t));
+    t.name = name;
+    t.handle = handle;
+    t.stackBytes = stackBytes;
+    t.timeoutMs = timeoutMs;
+    t.lastCheckIn = millis();
+    t.stackFreeMin = UINT32_MAX;
+    t.cpuPercent = -1;
+    return taskCount++;
+}
+
+inline void TaskHealthMonitor::sample() {
+    samples++;
+    freeHeap = ESP.getFreeHeap();
+    minFreeHeap = ESP.getMinFreeHeap();
+
+    // 1) Stack high-water marks (bytes on ESP-IDF)
+    for (int i = 0; i < taskCount; i++) {
+        uint32_t hwm = uxTaskGetStackHighWaterMark(tasks[i].handle);
+        if (hwm < tasks[i].stackFreeMin) tasks[i].stackFreeMin = hwm;
+    }
+
+#if HEALTH_HAVE_RUNTIME_STATS
+    // 2) Run-time counters → per-task CPU share and per-core idle share
+    uint32_t totalRunTime = 0;
+    UBaseType_t n = uxTaskGetSystemState(statusBuf, HEALTH_STATUS_SLOTS, &totalRunTime);
+    if (n == 0) {
+        return;  // More tasks than scratch slots; skip this window
+    }
+    uint32_t window = totalRunTime - lastTotalRunTime;
+    bool haveWindow = (lastTotalRunTime != 0 && window > 0);
+
+    for (UBaseType_t k = 0; k < n; k++) {
+        const TaskStatus_t& st = statusBuf[k];
+        for (int i = 0; i < taskCount; i++) {
+            if (tasks[i].handle != st.xHandle) continue;
+            if (haveWindow) {
+                // totalRunTime is per core, so one fully busy core = 100%
+                uint64_t pct = (uint64_t)(st.ulRunTimeCounter - tasks[i].lastRunTime) * 100 / window;
+                tasks[i].cpuPercent = (int8_t)(pct > 100 ? 100 : pct);
+            }
+            tasks[i].lastRunTime = st.ulRunTimeCounter;
+        }
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            if (st.xHandle != idleHandle(c)) continue;
+            if (haveWindow) {
+                uint64_t pct = (uint64_t)(st.ulRunTimeCounter - lastIdleRunTime[c]) * 100 / window;
+                coreIdlePercent[c] = (int8_t)(pct > 100 ? 100 : pct);
+            }
+            lastIdleRunTime[c] = st.ulRunTimeCounter;
+        }
+    }
+    lastTotalRunTime = totalRunTime;
+#else
+    // 2) Idle hooks → per-core idle share
+    if (!idleHooked) {
+        return;
+    }
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    uint32_t window = now - lastSampleUs;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        uint32_t idle = idleClocks()[c].idleUs;
+        if (lastSampleUs != 0 && window > 0) {
+            uint64_t pct = (uint64_t)(idle - lastIdleUs[c]) * 100 / window;
+            coreIdlePercent[c] = (int8_t)(pct > 100 ? 100 : pct);
+        }
+        lastIdleUs[c] = idle;
+    }
+    lastSampleUs = now;
+#endif
+}
+
+inline bool TaskHealthMonitor::feedWatchdog() {
+    uint32_t now = millis();
+    bool healthy = true;
+    for (int i = 0; i < taskCount; i++) {
+        WatchedTask& t = tasks[i];
+        bool late = t.timeoutMs > 0 && (now - t.lastCheckIn) > t.timeoutMs;
+        if (late && !t.starved) {
+            Serial.printf("→ HEALTH: task '%s' missed check-in (%lums)\n", t.name,
+                          (unsigned long)(now - t.lastCheckIn));
+        }
+        t.starved = late;
+        if (late) healthy = false;
+    }
+
+    if (!healthy) {
+        withheldFeeds++;
+        return false;
+    }
+    if (wdtSubscribed) {
+        esp_task_wdt_reset();
+    }
+    feeds++;
+    return true;
+}
+
+inline int TaskHealthMonitor::tightestStack() const {
+    int best = -1;
+    for (int i = 0; i < taskCount; i++) {
+        if (tasks[i].stackFreeMin == UINT32_MAX) continue;
+        if (best < 0 || tasks[i].stackFreeMin < tasks[best].stackFreeMin) best = i;
+    }
+    return best;
+}
+
+inline void TaskHealthMonitor::print(Print& out) const {
+    out.println("=== TASK HEALTH ===");
+    for (int i = 0; i < taskCount; i++) {
+        const WatchedTask& t = tasks[i];
+        out.printf("%-8s stack=%lu free_min=%lu cpu=%d%% checkin=%lums%s\n",
+                   t.name, (unsigned long)t.stackBytes,
+                   (unsigned long)(t.stackFreeMin == UINT32_MAX ? 0 : t.stackFreeMin),
+                   t.cpuPercent, (unsigned long)(millis() - t.lastCheckIn),
+                   t.starved ? " STARVED" : "");
+    }
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        out.printf("core%d idle=%d%%\n", c, coreIdlePercent[c]);
+    }
+    out.printf("heap free=%lu min=%lu  wdt feeds=%lu withheld=%lu\n",
+               (unsigned long)freeHeap, (unsigned long)minFreeHeap,
+               (unsigned long)feeds, (unsigned long)withheldFeeds);
+}
+
+#endif // TASKHEALTH_H
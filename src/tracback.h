@@ -0,0 +1,304 @@
+#ifndef TRACBACK_H
+#define TRACBACK_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "tracklog.h"
+#include "trailstore.h"
+#include "routestore.h"
+
+// TracBack: the way we came, as a route back to where this power-on's
+// track starts.
+// begin() hands the track log's session (see TrackLog::getSessionStart) to
+// step(), which decodes TRACBACK_STEP_BYTES of it per call into a
+// TrailStoreN at TRACBACK_TOL_M, so a day-long log is read in the
+// background without holding the loop. The simplified track is then served
+// newest point first as a RouteSource for RouteFollower.
+// A uniform grid over the track lists the segments crossing each cell, so
+// nearestLeg() (where to join the route, and whether a later leg is closer
+// than the one being followed) looks at the cells around the position
+// instead of every segment.
+
+#define TRACBACK_MAX_POINTS  512
+#define TRACBACK_TOL_M       8         // Keeps neighbouring switchbacks apart
+#define TRACBACK_STEP_BYTES  2048      // Log bytes decoded per step()
+#define TRACBACK_GRID        16        // Cells per side of the segment index
+#define TRACBACK_INDEX_MAX   2048      // Segment entries over all cells
+#define TRACBACK_REJOIN_M    30.0f     // A later leg this close is skipped to
+
+class TracBack : public RouteSource {
+private:
+    TrailStoreN<TRACBACK_MAX_POINTS> path;
+    TrackDecoder decoder;
+    TrackLog* log;
+    uint8_t file;                      // 0 = TRACK_OLD_PATH, 1 = TRACK_LOG_PATH, 2 = done
+    uint32_t offset;                   // Next byte to decode in that file
+    bool building;
+    bool ready;
+
+    // Segment index: cell c lists segments cellSegs[cellStart[c] .. cellStart[c + 1])
+    int32_t gridX, gridY;              // South-west corner, local metres
+    int32_t cell;                      // Cell side, metres
+    uint8_t dim;                       // Cells per side (TRACBACK_GRID, less if the track is tangled)
+    uint16_t cellStart[TRACBACK_GRID * TRACBACK_GRID + 1];
+    uint16_t cellSegs[TRACBACK_INDEX_MAX];
+
+    int32_t cellOf(int32_t v, int32_t origin) const {
+        int32_t c = (v - origin) / cell;
+        return c < 0 ? 0 : (c >= dim ? dim - 1 : c);
+    }
+    template <class F> void forEachCell(uint16_t seg, F visit) const;
+    void buildIndex();
+    void finish();
+
+public:
+    uint32_t decoded;                  // Log points read this build
+    uint32_t probes;                   // Segments measured by nearestLeg() so far
+
+    TracBack() : path(TRACBACK_TOL_M), log(nullptr), file(2), offset(0), building(false), ready(false), gridX(0),
+                 gridY(0), cell(1), dim(1), decoded(0), probes(0) {
+        memset(cellStart, 0, sizeof(cellStart));
+    }
+
+    // Start reading this power-on's track; false if there is no log
+    bool begin(TrackLog& trackLog);
+
+    // Decode the next piece of the log; true while there is more to read
+    bool step();
+
+    void cancel();
+
+    bool isBuilding() const { return building; }
+    bool isReady() const { return ready; }
+    uint8_t indexDim() const { return dim; }
+    uint16_t indexEntries() const { return cellStart[dim * dim]; }
+    int32_t tolerance() const { return path.tolerance(); }
+
+    // The route back: newest point first, the start of the track last
+    uint32_t size() const override { return ready ? path.size() : 0; }
+    bool get(uint32_t index, RoutePoint& out) override;
+
+    // Leg of the route whose segment passes nearest to a position (the leg's
+    // target is that segment's end nearer the start), and how far away it is
+    bool nearestLeg(double lat, double lon, uint32_t& leg, float& distM);
+
+    // The same by measuring every segment; what nearestLeg() must agree with
+    bool nearestLegScan(double lat, double lon, uint32_t& leg, float& distM) const;
+};
+
+inline bool TracBack::begin(TrackLog& trackLog) {
+    cancel();
+    if (!trackLog.isMounted()) {
+        return false;
+    }
+    // 1) Everything up to now goes to flash, and rotation waits for us
+    trackLog.flush();
+    trackLog.beginRead();
+    log = &trackLog;
+
+    // 2) The session starts in the old file or the current one
+    File old = LittleFS.open(TRACK_OLD_PATH, FILE_READ);
+    uint32_t oldSize = old ? old.size() : 0;
+    old.close();
+    uint32_t start = trackLog.getSessionStart();
+    if (start < oldSize) {
+        file = 0;
+        offset = start;
+    } else {
+        file = 1;
+        offset = start - oldSize;
+    }
+    path.reset();
+    decoder.reset();
+    decoded = 0;
+    building = true;
+    return true;
+}
+
+inline void TracBack::cancel() {
+    if (building && log) {
+        log->endRead();
+    }
+    building = false;
+    ready = false;
+    file = 2;
+}
+
+inline bool TracBack::step() {
+    if (!building) {
+        return false;
+    }
+    // 1) Read on from where the last step stopped
+    uint32_t budget = TRACBACK_STEP_BYTES;
+    while (budget > 0 && file < 2) {
+        File f = LittleFS.open(file == 0 ? TRACK_OLD_PATH : TRACK_LOG_PATH, FILE_READ);
+        if (!f || !f.seek(offset)) {
+            f.close();
+            file++;
+            offset = 0;
+            continue;
+        }
+        uint8_t buf[256];
+        size_t n = 0;
+        while (budget > 0 && (n = f.read(buf, budget < sizeof(buf) ? budget : sizeof(buf))) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                TrackFix fix;
+                if (decoder.push(buf[i], fix)) {
+                    path.add(fix.latE6 / 1e6, fix.lonE6 / 1e6);
+                    decoded++;
+                }
+            }
+            offset += n;
+            budget -= n;
+        }
+        f.close();
+        if (n == 0) {
+            file++;                    // End of this file
+            offset = 0;
+        }
+    }
+    if (file < 2) {
+        return true;
+    }
+
+    // 2) All read: index the segments and let go of the log
+    finish();
+    return false;
+}
+
+inline void TracBack::finish() {
+    building = false;
+    if (log) {
+        log->endRead();
+    }
+    buildIndex();
+    ready = true;
+}
+
+template <class F>
+inline void TracBack::forEachCell(uint16_t seg, F visit) const {
+    // Row by row: the cells the segment's x range covers within each row of cells
+    const TrailPoint& a = path.at(seg);
+    const TrailPoint& b = path.at(seg + 1);
+    int32_t cy0 = cellOf(min(a.y, b.y), gridY), cy1 = cellOf(max(a.y, b.y), gridY);
+    for (int32_t cy = cy0; cy <= cy1; cy++) {
+        int32_t xl = a.x, xh = b.x;
+        if (a.y != b.y) {
+            int32_t yl = max(min(a.y, b.y), gridY + cy * cell);
+            int32_t yh = min(max(a.y, b.y), gridY + (cy + 1) * cell);
+            xl = a.x + (int32_t)((int64_t)(b.x - a.x) * (yl - a.y) / (b.y - a.y));
+            xh = a.x + (int32_t)((int64_t)(b.x - a.x) * (yh - a.y) / (b.y - a.y));
+        }
+        int32_t cx0 = cellOf(min(xl, xh), gridX), cx1 = cellOf(max(xl, xh), gridX);
+        for (int32_t cx = cx0; cx <= cx1; cx++) {
+            visit(cy * dim + cx);
+        }
+    }
+}
+
+inline void TracBack::buildIndex() {
+    uint16_t segs = path.size() > 1 ? path.size() - 1 : 0;
+    int32_t x0, y0, x1, y1;
+    path.extent(x0, y0, x1, y1);
+    gridX = x0;
+    gridY = y0;
+
+    // 1) Count entries per cell; a track that crosses itself a lot gets coarser cells
+    for (dim = TRACBACK_GRID;; dim /= 2) {
+        cell = max((int32_t)1, (max(x1 - x0, y1 - y0) + dim) / dim);
+        memset(cellStart, 0, sizeof(cellStart));
+        uint32_t total = 0;
+        for (uint16_t s = 0; s < segs; s++) {
+            forEachCell(s, [this, &total](int32_t c) {
+                cellStart[c + 1]++;
+                total++;
+            });
+        }
+        if (total <= TRACBACK_INDEX_MAX || dim == 1) break;
+    }
+
+    // 2) Prefix sums, then drop each segment into its cells
+    for (uint16_t c = 0; c < dim * dim; c++) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    uint16_t fill[TRACBACK_GRID * TRACBACK_GRID];
+    memcpy(fill, cellStart, sizeof(fill));
+    for (uint16_t s = 0; s < segs; s++) {
+        forEachCell(s, [this, &fill, s](int32_t c) {
+            if (fill[c] < TRACBACK_INDEX_MAX) cellSegs[fill[c]++] = s;
+        });
+    }
+}
+
+inline bool TracBack::get(uint32_t index, RoutePoint& out) {
+    uint32_t n = size();
+    if (index >= n) {
+        return false;
+    }
+    path.toLatLonE7(path.at((uint16_t)(n - 1 - index)), out.latE7, out.lonE7);
+    memset(out.name, 0, sizeof(out.name));
+    strncpy(out.name, index == n - 1 ? "Track start" : "TracBack", sizeof(out.name) - 1);
+    return true;
+}
+
+inline bool TracBack::nearestLeg(double lat, double lon, uint32_t& leg, float& distM) {
+    TrailPoint p;
+    if (!ready || path.size() < 2 || !path.toLocal(lat, lon, p)) {
+        return false;
+    }
+
+    // 1) Rings of cells around the position (clamped onto the grid), until the
+    //    next ring cannot hold anything nearer than the best so far
+    int32_t cx = cellOf(p.x, gridX), cy = cellOf(p.y, gridY);
+    int64_t best = INT64_MAX;
+    uint16_t bestSeg = 0;
+    for (int32_t r = 0; r < dim; r++) {
+        for (int32_t y = cy - r; y <= cy + r; y++) {
+            if (y < 0 || y >= dim) continue;
+            bool edgeRow = (y == cy - r || y == cy + r);
+            for (int32_t x = cx - r; x <= cx + r; x += (edgeRow || r == 0) ? 1 : 2 * r) {
+                if (x < 0 || x >= dim) continue;
+                int32_t c = y * dim + x;
+                for (uint16_t i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                    uint16_t s = cellSegs[i];
+                    int64_t d = path.segDist2(p, path.at(s), path.at(s + 1));
+                    probes++;
+                    if (d < best || (d == best && s < bestSeg)) {
+                        best = d;
+                        bestSeg = s;
+                    }
+                }
+            }
+        }
+        if (best != INT64_MAX && best <= (int64_t)r * cell * r * cell) break;
+    }
+    if (best == INT64_MAX) {
+        return false;
+    }
+
+    // 2) Segment s runs from point s to s + 1; heading back its target is point s
+    leg = path.size() - 1 - bestSeg;
+    distM = sqrtf((float)best);
+    return true;
+}
+
+inline bool TracBack::nearestLegScan(double lat, double lon, uint32_t& leg, float& distM) const {
+    TrailPoint p;
+    if (!ready || path.size() < 2 || !path.toLocal(lat, lon, p)) {
+        return false;
+    }
+    int64_t best = INT64_MAX;
+    uint16_t bestSeg = 0;
+    for (uint16_t s = 0; s + 1 < path.size(); s++) {
+        int64_t d = path.segDist2(p, path.at(s), path.at(s + 1));
+        if (d < best) {
+            best = d;
+            bestSeg = s;
+        }
+    }
+    leg = path.size() - 1 - bestSeg;
+    distM = sqrtf((float)best);
+    return true;
+}
+
+#endif // TRACBACK_H
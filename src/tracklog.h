@@ -0,0 +1,303 @@
+#ifndef TRACKLOG_H
+#define TRACKLOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "navsnapshot.h"
+
+// Breadcrumb track log in LittleFS.
+// Each logged point is a delta against the previous one: a varint of the
+// seconds elapsed (never 0) followed by zigzag varints of the latitude and
+// longitude change in 1e-6 degrees, so a walking-pace point costs 3-5 bytes.
+// Every TRACK_KEY_EVERY points, and at the start of every file, a keyframe
+// (0x00, uint32 uptime seconds, int32 lat, int32 lon, little-endian) restarts
+// the chain so a reader can pick the stream up after a damaged or cut-off
+// record.
+// Points collect in a RAM page and are appended to the file a page at a
+// time. When the file passes TRACK_LOG_MAX_BYTES it becomes TRACK_OLD_PATH
+// (replacing the previous one), unless a download is reading it. Readers
+// run on other tasks; one lock covers both the reader count and the
+// rotation, so a read cannot start between the check and the rename.
+
+#define TRACK_LOG_PATH        "/track.bin"
+#define TRACK_OLD_PATH        "/track.old"
+#define TRACK_LOG_MAX_BYTES   (512UL * 1024UL)
+#define TRACK_PAGE_BYTES      256
+#define TRACK_KEY_EVERY       64
+#define TRACK_LOG_INTERVAL_MS 5000UL     // At most one point per interval...
+#define TRACK_MIN_STEP_E6     45         // ...and only after moving ~5 m
+#define TRACK_KEY_BYTES       13
+#define TRACK_MAX_RECORD      TRACK_KEY_BYTES
+#define TRACK_MAX_DELTA       15         // Three 32-bit varints, for readers
+
+class TrackLog {
+private:
+    uint8_t page[TRACK_PAGE_BYTES];
+    uint16_t pageLen;
+    bool mounted;
+    bool haveLast;
+    int32_t lastLat, lastLon;
+    uint32_t lastSec;
+    uint32_t lastLogMs;
+    uint16_t sinceKey;
+    bool newFile;                       // Next point must be a keyframe
+    uint32_t sessionStart;              // Committed offset of this power-on's first point
+    int readers;                        // Downloads in progress; rotation waits for them
+    SemaphoreHandle_t readLock;         // Guards readers and the rotation
+
+    // Holds readLock for a scope (no-op before begin() creates it)
+    class LockGuard {
+    private:
+        SemaphoreHandle_t m;
+    public:
+        explicit LockGuard(SemaphoreHandle_t h) : m(h) { if (m) xSemaphoreTake(m, portMAX_DELAY); }
+        ~LockGuard() { if (m) xSemaphoreGive(m); }
+    };
+
+    static uint8_t putVarint(uint8_t* p, uint32_t v) {
+        uint8_t n = 0;
+        while (v >= 0x80) {
+            p[n++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        p[n++] = (uint8_t)v;
+        return n;
+    }
+    static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+    void rotateIfFull();
+
+public:
+    uint32_t points;
+    uint32_t pageWrites;
+
+    TrackLog() : pageLen(0), mounted(false), haveLast(false), lastLat(0), lastLon(0), lastSec(0),
+                 lastLogMs(0), sinceKey(0), newFile(true), sessionStart(0), readers(0), readLock(nullptr),
+                 points(0), pageWrites(0) {}
+
+    // Mount LittleFS (formatting it on first use)
+    bool begin();
+
+    // Log the snapshot's position if it is due and has moved
+    void record(const NavSnapshot& nav, uint32_t nowMs);
+
+    // Append the RAM page to the file
+    void flush();
+
+    bool isMounted() const { return mounted; }
+
+    // Bytes committed to flash, old file first, as a reader would see them
+    uint32_t committedBytes() const;
+
+    // Where this power-on's points start in those bytes (always a keyframe)
+    uint32_t getSessionStart() const { return sessionStart; }
+
+    // Held by readers of the log files so they are not rotated underneath them
+    void beginRead() { LockGuard guard(readLock); readers++; }
+    void endRead() { LockGuard guard(readLock); readers--; }
+};
+
+// One point read back from the log
+struct TrackFix {
+    uint32_t sec;                       // Uptime seconds when it was logged
+    int32_t latE6, lonE6;
+    bool keyframe;
+};
+
+// Reads the log format above a byte at a time. Deltas before the first
+// keyframe, or after a record too long to be valid, are dropped until the
+// next keyframe.
+class TrackDecoder {
+private:
+    uint8_t rec[TRACK_MAX_DELTA];
+    uint8_t len;
+    uint8_t varints;                    // Complete varints in the delta record so far
+    bool haveBase;
+    TrackFix last;
+
+    static uint32_t getVarint(const uint8_t*& p) {
+        uint32_t v = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7) {
+            uint8_t b = *p++;
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    }
+    static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+public:
+    TrackDecoder() { reset(); }
+
+    void reset() {
+        len = 0;
+        varints = 0;
+        haveBase = false;
+        memset(&last, 0, sizeof(last));
+    }
+
+    // Feed one byte; true when it completes a point
+    bool push(uint8_t b, TrackFix& out);
+};
+
+inline bool TrackDecoder::push(uint8_t b, TrackFix& out) {
+    rec[len++] = b;
+
+    // 1) Keyframe: 0x00 and twelve bytes (a delta never starts with 0x00)
+    if (rec[0] == 0x00) {
+        if (len < TRACK_KEY_BYTES) return false;
+        uint32_t sec = 0, lat = 0, lon = 0;
+        for (int i = 0; i < 4; i++) {
+            sec |= (uint32_t)rec[1 + i] << (8 * i);
+            lat |= (uint32_t)rec[5 + i] << (8 * i);
+            lon |= (uint32_t)rec[9 + i] << (8 * i);
+        }
+        len = 0;
+        last.sec = sec;
+        last.latE6 = (int32_t)lat;
+        last.lonE6 = (int32_t)lon;
+        last.keyframe = true;
+        haveBase = true;
+        out = last;
+        return true;
+    }
+
+    // 2) Delta: three varints
+    if (!(b & 0x80)) varints++;
+    if (varints < 3) {
+        if (len == TRACK_MAX_DELTA) {
+            len = 0;                    // Not a record: resynchronise on a keyframe
+            varints = 0;
+            haveBase = false;
+        }
+        return false;
+    }
+    const uint8_t* p = rec;
+    uint32_t dSec = getVarint(p);
+    int32_t dLat = unzigzag(getVarint(p));
+    int32_t dLon = unzigzag(getVarint(p));
+    len = 0;
+    varints = 0;
+    if (!haveBase) return false;
+    last.sec += dSec;
+    last.latE6 += dLat;
+    last.lonE6 += dLon;
+    last.keyframe = false;
+    out = last;
+    return true;
+}
+
+inline bool TrackLog::begin() {
+    readLock = xSemaphoreCreateMutex();
+    mounted = LittleFS.begin(true);
+    if (!mounted) {
+        Serial.println("→ LittleFS mount failed, track log disabled");
+        return false;
+    }
+    sessionStart = committedBytes();
+    Serial.printf("→ Track log %s (%lu bytes)\n", TRACK_LOG_PATH, (unsigned long)sessionStart);
+    return true;
+}
+
+inline void TrackLog::record(const NavSnapshot& nav, uint32_t nowMs) {
+    if (!mounted || !nav.hasPosition || !nav.haveFix) {
+        return;
+    }
+    if (haveLast && nowMs - lastLogMs < TRACK_LOG_INTERVAL_MS) {
+        return;
+    }
+
+    int32_t lat = (int32_t)lround(nav.lat * 1e6);
+    int32_t lon = (int32_t)lround(nav.lon * 1e6);
+    int32_t dLat = lat - lastLat;
+    int32_t dLon = lon - lastLon;
+    if (haveLast && abs(dLat) < TRACK_MIN_STEP_E6 && abs(dLon) < TRACK_MIN_STEP_E6) {
+        return;  // Standing still
+    }
+    uint32_t sec = nav.fixMillis / 1000;
+
+    // 1) Room for the worst-case record
+    if (pageLen + TRACK_MAX_RECORD > TRACK_PAGE_BYTES) {
+        flush();
+    }
+
+    // 2) Keyframe or delta
+    if (newFile || !haveLast || sinceKey >= TRACK_KEY_EVERY || sec <= lastSec) {
+        uint8_t* p = page + pageLen;
+        p[0] = 0x00;
+        for (int i = 0; i < 4; i++) {
+            p[1 + i] = (uint8_t)(sec >> (8 * i));
+            p[5 + i] = (uint8_t)((uint32_t)lat >> (8 * i));
+            p[9 + i] = (uint8_t)((uint32_t)lon >> (8 * i));
+        }
+        pageLen += TRACK_KEY_BYTES;
+        sinceKey = 0;
+        newFile = false;
+    } else {
+        pageLen += putVarint(page + pageLen, sec - lastSec);
+        pageLen += putVarint(page + pageLen, zigzag(dLat));
+        pageLen += putVarint(page + pageLen, zigzag(dLon));
+        sinceKey++;
+    }
+
+    lastLat = lat;
+    lastLon = lon;
+    lastSec = sec;
+    lastLogMs = nowMs;
+    haveLast = true;
+    points++;
+}
+
+inline void TrackLog::flush() {
+    if (!mounted || pageLen == 0) {
+        return;
+    }
+    File f = LittleFS.open(TRACK_LOG_PATH, FILE_APPEND);
+    if (!f) {
+        Serial.println("→ Track log append failed");
+        return;
+    }
+    f.write(page, pageLen);
+    f.close();
+    pageLen = 0;
+    pageWrites++;
+    rotateIfFull();
+}
+
+inline void TrackLog::rotateIfFull() {
+    // Held until the rename is done, so no reader starts in between
+    LockGuard guard(readLock);
+    if (readers > 0) {
+        return;  // Try again after the download
+    }
+    File f = LittleFS.open(TRACK_LOG_PATH, FILE_READ);
+    uint32_t size = f ? f.size() : 0;
+    f.close();
+    if (size < TRACK_LOG_MAX_BYTES) {
+        return;
+    }
+    File old = LittleFS.open(TRACK_OLD_PATH, FILE_READ);
+    uint32_t oldSize = old ? old.size() : 0;
+    old.close();
+    sessionStart = sessionStart > oldSize ? sessionStart - oldSize : 0;  // 0: its start rotated out
+    LittleFS.remove(TRACK_OLD_PATH);
+    LittleFS.rename(TRACK_LOG_PATH, TRACK_OLD_PATH);
+    newFile = true;
+    Serial.printf("→ Track log rotated (%lu bytes)\n", (unsigned long)size);
+}
+
+inline uint32_t TrackLog::committedBytes() const {
+    uint32_t total = 0;
+    const char* paths[] = { TRACK_OLD_PATH, TRACK_LOG_PATH };
+    for (int i = 0; i < 2; i++) {
+        if (!LittleFS.exists(paths[i])) continue;
+        File f = LittleFS.open(paths[i], FILE_READ);
+        if (f) total += f.size();
+        f.close();
+    }
+    return total;
+}
+
+#endif // TRACKLOG_H
@@ -0,0 +1,245 @@
+#ifndef TRAILSTORE_H
+#define TRAILSTORE_H
+
+#include <Arduino.h>
+
+// A track simplified as it arrives, in bounded memory.
+// Points are kept as at most MAX_POINTS vertices in local metres (east /
+// north of the first point). The raw points after the last vertex wait in
+// a small window, and the newest one only becomes a vertex once the
+// straight line from the last vertex to the next point would pass further
+// than the tolerance from one of them (the opening-window form of
+// Douglas-Peucker). When the vertices run out the tolerance doubles and
+// Douglas-Peucker re-simplifies them, so a day-long track costs no more
+// than a short one.
+// The track screen keeps one with the tolerance tied to a pixel of its
+// whole-trail view (fitW x fitH); TracBack builds one from the flash log at
+// a fixed tolerance (fitW = 0).
+
+#define TRAIL_WINDOW       24      // Raw points between vertices
+#define TRAIL_M_PER_E6     0.11119493f   // Metres per 1e-6 degree of latitude
+
+struct TrailPoint {
+    int32_t x, y;                  // Metres east / north of the origin
+};
+
+template <uint16_t MAX_POINTS>
+class TrailStoreN {
+private:
+    TrailPoint pts[MAX_POINTS];
+    uint16_t n;
+    TrailPoint window[TRAIL_WINDOW];   // Raw points after pts[n - 1]; the last is the head
+    uint8_t wn;
+    int32_t minTol;
+    int32_t tol;                       // Simplification tolerance, metres
+    uint16_t fitW, fitH;               // View the tolerance follows, pixels (0 = fixed)
+    int32_t minX, minY, maxX, maxY;    // Extent of vertices and window
+    int32_t lat0E6, lon0E6;
+    float mPerLonE6;
+    uint32_t gen;
+    uint16_t stack[MAX_POINTS][2];     // Douglas-Peucker spans still to split
+    uint8_t keep[(MAX_POINTS + 7) / 8];
+
+    static int64_t dist2(const TrailPoint& a, const TrailPoint& b) {
+        int64_t dx = (int64_t)a.x - b.x, dy = (int64_t)a.y - b.y;
+        return dx * dx + dy * dy;
+    }
+
+    void grow(const TrailPoint& p);
+    void push(const TrailPoint& p);
+    void compact();
+
+public:
+    TrailStoreN(int32_t minTolM, uint16_t fitWidth = 0, uint16_t fitHeight = 0)
+        : minTol(minTolM), fitW(fitWidth), fitH(fitHeight), gen(0) {
+        reset();
+    }
+
+    void reset();
+
+    // Append a fix; true if the track changed
+    bool add(double lat, double lon);
+
+    // Metres east/north of the origin and back; false before the first point
+    bool toLocal(double lat, double lon, TrailPoint& out) const;
+    void toLatLonE7(const TrailPoint& p, int32_t& latE7, int32_t& lonE7) const;
+
+    // Squared distance from p to segment a-b, square metres
+    static int64_t segDist2(const TrailPoint& p, const TrailPoint& a, const TrailPoint& b);
+
+    bool isEmpty() const { return n == 0; }
+    uint16_t count() const { return n; }
+    const TrailPoint& vertex(uint16_t i) const { return pts[i]; }
+    const TrailPoint& head() const { return wn ? window[wn - 1] : pts[n - 1]; }
+    bool hasHead() const { return wn > 0; }
+
+    // The whole polyline: the vertices, then the head if it is not one
+    uint16_t size() const { return n + (wn ? 1 : 0); }
+    const TrailPoint& at(uint16_t i) const { return i < n ? pts[i] : head(); }
+
+    int32_t tolerance() const { return tol; }
+    uint32_t generation() const { return gen; }
+
+    void extent(int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1) const {
+        x0 = minX; y0 = minY; x1 = maxX; y1 = maxY;
+    }
+};
+
+template <uint16_t MAX_POINTS>
+inline void TrailStoreN<MAX_POINTS>::reset() {
+    n = 0;
+    wn = 0;
+    tol = minTol;
+    minX = minY = maxX = maxY = 0;
+    lat0E6 = lon0E6 = 0;
+    mPerLonE6 = TRAIL_M_PER_E6;
+    gen++;
+}
+
+template <uint16_t MAX_POINTS>
+inline bool TrailStoreN<MAX_POINTS>::toLocal(double lat, double lon, TrailPoint& out) const {
+    if (n == 0) return false;
+    int32_t dLat = (int32_t)lround(lat * 1e6) - lat0E6;
+    int32_t dLon = (int32_t)lround(lon * 1e6) - lon0E6;
+    if (dLon > 180000000) dLon -= 360000000;
+    if (dLon < -180000000) dLon += 360000000;
+    // Double, not float: half the world away is 2e7 m, past float's whole metres
+    out.x = (int32_t)lround((double)dLon * mPerLonE6);
+    out.y = (int32_t)lround((double)dLat * TRAIL_M_PER_E6);
+    return true;
+}
+
+template <uint16_t MAX_POINTS>
+inline void TrailStoreN<MAX_POINTS>::toLatLonE7(const TrailPoint& p, int32_t& latE7, int32_t& lonE7) const {
+    int64_t lat = (int64_t)lat0E6 * 10 + (int64_t)lround(p.y * 10.0 / TRAIL_M_PER_E6);
+    int64_t lon = (int64_t)lon0E6 * 10 + (mPerLonE6 > 0.0f ? (int64_t)lround(p.x * 10.0 / mPerLonE6) : 0);
+    if (lon > 1800000000LL) lon -= 3600000000LL;
+    if (lon < -1800000000LL) lon += 3600000000LL;
+    latE7 = (int32_t)lat;
+    lonE7 = (int32_t)lon;
+}
+
+template <uint16_t MAX_POINTS>
+inline int64_t TrailStoreN<MAX_POINTS>::segDist2(const TrailPoint& p, const TrailPoint& a, const TrailPoint& b) {
+    int64_t abx = (int64_t)b.x - a.x, aby = (int64_t)b.y - a.y;
+    int64_t apx = (int64_t)p.x - a.x, apy = (int64_t)p.y - a.y;
+    int64_t len2 = abx * abx + aby * aby;
+    if (len2 == 0) return apx * apx + apy * apy;
+    int64_t t = apx * abx + apy * aby;
+    if (t <= 0) return apx * apx + apy * apy;
+    if (t >= len2) return dist2(p, b);
+    // Perpendicular distance: cross² / len², in float to stay clear of overflow
+    float cross = (float)(apx * aby - apy * abx);
+    return (int64_t)(cross * cross / (float)len2);
+}
+
+template <uint16_t MAX_POINTS>
+inline void TrailStoreN<MAX_POINTS>::grow(const TrailPoint& p) {
+    if (p.x < minX) minX = p.x;
+    if (p.x > maxX) maxX = p.x;
+    if (p.y < minY) minY = p.y;
+    if (p.y > maxY) maxY = p.y;
+
+    // One pixel of the whole-trail view
+    if (fitW && fitH) {
+        int32_t span = max((maxX - minX) / fitW, (maxY - minY) / fitH);
+        if (span > tol) tol = span;
+    }
+}
+
+template <uint16_t MAX_POINTS>
+inline void TrailStoreN<MAX_POINTS>::push(const TrailPoint& p) {
+    if (n == MAX_POINTS) {
+        compact();
+    }
+    pts[n++] = p;
+}
+
+template <uint16_t MAX_POINTS>
+inline void TrailStoreN<MAX_POINTS>::compact() {
+    // Double the tolerance until Douglas-Peucker frees a quarter of the vertices
+    while (n > MAX_POINTS * 3 / 4) {
+        tol *= 2;
+        int64_t tol2 = (int64_t)tol * tol;
+
+        // 1) Mark the endpoints, then split spans at their farthest vertex
+        memset(keep, 0, sizeof(keep));
+        keep[0] |= 1;
+        keep[(n - 1) >> 3] |= 1 << ((n - 1) & 7);
+        int sp = 0;
+        stack[sp][0] = 0;
+        stack[sp][1] = n - 1;
+        sp++;
+        while (sp > 0) {
+            sp--;
+            uint16_t a = stack[sp][0], b = stack[sp][1];
+            int64_t worst = -1;
+            uint16_t at = a;
+            for (uint16_t i = a + 1; i < b; i++) {
+                int64_t d = segDist2(pts[i], pts[a], pts[b]);
+                if (d > worst) {
+                    worst = d;
+                    at = i;
+                }
+            }
+            if (worst > tol2) {
+                keep[at >> 3] |= 1 << (at & 7);
+                if (at - a > 1) {
+                    stack[sp][0] = a;
+                    stack[sp][1] = at;
+                    sp++;
+                }
+                if (b - at > 1) {
+                    stack[sp][0] = at;
+                    stack[sp][1] = b;
+                    sp++;
+                }
+            }
+        }
+
+        // 2) Squeeze out the rest
+        uint16_t kept = 0;
+        for (uint16_t i = 0; i < n; i++) {
+            if (keep[i >> 3] & (1 << (i & 7))) pts[kept++] = pts[i];
+        }
+        n = kept;
+    }
+    gen++;
+}
+
+template <uint16_t MAX_POINTS>
+inline bool TrailStoreN<MAX_POINTS>::add(double lat, double lon) {
+    TrailPoint p;
+    if (n == 0) {
+        lat0E6 = (int32_t)lround(lat * 1e6);
+        lon0E6 = (int32_t)lround(lon * 1e6);
+        mPerLonE6 = TRAIL_M_PER_E6 * cosf((float)(lat * PI / 180.0));
+        p.x = p.y = 0;
+        pts[n++] = p;
+        gen++;
+        return true;
+    }
+    toLocal(lat, lon, p);
+
+    // 1) Ignore steps under the tolerance (standing still, noise)
+    int64_t tol2 = (int64_t)tol * tol;
+    if (dist2(p, head()) < tol2) {
+        return false;
+    }
+
+    // 2) Does the line from the last vertex to p still pass near every raw point since?
+    bool fits = wn < TRAIL_WINDOW;
+    for (uint8_t i = 0; i < wn && fits; i++) {
+        fits = segDist2(window[i], pts[n - 1], p) <= tol2;
+    }
+    if (!fits) {
+        push(window[wn - 1]);              // The previous head becomes a vertex
+        wn = 0;
+    }
+    window[wn++] = p;
+    grow(p);
+    gen++;
+    return true;
+}
+
+#endif // TRAILSTORE_H
@@ -0,0 +1,271 @@
+#ifndef TRAILVIEW_H
+#define TRAILVIEW_H
+
+#include <Arduino.h>
+#include <HT_st7735.h>
+#include "trailstore.h"
+
+// Breadcrumb trail for the track screen.
+// TrailStore keeps the trail since power-on (see trailstore.h) with the
+// tolerance at one pixel of the whole-trail view, so nothing is kept that
+// the screen could not show, and at most TRAIL_MAX_POINTS vertices, so the
+// redraw costs the same however long the walk.
+// TrailRenderer projects the vertices, culls and clips them to the map,
+// draws them into a 4-bit framebuffer and pushes the changed bands of it
+// with one address window each.
+
+#define TRAIL_MAX_POINTS   128
+#define TRAIL_MIN_TOL_M    3       // Below this GNSS noise would draw the trail
+#define TRAIL_MIN_SPAN_M   100     // Narrowest whole-trail view, metres across
+#define TRAIL_MAP_W        160
+#define TRAIL_MAP_H        64      // Map rows; the text row sits below
+#define TRAIL_MARGIN_PX    4
+#define TRAIL_BAND_ROWS    16
+#define TRAIL_BANDS        (TRAIL_MAP_H / TRAIL_BAND_ROWS)
+
+class TrailStore : public TrailStoreN<TRAIL_MAX_POINTS> {
+public:
+    TrailStore()
+        : TrailStoreN<TRAIL_MAX_POINTS>(TRAIL_MIN_TOL_M, TRAIL_MAP_W - 2 * TRAIL_MARGIN_PX,
+                                        TRAIL_MAP_H - 2 * TRAIL_MARGIN_PX) {}
+};
+
+// Something other than the trail to mark on the map
+struct TrailMark {
+    TrailPoint at;
+    char label;                        // Drawn beside the marker, 0 for none
+    uint8_t color;                     // TRAIL_COLOR_*
+};
+
+enum TrailColor {
+    TRAIL_COLOR_BG = 0,
+    TRAIL_COLOR_TRAIL,
+    TRAIL_COLOR_HOME,
+    TRAIL_COLOR_WAYPOINT,
+    TRAIL_COLOR_ROUTE,
+    TRAIL_COLOR_HERE,
+    TRAIL_COLOR_COUNT
+};
+
+class TrailRenderer {
+private:
+    uint8_t fb[TRAIL_MAP_W * TRAIL_MAP_H / 2];     // 4 bits per pixel, two pixels per byte
+    uint16_t band[TRAIL_MAP_W * TRAIL_BAND_ROWS];  // RGB565 in bus byte order; SPI reads clobber it
+    uint32_t bandHash[TRAIL_BANDS];
+    bool valid;
+    int32_t cx, cy;                    // View centre, local metres
+    uint32_t scaleQ16;                 // Pixels per metre, 16.16
+
+    enum { OUT_LEFT = 1, OUT_RIGHT = 2, OUT_TOP = 4, OUT_BOTTOM = 8 };
+
+    static uint8_t outcode(int32_t x, int32_t y) {
+        uint8_t c = 0;
+        if (x < 0) c |= OUT_LEFT;
+        else if (x >= TRAIL_MAP_W) c |= OUT_RIGHT;
+        if (y < 0) c |= OUT_TOP;
+        else if (y >= TRAIL_MAP_H) c |= OUT_BOTTOM;
+        return c;
+    }
+
+    void pixel(int32_t x, int32_t y, uint8_t color) {
+        if ((uint32_t)x >= TRAIL_MAP_W || (uint32_t)y >= TRAIL_MAP_H) return;
+        uint8_t& b = fb[(y * TRAIL_MAP_W + x) >> 1];
+        b = (x & 1) ? (uint8_t)((b & 0x0F) | (color << 4)) : (uint8_t)((b & 0xF0) | color);
+    }
+
+    void project(const TrailPoint& p, int32_t& px, int32_t& py) const {
+        px = TRAIL_MAP_W / 2 + (int32_t)(((int64_t)p.x - cx) * scaleQ16 >> 16);
+        py = TRAIL_MAP_H / 2 - (int32_t)(((int64_t)p.y - cy) * scaleQ16 >> 16);
+    }
+
+    bool clip(int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1) const;
+    void line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t color);
+    void mark(const TrailMark& m);
+
+public:
+    TrailRenderer() : valid(false), cx(0), cy(0), scaleQ16(1 << 16) {}
+
+    // Forget what is on the panel (the screen was cleared or changed)
+    void invalidate() { valid = false; }
+
+    // Fit the trail and the first fitCount marks with a margin (zoom 1), or
+    // zoom in on 'centre'; marks past fitCount are drawn only if in view
+    void setView(const TrailStore& trail, const TrailMark* marks, uint8_t fitCount, const TrailPoint& centre,
+                 uint8_t zoom);
+
+    // Metres across the map at the current view
+    uint32_t viewWidth() const { return (uint32_t)(((uint64_t)TRAIL_MAP_W << 16) / scaleQ16); }
+
+    // Draw trail and marks into the framebuffer, then send the bands that changed
+    void render(const TrailStore& trail, const TrailMark* marks, uint8_t markCount);
+    uint8_t flush(HT_st7735& lcd, uint16_t y0);
+};
+
+inline void TrailRenderer::setView(const TrailStore& trail, const TrailMark* marks, uint8_t fitCount,
+                                   const TrailPoint& centre, uint8_t zoom) {
+    int32_t x0, y0, x1, y1;
+    trail.extent(x0, y0, x1, y1);
+    for (uint8_t i = 0; i < fitCount; i++) {
+        x0 = min(x0, marks[i].at.x);
+        x1 = max(x1, marks[i].at.x);
+        y0 = min(y0, marks[i].at.y);
+        y1 = max(y1, marks[i].at.y);
+    }
+
+    float mpp = max((float)(x1 - x0) / (TRAIL_MAP_W - 2 * TRAIL_MARGIN_PX),
+                    (float)(y1 - y0) / (TRAIL_MAP_H - 2 * TRAIL_MARGIN_PX));
+    mpp = max(mpp, (float)TRAIL_MIN_SPAN_M / TRAIL_MAP_W);
+    if (zoom > 1) {
+        mpp /= zoom;
+        cx = centre.x;
+        cy = centre.y;
+    } else {
+        cx = (int32_t)(((int64_t)x0 + x1) / 2);
+        cy = (int32_t)(((int64_t)y0 + y1) / 2);
+    }
+    scaleQ16 = max((uint32_t)1, (uint32_t)(65536.0f / mpp));
+}
+
+inline bool TrailRenderer::clip(int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1) const {
+    // Cohen-Sutherland against the map rectangle
+    uint8_t c0 = outcode(x0, y0), c1 = outcode(x1, y1);
+    while (true) {
+        if (!(c0 | c1)) return true;
+        if (c0 & c1) return false;         // Wholly on one side: culled
+        uint8_t c = c0 ? c0 : c1;
+        int64_t dx = (int64_t)x1 - x0, dy = (int64_t)y1 - y0;
+        int32_t x, y;
+        if (c & OUT_TOP) {
+            y = 0;
+            x = x0 + (int32_t)(dx * (y - y0) / dy);
+        } else if (c & OUT_BOTTOM) {
+            y = TRAIL_MAP_H - 1;
+            x = x0 + (int32_t)(dx * (y - y0) / dy);
+        } else if (c & OUT_LEFT) {
+            x = 0;
+            y = y0 + (int32_t)(dy * (x - x0) / dx);
+        } else {
+            x = TRAIL_MAP_W - 1;
+            y = y0 + (int32_t)(dy * (x - x0) / dx);
+        }
+        if (c == c0) {
+            x0 = x;
+            y0 = y;
+            c0 = outcode(x0, y0);
+        } else {
+            x1 = x;
+            y1 = y;
+            c1 = outcode(x1, y1);
+        }
+    }
+}
+
+inline void TrailRenderer::line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t color) {
+    if (!clip(x0, y0, x1, y1)) return;
+    // Bresenham
+    int32_t dx = abs(x1 - x0), dy = -abs(y1 - y0);
+    int32_t sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int32_t err = dx + dy;
+    while (true) {
+        pixel(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        int32_t e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+inline void TrailRenderer::mark(const TrailMark& m) {
+    int32_t x, y;
+    project(m.at, x, y);
+    if (outcode(x - 2, y - 2) & outcode(x + 2, y + 2)) return;
+
+    if (m.color == TRAIL_COLOR_HERE) {
+        // Filled square
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) pixel(x + dx, y + dy, m.color);
+        }
+    } else {
+        // Hollow square
+        for (int d = -2; d <= 2; d++) {
+            pixel(x + d, y - 2, m.color);
+            pixel(x + d, y + 2, m.color);
+            pixel(x - 2, y + d, m.color);
+            pixel(x + 2, y + d, m.color);
+        }
+    }
+    if (m.label) {
+        // Font_7x10 glyph to the upper right, flipped left when it would run off the map
+        int32_t lx = x + 4 + Font_7x10.width <= TRAIL_MAP_W ? x + 4 : x - 4 - Font_7x10.width;
+        int32_t ly = y - (int32_t)Font_7x10.height + 2;
+        const uint16_t* glyph = Font_7x10.data + (m.label - 32) * Font_7x10.height;
+        for (int32_t r = 0; r < Font_7x10.height; r++) {
+            for (int32_t c = 0; c < Font_7x10.width; c++) {
+                if ((glyph[r] << c) & 0x8000) pixel(lx + c, ly + r, m.color);
+            }
+        }
+    }
+}
+
+inline void TrailRenderer::render(const TrailStore& trail, const TrailMark* marks, uint8_t markCount) {
+    memset(fb, 0, sizeof(fb));
+
+    // 1) Trail: vertices, then on to the newest raw point; steps within a pixel are skipped
+    if (!trail.isEmpty()) {
+        int32_t px, py;
+        project(trail.at(0), px, py);
+        pixel(px, py, TRAIL_COLOR_TRAIL);
+        uint16_t last = trail.size() - 1;
+        for (uint16_t i = 1; i <= last; i++) {
+            int32_t x, y;
+            project(trail.at(i), x, y);
+            if (abs(x - px) <= 1 && abs(y - py) <= 1 && i < last) continue;
+            line(px, py, x, y, TRAIL_COLOR_TRAIL);
+            px = x;
+            py = y;
+        }
+    }
+
+    // 2) Marks on top, earlier ones over later ones
+    for (uint8_t i = markCount; i > 0; i--) {
+        mark(marks[i - 1]);
+    }
+}
+
+inline uint8_t TrailRenderer::flush(HT_st7735& lcd, uint16_t y0) {
+    static const uint16_t palette[TRAIL_COLOR_COUNT] = {
+        ST7735_BLACK, ST7735_CYAN, ST7735_GREEN, ST7735_YELLOW, ST7735_MAGENTA, ST7735_WHITE,
+    };
+    const uint32_t bandBytes = TRAIL_MAP_W * TRAIL_BAND_ROWS / 2;
+    uint8_t sent = 0;
+
+    for (uint8_t b = 0; b < TRAIL_BANDS; b++) {
+        // 1) Skip bands whose pixels are the same as last time (FNV-1a of the band)
+        const uint8_t* src = fb + b * bandBytes;
+        uint32_t h = 2166136261UL;
+        for (uint32_t i = 0; i < bandBytes; i++) {
+            h = (h ^ src[i]) * 16777619UL;
+        }
+        if (valid && h == bandHash[b]) continue;
+        bandHash[b] = h;
+
+        // 2) Expand to RGB565, high byte first as the panel wants it, and send in one window
+        for (uint32_t i = 0; i < bandBytes; i++) {
+            uint16_t lo = palette[src[i] & 0x0F], hi = palette[src[i] >> 4];
+            band[2 * i] = (uint16_t)((lo >> 8) | (lo << 8));
+            band[2 * i + 1] = (uint16_t)((hi >> 8) | (hi << 8));
+        }
+        lcd.st7735_draw_image(0, y0 + b * TRAIL_BAND_ROWS, TRAIL_MAP_W, TRAIL_BAND_ROWS, band);
+        sent++;
+    }
+    valid = true;
+    return sent;
+}
+
+#endif // TRAILVIEW_H
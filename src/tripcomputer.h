@@ -0,0 +1,188 @@
+#ifndef TRIPCOMPUTER_H
+#define TRIPCOMPUTER_H
+
+#include <Arduino.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+#include "navsnapshot.h"
+
+// Trip computer: distance, moving and stopped time, maximum and average
+// speed, ascent and descent. Each is a running total that one fix updates
+// in constant time, so the screen only formats numbers.
+// Distance is measured from an anchor. A fix only counts, and becomes the
+// new anchor, once it is further from it than GNSS jitter at the fix's HDOP
+// could explain, so standing still adds nothing however long, while slow
+// walking still adds up. The time since the last such step is moving time
+// once a step ends it, stopped time once the stop timeout passes without
+// one. That timeout is how long a walk at TRIP_CREEP_MPS takes to cover the
+// jitter threshold, and at least TRIP_STOP_MS, so a poor fix that needs a
+// longer step also waits longer before it calls a slow walk a stop.
+// Top speed is the distance counted between two steps at least
+// TRIP_SPEED_WINDOW_MS apart, not the momentary speed, which wanders by
+// several km/h at rest.
+// Ascent and descent use a dead band: altitude only counts once it is
+// TRIP_CLIMB_M above or below the last level counted.
+// A gap of more than TRIP_MAX_GAP_MS between fixes (signal lost, light
+// sleep) counts as neither time nor distance; the next fix starts afresh
+// from where it is.
+// save() keeps the totals in RTC memory over deep sleep and restore() takes
+// them back, once, on the boot that wakes from it. Any other reset (power-on,
+// reset button, watchdog, panic) starts from zero even though RTC memory
+// may still hold a valid copy.
+
+#define TRIP_JITTER_M        15.0f     // Per unit of HDOP: about 3.5 sigma of the wander
+#define TRIP_JITTER_MIN_M    5.0f
+#define TRIP_STOP_MS         30000UL   // No step for this long, at least: stopped
+#define TRIP_CREEP_MPS       0.5f      // Slowest walk that still counts as moving
+#define TRIP_SPEED_WINDOW_MS 10000UL
+#define TRIP_MAX_GAP_MS      10000UL
+#define TRIP_CLIMB_M         10.0f     // GNSS altitude wanders about twice as far as position
+#define TRIP_MAGIC           0x54524950UL  // "TRIP"
+
+struct TripTotals {
+    double distanceM;                  // First, so nothing the CRC covers is padding
+    uint32_t magic;
+    uint32_t movingMs;
+    uint32_t stoppedMs;
+    float maxKmh;
+    float ascentM;
+    float descentM;
+    uint32_t crc;                      // Over the fields above
+};
+
+RTC_DATA_ATTR static TripTotals tripRtc;
+
+class TripComputer {
+private:
+    TripTotals t;
+    bool haveFix;
+    uint32_t lastFixMs;
+    uint32_t pendingMs;                // Since the anchor last moved, not yet booked
+    double anchorLat, anchorLon;
+    uint32_t speedMs;                  // Start of the top speed window
+    double speedDistM;                 // Distance at its start
+    bool haveAlt;
+    float altRef;                      // Last altitude counted
+
+    // Metres between two nearby positions (flat, across the antimeridian too)
+    static double distance(double lat1, double lon1, double lat2, double lon2) {
+        double dLon = lon2 - lon1;
+        if (dLon > 180.0) dLon -= 360.0;
+        if (dLon < -180.0) dLon += 360.0;
+        double dx = dLon * cos(lat2 * PI / 180.0), dy = lat2 - lat1;
+        return sqrt(dx * dx + dy * dy) * 111194.93;
+    }
+
+    static uint32_t crcOf(const TripTotals& totals) {
+        return esp_rom_crc32_le(0, (const uint8_t*)&totals, offsetof(TripTotals, crc));
+    }
+
+public:
+    uint32_t fixes;                    // update() calls that took a fix
+
+    TripComputer() : haveFix(false), lastFixMs(0), pendingMs(0), anchorLat(0), anchorLon(0), speedMs(0),
+                     speedDistM(0), haveAlt(false), altRef(0), fixes(0) {
+        reset();
+    }
+
+    void reset() {
+        memset(&t, 0, sizeof(t));
+        t.magic = TRIP_MAGIC;
+        haveFix = false;
+        haveAlt = false;
+    }
+
+    // Take a snapshot's fix; false if it has none or it was seen already
+    bool update(const NavSnapshot& snap);
+
+    // Totals to RTC memory (before deep sleep) and back (after it)
+    void save() const;
+    bool restore();
+
+    double distanceM() const { return t.distanceM; }
+    uint32_t movingMs() const { return t.movingMs; }
+    uint32_t stoppedMs() const { return t.stoppedMs; }
+    float maxKmh() const { return t.maxKmh; }
+    float avgKmh() const { return t.movingMs ? (float)(t.distanceM * 3600.0 / t.movingMs) : 0.0f; }
+    float ascentM() const { return t.ascentM; }
+    float descentM() const { return t.descentM; }
+};
+
+inline bool TripComputer::update(const NavSnapshot& snap) {
+    if (!snap.hasPosition || !snap.haveFix || (haveFix && snap.fixMillis == lastFixMs)) {
+        return false;
+    }
+    uint32_t dt = snap.fixMillis - lastFixMs;
+    bool fresh = !haveFix || dt > TRIP_MAX_GAP_MS;
+    haveFix = true;
+    lastFixMs = snap.fixMillis;
+    fixes++;
+
+    if (fresh) {
+        anchorLat = snap.lat;
+        anchorLon = snap.lon;
+        speedMs = snap.fixMillis;
+        speedDistM = t.distanceM;
+        pendingMs = 0;
+        haveAlt = false;
+    } else {
+        // 1) Distance from the anchor once past the jitter; that step makes
+        //    the time since the last one moving time
+        pendingMs += dt;
+        double d = distance(anchorLat, anchorLon, snap.lat, snap.lon);
+        float jitterM = max(TRIP_JITTER_MIN_M, TRIP_JITTER_M * snap.hdop);
+        if (d > jitterM) {
+            t.distanceM += d;
+            t.movingMs += pendingMs;
+            pendingMs = 0;
+            anchorLat = snap.lat;
+            anchorLon = snap.lon;
+
+            // 2) Top speed: the steps over a whole window
+            uint32_t window = snap.fixMillis - speedMs;
+            if (window >= TRIP_SPEED_WINDOW_MS) {
+                float kmh = (float)((t.distanceM - speedDistM) * 3600.0 / window);
+                if (kmh > t.maxKmh) t.maxKmh = kmh;
+                speedMs = snap.fixMillis;
+                speedDistM = t.distanceM;
+            }
+        } else if (pendingMs > max((uint32_t)TRIP_STOP_MS, (uint32_t)(jitterM * 1000.0f / TRIP_CREEP_MPS))) {
+            t.stoppedMs += pendingMs;
+            pendingMs = 0;
+        }
+    }
+
+    // 3) Climb and descent past the dead band
+    if (snap.hasAltitude) {
+        if (!haveAlt) {
+            altRef = snap.altitudeM;
+            haveAlt = true;
+        } else if (snap.altitudeM > altRef + TRIP_CLIMB_M) {
+            t.ascentM += snap.altitudeM - altRef;
+            altRef = snap.altitudeM;
+        } else if (snap.altitudeM < altRef - TRIP_CLIMB_M) {
+            t.descentM += altRef - snap.altitudeM;
+            altRef = snap.altitudeM;
+        }
+    }
+    return true;
+}
+
+inline void TripComputer::save() const {
+    tripRtc = t;
+    tripRtc.crc = crcOf(tripRtc);
+}
+
+inline bool TripComputer::restore() {
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP || tripRtc.magic != TRIP_MAGIC ||
+        tripRtc.crc != crcOf(tripRtc)) {
+        return false;
+    }
+    t = tripRtc;
+    tripRtc.magic = 0;                 // Taken: a later reset must not bring it back
+    haveFix = false;
+    haveAlt = false;
+    return true;
+}
+
+#endif // TRIPCOMPUTER_H
@@ -0,0 +1,142 @@
+// Host-side decoder for the tracker's BLE position broadcast.
+//
+// Build:  g++ -std=c++11 -O2 -I../src -o advdecode advdecode.cpp
+//
+// Reads advertising data as hex, one advertisement per line, from stdin or
+// the files given, and prints each tracker position it finds as CSV:
+//   node,seq,lat,lon,speed_kmh,heading_deg,battery_pct,charging,fix,sats
+// Anything that is not a hex digit separates bytes loosely, so btmon dumps
+// ("Data: 1502ffff..."), nRF Connect raw data ("0x1502FFFF...") and plain
+// "15 02 ff ff ..." all work; a leading MAC address is skipped.
+//
+//   advdecode --selftest   round-trips a set of fixes through the same
+//                          encoder the firmware uses (exit status 1 on error)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include "beaconpacket.h"
+
+static int hexVal(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = (char)tolower((unsigned char)c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Longest run of hex digit pairs on the line (spaces allowed inside the run)
+static size_t parseHexLine(const char* line, uint8_t* out, size_t maxLen) {
+    size_t best = 0;
+    uint8_t run[256];
+    size_t n = 0;
+    int hi = -1;
+    for (const char* p = line; ; p++) {
+        int v = *p ? hexVal(*p) : -1;
+        if (v >= 0) {
+            if (hi < 0) {
+                hi = v;
+            } else {
+                if (n < sizeof(run)) run[n++] = (uint8_t)(hi << 4 | v);
+                hi = -1;
+            }
+            continue;
+        }
+        // "0x" prefixes and single spaces keep the run going
+        if (*p == 'x' && hi == 0) { hi = -1; continue; }
+        if (*p == ' ' && hi < 0 && p[1] && hexVal(p[1]) >= 0) continue;
+        if (n > best && n <= maxLen) {
+            memcpy(out, run, n);
+            best = n;
+        }
+        n = 0;
+        hi = -1;
+        if (!*p) break;
+    }
+    return best;
+}
+
+static void printFix(const BeaconFix& f) {
+    printf("%04X,%u,%.6f,%.6f,%.1f,%.1f,%u,%d,%u,%u\n", f.nodeId, f.seq, f.latE6 / 1e6, f.lonE6 / 1e6,
+           f.speedHalfKmh / 2.0, f.heading256 * 360.0 / 256.0, f.batteryPct, f.charging ? 1 : 0,
+           f.fixQuality, f.sats);
+}
+
+static int decodeStream(FILE* in) {
+    char line[1024];
+    uint8_t ad[256];
+    int found = 0;
+    while (fgets(line, sizeof(line), in)) {
+        size_t len = parseHexLine(line, ad, sizeof(ad));
+        BeaconFix fix;
+        if (len && beaconAdvDecode(ad, len, fix)) {
+            printFix(fix);
+            found++;
+        }
+    }
+    return found;
+}
+
+static int selfTest() {
+    static const int32_t coords[][2] = {
+        { 0, 0 }, { 90000000, 180000000 }, { -90000000, -180000000 },
+        { 37774929, -122419416 }, { -33868820, 151209290 }, { 1, -1 },
+    };
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(coords) / sizeof(coords[0]); i++) {
+        BeaconFix in;
+        memset(&in, 0, sizeof(in));
+        in.nodeId = (uint16_t)(0x1234 + i);
+        in.seq = (uint8_t)(i * 37);
+        in.latE6 = coords[i][0];
+        in.lonE6 = coords[i][1];
+        in.speedHalfKmh = (uint16_t)(i * 40);
+        in.heading256 = (uint8_t)(i * 51);
+        in.batteryPct = (uint8_t)(i * 20);
+        in.charging = i & 1;
+        in.fixQuality = (uint8_t)(i % 3);
+        in.sats = (uint8_t)(i * 3);
+        in.rateReq = 0x0F;
+
+        // A flags structure first, as a scanner would see a combined payload
+        uint8_t ad[3 + BEACON_ADV_LEN] = { 0x02, 0x01, 0x06 };
+        size_t len = 3 + beaconAdvEncode(in, ad + 3);
+
+        BeaconFix out;
+        if (!beaconAdvDecode(ad, len, out) || out.nodeId != in.nodeId || out.seq != in.seq ||
+            out.latE6 != in.latE6 || out.lonE6 != in.lonE6 || out.speedHalfKmh != in.speedHalfKmh ||
+            out.heading256 != in.heading256 || out.batteryPct != in.batteryPct ||
+            out.charging != in.charging || out.fixQuality != in.fixQuality || out.sats != in.sats) {
+            printf("FAIL case %u\n", (unsigned)i);
+            failures++;
+        }
+        // Truncating the frame must never decode
+        if (beaconAdvDecode(ad, len - 2, out)) {
+            printf("FAIL truncated case %u\n", (unsigned)i);
+            failures++;
+        }
+    }
+    printf("selftest: %s\n", failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--selftest") == 0) {
+        return selfTest();
+    }
+    int found = 0;
+    if (argc < 2) {
+        found = decodeStream(stdin);
+    }
+    for (int i = 1; i < argc; i++) {
+        FILE* f = fopen(argv[i], "r");
+        if (!f) {
+            perror(argv[i]);
+            return 2;
+        }
+        found += decodeStream(f);
+        fclose(f);
+    }
+    fprintf(stderr, "%d positions\n", found);
+    return 0;
+}
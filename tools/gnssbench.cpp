@@ -0,0 +1,200 @@
+// Host benchmark: the tracker's GnssParser against the bundled TinyGPSPlus.
+//
+// Build (from tools/):
+//   H="../.pio/libdeps/heltec_wifi_lora_32_V3/Heltec ESP32 Dev-Boards/src"
+//   g++ -std=gnu++11 -O2 -Ihost -I../src -I"$H" -o gnssbench gnssbench.cpp "$H/HT_TinyGPS++.cpp"
+//
+//   gnssbench STREAM... [--repeat N]
+//
+// STREAM is raw NMEA, e.g. from nmeagen. For each stream:
+//  1) Agreement: both parsers get the stream one character at a time. After
+//     every GGA and RMC that both accept, time, date, position, speed,
+//     course, altitude, satellites and HDOP must match exactly, and so must
+//     the checksum counters. Exit status 1 on any difference. TinyGPSPlus
+//     also checksums text that follows a line end without a new '$' (the
+//     tail of a line cut by an overrun); GnssParser ignores it, so those
+//     are counted separately and are not differences.
+//  2) Throughput: encode() over the whole stream, N times, for each parser
+//     bare and with CUSTOM_FIELDS custom fields registered (the GSV and GSA
+//     terms TinyGPSPlus can only reach that way). Reported as ns per
+//     character and per sentence; compare runs on the same machine.
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "HT_TinyGPS++.h"
+#include "gnssparser.h"
+
+#define BENCH_REPEAT    20
+
+// Sentence, term: in view per talker, then the GSA fix mode and DOPs
+static const struct { const char* sentence; int term; } CUSTOM_FIELDS[] = {
+    { "GPGSV", 3 }, { "GLGSV", 3 }, { "GAGSV", 3 }, { "GBGSV", 3 }, { "GQGSV", 3 },
+    { "GNGSA", 2 }, { "GNGSA", 15 }, { "GNGSA", 17 },
+};
+#define CUSTOM_COUNT    (sizeof(CUSTOM_FIELDS) / sizeof(CUSTOM_FIELDS[0]))
+
+static bool readFile(const char* path, std::string& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+// Talker-independent type of a sentence starting at s ("$GNGGA,..." -> "GGA")
+static bool sentenceIs(const std::string& s, size_t start, const char* type) {
+    return start + 6 <= s.size() && s.compare(start + 3, 3, type) == 0 &&
+           (s.compare(start + 1, 2, "GP") == 0 || s.compare(start + 1, 2, "GN") == 0);
+}
+
+static unsigned long compare(const std::string& stream) {
+    TinyGPSPlus ref;
+    GnssParser gps;
+    unsigned long diffs = 0, checked = 0, fragPassed = 0, fragFailed = 0;
+    size_t start = 0;
+    bool started = false;
+
+#define SAME(what, a, b)                                                                     \
+    do {                                                                                     \
+        if ((a) != (b)) {                                                                    \
+            if (diffs++ < 10) fprintf(stderr, "  differs at byte %lu: %s\n", (unsigned long)start, what); \
+        }                                                                                    \
+    } while (0)
+
+    for (size_t i = 0; i < stream.size(); i++) {
+        char c = stream[i];
+        if (c == '$') {
+            start = i;
+            started = true;
+        }
+        uint32_t refPassed = ref.passedChecksum(), refFailed = ref.failedChecksum();
+        bool r = ref.encode(c), g = gps.encode(c);
+        if (!started) {
+            fragPassed += ref.passedChecksum() - refPassed;
+            fragFailed += ref.failedChecksum() - refFailed;
+            r = false;
+        }
+        if (c == '\r' || c == '\n') started = false;
+        SAME("sentence accepted", r, g);
+        if (!r || !g) continue;
+
+        bool gga = sentenceIs(stream, start, "GGA"), rmc = sentenceIs(stream, start, "RMC");
+        if (!gga && !rmc) continue;
+        checked++;
+        SAME("time", ref.time.value(), gps.time.value());
+        SAME("location valid", ref.location.isValid(), gps.location.isValid());
+        if (ref.location.isUpdated() || gps.location.isUpdated()) {
+            SAME("location updated", ref.location.isUpdated(), gps.location.isUpdated());
+            const RawDegrees& rl = ref.location.rawLat();
+            const RawDegrees& rn = ref.location.rawLng();
+            const GnssRawDegrees& gl = gps.location.rawLat();
+            const GnssRawDegrees& gn = gps.location.rawLng();
+            SAME("latitude", rl.deg * 1000000000ULL + rl.billionths, gl.deg * 1000000000ULL + gl.billionths);
+            SAME("latitude sign", rl.negative, gl.negative);
+            SAME("longitude", rn.deg * 1000000000ULL + rn.billionths, gn.deg * 1000000000ULL + gn.billionths);
+            SAME("longitude sign", rn.negative, gn.negative);
+        }
+        if (gga) {
+            SAME("satellites", ref.satellites.value(), gps.satellites.value());
+            SAME("hdop", ref.hdop.value(), gps.hdop.value());
+            SAME("altitude", ref.altitude.value(), gps.altitude.value());
+        }
+        else {
+            SAME("date", ref.date.value(), gps.date.value());
+            SAME("speed", ref.speed.value(), gps.speed.value());
+            SAME("course", ref.course.value(), gps.course.value());
+        }
+    }
+    SAME("passed checksums", ref.passedChecksum() - fragPassed, gps.passedChecksum());
+    SAME("failed checksums", ref.failedChecksum() - fragFailed, gps.failedChecksum());
+    SAME("sentences with fix", ref.sentencesWithFix(), gps.sentencesWithFix());
+#undef SAME
+
+    printf("  agreement: %lu GGA/RMC compared, %lu checksums passed, %lu failed, %lu difference(s)\n", checked,
+           (unsigned long)gps.passedChecksum(), (unsigned long)gps.failedChecksum(), diffs);
+    if (fragPassed + fragFailed) {
+        printf("  line tails without '$' that TinyGPSPlus checksummed: %lu passed, %lu failed\n", fragPassed,
+               fragFailed);
+    }
+    return diffs;
+}
+
+template <class P>
+static double timeEncode(P& parser, const std::string& stream, int repeat) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    uint32_t accepted = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (size_t i = 0; i < stream.size(); i++) accepted += parser.encode(stream[i]);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (accepted == 0xFFFFFFFF) printf(" ");    // Keep the loop observable
+    return s;
+}
+
+static void report(const char* name, double s, double baseline, const std::string& stream, int repeat,
+                   unsigned long sentences) {
+    double chars = (double)stream.size() * repeat;
+    printf("  %-22s %7.2f ns/char %8.1f ns/sentence %8.1f MB/s  x%.2f\n", name, s * 1e9 / chars,
+           s * 1e9 / ((double)sentences * repeat), chars / s / 1e6, baseline / s);
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> paths;
+    int repeat = BENCH_REPEAT;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = std::max(1, atoi(argv[++i]));
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        fprintf(stderr, "usage: gnssbench STREAM... [--repeat N]\n");
+        return 2;
+    }
+
+    unsigned long diffs = 0;
+    for (size_t p = 0; p < paths.size(); p++) {
+        std::string stream;
+        if (!readFile(paths[p], stream)) return 1;
+        unsigned long sentences = 0;
+        for (size_t i = 0; i < stream.size(); i++) sentences += stream[i] == '$';
+        printf("%s: %lu bytes, %lu sentences\n", paths[p], (unsigned long)stream.size(), sentences);
+        if (!sentences) continue;
+
+        diffs += compare(stream);
+
+        TinyGPSPlus ref, refCustom;
+        GnssParser gps, gpsCustom;
+        TinyGPSCustom refFields[CUSTOM_COUNT];
+        GnssCustom gpsFields[CUSTOM_COUNT];
+        for (size_t f = 0; f < CUSTOM_COUNT; f++) {
+            refFields[f].begin(refCustom, CUSTOM_FIELDS[f].sentence, CUSTOM_FIELDS[f].term);
+            gpsFields[f].begin(gpsCustom, CUSTOM_FIELDS[f].sentence, CUSTOM_FIELDS[f].term);
+        }
+
+        double tRef = timeEncode(ref, stream, repeat);
+        double tRefCustom = timeEncode(refCustom, stream, repeat);
+        double tGps = timeEncode(gps, stream, repeat);
+        double tGpsCustom = timeEncode(gpsCustom, stream, repeat);
+        report("TinyGPSPlus", tRef, tRef, stream, repeat, sentences);
+        report("TinyGPSPlus + custom", tRefCustom, tRef, stream, repeat, sentences);
+        report("GnssParser", tGps, tRef, stream, repeat, sentences);
+        report("GnssParser + custom", tGpsCustom, tRef, stream, repeat, sentences);
+
+        // The custom fields must read the same
+        for (size_t f = 0; f < CUSTOM_COUNT; f++) {
+            if (strcmp(refFields[f].value(), gpsFields[f].value()) != 0) {
+                fprintf(stderr, "  custom %s,%d differs: '%s' vs '%s'\n", CUSTOM_FIELDS[f].sentence,
+                        CUSTOM_FIELDS[f].term, refFields[f].value(), gpsFields[f].value());
+                diffs++;
+            }
+        }
+    }
+
+    printf("gnssbench: %s\n", diffs ? "DIFFERENCES" : "ok");
+    return diffs ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimal Arduino core for building the firmware headers on a PC.
+// Only what src/ uses is here. Time is a virtual clock that the tool advances
+// with hostAdvanceMs(), so delay() never sleeps and runs are repeatable.
+// Serial output is discarded unless hostSerialEcho(true). Bytes queued with
+// Serial.hostFeed() / Serial1.hostFeed() are returned by read().
+// Host tools are single translation units, so the globals below are static.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <string>
+#include <deque>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define PI          3.1415926535897932384626433832795
+#define DEG_TO_RAD  0.017453292519943295769236907684886
+#define RAD_TO_DEG  57.295779513082320876798154814105
+#define TWO_PI      6.283185307179586476925286766559
+#define HIGH        1
+#define LOW         0
+#define INPUT       0x01
+#define OUTPUT      0x03
+#define INPUT_PULLUP 0x05
+#define RISING      0x01
+#define FALLING     0x02
+#define CHANGE      0x03
+#define DEC         10
+#define HEX         16
+#define A0          1
+#define SERIAL_8N1  0x800001c
+#define ADC_11db    3
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+#define sq(x)       ((x) * (x))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// ---------------------------------------------------------------- clock
+
+static inline uint64_t& hostMicros() {
+    static uint64_t us = 0;
+    return us;
+}
+static inline void hostAdvanceMs(uint32_t ms) { hostMicros() += (uint64_t)ms * 1000; }
+
+// 32-bit like the target, so wrap-around arithmetic behaves the same
+static inline unsigned long millis() { return (uint32_t)(hostMicros() / 1000); }
+static inline unsigned long micros() { return (uint32_t)hostMicros(); }
+static inline void delay(unsigned long ms) { hostAdvanceMs(ms); }
+static inline void delayMicroseconds(unsigned int us) { hostMicros() += us; }
+static inline void yield() {}
+
+// ---------------------------------------------------------------- pins
+
+struct HostPins {
+    int level[64];
+    int analog[64];
+    HostPins() {
+        for (int i = 0; i < 64; i++) {
+            level[i] = HIGH;        // Buttons are active-low: released
+            analog[i] = 0;
+        }
+    }
+};
+static inline HostPins& hostPins() {
+    static HostPins pins;
+    return pins;
+}
+
+static inline void pinMode(uint8_t, uint8_t) {}
+static inline void digitalWrite(uint8_t pin, uint8_t val) { hostPins().level[pin & 63] = val; }
+static inline int digitalRead(uint8_t pin) { return hostPins().level[pin & 63]; }
+static inline uint16_t analogRead(uint8_t pin) { return (uint16_t)hostPins().analog[pin & 63]; }
+static inline void analogSetPinAttenuation(uint8_t, int) {}
+static inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+static inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+static inline void detachInterrupt(uint8_t) {}
+
+static inline long random(long howbig) { return howbig > 0 ? rand() % howbig : 0; }
+static inline long random(long howsmall, long howbig) {
+    return howsmall < howbig ? howsmall + random(howbig - howsmall) : howsmall;
+}
+static inline void randomSeed(unsigned long seed) { srand((unsigned)seed); }
+
+// ---------------------------------------------------------------- String
+
+class String {
+private:
+    std::string s;
+
+    static std::string fmt(const char* f, ...) __attribute__((format(printf, 1, 2))) {
+        char buf[48];
+        va_list ap;
+        va_start(ap, f);
+        vsnprintf(buf, sizeof(buf), f, ap);
+        va_end(ap);
+        return buf;
+    }
+
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& v) : s(v) {}
+    String(char c) : s(1, c) {}
+    String(unsigned char v) : s(fmt("%u", v)) {}
+    String(int v) : s(fmt("%d", v)) {}
+    String(unsigned int v) : s(fmt("%u", v)) {}
+    String(long v) : s(fmt("%ld", v)) {}
+    String(unsigned long v) : s(fmt("%lu", v)) {}
+    String(float v, unsigned int decimals = 2) : s(fmt("%.*f", (int)decimals, v)) {}
+    String(double v, unsigned int decimals = 2) : s(fmt("%.*f", (int)decimals, v)) {}
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int)s.size(); }
+    char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    bool operator==(const String& o) const { return s == o.s; }
+    bool operator!=(const String& o) const { return s != o.s; }
+    int toInt() const { return atoi(s.c_str()); }
+    float toFloat() const { return (float)atof(s.c_str()); }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+};
+
+// ---------------------------------------------------------------- Print / Serial
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t* buf, size_t n) = 0;
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char* v) { return write(v); }
+    size_t print(const String& v) { return write(v.c_str()); }
+    size_t print(char v) { return write((uint8_t)v); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC) {
+        return base == DEC ? printf("%ld", v) : print((unsigned long)v, base);
+    }
+    size_t print(unsigned long v, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", v); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(T v) { return print(v) + println(); }
+    template <class T> size_t println(T v, int f) { return print(v, f) + println(); }
+
+    size_t printf(const char* f, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list ap;
+        va_start(ap, f);
+        int n = vsnprintf(buf, sizeof(buf), f, ap);
+        va_end(ap);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+};
+
+class HardwareSerial : public Print {
+private:
+    std::deque<uint8_t> rx;
+    FILE* echo;
+
+public:
+    HardwareSerial() : echo(nullptr) {}
+
+    // Host side: where output goes (nullptr drops it) and what read() returns
+    void hostEcho(FILE* f) { echo = f; }
+    void hostFeed(const char* data, size_t n) { rx.insert(rx.end(), data, data + n); }
+    void hostFeed(const char* line) { hostFeed(line, strlen(line)); }
+
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    size_t setRxBufferSize(size_t n) { return n; }
+    operator bool() const { return true; }
+    void flush() {}
+    int availableForWrite() { return 256; }
+
+    int available() { return (int)rx.size(); }
+    int peek() { return rx.empty() ? -1 : rx.front(); }
+    int read() {
+        if (rx.empty()) return -1;
+        int c = rx.front();
+        rx.pop_front();
+        return c;
+    }
+    size_t read(uint8_t* buf, size_t n) {
+        size_t got = 0;
+        while (got < n && !rx.empty()) {
+            buf[got++] = rx.front();
+            rx.pop_front();
+        }
+        return got;
+    }
+    size_t readBytes(uint8_t* buf, size_t n) { return read(buf, n); }
+    size_t readBytes(char* buf, size_t n) { return read((uint8_t*)buf, n); }
+
+    using Print::write;
+    size_t write(const uint8_t* buf, size_t n) override {
+        if (echo) fwrite(buf, 1, n, echo);
+        return n;
+    }
+};
+
+static HardwareSerial Serial;
+static HardwareSerial Serial1;
+
+// ---------------------------------------------------------------- ESP
+
+class EspClass {
+public:
+    uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return (uint32_t)(hostMicros() * 240); }
+    uint32_t getHeapSize() { return 320 * 1024; }
+    uint32_t getFreeHeap() { return 200 * 1024; }
+    uint32_t getMinFreeHeap() { return 180 * 1024; }
+    void restart() { exit(0); }
+};
+static EspClass ESP;
+
+#endif // HOST_ARDUINO_H
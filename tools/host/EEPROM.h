@@ -0,0 +1,38 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+// Emulated EEPROM: a RAM array, erased (0xFF) at start; commit() is a no-op
+
+#include <Arduino.h>
+
+class EEPROMClass {
+private:
+    uint8_t bytes[4096];
+    size_t used;
+
+public:
+    EEPROMClass() : used(0) { memset(bytes, 0xFF, sizeof(bytes)); }
+
+    bool begin(size_t size) {
+        used = std::min(size, sizeof(bytes));
+        return true;
+    }
+    bool commit() { return true; }
+    size_t length() const { return used; }
+    uint8_t* getDataPtr() { return bytes; }
+    uint8_t read(int address) { return bytes[address]; }
+    void write(int address, uint8_t value) { bytes[address] = value; }
+
+    template <typename T> T& get(int address, T& t) {
+        memcpy(&t, bytes + address, sizeof(T));
+        return t;
+    }
+    template <typename T> const T& put(int address, const T& t) {
+        memcpy(bytes + address, &t, sizeof(T));
+        return t;
+    }
+};
+
+static EEPROMClass EEPROM;
+
+#endif // HOST_EEPROM_H
@@ -0,0 +1,332 @@
+#ifndef HOST_HT_ST7735_H
+#define HOST_HT_ST7735_H
+
+// Host stand-in for the Heltec ST7735 driver (HT_st7735.cpp) on the 160x80
+// panel. Public API and bus traffic match the library call for call: each
+// st7735_spi.transfer() the driver makes is one transaction here, with the
+// same bytes and the same CS edges. A small controller model (CASET, RASET,
+// RAMWR, 16-bit colour) decodes those bytes into a 160x80 RGB565
+// framebuffer, so a frame can be saved with writePng() and pixel writes that
+// change nothing on screen are counted. Colours are stored as sent; the
+// panel's INVON is not applied.
+//
+// Bus counters accumulate from beginFrame() until the next beginFrame();
+// totals() covers everything since construction.
+
+#include <Arduino.h>
+#include "HT_st7735_fonts.h"
+#include "pngwrite.h"
+
+#define ST7735_CS_Pin        38
+#define ST7735_REST_Pin      39
+#define ST7735_DC_Pin        40
+#define ST7735_SCLK_Pin      41
+#define ST7735_MOSI_Pin      42
+#define ST7735_LED_K_Pin     21
+#define ST7735_VTFT_CTRL_Pin  3
+
+#define ST7735_IS_160X80 1
+#define ST7735_XSTART 1
+#define ST7735_YSTART 26
+#define ST7735_WIDTH  160
+#define ST7735_HEIGHT 80
+
+#define ST7735_SWRESET 0x01
+#define ST7735_SLPOUT  0x11
+#define ST7735_NORON   0x13
+#define ST7735_INVOFF  0x20
+#define ST7735_INVON   0x21
+#define ST7735_GAMSET  0x26
+#define ST7735_DISPON  0x29
+#define ST7735_CASET   0x2A
+#define ST7735_RASET   0x2B
+#define ST7735_RAMWR   0x2C
+
+#define ST7735_BLACK   0x0000
+#define ST7735_BLUE    0x001F
+#define ST7735_RED     0xF800
+#define ST7735_GREEN   0x07E0
+#define ST7735_CYAN    0x07FF
+#define ST7735_MAGENTA 0xF81F
+#define ST7735_YELLOW  0xFFE0
+#define ST7735_WHITE   0xFFFF
+#define ST7735_COLOR565(r, g, b) (((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b & 0xF8) >> 3))
+
+typedef enum {
+    GAMMA_10 = 0x01,
+    GAMMA_25 = 0x02,
+    GAMMA_22 = 0x04,
+    GAMMA_18 = 0x08
+} GammaDef;
+
+struct St7735BusStats {
+    uint32_t transactions;      // spi.transfer() calls
+    uint32_t bytes;             // Bytes clocked out, commands included
+    uint32_t commands;          // Bytes sent with DC low
+    uint32_t windows;           // Address windows set (CASET + RASET + RAMWR)
+    uint32_t csToggles;         // CS edges, both directions
+    uint32_t pixels;            // Pixels written to panel RAM
+    uint32_t pixelsChanged;     // ...of which changed a visible pixel
+
+    St7735BusStats() { memset(this, 0, sizeof(*this)); }
+};
+
+class HT_st7735 {
+private:
+    // Controller model
+    uint16_t fb[ST7735_WIDTH * ST7735_HEIGHT];
+    uint8_t cmd;
+    uint8_t args[4];
+    uint8_t argCount;
+    uint8_t col0, col1, row0, row1;     // Panel RAM window
+    uint8_t col, row;                   // RAM write pointer
+    int pixelHi;                        // First byte of a pixel, or -1
+    bool csLow;
+
+    St7735BusStats frame;
+    St7735BusStats total;
+
+    uint16_t _width;
+    uint16_t _height;
+    uint16_t _x_start;
+    uint16_t _y_start;
+
+    void count(uint32_t St7735BusStats::*field, uint32_t n) {
+        frame.*field += n;
+        total.*field += n;
+    }
+
+    void st7735_select() {
+        if (!csLow) count(&St7735BusStats::csToggles, 1);
+        csLow = true;
+    }
+    void st7735_unselect() {
+        if (csLow) count(&St7735BusStats::csToggles, 1);
+        csLow = false;
+    }
+
+    // One st7735_spi.transfer() with DC low (command) or high (data)
+    void transfer(bool dc, const uint8_t* buf, size_t n) {
+        count(&St7735BusStats::transactions, 1);
+        count(&St7735BusStats::bytes, (uint32_t)n);
+        if (!dc) {
+            count(&St7735BusStats::commands, (uint32_t)n);
+            cmd = buf[n - 1];
+            argCount = 0;
+            pixelHi = -1;
+            if (cmd == ST7735_RAMWR) {
+                col = col0;
+                row = row0;
+            }
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            data(buf[i]);
+        }
+    }
+
+    void data(uint8_t b) {
+        if (cmd == ST7735_CASET || cmd == ST7735_RASET) {
+            if (argCount < 4) args[argCount++] = b;
+            if (argCount == 4) {
+                if (cmd == ST7735_CASET) {
+                    col0 = args[1];
+                    col1 = args[3];
+                    count(&St7735BusStats::windows, 1);
+                } else {
+                    row0 = args[1];
+                    row1 = args[3];
+                }
+            }
+            return;
+        }
+        if (cmd != ST7735_RAMWR) {
+            return;
+        }
+        if (pixelHi < 0) {
+            pixelHi = b;
+            return;
+        }
+        storePixel((uint16_t)(pixelHi << 8 | b));
+        pixelHi = -1;
+    }
+
+    void storePixel(uint16_t color) {
+        count(&St7735BusStats::pixels, 1);
+        int x = (int)col - _x_start, y = (int)row - _y_start;
+        if (x >= 0 && x < _width && y >= 0 && y < _height) {
+            uint16_t& px = fb[y * _width + x];
+            if (px != color) {
+                count(&St7735BusStats::pixelsChanged, 1);
+                px = color;
+            }
+        }
+        // Column first, then row, wrapping inside the window
+        if (col++ >= col1) {
+            col = col0;
+            if (row++ >= row1) row = row0;
+        }
+    }
+
+    void st7735_write_cmd(uint8_t c) { transfer(false, &c, 1); }
+    void st7735_write_data(const uint8_t* buff, size_t buff_size) { transfer(true, buff, buff_size); }
+
+    void st7735_set_address_window(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+        st7735_write_cmd(ST7735_CASET);
+        uint8_t d[] = { 0x00, (uint8_t)(x0 + _x_start), 0x00, (uint8_t)(x1 + _x_start) };
+        st7735_write_data(d, sizeof(d));
+        st7735_write_cmd(ST7735_RASET);
+        d[1] = (uint8_t)(y0 + _y_start);
+        d[3] = (uint8_t)(y1 + _y_start);
+        st7735_write_data(d, sizeof(d));
+        st7735_write_cmd(ST7735_RAMWR);
+    }
+
+    // Same lists as the driver, for the byte count; only CASET/RASET matter here
+    void st7735_execute_cmd_list(const uint8_t* addr) {
+        uint8_t numCommands = *addr++;
+        while (numCommands--) {
+            st7735_write_cmd(*addr++);
+            uint8_t numArgs = *addr++;
+            bool hasDelay = numArgs & 0x80;
+            numArgs &= 0x7F;
+            if (numArgs) {
+                st7735_write_data(addr, numArgs);
+                addr += numArgs;
+            }
+            if (hasDelay) addr++;
+        }
+    }
+
+public:
+    HT_st7735(int8_t = ST7735_CS_Pin, int8_t = ST7735_REST_Pin, int8_t = ST7735_DC_Pin,
+              int8_t = ST7735_SCLK_Pin, int8_t = ST7735_MOSI_Pin, int8_t = ST7735_LED_K_Pin,
+              int8_t = ST7735_VTFT_CTRL_Pin)
+        : cmd(0), argCount(0), col0(0), col1(0), row0(0), row1(0), col(0), row(0), pixelHi(-1), csLow(false),
+          _width(ST7735_WIDTH), _height(ST7735_HEIGHT), _x_start(ST7735_XSTART), _y_start(ST7735_YSTART) {
+        memset(fb, 0, sizeof(fb));
+        memset(args, 0, sizeof(args));
+    }
+
+    void st7735_init(void) {
+        static const uint8_t cmds1[] = {
+            15,
+            ST7735_SWRESET, 0x80, 150, ST7735_SLPOUT, 0x80, 255,
+            0xB1, 3, 0x01, 0x2C, 0x2D, 0xB2, 3, 0x01, 0x2C, 0x2D,
+            0xB3, 6, 0x01, 0x2C, 0x2D, 0x01, 0x2C, 0x2D, 0xB4, 1, 0x07,
+            0xC0, 3, 0xA2, 0x02, 0x84, 0xC1, 1, 0xC5, 0xC2, 2, 0x0A, 0x00,
+            0xC3, 2, 0x8A, 0x2A, 0xC4, 2, 0x8A, 0xEE, 0xC5, 1, 0x0E,
+            ST7735_INVOFF, 0, 0x36, 1, 0x80 | 0x20 | 0x08, 0x3A, 1, 0x05,
+        };
+        static const uint8_t cmds2[] = {
+            3, ST7735_CASET, 4, 0x00, 0x00, 0x00, 0x4F, ST7735_RASET, 4, 0x00, 0x00, 0x00, 0x9F, ST7735_INVON, 0,
+        };
+        static const uint8_t cmds3[] = {
+            4,
+            0xE0, 16, 0x02, 0x1c, 0x07, 0x12, 0x37, 0x32, 0x29, 0x2d, 0x29, 0x25, 0x2B, 0x39, 0x00, 0x01, 0x03, 0x10,
+            0xE1, 16, 0x03, 0x1d, 0x07, 0x06, 0x2E, 0x2C, 0x29, 0x2D, 0x2E, 0x2E, 0x37, 0x3F, 0x00, 0x00, 0x02, 0x10,
+            ST7735_NORON, 0x80, 10, ST7735_DISPON, 0x80, 100,
+        };
+        st7735_select();
+        st7735_execute_cmd_list(cmds1);
+        st7735_execute_cmd_list(cmds2);
+        st7735_execute_cmd_list(cmds3);
+        st7735_unselect();
+    }
+
+    void st7735_draw_pixel(uint16_t x, uint16_t y, uint16_t color) {
+        if ((x >= _width) || (y >= _height)) return;
+        st7735_select();
+        st7735_set_address_window(x, y, x + 1, y + 1);
+        uint8_t d[] = { (uint8_t)(color >> 8), (uint8_t)(color & 0xFF) };
+        st7735_write_data(d, sizeof(d));
+        st7735_unselect();
+    }
+
+    void st7735_write_char(uint16_t x, uint16_t y, char ch, FontDef font, uint16_t color, uint16_t bgcolor) {
+        st7735_set_address_window(x, y, x + font.width - 1, y + font.height - 1);
+        for (uint32_t i = 0; i < font.height; i++) {
+            uint32_t b = font.data[(ch - 32) * font.height + i];
+            for (uint32_t j = 0; j < font.width; j++) {
+                uint16_t c = ((b << j) & 0x8000) ? color : bgcolor;
+                uint8_t d[] = { (uint8_t)(c >> 8), (uint8_t)(c & 0xFF) };
+                st7735_write_data(d, sizeof(d));
+            }
+        }
+    }
+
+    void st7735_write_str(uint16_t x, uint16_t y, String str_data, FontDef font = Font_11x18,
+                          uint16_t color = ST7735_BLUE, uint16_t bgcolor = ST7735_BLACK) {
+        st7735_write_str(x, y, str_data.c_str(), font, color, bgcolor);
+    }
+
+    void st7735_write_str(uint16_t x, uint16_t y, const char* str, FontDef font = Font_11x18,
+                          uint16_t color = ST7735_BLUE, uint16_t bgcolor = ST7735_BLACK) {
+        st7735_select();
+        while (*str) {
+            if (x + font.width >= _width) {
+                x = 0;
+                y += font.height;
+                if (y + font.height >= _height) break;
+                if (*str == ' ') {
+                    str++;
+                    continue;
+                }
+            }
+            st7735_write_char(x, y, *str, font, color, bgcolor);
+            x += font.width;
+            str++;
+        }
+        st7735_unselect();
+    }
+
+    void st7735_fill_rectangle(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+        if ((x >= _width) || (y >= _height)) return;
+        if ((x + w - 1) >= _width) w = _width - x;
+        if ((y + h - 1) >= _height) h = _height - y;
+        st7735_select();
+        st7735_set_address_window(x, y, x + w - 1, y + h - 1);
+        uint8_t d[] = { (uint8_t)(color >> 8), (uint8_t)(color & 0xFF) };
+        for (uint32_t n = (uint32_t)w * h; n > 0; n--) {
+            st7735_write_data(d, sizeof(d));      // One transfer per pixel, as the driver does
+        }
+        st7735_unselect();
+    }
+
+    void st7735_fill_screen(uint16_t color) { st7735_fill_rectangle(0, 0, _width, _height, color); }
+
+    void st7735_draw_image(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t* image) {
+        if ((x >= _width) || (y >= _height)) return;
+        if ((x + w - 1) >= _width) return;
+        if ((y + h - 1) >= _height) return;
+        st7735_select();
+        st7735_set_address_window(x, y, x + w - 1, y + h - 1);
+        st7735_write_data((const uint8_t*)image, sizeof(uint16_t) * w * h);
+        st7735_unselect();
+    }
+
+    void st7735_invert_colors(bool invert) {
+        st7735_select();
+        st7735_write_cmd(invert ? ST7735_INVON : ST7735_INVOFF);
+        st7735_unselect();
+    }
+
+    void st7735_set_gamma(GammaDef gamma) {
+        uint8_t d[1] = { (uint8_t)gamma };
+        st7735_select();
+        st7735_write_cmd(ST7735_GAMSET);
+        st7735_write_data(d, sizeof(d));
+        st7735_unselect();
+    }
+
+    // Host side
+    void beginFrame() { frame = St7735BusStats(); }
+    const St7735BusStats& frameStats() const { return frame; }
+    const St7735BusStats& totals() const { return total; }
+    uint16_t pixel(int x, int y) const { return fb[y * _width + x]; }
+    bool writePng(const char* path, int scale = 1) const {
+        return writePngRgb565(path, fb, _width, _height, scale);
+    }
+};
+
+#endif // HOST_HT_ST7735_H
@@ -0,0 +1,110 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+// LittleFS held in memory: enough for the track log, route store and route
+// upload to run on the host. Files live until the process exits.
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <Arduino.h>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+#define HOST_FS_TOTAL_BYTES (1536UL * 1024)
+
+typedef std::shared_ptr<std::vector<uint8_t> > HostFileData;
+
+class File {
+private:
+    HostFileData data;
+    size_t pos;
+    bool writable;
+
+public:
+    File() : pos(0), writable(false) {}
+    File(HostFileData d, size_t p, bool w) : data(d), pos(p), writable(w) {}
+
+    operator bool() const { return (bool)data; }
+    size_t size() const { return data ? data->size() : 0; }
+    size_t position() const { return pos; }
+    int available() { return data ? (int)(data->size() - pos) : 0; }
+    bool seek(uint32_t p) {
+        if (!data || p > data->size()) return false;
+        pos = p;
+        return true;
+    }
+    size_t read(uint8_t* buf, size_t n) {
+        if (!data || pos >= data->size()) return 0;
+        n = std::min(n, data->size() - pos);
+        memcpy(buf, data->data() + pos, n);
+        pos += n;
+        return n;
+    }
+    int read() {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    size_t write(const uint8_t* buf, size_t n) {
+        if (!data || !writable) return 0;
+        if (data->size() < pos + n) data->resize(pos + n);
+        memcpy(data->data() + pos, buf, n);
+        pos += n;
+        return n;
+    }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    void flush() {}
+    void close() { data.reset(); }
+};
+
+class LittleFSFS {
+private:
+    std::map<std::string, HostFileData> files;
+
+public:
+    bool begin(bool = false, const char* = "/littlefs", uint8_t = 10, const char* = "spiffs") {
+        return true;
+    }
+    void end() {}
+    bool format() {
+        files.clear();
+        return true;
+    }
+
+    File open(const char* path, const char* mode = FILE_READ) {
+        std::map<std::string, HostFileData>::iterator it = files.find(path);
+        if (mode[0] == 'r') {
+            return it == files.end() ? File() : File(it->second, 0, false);
+        }
+        if (it == files.end() || mode[0] == 'w') {
+            files[path] = HostFileData(new std::vector<uint8_t>());
+        }
+        HostFileData d = files[path];
+        return File(d, mode[0] == 'a' ? d->size() : 0, true);
+    }
+    bool exists(const char* path) { return files.count(path) != 0; }
+    bool remove(const char* path) { return files.erase(path) != 0; }
+    bool rename(const char* from, const char* to) {
+        std::map<std::string, HostFileData>::iterator it = files.find(from);
+        if (it == files.end()) return false;
+        HostFileData d = it->second;
+        files.erase(it);
+        files[to] = d;
+        return true;
+    }
+    size_t totalBytes() { return HOST_FS_TOTAL_BYTES; }
+    size_t usedBytes() {
+        size_t used = 0;
+        for (std::map<std::string, HostFileData>::iterator it = files.begin(); it != files.end(); ++it) {
+            used += (it->second->size() + 4095) / 4096 * 4096;
+        }
+        return used;
+    }
+};
+
+static LittleFSFS LittleFS;
+
+#endif // HOST_LITTLEFS_H
@@ -0,0 +1,22 @@
+#ifndef HOST_LORAWAN_APP_H
+#define HOST_LORAWAN_APP_H
+
+// Heltec board support for host builds: the SX1262 driver interface from
+// radio.h, declared but not implemented. Host tools never run
+// HTITTracker::begin(), so nothing calls into the radio.
+
+#include <Arduino.h>
+#include "radio.h"
+
+class McuClass {
+public:
+    void begin(uint8_t, uint8_t) {}
+};
+static McuClass Mcu;
+
+typedef void (DioIrqHandler)(void);
+static inline void SX126xIoIrqInit(DioIrqHandler*) {}
+
+extern "C" void RadioOnDioIrq(void);
+
+#endif // HOST_LORAWAN_APP_H
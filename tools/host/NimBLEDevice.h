@@ -0,0 +1,152 @@
+#ifndef HOST_NIMBLEDEVICE_H
+#define HOST_NIMBLEDEVICE_H
+
+// NimBLE-Arduino surface used by src/, with no controller behind it: the
+// stack never comes up, createServer() returns nullptr and callers keep BLE
+// off exactly as they do when init fails on the target.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define BLE_HCI_LE_PHY_1M           1
+#define BLE_HCI_LE_PHY_2M           2
+#define BLE_HCI_LE_PHY_CODED        3
+#define BLE_GAP_LE_PHY_2M_MASK      0x02
+#define BLE_HS_ADV_F_DISC_GEN       0x02
+#define BLE_HS_ADV_F_BREDR_UNSUP    0x04
+
+namespace NIMBLE_PROPERTY {
+enum { READ = 0x0002, WRITE_NR = 0x0004, WRITE = 0x0008, NOTIFY = 0x0010, INDICATE = 0x0020 };
+}
+
+class NimBLEUUID {
+public:
+    NimBLEUUID(uint16_t) {}
+    NimBLEUUID(const char*) {}
+};
+
+class NimBLEConnInfo {
+public:
+    uint16_t getConnHandle() const { return 0; }
+    uint16_t getConnInterval() const { return 0; }
+};
+
+class NimBLEAttValue {
+public:
+    const uint8_t* data() const { return nullptr; }
+    size_t size() const { return 0; }
+};
+
+class NimBLECharacteristic;
+class NimBLEServer;
+
+class NimBLECharacteristicCallbacks {
+public:
+    virtual ~NimBLECharacteristicCallbacks() {}
+    virtual void onWrite(NimBLECharacteristic*, NimBLEConnInfo&) {}
+    virtual void onSubscribe(NimBLECharacteristic*, NimBLEConnInfo&, uint16_t) {}
+};
+
+class NimBLEServerCallbacks {
+public:
+    virtual ~NimBLEServerCallbacks() {}
+    virtual void onConnect(NimBLEServer*, NimBLEConnInfo&) {}
+    virtual void onDisconnect(NimBLEServer*, NimBLEConnInfo&, int) {}
+    virtual void onConnParamsUpdate(NimBLEConnInfo&) {}
+};
+
+class NimBLECharacteristic {
+public:
+    void setValue(const uint8_t*, size_t) {}
+    NimBLEAttValue getValue() const { return NimBLEAttValue(); }
+    bool notify(uint16_t = 0xffff) const { return false; }
+    bool indicate(uint16_t = 0xffff) const { return false; }
+    void setCallbacks(NimBLECharacteristicCallbacks*) {}
+};
+
+class NimBLEService {
+public:
+    NimBLECharacteristic* createCharacteristic(const NimBLEUUID&, uint32_t = 0, uint16_t = 512) { return nullptr; }
+    bool start() { return false; }
+};
+
+class NimBLEServer {
+public:
+    NimBLEService* createService(const NimBLEUUID&) { return nullptr; }
+    void setCallbacks(NimBLEServerCallbacks*, bool = true) {}
+    void updateConnParams(uint16_t, uint16_t, uint16_t, uint16_t, uint16_t) const {}
+    void setDataLen(uint16_t, uint16_t) const {}
+    bool updatePhy(uint16_t, uint8_t, uint8_t, uint16_t) { return false; }
+    void advertiseOnDisconnect(bool) {}
+};
+
+class NimBLEAdvertising {
+public:
+    bool addServiceUUID(const NimBLEUUID&) { return false; }
+    bool setAppearance(uint16_t) { return false; }
+    bool setName(const std::string&) { return false; }
+    void setMinInterval(uint16_t) {}
+    void setMaxInterval(uint16_t) {}
+    bool start(uint32_t = 0) { return false; }
+};
+
+class NimBLEExtAdvertisement {
+public:
+    NimBLEExtAdvertisement(uint8_t = BLE_HCI_LE_PHY_1M, uint8_t = BLE_HCI_LE_PHY_1M) {}
+    void setLegacyAdvertising(bool) {}
+    void setConnectable(bool) {}
+    void setScannable(bool) {}
+    bool setFlags(uint8_t) { return false; }
+    bool addServiceUUID(const NimBLEUUID&) { return false; }
+    bool setAppearance(uint16_t) { return false; }
+    bool setName(const std::string&, bool = true) { return false; }
+    void setMinInterval(uint32_t) {}
+    void setMaxInterval(uint32_t) {}
+    void setTxPower(int8_t) {}
+    bool setData(const uint8_t*, size_t) { return false; }
+};
+
+class NimBLEExtAdvertising {
+public:
+    bool setInstanceData(uint8_t, NimBLEExtAdvertisement&) { return false; }
+    bool updateInstanceData(uint8_t, const uint8_t*, size_t) { return false; }
+    bool start(uint8_t, int = 0, int = 0) { return false; }
+    bool stop(uint8_t) { return false; }
+    bool isActive(uint8_t) { return false; }
+};
+
+class NimBLEL2CAPChannel {
+public:
+    bool write(const uint8_t*, size_t) { return false; }
+    uint16_t getMTU() const { return 0; }
+};
+
+class NimBLEL2CAPChannelCallbacks {
+public:
+    virtual ~NimBLEL2CAPChannelCallbacks() {}
+    virtual void onConnect(NimBLEL2CAPChannel*, uint16_t) {}
+    virtual void onRead(NimBLEL2CAPChannel*, std::vector<uint8_t>&) {}
+    virtual void onDisconnect(NimBLEL2CAPChannel*) {}
+};
+
+class NimBLEL2CAPServer {
+public:
+    NimBLEL2CAPChannel* createService(uint16_t, uint16_t, NimBLEL2CAPChannelCallbacks*) { return nullptr; }
+};
+
+class NimBLEDevice {
+public:
+    static bool init(const std::string&) { return false; }
+    static bool setMTU(uint16_t) { return false; }
+    static NimBLEServer* createServer() { return nullptr; }
+    static NimBLEL2CAPServer* createL2CAPServer() { return nullptr; }
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    static NimBLEExtAdvertising* getAdvertising() { return nullptr; }
+#else
+    static NimBLEAdvertising* getAdvertising() { return nullptr; }
+#endif
+};
+
+#endif // HOST_NIMBLEDEVICE_H
@@ -0,0 +1,13 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <Arduino.h>
+
+typedef enum { GPIO_NUM_0 = 0 } gpio_num_t;
+
+static inline int esp_sleep_enable_ext0_wakeup(gpio_num_t, int) { return 0; }
+static inline int esp_sleep_enable_timer_wakeup(uint64_t) { return 0; }
+static inline int esp_light_sleep_start() { return 0; }
+static inline void esp_deep_sleep_start() { exit(0); }
+
+#endif // HOST_ESP_SLEEP_H
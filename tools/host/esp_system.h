@@ -0,0 +1,13 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+// Values as in ESP-IDF; a host run always starts from power-on
+typedef enum {
+    ESP_RST_UNKNOWN = 0,
+    ESP_RST_POWERON = 1,
+    ESP_RST_DEEPSLEEP = 8,
+} esp_reset_reason_t;
+
+static inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#include "esp_err.h"
+
+static inline esp_err_t esp_task_wdt_init(uint32_t, bool) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_add(void*) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_delete(void*) { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_reset() { return ESP_OK; }
+static inline esp_err_t esp_task_wdt_status(void*) { return ESP_OK; }
+
+#endif // HOST_ESP_TASK_WDT_H
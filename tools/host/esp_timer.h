@@ -0,0 +1,81 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <Arduino.h>
+#include "esp_err.h"
+
+static inline int64_t esp_timer_get_time() { return (int64_t)hostMicros(); }
+
+// One-shot timers on the host clock. Nothing fires by itself: advance the
+// clock, then hostRunTimers() calls each armed timer whose time has come.
+
+#define HOST_ESP_TIMERS 4
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+} esp_timer_create_args_t;
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    bool armed;
+    uint64_t dueUs;
+    uint32_t starts;                   // esp_timer_start_once() calls
+};
+typedef struct esp_timer* esp_timer_handle_t;
+
+struct HostEspTimers {
+    esp_timer timers[HOST_ESP_TIMERS];
+    int used;
+};
+
+static inline HostEspTimers& hostEspTimers() {
+    static HostEspTimers all;
+    return all;
+}
+
+static inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    HostEspTimers& all = hostEspTimers();
+    if (all.used >= HOST_ESP_TIMERS) return ESP_FAIL;
+    esp_timer* t = &all.timers[all.used++];
+    memset(t, 0, sizeof(*t));
+    t->callback = args->callback;
+    t->arg = args->arg;
+    *out = t;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeoutUs) {
+    t->armed = true;
+    t->dueUs = hostMicros() + timeoutUs;
+    t->starts++;
+    return ESP_OK;
+}
+
+static inline esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    t->armed = false;
+    return ESP_OK;
+}
+
+// Fire every armed timer that is due; returns how many fired
+static inline int hostRunTimers() {
+    int fired = 0;
+    HostEspTimers& all = hostEspTimers();
+    for (int i = 0; i < all.used; i++) {
+        esp_timer& t = all.timers[i];
+        if (t.armed && t.dueUs <= hostMicros()) {
+            t.armed = false;
+            t.callback(t.arg);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+#endif // HOST_ESP_TIMER_H
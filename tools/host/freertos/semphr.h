@@ -0,0 +1,17 @@
+#ifndef HOST_FREERTOS_SEMPHR_H
+#define HOST_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex() { return (SemaphoreHandle_t)1; }
+static inline SemaphoreHandle_t xSemaphoreCreateBinary() { return (SemaphoreHandle_t)1; }
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+static inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t, BaseType_t* woken) {
+    if (woken) *woken = pdFALSE;
+    return pdTRUE;
+}
+
+#endif // HOST_FREERTOS_SEMPHR_H
@@ -0,0 +1,35 @@
+#ifndef HOST_FREERTOS_STREAM_BUFFER_H
+#define HOST_FREERTOS_STREAM_BUFFER_H
+
+#include <deque>
+#include "FreeRTOS.h"
+
+// Bounded byte queue; receive never blocks on the host
+struct HostStreamBuffer {
+    std::deque<uint8_t> bytes;
+    size_t capacity;
+};
+typedef HostStreamBuffer* StreamBufferHandle_t;
+
+static inline StreamBufferHandle_t xStreamBufferCreate(size_t size, size_t) {
+    HostStreamBuffer* sb = new HostStreamBuffer;
+    sb->capacity = size;
+    return sb;
+}
+static inline size_t xStreamBufferSend(StreamBufferHandle_t sb, const void* data, size_t len, TickType_t) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t n = 0;
+    while (n < len && sb->bytes.size() < sb->capacity) sb->bytes.push_back(p[n++]);
+    return n;
+}
+static inline size_t xStreamBufferReceive(StreamBufferHandle_t sb, void* data, size_t len, TickType_t) {
+    uint8_t* p = (uint8_t*)data;
+    size_t n = 0;
+    while (n < len && !sb->bytes.empty()) {
+        p[n++] = sb->bytes.front();
+        sb->bytes.pop_front();
+    }
+    return n;
+}
+
+#endif // HOST_FREERTOS_STREAM_BUFFER_H
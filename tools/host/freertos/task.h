@@ -0,0 +1,47 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef enum { eRunning = 0, eReady, eBlocked, eSuspended, eDeleted, eInvalid } eTaskState;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char* pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t* pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+typedef void (*TaskFunction_t)(void*);
+
+// The one "task" on the host is the caller
+static inline TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t)1; }
+static inline TaskHandle_t xTaskGetIdleTaskHandleForCPU(UBaseType_t) { return nullptr; }
+static inline TaskHandle_t xTaskGetIdleTaskHandleForCore(BaseType_t) { return nullptr; }
+static inline const char* pcTaskGetName(TaskHandle_t) { return "host"; }
+static inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 8192; }
+static inline UBaseType_t uxTaskGetNumberOfTasks() { return 1; }
+static inline UBaseType_t uxTaskGetSystemState(TaskStatus_t*, UBaseType_t, uint32_t* total) {
+    if (total) *total = 0;
+    return 0;
+}
+
+static inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t,
+                                                 TaskHandle_t* handle, BaseType_t) {
+    if (handle) *handle = nullptr;
+    return pdFAIL;
+}
+static inline void vTaskDelete(TaskHandle_t) {}
+static inline void vTaskDelay(TickType_t) {}
+static inline TickType_t xTaskGetTickCount() { return 0; }
+static inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+static inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t* woken) { if (woken) *woken = pdFALSE; }
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,92 @@
+#ifndef HOST_PNGWRITE_H
+#define HOST_PNGWRITE_H
+
+// Dependency-free PNG writer for RGB565 framebuffers: 8-bit RGB, stored
+// (uncompressed) deflate blocks, each pixel repeated scale x scale times.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+static inline uint32_t pngCrc(uint32_t crc, const uint8_t* p, size_t n) {
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static inline void pngPut32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 3; i >= 0; i--) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+static inline void pngChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    pngPut32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    pngPut32(out, pngCrc(0, &out[start], out.size() - start));
+}
+
+static inline bool writePngRgb565(const char* path, const uint16_t* pixels, int width, int height, int scale = 1) {
+    int w = width * scale, h = height * scale;
+
+    // 1) Raw scanlines: filter byte 0, then RGB888
+    std::vector<uint8_t> raw;
+    raw.reserve((size_t)h * (1 + 3 * w));
+    for (int y = 0; y < h; y++) {
+        raw.push_back(0);
+        for (int x = 0; x < w; x++) {
+            uint16_t c = pixels[(y / scale) * width + x / scale];
+            uint8_t r = (uint8_t)((c >> 11) & 0x1F), g = (uint8_t)((c >> 5) & 0x3F), b = (uint8_t)(c & 0x1F);
+            raw.push_back((uint8_t)(r << 3 | r >> 2));
+            raw.push_back((uint8_t)(g << 2 | g >> 4));
+            raw.push_back((uint8_t)(b << 3 | b >> 2));
+        }
+    }
+
+    // 2) zlib stream of stored blocks + Adler-32
+    std::vector<uint8_t> z;
+    z.push_back(0x78);
+    z.push_back(0x01);
+    size_t pos = 0;
+    do {
+        size_t n = raw.size() - pos < 65535 ? raw.size() - pos : 65535;
+        z.push_back(pos + n == raw.size() ? 1 : 0);
+        z.push_back((uint8_t)n);
+        z.push_back((uint8_t)(n >> 8));
+        z.push_back((uint8_t)~n);
+        z.push_back((uint8_t)(~n >> 8));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+    } while (pos < raw.size());
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw.size(); i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    pngPut32(z, b << 16 | a);
+
+    // 3) Signature, IHDR, IDAT, IEND
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> out(sig, sig + 8);
+    std::vector<uint8_t> ihdr;
+    pngPut32(ihdr, (uint32_t)w);
+    pngPut32(ihdr, (uint32_t)h);
+    ihdr.push_back(8);      // Bit depth
+    ihdr.push_back(2);      // Truecolour
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    pngChunk(out, "IHDR", ihdr);
+    pngChunk(out, "IDAT", z);
+    pngChunk(out, "IEND", std::vector<uint8_t>());
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    return fclose(f) == 0 && ok;
+}
+
+#endif // HOST_PNGWRITE_H
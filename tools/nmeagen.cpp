@@ -0,0 +1,637 @@
+// Synthetic GNSS NMEA stream generator for replay, throughput and stress tests.
+//
+// Build:  g++ -std=c++11 -O2 -o nmeagen nmeagen.cpp
+//
+//   nmeagen SCENARIO [options] > stream.nmea
+//   nmeagen --list                   list the scenarios
+//   nmeagen --selftest               checks formatting, checksums and the fault
+//                                    injectors (exit status 1 on error)
+//
+// Options:
+//   --seconds N        length of the run (default depends on the scenario)
+//   --rate HZ          position epochs per second, 1..20
+//   --sats N           satellites in view over all constellations, 0..64
+//   --seed N           random seed, the same seed gives the same stream
+//   --truth FILE       write the true trajectory as CSV, one row per epoch:
+//                      utc,t_ms,lat,lon,speed_kmh,course_deg,fix
+//   --bad-checksum P   probability per sentence of a corrupted payload byte
+//   --truncate P       probability per sentence of cutting it short
+//   --overrun P        probability per sentence of a UART overrun after it
+//                      (a run of 16..255 bytes dropped from the stream)
+//   --noise P          probability per sentence of line noise before it
+//
+// Every epoch carries GNGGA, GNRMC and GNVTG; GSA (one per constellation) and
+// GSV (per talker: GP, GL, GA, GB, GQ) follow once per second, as the
+// receivers do at higher rates. Positions are the true track plus Gaussian
+// noise scaled by HDOP; the truth file has the track without noise. Fault
+// counts and the stream size are reported on stderr.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define EARTH_RADIUS_M  6371000.0
+#define DEG             (M_PI / 180.0)
+#define KMH_PER_KNOT    1.852
+#define START_UTC_S     (12 * 3600)          // 12:00:00 on START_DATE
+#define START_DATE      "170926"             // ddmmyy
+
+// ---------------------------------------------------------------------------
+// Random numbers (xorshift64*, repeatable across platforms)
+
+class Rng {
+private:
+    uint64_t s;
+    bool haveSpare;
+    double spare;
+
+public:
+    explicit Rng(uint64_t seed) : s(seed ? seed : 0x9E3779B97F4A7C15ULL), haveSpare(false), spare(0) {}
+
+    uint64_t next() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 0x2545F4914F6CDD1DULL;
+    }
+
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    int range(int lo, int hi) { return lo + (int)(uniform() * (hi - lo + 1)); }
+    bool chance(double p) { return p > 0 && uniform() < p; }
+
+    double gauss() {
+        if (haveSpare) {
+            haveSpare = false;
+            return spare;
+        }
+        double u, v, r;
+        do {
+            u = uniform() * 2 - 1;
+            v = uniform() * 2 - 1;
+            r = u * u + v * v;
+        } while (r >= 1 || r == 0);
+        double m = sqrt(-2 * log(r) / r);
+        spare = v * m;
+        haveSpare = true;
+        return u * m;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Trajectory
+
+struct Truth {
+    double lat, lon;        // Degrees
+    double speedKmh;
+    double courseDeg;       // 0 = north
+    bool fix;
+    double hdop;
+    double noiseM;          // 1-sigma horizontal noise at HDOP 1
+};
+
+static double wrapLon(double lon) {
+    while (lon >= 180.0) lon -= 360.0;
+    while (lon < -180.0) lon += 360.0;
+    return lon;
+}
+
+// Move along the current course for dist metres (great circle step)
+static void advance(Truth& t, double distM) {
+    double d = distM / EARTH_RADIUS_M, th = t.courseDeg * DEG;
+    double p1 = t.lat * DEG, l1 = t.lon * DEG;
+    double p2 = asin(sin(p1) * cos(d) + cos(p1) * sin(d) * cos(th));
+    double l2 = l1 + atan2(sin(th) * sin(d) * cos(p1), cos(d) - sin(p1) * sin(p2));
+    t.lat = p2 / DEG;
+    t.lon = wrapLon(l2 / DEG);
+}
+
+struct Scenario {
+    const char* name;
+    const char* help;
+    int seconds;
+    int rate;
+    int sats;
+    void (*start)(Truth& t);
+    void (*step)(Truth& t, double tS, double dt, Rng& rng);
+};
+
+static void walkStart(Truth& t) {
+    t.lat = 47.376887; t.lon = 8.541694; t.speedKmh = 5.0; t.courseDeg = 40; t.fix = true; t.hdop = 0.9; t.noiseM = 2.0;
+}
+static void walkStep(Truth& t, double, double dt, Rng& rng) {
+    t.courseDeg = fmod(t.courseDeg + rng.gauss() * 8.0 * sqrt(dt) + 360.0, 360.0);
+    t.speedKmh = 5.0 + 0.4 * sin(t.courseDeg * DEG);
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static void strollStart(Truth& t) {
+    t.lat = 46.948090; t.lon = 7.447440; t.speedKmh = 3.6; t.courseDeg = 120; t.fix = true; t.hdop = 2.5; t.noiseM = 2.0;
+}
+static void strollStep(Truth& t, double, double dt, Rng& rng) {
+    t.courseDeg = fmod(t.courseDeg + rng.gauss() * 4.0 * sqrt(dt) + 360.0, 360.0);
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static void driveStart(Truth& t) {
+    t.lat = 47.421; t.lon = 8.555; t.speedKmh = 0; t.courseDeg = 350; t.fix = true; t.hdop = 0.8; t.noiseM = 1.5;
+}
+static void driveStep(Truth& t, double tS, double dt, Rng& rng) {
+    // 60 s cycles: accelerate to 100 km/h, cruise, turn, brake to a stop
+    double c = fmod(tS, 60.0);
+    if (c < 15) t.speedKmh = std::min(100.0, t.speedKmh + 7.0 * dt);
+    else if (c < 40) t.speedKmh = 100.0;
+    else if (c < 45) t.courseDeg = fmod(t.courseDeg + (rng.uniform() < 0.5 ? -12 : 12) * dt + 360.0, 360.0);
+    else t.speedKmh = std::max(0.0, t.speedKmh - 9.0 * dt);
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static void staticStart(Truth& t) {
+    t.lat = 51.477928; t.lon = -0.001545; t.speedKmh = 0; t.courseDeg = 0; t.fix = true; t.hdop = 1.2; t.noiseM = 3.0;
+}
+static void staticStep(Truth& t, double tS, double, Rng&) {
+    t.hdop = 1.6 + 0.9 * sin(tS / 40.0);      // Slow multipath swing
+}
+
+// Home is fixed in Sydney, then the receiver loses the fix and reappears
+// near the antipode and walks, so distance to home is close to half the globe
+static void antipodalStart(Truth& t) {
+    t.lat = -33.868800; t.lon = 151.209300; t.speedKmh = 0; t.courseDeg = 0; t.fix = true; t.hdop = 0.9; t.noiseM = 2.0;
+}
+static void antipodalStep(Truth& t, double tS, double dt, Rng&) {
+    if (tS < 20) return;
+    if (tS < 30) {
+        t.fix = false;
+        t.lat = 33.8688 + 0.0005;
+        t.lon = wrapLon(151.2093 - 180.0 + 0.0005);
+        t.speedKmh = 0;
+        return;
+    }
+    t.fix = true;
+    t.speedKmh = 5.0;
+    t.courseDeg = 225;      // Straight at the antipode and past it
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static void equatorStart(Truth& t) {
+    t.lat = -0.002; t.lon = -0.002; t.speedKmh = 60; t.courseDeg = 45; t.fix = true; t.hdop = 0.8; t.noiseM = 1.5;
+}
+static void equatorStep(Truth& t, double, double dt, Rng&) {
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static void datelineStart(Truth& t) {
+    t.lat = -16.5; t.lon = 179.996; t.speedKmh = 80; t.courseDeg = 90; t.fix = true; t.hdop = 0.8; t.noiseM = 1.5;
+}
+static void datelineStep(Truth& t, double, double dt, Rng&) {
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static void burstStart(Truth& t) {
+    t.lat = 35.681236; t.lon = 139.767125; t.speedKmh = 50; t.courseDeg = 180; t.fix = true; t.hdop = 0.5; t.noiseM = 1.0;
+}
+static void burstStep(Truth& t, double tS, double dt, Rng&) {
+    t.courseDeg = fmod(180.0 + 30.0 * sin(tS / 10.0) + 360.0, 360.0);
+    advance(t, t.speedKmh / 3.6 * dt);
+}
+
+static const Scenario SCENARIOS[] = {
+    { "walk",      "5 km/h random walk, 2 m noise",                          600, 1, 14, walkStart, walkStep },
+    { "stroll",    "3.6 km/h in a street canyon, HDOP 2.5",                  600, 1,  8, strollStart, strollStep },
+    { "drive",     "stop-go cycles to 100 km/h with turns",                  300, 1, 18, driveStart, driveStep },
+    { "static",    "stationary, 3 m noise, HDOP swinging 0.7-2.5",           300, 1, 10, staticStart, staticStep },
+    { "antipodal", "home in Sydney, 10 s without fix, walk at the antipode",  90, 1, 12, antipodalStart, antipodalStep },
+    { "equator",   "60 km/h north-east across 0 N and 0 E",                   60, 1, 12, equatorStart, equatorStep },
+    { "dateline",  "80 km/h east across 180 E/W",                             60, 1, 12, datelineStart, datelineStep },
+    { "burst",     "10 Hz, 48 satellites on five systems, 50 km/h",           60, 10, 48, burstStart, burstStep },
+};
+#define SCENARIO_COUNT  (sizeof(SCENARIOS) / sizeof(SCENARIOS[0]))
+
+// ---------------------------------------------------------------------------
+// Sentences
+
+static std::string sentence(const char* body) {
+    uint8_t sum = 0;
+    for (const char* p = body; *p; p++) sum ^= (uint8_t)*p;
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+    return std::string("$") + body + tail;
+}
+
+// ddmm.mmmmm / dddmm.mmmmm, rounded once so minutes never print as 60
+static void formatCoord(double v, int degDigits, char* out, size_t n) {
+    long long m = llround(fabs(v) * 60.0 * 100000.0);
+    int deg = (int)(m / 6000000);
+    long long rem = m % 6000000;
+    snprintf(out, n, "%0*d%02d.%05d", degDigits, deg, (int)(rem / 100000), (int)(rem % 100000));
+}
+
+static void formatUtc(double tS, char* out, size_t n) {
+    long cs = llround(tS * 100.0) + (long)START_UTC_S * 100;
+    cs %= 24L * 3600 * 100;
+    snprintf(out, n, "%02ld%02ld%02ld.%02ld", cs / 360000, cs / 6000 % 60, cs / 100 % 60, cs % 100);
+}
+
+struct Sat {
+    char talker[3];     // GP, GL, GA, GB, GQ
+    int sysId;          // NMEA 4.10 GSA system ID
+    int prn;
+    double elev, az;
+    int snr;
+};
+
+static std::vector<Sat> makeSky(int count, Rng& rng) {
+    // Roughly the split a multi-GNSS receiver sees: GPS 35 %, the rest shared
+    static const struct { const char* talker; int sysId; int prnBase; int share; } SYS[] = {
+        { "GP", 1, 1, 35 }, { "GL", 2, 65, 20 }, { "GA", 3, 1, 20 }, { "GB", 4, 1, 20 }, { "GQ", 5, 193, 5 },
+    };
+    std::vector<Sat> sky;
+    int left = count;
+    for (int s = 0; s < 5 && left > 0; s++) {
+        int n = s == 4 ? left : std::min(left, (count * SYS[s].share + 50) / 100);
+        for (int i = 0; i < n; i++) {
+            Sat sat;
+            memcpy(sat.talker, SYS[s].talker, 3);
+            sat.sysId = SYS[s].sysId;
+            sat.prn = SYS[s].prnBase + i;
+            sat.elev = 5 + rng.uniform() * 85;
+            sat.az = rng.uniform() * 360;
+            sat.snr = 20 + (int)(sat.elev / 90.0 * 25) + rng.range(0, 5);
+            sky.push_back(sat);
+        }
+        left -= n;
+    }
+    return sky;
+}
+
+static void epochSentences(double tS, const Truth& t, double lat, double lon, double speedKmh,
+                           int satsUsed, std::vector<std::string>& out) {
+    char utc[16], la[16], lo[16], body[160];
+    formatUtc(tS, utc, sizeof(utc));
+    formatCoord(lat, 2, la, sizeof(la));
+    formatCoord(lon, 3, lo, sizeof(lo));
+    char ns = lat < 0 ? 'S' : 'N', ew = lon < 0 ? 'W' : 'E';
+
+    if (t.fix) {
+        snprintf(body, sizeof(body), "GNGGA,%s,%s,%c,%s,%c,1,%02d,%.1f,%.1f,M,47.0,M,,", utc, la, ns, lo, ew,
+                 satsUsed, t.hdop, 408.0 + 2.0 * sin(tS / 30.0));
+        out.push_back(sentence(body));
+        snprintf(body, sizeof(body), "GNRMC,%s,A,%s,%c,%s,%c,%.3f,%.2f,%s,,,A,V", utc, la, ns, lo, ew,
+                 speedKmh / KMH_PER_KNOT, t.courseDeg, START_DATE);
+        out.push_back(sentence(body));
+        snprintf(body, sizeof(body), "GNVTG,%.2f,T,,M,%.3f,N,%.3f,K,A", t.courseDeg, speedKmh / KMH_PER_KNOT,
+                 speedKmh);
+        out.push_back(sentence(body));
+    }
+    else {
+        snprintf(body, sizeof(body), "GNGGA,%s,,,,,0,00,99.9,,,,,,", utc);
+        out.push_back(sentence(body));
+        snprintf(body, sizeof(body), "GNRMC,%s,V,,,,,,,%s,,,N,V", utc, START_DATE);
+        out.push_back(sentence(body));
+        out.push_back(sentence("GNVTG,,T,,M,,N,,K,N"));
+    }
+}
+
+static void skySentences(const std::vector<Sat>& sky, const Truth& t, std::vector<std::string>& out) {
+    static const char* TALKERS[] = { "GP", "GL", "GA", "GB", "GQ" };
+    char body[160];
+
+    // 1) GSA per system: up to 12 PRNs used in the fix
+    for (int s = 0; s < 5; s++) {
+        std::string prns;
+        int used = 0;
+        for (size_t i = 0; i < sky.size(); i++) {
+            if (strcmp(sky[i].talker, TALKERS[s]) != 0 || sky[i].elev < 10 || !t.fix) continue;
+            if (used < 12) {
+                char f[8];
+                snprintf(f, sizeof(f), "%02d,", sky[i].prn);
+                prns += f;
+                used++;
+            }
+        }
+        bool any = false;
+        for (size_t i = 0; i < sky.size(); i++) any |= strcmp(sky[i].talker, TALKERS[s]) == 0;
+        if (!any) continue;
+        for (int k = used; k < 12; k++) prns += ",";
+        snprintf(body, sizeof(body), "GNGSA,A,%d,%s%.1f,%.1f,%.1f,%d", t.fix ? 3 : 1, prns.c_str(), t.hdop * 1.6,
+                 t.hdop, t.hdop * 1.3, s + 1);
+        out.push_back(sentence(body));
+    }
+
+    // 2) GSV per talker, four satellites a message
+    for (int s = 0; s < 5; s++) {
+        std::vector<const Sat*> mine;
+        for (size_t i = 0; i < sky.size(); i++) {
+            if (strcmp(sky[i].talker, TALKERS[s]) == 0) mine.push_back(&sky[i]);
+        }
+        if (mine.empty()) continue;
+        int msgs = (int)(mine.size() + 3) / 4;
+        for (int m = 0; m < msgs; m++) {
+            int len = snprintf(body, sizeof(body), "%sGSV,%d,%d,%02d", TALKERS[s], msgs, m + 1, (int)mine.size());
+            for (int k = m * 4; k < m * 4 + 4 && k < (int)mine.size(); k++) {
+                const Sat* sat = mine[k];
+                len += snprintf(body + len, sizeof(body) - len, ",%02d,%02d,%03d,%02d", sat->prn,
+                                (int)sat->elev, (int)sat->az, t.fix ? sat->snr : 0);
+            }
+            snprintf(body + len, sizeof(body) - len, ",1");     // Signal ID (L1)
+            out.push_back(sentence(body));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Faults
+
+struct Faults {
+    double badChecksum, truncate, overrun, noise;
+    unsigned long nBadChecksum, nTruncated, nOverrun, nNoise, bytesDropped;
+};
+
+// Emits one sentence into the stream with the configured faults applied
+static void emit(std::string s, Faults& f, Rng& rng, std::string& stream, size_t& dropPending) {
+    if (rng.chance(f.noise)) {
+        int n = rng.range(1, 24);
+        for (int i = 0; i < n; i++) stream += (char)rng.range(1, 255);
+        f.nNoise++;
+    }
+    if (rng.chance(f.badChecksum)) {
+        // Flip one payload byte to another printable one; the checksum no longer matches
+        size_t star = s.find('*');
+        size_t pos = 1 + (size_t)rng.range(0, (int)star - 2);
+        char c;
+        do {
+            c = (char)rng.range('0', '9');
+        } while (c == s[pos]);
+        s[pos] = c;
+        f.nBadChecksum++;
+    }
+    if (rng.chance(f.truncate)) {
+        // Half lose the line ending too, so the next sentence runs into them
+        size_t keep = (size_t)rng.range(1, (int)s.size() - 3);
+        s = s.substr(0, keep) + (rng.chance(0.5) ? "\r\n" : "");
+        f.nTruncated++;
+    }
+
+    for (size_t i = 0; i < s.size(); i++) {
+        if (dropPending) {
+            dropPending--;
+            f.bytesDropped++;
+            continue;
+        }
+        stream += s[i];
+    }
+    if (rng.chance(f.overrun)) {
+        dropPending += (size_t)rng.range(16, 255);
+        f.nOverrun++;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+struct Options {
+    const Scenario* sc;
+    int seconds, rate, sats;
+    uint64_t seed;
+    const char* truthPath;
+    bool report;            // Sizes and fault counts on stderr
+    Faults faults;
+};
+
+static void generate(const Options& o, std::string& stream, FILE* truth) {
+    Rng rng(o.seed), faultRng(o.seed ^ 0xA5A5A5A5ULL);
+    Faults f = o.faults;
+    size_t dropPending = 0;
+    std::vector<Sat> sky = makeSky(o.sats, rng);
+    Truth t;
+    memset(&t, 0, sizeof(t));
+    o.sc->start(t);
+
+    double dt = 1.0 / o.rate;
+    double noiseN = 0, noiseE = 0;
+    int epochs = o.seconds * o.rate;
+    if (truth) fprintf(truth, "utc,t_ms,lat,lon,speed_kmh,course_deg,fix\n");
+
+    for (int e = 0; e <= epochs; e++) {
+        double tS = e * dt;
+        if (e > 0) o.sc->step(t, tS, dt, rng);
+
+        // 1) Receiver noise: first-order Gauss-Markov so it wanders like real fixes
+        double sigma = t.noiseM * t.hdop;
+        noiseN = 0.9 * noiseN + sigma * 0.436 * rng.gauss();
+        noiseE = 0.9 * noiseE + sigma * 0.436 * rng.gauss();
+        double lat = t.lat + noiseN / (EARTH_RADIUS_M * DEG);
+        double lon = wrapLon(t.lon + noiseE / (EARTH_RADIUS_M * DEG * cos(t.lat * DEG)));
+        double speed = std::max(0.0, t.speedKmh + rng.gauss() * 0.3);
+
+        // 2) Sky drifts a little per epoch
+        int satsUsed = 0;
+        for (size_t i = 0; i < sky.size(); i++) {
+            sky[i].az = fmod(sky[i].az + 0.004 * dt * 360.0 / 60.0 + 360.0, 360.0);
+            satsUsed += sky[i].elev >= 10;
+        }
+
+        std::vector<std::string> lines;
+        epochSentences(tS, t, lat, lon, speed, t.fix ? std::min(satsUsed, 99) : 0, lines);
+        if (e % o.rate == 0) skySentences(sky, t, lines);
+        for (size_t i = 0; i < lines.size(); i++) emit(lines[i], f, faultRng, stream, dropPending);
+
+        if (truth) {
+            char utc[16];
+            formatUtc(tS, utc, sizeof(utc));
+            fprintf(truth, "%s,%ld,%.8f,%.8f,%.3f,%.2f,%d\n", utc, (long)llround(tS * 1000), t.lat, t.lon,
+                    t.speedKmh, t.courseDeg, t.fix ? 1 : 0);
+        }
+    }
+
+    if (!o.report) return;
+    fprintf(stderr, "nmeagen: %s %d s at %d Hz, %d sats: %lu bytes\n", o.sc->name, o.seconds, o.rate, o.sats,
+            (unsigned long)stream.size());
+    fprintf(stderr, "nmeagen: faults: %lu bad checksum, %lu truncated, %lu overrun (%lu bytes), %lu noise\n",
+            f.nBadChecksum, f.nTruncated, f.nOverrun, f.bytesDropped, f.nNoise);
+}
+
+// ---------------------------------------------------------------------------
+
+static bool checksumOk(const std::string& line) {
+    size_t star = line.find('*');
+    if (line.empty() || line[0] != '$' || star == std::string::npos || star + 3 > line.size()) return false;
+    uint8_t sum = 0;
+    for (size_t i = 1; i < star; i++) sum ^= (uint8_t)line[i];
+    return strtoul(line.substr(star + 1, 2).c_str(), nullptr, 16) == sum;
+}
+
+static std::vector<std::string> splitLines(const std::string& stream) {
+    std::vector<std::string> lines;
+    std::string cur;
+    for (size_t i = 0; i < stream.size(); i++) {
+        char c = stream[i];
+        if (c == '\r' || c == '\n') {
+            if (!cur.empty()) lines.push_back(cur);
+            cur.clear();
+        }
+        else cur += c;
+    }
+    if (!cur.empty()) lines.push_back(cur);
+    return lines;
+}
+
+static int selfTest() {
+    int failures = 0;
+#define CHECK(cond, what) do { if (!(cond)) { fprintf(stderr, "FAIL: %s\n", what); failures++; } } while (0)
+
+    // 1) Coordinate and time formatting, including the 59.999995' rounding edge
+    char buf[32];
+    formatCoord(47.5, 2, buf, sizeof(buf));
+    CHECK(strcmp(buf, "4730.00000") == 0, "lat 47.5");
+    formatCoord(-8.0 - 59.999999 / 60.0, 3, buf, sizeof(buf));
+    CHECK(strcmp(buf, "00900.00000") == 0, "lon minute rollover");
+    formatCoord(179.99999999, 3, buf, sizeof(buf));
+    CHECK(strcmp(buf, "18000.00000") == 0, "lon 180");
+    formatUtc(3661.25, buf, sizeof(buf));
+    CHECK(strcmp(buf, "130101.25") == 0, "utc");
+    CHECK(sentence("GPGGA,,,,,,0,00,,,,,,,") == "$GPGGA,,,,,,0,00,,,,,,,*66\r\n", "checksum");
+
+    // 2) Clean streams: every line checksums, every scenario covers its edge
+    Options o;
+    memset(&o, 0, sizeof(o));
+    o.seed = 1;
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        o.sc = &SCENARIOS[s];
+        o.seconds = o.sc->seconds;
+        o.rate = o.sc->rate;
+        o.sats = o.sc->sats;
+        std::string stream;
+        generate(o, stream, nullptr);
+        std::vector<std::string> lines = splitLines(stream);
+        size_t bad = 0, gga = 0, gsv = 0;
+        bool north = false, south = false, east = false, west = false;
+        for (size_t i = 0; i < lines.size(); i++) {
+            bad += !checksumOk(lines[i]);
+            if (lines[i].compare(0, 6, "$GNGGA") == 0) {
+                gga++;
+                north |= lines[i].find(",N,") != std::string::npos;
+                south |= lines[i].find(",S,") != std::string::npos;
+                east |= lines[i].find(",E,") != std::string::npos;
+                west |= lines[i].find(",W,") != std::string::npos;
+            }
+            gsv += lines[i].find("GSV,") == 3;
+            CHECK(lines[i].size() <= 82, "sentence longer than 82 characters");
+        }
+        CHECK(bad == 0, o.sc->name);
+        CHECK(gga == (size_t)(o.seconds * o.rate + 1), "one GGA per epoch");
+        CHECK(gsv > 0, "GSV present");
+        if (!strcmp(o.sc->name, "equator")) CHECK(north && south && east && west, "equator crosses both axes");
+        if (!strcmp(o.sc->name, "dateline")) CHECK(east && west, "dateline crosses 180");
+    }
+
+    // 3) Faults: bad checksums are detectable, overruns drop bytes, and the
+    //    clean lines that survive still checksum
+    o.sc = &SCENARIOS[0];
+    o.seconds = 120;
+    o.rate = 1;
+    o.sats = 14;
+    o.faults.badChecksum = 0.05;
+    o.faults.truncate = 0.05;
+    o.faults.overrun = 0.02;
+    o.faults.noise = 0.02;
+    std::string clean, faulty;
+    Options c = o;
+    memset(&c.faults, 0, sizeof(c.faults));
+    generate(c, clean, nullptr);
+    generate(o, faulty, nullptr);
+    std::vector<std::string> cl = splitLines(clean), fl = splitLines(faulty);
+    size_t good = 0;
+    for (size_t i = 0; i < fl.size(); i++) good += checksumOk(fl[i]);
+    CHECK(faulty.size() < clean.size(), "faults shrink the stream");
+    CHECK(good < cl.size() && good > cl.size() * 3 / 4, "most lines survive");
+
+    // 4) Same seed, same stream
+    std::string again;
+    generate(o, again, nullptr);
+    CHECK(again == faulty, "repeatable");
+
+    if (failures) {
+        fprintf(stderr, "nmeagen selftest: %d failure(s)\n", failures);
+        return 1;
+    }
+    fprintf(stderr, "nmeagen selftest: ok\n");
+    return 0;
+#undef CHECK
+}
+
+static void usage() {
+    fprintf(stderr, "usage: nmeagen SCENARIO [--seconds N] [--rate HZ] [--sats N] [--seed N] [--truth FILE]\n"
+                    "                        [--bad-checksum P] [--truncate P] [--overrun P] [--noise P]\n"
+                    "       nmeagen --list | --selftest\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    if (!strcmp(argv[1], "--selftest")) return selfTest();
+    if (!strcmp(argv[1], "--list")) {
+        for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+            printf("%-10s %4d s %2d Hz %2d sats  %s\n", SCENARIOS[s].name, SCENARIOS[s].seconds, SCENARIOS[s].rate,
+                   SCENARIOS[s].sats, SCENARIOS[s].help);
+        }
+        return 0;
+    }
+
+    Options o;
+    memset(&o, 0, sizeof(o));
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        if (!strcmp(argv[1], SCENARIOS[s].name)) o.sc = &SCENARIOS[s];
+    }
+    if (!o.sc) {
+        fprintf(stderr, "nmeagen: unknown scenario '%s' (see --list)\n", argv[1]);
+        return 2;
+    }
+    o.seconds = o.sc->seconds;
+    o.rate = o.sc->rate;
+    o.sats = o.sc->sats;
+    o.seed = 1;
+    o.report = true;
+
+    for (int i = 2; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) {
+            usage();
+            return 2;
+        }
+        if (!strcmp(a, "--seconds")) o.seconds = atoi(v);
+        else if (!strcmp(a, "--rate")) o.rate = atoi(v);
+        else if (!strcmp(a, "--sats")) o.sats = atoi(v);
+        else if (!strcmp(a, "--seed")) o.seed = strtoull(v, nullptr, 0);
+        else if (!strcmp(a, "--truth")) o.truthPath = v;
+        else if (!strcmp(a, "--bad-checksum")) o.faults.badChecksum = atof(v);
+        else if (!strcmp(a, "--truncate")) o.faults.truncate = atof(v);
+        else if (!strcmp(a, "--overrun")) o.faults.overrun = atof(v);
+        else if (!strcmp(a, "--noise")) o.faults.noise = atof(v);
+        else {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+    if (o.seconds < 1 || o.rate < 1 || o.rate > 20 || o.sats < 0 || o.sats > 64) {
+        fprintf(stderr, "nmeagen: --seconds >= 1, --rate 1..20, --sats 0..64\n");
+        return 2;
+    }
+
+    FILE* truth = nullptr;
+    if (o.truthPath && !(truth = fopen(o.truthPath, "w"))) {
+        perror(o.truthPath);
+        return 1;
+    }
+    std::string stream;
+    generate(o, stream, truth);
+    if (truth) fclose(truth);
+    return fwrite(stream.data(), 1, stream.size(), stdout) == stream.size() ? 0 : 1;
+}
@@ -0,0 +1,613 @@
+// Host replay of NMEA streams through the tracker's GNSS ingest path.
+//
+// Build (from tools/):
+//   H="../.pio/libdeps/heltec_wifi_lora_32_V3/Heltec ESP32 Dev-Boards/src"
+//   g++ -std=gnu++11 -O2 -DHOST_HARNESS -DHELTEC_BOARD=1 -DSLOW_CLK_TPYE=0
+//       -Ihost -I../src -I"$H" -I"$H/radio" -o nmeareplay nmeareplay.cpp "$H/HT_st7735_fonts.cpp"
+//
+//   nmeareplay STREAM [--truth FILE] [--repeat N] [--chunk BYTES]
+//
+// STREAM is raw NMEA, from a capture or from nmeagen; TRUTH is the CSV that
+// nmeagen --truth writes. Three passes over the firmware (src/main.h) built
+// against the stand-ins in host/:
+//
+//  1) Accuracy: the stream is fed through Serial1 and drainNMEA() sentence by
+//     sentence, with the virtual clock set from each GGA's and RMC's UTC field, so
+//     calculateSpeed() sees receiver time. After every position update the
+//     published NavSnapshot is compared with the truth row of the same UTC:
+//     position error, speed error once speed is valid, and the distance and
+//     bearing to home the navigation screen would show against the exact
+//     values from the true track. Positions off by more than
+//     REPLAY_OUTLIER_M are counted as outliers; with a clean stream there
+//     are none, with injected faults they are corrupted sentences the
+//     ingest accepted.
+//     Each position also goes to the track log, as the track task would,
+//     and to the trip computer, whose totals are set against the truth's:
+//     distance along the true track, time spent moving and top speed.
+//  2) TracBack (with TRUTH): the log is turned into the TracBack route, then
+//     the true track is walked backwards through serviceRoute(), a fix per
+//     truth row. Reports how far the walk strays from the route, the legs
+//     the follower advanced or skipped and whether it reached the start, and
+//     checks every nearestLeg() answer against nearestLegScan().
+//  3) Geofence (with TRUTH): keep-in and keep-out circles and polygons are
+//     laid across the true track, with distractors kilometres away, written
+//     to the zone file and loaded as the firmware would. The track is walked
+//     forwards through Geofence::update() and every zone's state is checked
+//     against a full double-precision test of every zone and edge: a zone
+//     may only change state once the fix is ZONE_HYSTERESIS_M past its edge,
+//     and must have by the time it is that far past. Reports zones and edges
+//     tested per fix against the full test's count, and the time per fix.
+//  4) Throughput: the whole stream is pushed through drainNMEA() REPEAT
+//     times in CHUNK-byte reads (the UART FIFO size by default) and timed
+//     with the host clock. Absolute numbers are host numbers; compare runs
+//     on the same machine, and use the on-target microbenchmarks for cycles.
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "main.h"
+
+#define REPLAY_OUTLIER_M    100.0
+#define REPLAY_CHUNK        128         // ESP32 UART RX FIFO
+#define REPLAY_REPEAT       20
+#define REPLAY_T0_MS        1000        // millis() 0 means "not started" to calculateSpeed()
+
+static HTITTracker tracker;
+
+struct TruthRow {
+    uint32_t tMs;
+    double lat, lon, speedKmh, courseDeg;
+    bool fix;
+};
+
+struct ErrorStats {
+    std::vector<double> v;
+    void add(double e) { v.push_back(e); }
+    void print(const char* name, const char* unit) {
+        if (v.empty()) {
+            printf("  %-16s n=0\n", name);
+            return;
+        }
+        std::sort(v.begin(), v.end());
+        double sum = 0;
+        for (size_t i = 0; i < v.size(); i++) sum += v[i];
+        printf("  %-16s n=%-6lu mean=%.3f p50=%.3f p95=%.3f max=%.3f %s\n", name, (unsigned long)v.size(),
+               sum / v.size(), v[v.size() / 2], v[v.size() * 95 / 100], v.back(), unit);
+    }
+};
+
+static double haversineM(double lat1, double lon1, double lat2, double lon2) {
+    double p1 = lat1 * PI / 180.0, p2 = lat2 * PI / 180.0;
+    double dp = p2 - p1, dl = (lon2 - lon1) * PI / 180.0;
+    double a = sin(dp / 2) * sin(dp / 2) + cos(p1) * cos(p2) * sin(dl / 2) * sin(dl / 2);
+    return 6371000.0 * 2 * atan2(sqrt(a), sqrt(1 - a));
+}
+
+static double bearingDeg(double lat1, double lon1, double lat2, double lon2) {
+    double p1 = lat1 * PI / 180.0, p2 = lat2 * PI / 180.0, dl = (lon2 - lon1) * PI / 180.0;
+    double b = atan2(sin(dl) * cos(p2), cos(p1) * sin(p2) - sin(p1) * cos(p2) * cos(dl)) * 180.0 / PI;
+    return fmod(b + 360.0, 360.0);
+}
+
+static double angleDiff(double a, double b) {
+    double d = fabs(fmod(a - b + 540.0, 360.0) - 180.0);
+    return d;
+}
+
+static bool readFile(const char* path, std::string& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    fclose(f);
+    return true;
+}
+
+static bool loadTruth(const char* path, std::map<std::string, TruthRow>& rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char utc[16];
+        unsigned long tMs;
+        int fix;
+        TruthRow r;
+        if (sscanf(line, "%15[^,],%lu,%lf,%lf,%lf,%lf,%d", utc, &tMs, &r.lat, &r.lon, &r.speedKmh, &r.courseDeg,
+                   &fix) != 7) {
+            continue;   // Header
+        }
+        r.tMs = (uint32_t)tMs;
+        r.fix = fix != 0;
+        rows[utc] = r;
+    }
+    fclose(f);
+    return true;
+}
+
+// UTC field of an intact "$xxGGA,hhmmss.ss," or "$xxRMC,..." sentence, empty
+// for anything else (a corrupted time must not drag the clock along)
+static std::string epochUtc(const std::string& s) {
+    if (s.size() < 7 || s[0] != '$' || (s.compare(3, 4, "GGA,") != 0 && s.compare(3, 4, "RMC,") != 0)) {
+        return std::string();
+    }
+    size_t star = s.find('*');
+    if (star == std::string::npos || star + 3 > s.size()) return std::string();
+    uint8_t sum = 0;
+    for (size_t i = 1; i < star; i++) sum ^= (uint8_t)s[i];
+    if (strtoul(s.substr(star + 1, 2).c_str(), nullptr, 16) != sum) return std::string();
+    size_t end = s.find(',', 7);
+    if (end == std::string::npos || end - 7 < 6) return std::string();
+    return s.substr(7, end - 7);
+}
+
+static uint32_t utcMs(const std::string& utc) {
+    int hh = atoi(utc.substr(0, 2).c_str()), mm = atoi(utc.substr(2, 2).c_str());
+    double ss = atof(utc.c_str() + 4);
+    return (uint32_t)llround(((hh * 60 + mm) * 60 + ss) * 1000.0);
+}
+
+class HostHarness {
+private:
+    HTITTracker& t;
+
+public:
+    explicit HostHarness(HTITTracker& tracker) : t(tracker) {}
+
+    void reset() {
+        t.gnss.reset();
+        t.hasValidPosition = false;
+        t.homeEstablished = false;
+        t.lastSpeedTime = 0;
+        t.hasValidSpeed = false;
+        t.hasValidCourse = false;
+        t.hasValidAltitude = false;
+        t.trip.reset();
+        t.trackLog.begin();            // A new session in the log
+    }
+
+    void drain() { t.drainNMEA(); }
+    void logTrack(const NavSnapshot& snap) {
+        t.trackLog.record(snap, millis());
+        t.trip.update(snap);
+    }
+    const TripComputer& trip() const { return t.trip; }
+
+    // Select TracBack and run the route task until the log is read
+    bool startTracBack(unsigned long& passes) {
+        t.routeNav.stop();
+        if (!t.tracBack.begin(t.trackLog)) return false;
+        t.tracBackActive = true;
+        for (passes = 0; t.tracBack.isBuilding(); passes++) t.serviceRoute();
+        return true;
+    }
+
+    // A fix at (lat, lon) as the ingest side would publish it, then a route task pass
+    void moveTo(double lat, double lon) {
+        t.currentLat = lat;
+        t.currentLon = lon;
+        t.hasValidPosition = true;
+        t.haveFix = true;
+        t.lastFixMillis = millis();
+        t.publishNavSnapshot();
+        t.serviceRoute();
+    }
+
+    TracBack& tracBack() { return t.tracBack; }
+    RouteFollower& follower() { return t.routeNav; }
+
+    // What the navigation screen would show for this snapshot
+    void homeVector(const NavSnapshot& snap, float& distM, float& bearing) {
+        t.nav = snap;
+        distM = t.calculateDistanceToHome();
+        bearing = t.calculateBearingToHome();
+    }
+};
+
+static void accuracyPass(HostHarness& h, const std::string& stream, const std::map<std::string, TruthRow>& truth) {
+    ErrorStats posErr, speedErr, homeDistErr, homeBearErr;
+    unsigned long sentences = 0, updates = 0, matched = 0, outliers = 0;
+    uint32_t base = 0;
+    bool haveBase = false, haveHome = false;
+    double homeLat = 0, homeLon = 0;
+    uint32_t lastFix = 0;
+
+    h.reset();
+    hostMicros() = (uint64_t)REPLAY_T0_MS * 1000;
+
+    // Split in front of every '$' so each feed holds one sentence (plus any
+    // noise that came before the next one)
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        size_t next = stream.find('$', pos + 1);
+        if (next == std::string::npos) next = stream.size();
+        std::string seg = stream.substr(pos, next - pos);
+        pos = next;
+        sentences++;
+
+        // 1) Move the clock to the receiver's time of this epoch
+        std::string utc = epochUtc(seg);
+        if (!utc.empty()) {
+            uint32_t ms = utcMs(utc);
+            if (!haveBase) {
+                base = ms;
+                haveBase = true;
+            }
+            uint64_t at = (uint64_t)(REPLAY_T0_MS + (ms - base)) * 1000;
+            if (at > hostMicros()) hostMicros() = at;
+        }
+
+        Serial1.hostFeed(seg.data(), seg.size());
+        h.drain();
+
+        // 2) Score each new position against the truth of the same epoch
+        NavSnapshot snap;
+        tracker.getNavSnapshot(snap);
+        if (!snap.hasPosition || snap.fixMillis == lastFix) continue;
+        lastFix = snap.fixMillis;
+        updates++;
+        h.logTrack(snap);
+        std::map<std::string, TruthRow>::const_iterator it = truth.find(utc);
+        if (utc.empty() || it == truth.end()) continue;
+        const TruthRow& r = it->second;
+        matched++;
+
+        if (!haveHome && snap.homeEstablished) {
+            homeLat = r.lat;
+            homeLon = r.lon;
+            haveHome = true;
+        }
+        double e = haversineM(snap.lat, snap.lon, r.lat, r.lon);
+        if (e > REPLAY_OUTLIER_M) {
+            outliers++;
+            continue;
+        }
+        posErr.add(e);
+        if (snap.hasSpeed) speedErr.add(fabs(snap.speedKmh - r.speedKmh));
+        if (haveHome) {
+            float distM, bearing;
+            h.homeVector(snap, distM, bearing);
+            double trueDist = haversineM(r.lat, r.lon, homeLat, homeLon);
+            homeDistErr.add(fabs(distM - trueDist));
+            if (trueDist > 50.0) homeBearErr.add(angleDiff(bearing, bearingDeg(r.lat, r.lon, homeLat, homeLon)));
+        }
+    }
+
+    printf("accuracy: %lu sentences, %lu position updates, %lu matched to truth, %lu outliers (> %.0f m)\n",
+           sentences, updates, matched, outliers, REPLAY_OUTLIER_M);
+    if (truth.empty()) return;
+    posErr.print("position", "m");
+    speedErr.print("speed", "km/h");
+    homeDistErr.print("home distance", "m");
+    homeBearErr.print("home bearing", "deg");
+
+    // Trip totals against the true track
+    std::vector<TruthRow> rows;
+    for (std::map<std::string, TruthRow>::const_iterator it = truth.begin(); it != truth.end(); ++it) {
+        if (it->second.fix) rows.push_back(it->second);
+    }
+    std::sort(rows.begin(), rows.end(), [](const TruthRow& a, const TruthRow& b) { return a.tMs < b.tMs; });
+    double trueDist = 0, trueMax = 0;
+    uint32_t trueMovingMs = 0;
+    for (size_t i = 1; i < rows.size(); i++) {
+        if (rows[i].tMs - rows[i - 1].tMs > TRIP_MAX_GAP_MS) continue;   // Nor does the trip bridge a lost fix
+        trueDist += haversineM(rows[i - 1].lat, rows[i - 1].lon, rows[i].lat, rows[i].lon);
+        if (rows[i].speedKmh > 0) trueMovingMs += rows[i].tMs - rows[i - 1].tMs;
+        trueMax = std::max(trueMax, rows[i].speedKmh);
+    }
+    const TripComputer& trip = h.trip();
+    printf("  trip: %.3f km (true %.3f, %+.1f%%), moving %lu s (true %lu), stopped %lu s, avg %.1f km/h, "
+           "max %.1f km/h (true %.1f), up %.0f m, down %.0f m\n", trip.distanceM() / 1000.0, trueDist / 1000.0,
+           trueDist > 0 ? (trip.distanceM() - trueDist) * 100.0 / trueDist : 0.0,
+           (unsigned long)(trip.movingMs() / 1000), (unsigned long)(trueMovingMs / 1000),
+           (unsigned long)(trip.stoppedMs() / 1000), trip.avgKmh(), trip.maxKmh(), trueMax, trip.ascentM(),
+           trip.descentM());
+}
+
+// Nearest leg by looking at every one, in metres around the query
+static int tracBackPass(HostHarness& h, const std::map<std::string, TruthRow>& truth) {
+    // 1) The log as a route
+    unsigned long passes = 0;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    if (!h.startTracBack(passes)) {
+        printf("tracback: no track log\n");
+        return 0;
+    }
+    double buildS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    TracBack& tb = h.tracBack();
+    RouteFollower& f = h.follower();
+    printf("tracback: %lu log points -> %lu route points at %ld m, index %ux%u cells / %u entries, "
+           "%lu route task passes, %.2f ms\n", (unsigned long)tb.decoded, (unsigned long)tb.size(),
+           (long)tb.tolerance(), tb.indexDim(), tb.indexDim(), tb.indexEntries(), passes, buildS * 1e3);
+    if (tb.size() < 2) return 0;
+
+    // 2) Walk the truth backwards, a fix per row
+    std::vector<TruthRow> rows;
+    for (std::map<std::string, TruthRow>::const_iterator it = truth.begin(); it != truth.end(); ++it) {
+        if (it->second.fix) rows.push_back(it->second);
+    }
+    std::sort(rows.begin(), rows.end(), [](const TruthRow& a, const TruthRow& b) { return a.tMs > b.tMs; });
+    ErrorStats offset;
+    unsigned long skips = 0, mismatches = 0, queries = 0;
+    double queryS = 0;
+    uint32_t firstLeg = 0, lastLeg = 0;
+    bool started = false;
+    uint32_t probes0 = tb.probes;
+    for (size_t i = 0; i < rows.size(); i++) {
+        hostAdvanceMs(1000);
+        h.moveTo(rows[i].lat, rows[i].lon);
+        if (!started) {
+            firstLeg = lastLeg = f.getLeg();
+            started = true;
+        }
+        if (f.getLeg() > lastLeg + 1) skips++;
+        lastLeg = f.getLeg();
+
+        uint32_t leg;
+        float dist;
+        std::chrono::steady_clock::time_point q0 = std::chrono::steady_clock::now();
+        bool found = tb.nearestLeg(rows[i].lat, rows[i].lon, leg, dist);
+        queryS += std::chrono::duration<double>(std::chrono::steady_clock::now() - q0).count();
+        queries++;
+        if (!found) continue;
+        offset.add(dist);
+        uint32_t scanLeg = 0;
+        float scanDist = 0;
+        tb.nearestLegScan(rows[i].lat, rows[i].lon, scanLeg, scanDist);
+        if (scanLeg != leg || scanDist != dist) {
+            if (mismatches++ < 5) {
+                fprintf(stderr, "  nearest leg: grid %lu at %.1f m, scan %lu at %.1f m\n", (unsigned long)leg, dist,
+                        (unsigned long)scanLeg, scanDist);
+            }
+        }
+    }
+    printf("  walked back %lu fixes: joined at leg %lu, %s at leg %lu/%lu, %lu skip(s) ahead\n",
+           (unsigned long)rows.size(), (unsigned long)firstLeg + 1, f.isFinished() ? "finished" : "stopped",
+           (unsigned long)std::min(f.getLeg() + 1, f.getTotal()), (unsigned long)f.getTotal(), skips);
+    offset.print("route offset", "m");
+    printf("  nearest leg: %.1f segments/query, %.0f ns/query, %lu disagreement(s) with a full scan\n",
+           queries ? (double)(tb.probes - probes0) / queries : 0.0, queries ? queryS * 1e9 / queries : 0.0,
+           mismatches);
+    return mismatches ? 1 : 0;
+}
+
+// One synthetic zone: its header and points, and the same in metres for the reference
+struct ReplayZone {
+    ZoneHeader h;
+    std::vector<RoutePoint> pts;
+    double lat0, lon0, mPerLon;        // Reference frame: metres east / north of the first point
+    std::vector<double> x, y;
+};
+
+static void replayToLocal(const ReplayZone& z, double lat, double lon, double& x, double& y) {
+    double dLon = lon - z.lon0;
+    if (dLon > 180.0) dLon -= 360.0;
+    if (dLon < -180.0) dLon += 360.0;
+    x = dLon * z.mPerLon;
+    y = (lat - z.lat0) * ZONE_M_PER_E7 * 1e7;
+}
+
+// A zone centred dNorth / dEast metres from (lat, lon): a circle, or a star
+// polygon with 'points' vertices whose radius alternates with 0.6 of it
+static ReplayZone replayZone(const char* name, uint8_t shape, uint8_t rule, double lat, double lon, double dNorth,
+                             double dEast, double radiusM, uint16_t points) {
+    ReplayZone z;
+    memset(&z.h, 0, sizeof(z.h));
+    z.h.shape = shape;
+    z.h.rule = rule;
+    z.h.points = shape == ZONE_SHAPE_CIRCLE ? 1 : points;
+    z.h.radiusM = shape == ZONE_SHAPE_CIRCLE ? (uint32_t)radiusM : 0;
+    strncpy(z.h.name, name, sizeof(z.h.name) - 1);
+    double mPerLat = ZONE_M_PER_E7 * 1e7, mPerLon = mPerLat * cos(lat * PI / 180.0);
+    for (uint16_t k = 0; k < z.h.points; k++) {
+        double a = 2.0 * PI * k / z.h.points, r = (k & 1) ? radiusM * 0.6 : radiusM;
+        double n = dNorth + (shape == ZONE_SHAPE_CIRCLE ? 0.0 : r * cos(a));
+        double e = dEast + (shape == ZONE_SHAPE_CIRCLE ? 0.0 : r * sin(a));
+        double pLon = lon + e / mPerLon;
+        if (pLon > 180.0) pLon -= 360.0;
+        if (pLon < -180.0) pLon += 360.0;
+        RoutePoint pt;
+        memset(&pt, 0, sizeof(pt));
+        pt.latE7 = (int32_t)lround((lat + n / mPerLat) * 1e7);
+        pt.lonE7 = (int32_t)lround(pLon * 1e7);
+        z.pts.push_back(pt);
+    }
+    z.lat0 = z.pts[0].latE7 / 1e7;
+    z.lon0 = z.pts[0].lonE7 / 1e7;
+    z.mPerLon = mPerLat * cos(z.lat0 * PI / 180.0);
+    for (size_t k = 0; k < z.pts.size(); k++) {
+        double x, y;
+        replayToLocal(z, z.pts[k].latE7 / 1e7, z.pts[k].lonE7 / 1e7, x, y);
+        z.x.push_back(x);
+        z.y.push_back(y);
+    }
+    return z;
+}
+
+// Signed distance from a position to the zone's edge, metres: negative inside
+static double replayEdgeDist(const ReplayZone& z, double lat, double lon, unsigned long& edges) {
+    double px, py;
+    replayToLocal(z, lat, lon, px, py);
+    if (z.h.shape == ZONE_SHAPE_CIRCLE) {
+        edges++;
+        return sqrt(px * px + py * py) - z.h.radiusM;
+    }
+    bool in = false;
+    double best = 1e300;
+    size_t n = z.x.size();
+    for (size_t a = 0; a < n; a++) {
+        size_t b = (a + 1) % n;
+        edges++;
+        if ((z.y[a] > py) != (z.y[b] > py) &&
+            px < z.x[a] + (z.x[b] - z.x[a]) * (py - z.y[a]) / (z.y[b] - z.y[a])) {
+            in = !in;
+        }
+        double abx = z.x[b] - z.x[a], aby = z.y[b] - z.y[a];
+        double len2 = abx * abx + aby * aby;
+        double t = len2 > 0 ? ((px - z.x[a]) * abx + (py - z.y[a]) * aby) / len2 : 0.0;
+        t = t < 0 ? 0 : (t > 1 ? 1 : t);
+        double dx = z.x[a] + t * abx - px, dy = z.y[a] + t * aby - py;
+        best = std::min(best, dx * dx + dy * dy);
+    }
+    return in ? -sqrt(best) : sqrt(best);
+}
+
+static int geofencePass(const std::map<std::string, TruthRow>& truth) {
+    std::vector<TruthRow> rows;
+    for (std::map<std::string, TruthRow>::const_iterator it = truth.begin(); it != truth.end(); ++it) {
+        if (it->second.fix) rows.push_back(it->second);
+    }
+    std::sort(rows.begin(), rows.end(), [](const TruthRow& a, const TruthRow& b) { return a.tMs < b.tMs; });
+    if (rows.size() < 8) return 0;
+
+    // 1) Zones on the track, then distractors kilometres off it, up to ZONE_MAX_ZONES
+    std::vector<ReplayZone> zones;
+    const TruthRow& s = rows[0];
+    for (int k = 1; k <= 6; k++) {
+        const TruthRow& r = rows[rows.size() * k / 7];
+        char name[16];
+        snprintf(name, sizeof(name), "Track %d", k);
+        uint8_t rule = (k & 1) ? ZONE_RULE_KEEP_OUT : ZONE_RULE_KEEP_IN;
+        if (k <= 2) zones.push_back(replayZone(name, ZONE_SHAPE_CIRCLE, rule, r.lat, r.lon, 10.0, -20.0, 60.0 * k, 0));
+        else zones.push_back(replayZone(name, ZONE_SHAPE_POLYGON, rule, r.lat, r.lon, 30.0, 40.0, 60.0 * k, 4 * k));
+    }
+    int onTrack = (int)zones.size();
+    for (int k = 0; (int)zones.size() < ZONE_MAX_ZONES; k++) {
+        char name[16];
+        snprintf(name, sizeof(name), "Far %d", k);
+        double a = k * 2.0 * PI / (ZONE_MAX_ZONES - onTrack), d = 5000.0 + 3000.0 * k;
+        zones.push_back(replayZone(name, (k & 1) ? ZONE_SHAPE_CIRCLE : ZONE_SHAPE_POLYGON,
+                                   (k & 2) ? ZONE_RULE_KEEP_IN : ZONE_RULE_KEEP_OUT, s.lat, s.lon, d * cos(a),
+                                   d * sin(a), 400.0, 30));
+    }
+
+    // 2) The zone file as an upload leaves it, then load it as the firmware does
+    File file = LittleFS.open(ZONE_PATH, FILE_WRITE);
+    uint8_t raw[ROUTE_RECORD_BYTES];
+    uint32_t crc = 0, records = 0;
+    for (size_t i = 0; i < zones.size(); i++) {
+        RoutePoint hdr;
+        zoneHeaderToPoint(zones[i].h, hdr);
+        routePackPoint(hdr, raw);
+        crc = esp_rom_crc32_le(crc, raw, sizeof(raw));
+        file.write(raw, sizeof(raw));
+        for (size_t k = 0; k < zones[i].pts.size(); k++) {
+            routePackPoint(zones[i].pts[k], raw);
+            crc = esp_rom_crc32_le(crc, raw, sizeof(raw));
+            file.write(raw, sizeof(raw));
+        }
+        records += 1 + zones[i].pts.size();
+    }
+    RouteStore::makeIndex(raw, records, crc);
+    file.write(raw, sizeof(raw));
+    file.close();
+    static Geofence g;
+    uint8_t loaded = g.load();
+    printf("geofence: %u of %lu zones loaded (%d on the track), %lu records\n", loaded, (unsigned long)zones.size(),
+           onTrack, (unsigned long)records);
+    if (loaded != zones.size()) return 1;
+
+    // 3) Walk the track; check each zone's state against the reference
+    const double h = ZONE_HYSTERESIS_M, slack = 0.5;     // Slack: the decimetre frame's rounding
+    unsigned long events = 0, early = 0, late = 0, refEdges = 0;
+    double updateS = 0;
+    uint32_t zoneTests0 = g.zoneTests, edgeTests0 = g.edgeTests;
+    for (size_t i = 0; i < rows.size(); i++) {
+        ZoneEvent ev[ZONE_MAX_ZONES];
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        uint8_t n = g.update(rows[i].lat, rows[i].lon, ev, ZONE_MAX_ZONES);
+        updateS += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        events += n;
+        for (uint8_t z = 0; z < zones.size(); z++) {
+            double d = replayEdgeDist(zones[z], rows[i].lat, rows[i].lon, refEdges);
+            bool inside = g.zone(z).inside;
+            bool flipped = false;
+            for (uint8_t k = 0; k < n; k++) flipped = flipped || ev[k].zone == z;
+            // Inside only once h past the edge inwards, outside once h past it outwards
+            bool bad = false;
+            if (flipped && (inside ? d > -h + slack : d < h - slack)) {
+                bad = true;
+                early++;
+            } else if (inside ? d > h + slack : d < -h - slack) {
+                bad = true;
+                late++;
+            }
+            if (bad && early + late <= 5) {
+                fprintf(stderr, "  zone '%s' %s at %.1f m from its edge (fix %lu)\n", zones[z].h.name,
+                        inside ? "inside" : "outside", d, (unsigned long)i);
+            }
+        }
+    }
+    unsigned long fixes = rows.size();
+    printf("  %lu fixes, %lu event(s): %.2f zones and %.1f edges tested per fix (a full test: %lu zones, %.1f edges), "
+           "%lu near list rebuild(s), %.0f ns/fix\n", fixes, events, (double)(g.zoneTests - zoneTests0) / fixes,
+           (double)(g.edgeTests - edgeTests0) / fixes, (unsigned long)zones.size(), (double)refEdges / fixes,
+           (unsigned long)g.rebuilds, updateS * 1e9 / fixes);
+    printf("  %lu early change(s), %lu missed change(s) against the reference\n", early, late);
+    return early + late ? 1 : 0;
+}
+
+static void throughputPass(HostHarness& h, const std::string& stream, int repeat, size_t chunk) {
+    unsigned long lines = 0;
+    bool inLine = false;
+    for (size_t i = 0; i < stream.size(); i++) {
+        bool eol = stream[i] == '\r' || stream[i] == '\n';
+        if (eol && inLine) lines++;
+        inLine = !eol;
+    }
+
+    h.reset();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+            Serial1.hostFeed(stream.data() + pos, std::min(chunk, stream.size() - pos));
+            h.drain();
+        }
+        hostAdvanceMs(1000);
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    double bytes = (double)stream.size() * repeat, n = (double)lines * repeat;
+    printf("throughput: %d x %lu bytes, %lu lines in %.3f s: %.1f MB/s, %.0f lines/s, %.1f ns/byte, %.0f ns/line\n",
+           repeat, (unsigned long)stream.size(), lines, s, bytes / s / 1e6, n / s, s * 1e9 / bytes,
+           n > 0 ? s * 1e9 / n : 0.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: nmeareplay STREAM [--truth FILE] [--repeat N] [--chunk BYTES]\n");
+        return 2;
+    }
+    const char* truthPath = nullptr;
+    int repeat = REPLAY_REPEAT;
+    size_t chunk = REPLAY_CHUNK;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--truth")) truthPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--repeat")) repeat = std::max(1, atoi(argv[i + 1]));
+        else if (!strcmp(argv[i], "--chunk")) chunk = (size_t)std::max(1, atoi(argv[i + 1]));
+        else {
+            fprintf(stderr, "nmeareplay: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::string stream;
+    std::map<std::string, TruthRow> truth;
+    if (!readFile(argv[1], stream)) return 1;
+    if (truthPath && !loadTruth(truthPath, truth)) return 1;
+
+    HostHarness h(tracker);
+    accuracyPass(h, stream, truth);
+    int status = truth.empty() ? 0 : tracBackPass(h, truth);
+    if (!truth.empty()) status |= geofencePass(truth);
+    throughputPass(h, stream, repeat, chunk);
+    return status;
+}
@@ -0,0 +1,473 @@
+// Host-side route uploader for the tracker's bulk waypoint protocol.
+//
+// Build:  g++ -std=c++11 -O2 -I../src -o routeup routeup.cpp
+//
+//   routeup route.csv /dev/ttyUSB0   upload over the USB console (115200 8N1)
+//   routeup route.csv -              write the framed stream to stdout, e.g.
+//                                    to hand to a BLE tool that writes it to
+//                                    the upload characteristic
+//   routeup --zones zones.csv PORT   the same with geofence zones
+//   routeup --selftest               frames a route, mangles the stream and
+//                                    checks the parser recovers (exit status 1
+//                                    on error)
+//
+// route.csv holds one point per line: lat,lon[,name] in decimal degrees.
+// zones.csv holds one zone per line, a polygon's points on the lines after:
+//   keepout,circle,lat,lon,radius_m[,name]
+//   keepin,polygon[,name]
+//   lat,lon
+//   ...
+// Blank lines and lines starting with '#' are skipped.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include "routeframe.h"
+
+#define ACK_TIMEOUT_MS  2000
+#define MAX_RETRIES     10
+
+static uint32_t crc32(uint32_t crc, const uint8_t* p, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static uint32_t nowMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return (uint32_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+}
+
+static bool loadCsv(const char* path, std::vector<RoutePoint>& pts) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        double lat, lon;
+        char name[ROUTE_NAME_LEN + 1] = "";
+        int n = sscanf(line, "%lf,%lf,%24[^\r\n]", &lat, &lon, name);
+        if (n < 2 || lat < -90 || lat > 90 || lon < -180 || lon > 180) {
+            fprintf(stderr, "%s:%d: bad point\n", path, lineNo);
+            fclose(f);
+            return false;
+        }
+        RoutePoint pt;
+        memset(&pt, 0, sizeof(pt));
+        pt.latE7 = (int32_t)(lat * 1e7 + (lat < 0 ? -0.5 : 0.5));
+        pt.lonE7 = (int32_t)(lon * 1e7 + (lon < 0 ? -0.5 : 0.5));
+        memcpy(pt.name, name, ROUTE_NAME_LEN);
+        pts.push_back(pt);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool zoneRule(const char* word, uint8_t& rule) {
+    if (strcmp(word, "keepin") == 0) rule = ZONE_RULE_KEEP_IN;
+    else if (strcmp(word, "keepout") == 0) rule = ZONE_RULE_KEEP_OUT;
+    else return false;
+    return true;
+}
+
+static bool loadZonesCsv(const char* path, std::vector<RoutePoint>& recs) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    char line[256];
+    int lineNo = 0;
+    long polygon = -1;                  // Header record of the open polygon, -1 for none
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNo++;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        ZoneHeader h;
+        memset(&h, 0, sizeof(h));
+        char word[16], shape[16];
+        double lat, lon, radius;
+        RoutePoint pt;
+        memset(&pt, 0, sizeof(pt));
+        if (sscanf(line, "%15[a-z],%15[a-z]", word, shape) == 2) {
+            // A new zone closes the polygon before it
+            if (polygon >= 0 && recs.size() - polygon - 1 < 3) {
+                fprintf(stderr, "%s:%d: polygon needs 3 points\n", path, lineNo);
+                ok = false;
+                break;
+            }
+            polygon = -1;
+            ok = zoneRule(word, h.rule);
+            if (ok && strcmp(shape, "circle") == 0) {
+                ok = sscanf(line, "%*[a-z],%*[a-z],%lf,%lf,%lf,%23[^\r\n]", &lat, &lon, &radius, h.name) >= 3 &&
+                     radius >= 1 && radius <= 100000;
+                h.shape = ZONE_SHAPE_CIRCLE;
+                h.points = 1;
+                h.radiusM = (uint32_t)(radius + 0.5);
+            } else if (ok && strcmp(shape, "polygon") == 0) {
+                sscanf(line, "%*[a-z],%*[a-z],%23[^\r\n]", h.name);
+                h.shape = ZONE_SHAPE_POLYGON;
+                polygon = (long)recs.size();
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                fprintf(stderr, "%s:%d: bad zone\n", path, lineNo);
+                break;
+            }
+            zoneHeaderToPoint(h, pt);
+            recs.push_back(pt);
+            if (h.shape == ZONE_SHAPE_POLYGON) continue;
+        } else if (polygon < 0 || sscanf(line, "%lf,%lf", &lat, &lon) != 2) {
+            fprintf(stderr, "%s:%d: bad point\n", path, lineNo);
+            ok = false;
+            break;
+        }
+        if (lat < -90 || lat > 90 || lon < -180 || lon > 180) {
+            fprintf(stderr, "%s:%d: bad point\n", path, lineNo);
+            ok = false;
+            break;
+        }
+        memset(&pt, 0, sizeof(pt));
+        pt.latE7 = (int32_t)(lat * 1e7 + (lat < 0 ? -0.5 : 0.5));
+        pt.lonE7 = (int32_t)(lon * 1e7 + (lon < 0 ? -0.5 : 0.5));
+        recs.push_back(pt);
+
+        // Keep the open polygon's point count current
+        if (polygon >= 0) {
+            zoneHeaderFromPoint(recs[polygon], h);
+            h.points = (uint16_t)(recs.size() - polygon - 1);
+            zoneHeaderToPoint(h, recs[polygon]);
+        }
+    }
+    fclose(f);
+    if (ok && polygon >= 0 && recs.size() - polygon - 1 < 3) {
+        fprintf(stderr, "%s: polygon needs 3 points\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Frames for the whole upload
+static void frameBegin(uint32_t count, uint8_t file, std::vector<uint8_t>& out) {
+    uint8_t p[5];
+    routePut32(p, count);
+    p[4] = file;
+    uint16_t len = file == ROUTE_FILE_ROUTE ? 4 : 5;   // Older firmware only knows routes
+    uint8_t frame[ROUTE_FRAME_OVERHEAD + 5];
+    out.insert(out.end(), frame, frame + routeFrameEncode(ROUTE_MSG_BEGIN, p, len, frame));
+}
+
+static void frameData(const std::vector<RoutePoint>& pts, uint32_t first, uint32_t n, std::vector<uint8_t>& out) {
+    uint8_t p[ROUTE_FRAME_MAX_PAYLOAD];
+    routePut32(p, first);
+    for (uint32_t i = 0; i < n; i++) routePackPoint(pts[first + i], p + 4 + i * ROUTE_RECORD_BYTES);
+    uint8_t frame[ROUTE_FRAME_MAX_BYTES];
+    size_t len = routeFrameEncode(ROUTE_MSG_DATA, p, (uint16_t)(4 + n * ROUTE_RECORD_BYTES), frame);
+    out.insert(out.end(), frame, frame + len);
+}
+
+static uint32_t recordsCrc(const std::vector<RoutePoint>& pts) {
+    uint32_t crc = 0;
+    uint8_t raw[ROUTE_RECORD_BYTES];
+    for (size_t i = 0; i < pts.size(); i++) {
+        routePackPoint(pts[i], raw);
+        crc = crc32(crc, raw, sizeof(raw));
+    }
+    return crc;
+}
+
+static void frameCommit(const std::vector<RoutePoint>& pts, std::vector<uint8_t>& out) {
+    uint8_t p[8];
+    routePut32(p, (uint32_t)pts.size());
+    routePut32(p + 4, recordsCrc(pts));
+    uint8_t frame[ROUTE_FRAME_OVERHEAD + 8];
+    out.insert(out.end(), frame, frame + routeFrameEncode(ROUTE_MSG_COMMIT, p, 8, frame));
+}
+
+static void frameAll(const std::vector<RoutePoint>& pts, uint8_t file, std::vector<uint8_t>& out) {
+    frameBegin((uint32_t)pts.size(), file, out);
+    for (uint32_t i = 0; i < pts.size(); i += ROUTE_FRAME_MAX_RECORDS) {
+        uint32_t n = (uint32_t)pts.size() - i;
+        frameData(pts, i, n < ROUTE_FRAME_MAX_RECORDS ? n : ROUTE_FRAME_MAX_RECORDS, out);
+    }
+    frameCommit(pts, out);
+}
+
+// ---------------------------------------------------------------- serial
+
+struct Ack {
+    uint8_t status;
+    uint8_t type;
+    uint32_t next;
+};
+
+static int openPort(const char* path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+    return fd;
+}
+
+static bool sendAll(int fd, const std::vector<uint8_t>& bytes) {
+    size_t off = 0;
+    while (off < bytes.size()) {
+        ssize_t n = write(fd, bytes.data() + off, bytes.size() - off);
+        if (n < 0) {
+            perror("write");
+            return false;
+        }
+        off += (size_t)n;
+    }
+    return true;
+}
+
+// Next ACK from the console (log text and NMEA around it are skipped)
+static bool readAck(int fd, RouteFrameParser& parser, Ack& ack, uint32_t timeoutMs) {
+    uint32_t until = nowMs() + timeoutMs;
+    while ((int32_t)(until - nowMs()) > 0) {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(fd, &rd);
+        struct timeval tv = { 0, 20000 };
+        if (select(fd + 1, &rd, nullptr, nullptr, &tv) <= 0) continue;
+        uint8_t buf[256];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        for (ssize_t i = 0; i < n; i++) {
+            if (parser.feed(buf[i]) && parser.type() == ROUTE_MSG_ACK && parser.length() == 6) {
+                ack.status = parser.payload()[0];
+                ack.type = parser.payload()[1];
+                ack.next = routeGet32(parser.payload() + 2);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static int upload(const std::vector<RoutePoint>& pts, uint8_t file, const char* port) {
+    int fd = openPort(port);
+    if (fd < 0) return 2;
+    RouteFrameParser parser;
+    Ack ack;
+    std::vector<uint8_t> out;
+    uint32_t t0 = nowMs();
+
+    // 1) BEGIN
+    frameBegin((uint32_t)pts.size(), file, out);
+    if (!sendAll(fd, out) || !readAck(fd, parser, ack, ACK_TIMEOUT_MS) || ack.status != ROUTE_OK) {
+        fprintf(stderr, "BEGIN refused (status %d)\n", ack.status);
+        close(fd);
+        return 1;
+    }
+
+    // 2) DATA with at most ROUTE_WINDOW_RECORDS unacknowledged records
+    uint32_t total = (uint32_t)pts.size();
+    uint32_t acked = 0, sent = 0;
+    int retries = 0;
+    while (acked < total) {
+        out.clear();
+        while (sent < total && sent - acked < ROUTE_WINDOW_RECORDS) {
+            uint32_t n = total - sent;
+            if (n > ROUTE_FRAME_MAX_RECORDS) n = ROUTE_FRAME_MAX_RECORDS;
+            frameData(pts, sent, n, out);
+            sent += n;
+        }
+        if (!out.empty() && !sendAll(fd, out)) break;
+        if (sent == total && total - acked < ROUTE_PAGE_RECORDS) {
+            break;  // The last partial page is only acknowledged by COMMIT
+        }
+        if (!readAck(fd, parser, ack, ACK_TIMEOUT_MS)) {
+            if (++retries > MAX_RETRIES) break;
+            sent = acked;  // Nothing heard: go back to the last known point
+            continue;
+        }
+        if (ack.status == ROUTE_ERR_SEQUENCE) {
+            sent = ack.next;  // Device lost bytes; resume where it asks
+            if (++retries > MAX_RETRIES) break;
+        } else if (ack.status != ROUTE_OK) {
+            fprintf(stderr, "DATA refused at %u (status %d)\n", ack.next, ack.status);
+            close(fd);
+            return 1;
+        }
+        if (ack.next > acked) acked = ack.next;
+        fprintf(stderr, "\r%u/%u", acked, total);
+    }
+
+    // 3) COMMIT (resending whatever the device says it is missing)
+    for (int attempt = 0; attempt < MAX_RETRIES; attempt++) {
+        out.clear();
+        frameCommit(pts, out);
+        if (!sendAll(fd, out) || !readAck(fd, parser, ack, ACK_TIMEOUT_MS)) continue;
+        if (ack.type != ROUTE_MSG_COMMIT && ack.status == ROUTE_OK) continue;  // Late DATA ack
+        if (ack.status == ROUTE_OK) {
+            uint32_t ms = nowMs() - t0;
+            fprintf(stderr, "\r%u records stored in %u ms (%.1f kB/s)\n", total, ms,
+                    ms ? total * ROUTE_RECORD_BYTES / (double)ms : 0.0);
+            close(fd);
+            return 0;
+        }
+        if (ack.status != ROUTE_ERR_SEQUENCE) break;
+        out.clear();
+        for (uint32_t i = ack.next; i < total; i += ROUTE_FRAME_MAX_RECORDS) {
+            uint32_t n = total - i;
+            frameData(pts, i, n < ROUTE_FRAME_MAX_RECORDS ? n : ROUTE_FRAME_MAX_RECORDS, out);
+        }
+        sendAll(fd, out);
+    }
+    fprintf(stderr, "\nupload failed (status %d at %u)\n", ack.status, ack.next);
+    close(fd);
+    return 1;
+}
+
+// ---------------------------------------------------------------- selftest
+
+static int selfTest() {
+    std::vector<RoutePoint> pts;
+    for (uint32_t i = 0; i < 1000; i++) {
+        RoutePoint pt;
+        memset(&pt, 0, sizeof(pt));
+        pt.latE7 = (int32_t)((int64_t)i * 1234567 % 1800000000 - 900000000);
+        pt.lonE7 = (int32_t)((int64_t)i * 3579111 % 3600000000LL - 1800000000);
+        snprintf(pt.name, sizeof(pt.name), "P%u", i);
+        pts.push_back(pt);
+    }
+    std::vector<uint8_t> stream;
+    const char* noise = "\xe2\x86\x92 log line $GNGGA,,,*00\r\n";
+    stream.insert(stream.end(), noise, noise + strlen(noise));
+    frameAll(pts, ROUTE_FILE_ROUTE, stream);
+
+    // A corrupted DATA frame must be dropped without losing the frames after it
+    std::vector<uint8_t> bad;
+    frameData(pts, 0, 4, bad);
+    bad[10] ^= 0x40;
+    stream.insert(stream.begin() + strlen(noise), bad.begin(), bad.end());
+
+    RouteFrameParser parser;
+    std::vector<RoutePoint> got;
+    uint32_t expected = 0, commitCrc = 0, commitCount = 0;
+    for (size_t i = 0; i < stream.size(); i++) {
+        if (!parser.feed(stream[i])) continue;
+        const uint8_t* p = parser.payload();
+        switch (parser.type()) {
+            case ROUTE_MSG_BEGIN:
+                expected = routeGet32(p);
+                break;
+            case ROUTE_MSG_DATA:
+                if (routeGet32(p) != got.size()) break;
+                for (uint16_t off = 4; off < parser.length(); off += ROUTE_RECORD_BYTES) {
+                    RoutePoint pt;
+                    routeUnpackPoint(p + off, pt);
+                    got.push_back(pt);
+                }
+                break;
+            case ROUTE_MSG_COMMIT:
+                commitCount = routeGet32(p);
+                commitCrc = routeGet32(p + 4);
+                break;
+        }
+    }
+
+    int failures = 0;
+    if (expected != pts.size() || got.size() != pts.size() || commitCount != pts.size()) {
+        printf("FAIL counts: begin %u, data %u, commit %u\n", expected, (unsigned)got.size(), commitCount);
+        failures++;
+    }
+    for (size_t i = 0; i < got.size() && i < pts.size(); i++) {
+        if (got[i].latE7 != pts[i].latE7 || got[i].lonE7 != pts[i].lonE7 || strcmp(got[i].name, pts[i].name)) {
+            printf("FAIL point %u\n", (unsigned)i);
+            failures++;
+            break;
+        }
+    }
+    if (commitCrc != recordsCrc(got)) {
+        printf("FAIL crc\n");
+        failures++;
+    }
+    if (parser.errors < 1) {
+        printf("FAIL corrupt frame accepted\n");
+        failures++;
+    }
+    // A zone header must survive the trip through a RoutePoint record
+    ZoneHeader h, back;
+    memset(&h, 0, sizeof(h));
+    h.shape = ZONE_SHAPE_POLYGON;
+    h.rule = ZONE_RULE_KEEP_OUT;
+    h.points = 600;
+    h.radiusM = 0xFEDCBA98UL;
+    strcpy(h.name, "Quarry");
+    RoutePoint rec;
+    uint8_t raw[ROUTE_RECORD_BYTES];
+    zoneHeaderToPoint(h, rec);
+    routePackPoint(rec, raw);
+    routeUnpackPoint(raw, rec);
+    zoneHeaderFromPoint(rec, back);
+    if (raw[0] != ZONE_SHAPE_POLYGON || raw[1] != ZONE_RULE_KEEP_OUT || back.points != h.points ||
+        back.radiusM != h.radiusM || strcmp(back.name, h.name)) {
+        printf("FAIL zone header\n");
+        failures++;
+    }
+    // Reference value: CRC-32 of "123456789"
+    if (crc32(0, (const uint8_t*)"123456789", 9) != 0xCBF43926UL) {
+        printf("FAIL crc32\n");
+        failures++;
+    }
+    printf("selftest: %s (%u bytes, %u frames, %u errors)\n", failures ? "FAIL" : "ok",
+           (unsigned)stream.size(), parser.frames, parser.errors);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--selftest") == 0) {
+        return selfTest();
+    }
+    uint8_t file = argc > 1 && strcmp(argv[1], "--zones") == 0 ? ROUTE_FILE_ZONES : ROUTE_FILE_ROUTE;
+    if (file == ROUTE_FILE_ZONES) {
+        argc--;
+        argv++;
+    }
+    if (argc != 3) {
+        fprintf(stderr, "usage: routeup [--zones] file.csv <serial-port | ->\n       routeup --selftest\n");
+        return 2;
+    }
+    std::vector<RoutePoint> pts;
+    unsigned long max = file == ROUTE_FILE_ZONES ? ZONE_MAX_RECORDS : ROUTE_MAX_POINTS;
+    if (!(file == ROUTE_FILE_ZONES ? loadZonesCsv(argv[1], pts) : loadCsv(argv[1], pts))) return 2;
+    if (pts.empty() || pts.size() > max) {
+        fprintf(stderr, "%u records (1..%lu allowed)\n", (unsigned)pts.size(), max);
+        return 2;
+    }
+    if (strcmp(argv[2], "-") == 0) {
+        std::vector<uint8_t> stream;
+        frameAll(pts, file, stream);
+        fwrite(stream.data(), 1, stream.size(), stdout);
+        fprintf(stderr, "%u records, %u bytes\n", (unsigned)pts.size(), (unsigned)stream.size());
+        return 0;
+    }
+    return upload(pts, file, argv[2]);
+}
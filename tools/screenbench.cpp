@@ -0,0 +1,458 @@
+// Host-side render-cost benchmark for the tracker screens.
+//
+// Build (from tools/):
+//   H="../.pio/libdeps/heltec_wifi_lora_32_V3/Heltec ESP32 Dev-Boards/src"
+//   g++ -std=gnu++11 -O2 -DHOST_HARNESS -DHELTEC_BOARD=1 -DSLOW_CLK_TPYE=0
+//       -Ihost -I../src -I"$H" -I"$H/radio" -o screenbench screenbench.cpp "$H/HT_st7735_fonts.cpp"
+//
+// Compiles the firmware (src/main.h) against the stand-ins in host/, where
+// HT_st7735 is a mock that decodes the SPI traffic into a framebuffer and
+// counts it. Each scenario puts one screen up and plays a scripted run of
+// state changes through it, one updateLCD() per LCD_INTERVAL, and reports
+// per frame: bytes on the bus, transactions, address windows, CS edges and
+// the pixels that actually changed.
+//
+//   screenbench                     compare with screenbench.baseline and exit 1
+//                                   if any scenario moves more bytes than recorded
+//   screenbench --update-baseline   rewrite the baseline from this run
+//   screenbench --baseline FILE     use another baseline file
+//   screenbench --png DIR           also save each scenario's first and last frame
+//
+// The scenarios share one tracker and run in a fixed order (the screens keep
+// state in function statics), so the counts are exact and repeatable: any
+// increase is a regression, any decrease is a reason to update the baseline.
+
+#include <map>
+#include <string>
+#include "main.h"
+
+#define BENCH_BASELINE  "screenbench.baseline"
+#define BENCH_FRAMES    12
+
+static HTITTracker tracker;
+
+// In-RAM route for the route screen
+class BenchRoute : public RouteSource {
+public:
+    RoutePoint points[5];
+    uint32_t size() const override { return 5; }
+    bool get(uint32_t index, RoutePoint& out) override {
+        if (index >= 5) return false;
+        out = points[index];
+        return true;
+    }
+};
+
+struct SceneResult {
+    std::string name;
+    St7735BusStats entry;          // First frame on the screen
+    St7735BusStats steady;         // Sum over the remaining frames
+    uint32_t steadyFrames;
+    uint32_t maxBytes;
+};
+
+class HostHarness {
+private:
+    HTITTracker& t;
+    double lat, lon;
+    int battery;
+    BenchRoute route;
+
+    // One NMEA sentence with a valid checksum, as the ingest task would pass it on
+    void nmea(const char* body) {
+        uint8_t sum = 0;
+        for (const char* p = body; *p; p++) sum ^= (uint8_t)*p;
+        char line[128];
+        snprintf(line, sizeof(line), "$%s*%02X", body, sum);
+        t.processNMEALine(line);
+    }
+
+    void gga(int fix, int sats, float hdop) {
+        double alat = fabs(lat), alon = fabs(lon);
+        int latDeg = (int)alat, lonDeg = (int)alon;
+        char body[96];
+        snprintf(body, sizeof(body), "GNGGA,120000.00,%02d%08.5f,%c,%03d%08.5f,%c,%d,%02d,%.1f,408.0,M,47.0,M,,",
+                 latDeg, (alat - latDeg) * 60.0, lat < 0 ? 'S' : 'N', lonDeg, (alon - lonDeg) * 60.0,
+                 lon < 0 ? 'W' : 'E', fix, sats, hdop);
+        nmea(body);
+    }
+
+    void gsv(const char* talker, int inView) {
+        char body[48];
+        snprintf(body, sizeof(body), "%sGSV,1,1,%02d", talker, inView);
+        nmea(body);
+    }
+
+    // About 1.5 m/s north-east
+    void walk() {
+        lat += 0.00001;
+        lon += 0.000012;
+        gga(1, 14, 0.8f);
+    }
+
+    void show(ScreenType screen) {
+        t.currentScreen = screen;
+        t.menuIndex = 0;
+    }
+
+    void addPeer(uint16_t id, double dLat, double dLon, uint8_t seq) {
+        BeaconFix fix;
+        memset(&fix, 0, sizeof(fix));
+        fix.nodeId = id;
+        fix.seq = seq;
+        fix.latE6 = (int32_t)lround((lat + dLat) * 1e6);
+        fix.lonE6 = (int32_t)lround((lon + dLon) * 1e6);
+        fix.speedHalfKmh = (uint16_t)(6 + seq % 4);
+        fix.batteryPct = (uint8_t)(90 - seq);
+        fix.fixQuality = 1;
+        fix.sats = 12;
+        fix.rateReq = 0x0F;
+        t.peers.update(fix, true, (int16_t)(-80 - seq % 7), 6, millis());
+    }
+
+public:
+    explicit HostHarness(HTITTracker& tracker) : t(tracker), lat(47.376900), lon(8.541700), battery(87) {}
+
+    // Scenario steps: frame 0 enters the screen, later frames change state
+    void statusIdle(int) { show(SCREEN_STATUS); }
+    void statusFix(int f) {
+        if (f == 0) show(SCREEN_STATUS);
+        gsv("GP", 4 + f);
+        gsv("GL", f / 2);
+        if (f >= 3) gga(1, 4 + f, 2.5f - 0.1f * f);
+        if (f % 5 == 4) battery--;
+    }
+    void navigationWalk(int f) {
+        if (f == 0) show(SCREEN_NAVIGATION);
+        walk();
+    }
+    void mainMenu(int f) {
+        if (f == 0) show(SCREEN_MAIN_MENU);
+        t.menuIndex = f % 7;
+    }
+    void waypointMenu(int f) {
+        if (f == 0) show(SCREEN_WAYPOINT_MENU);
+        t.menuIndex = f % 5;
+    }
+    void waypointNav(int f) {
+        if (f == 0) {
+            t.setWaypoint(0, lat + 0.004, lon + 0.005, "Hut");
+            t.activeWaypoint = 1;
+            show(SCREEN_WAYPOINT1_NAV);
+        }
+        walk();
+    }
+    void setWaypoint(int f) {
+        if (f == 0) {
+            t.waypointToSet = 1;
+            show(SCREEN_SET_WAYPOINT);
+        }
+        gsv("GP", 10 + f % 3);
+    }
+    void waypointReset(int f) {
+        if (f == 0) {
+            t.waypointToReset = 1;
+            show(SCREEN_WAYPOINT_RESET);
+        }
+        t.menuIndex = f % 3;
+    }
+    void systemInfo(int f) {
+        if (f == 0) show(SCREEN_SYSTEM_INFO);
+        if (f % 3 == 2) battery--;
+    }
+    void powerMenu(int f) {
+        if (f == 0) show(SCREEN_POWER_MENU);
+        t.menuIndex = f % 4;
+    }
+    void diagnostics(int f) {
+        if (f == 0) show(SCREEN_DIAGNOSTICS);
+        t.health.samples++;
+        t.health.freeHeap = 180 * 1024 - f * 512;
+    }
+    void peerList(int f) {
+        if (f == 0) {
+            addPeer(0xA1B2, 0.002, 0.001, 0);
+            addPeer(0x3C4D, -0.010, 0.020, 0);
+            addPeer(0x5E6F, 0.0003, -0.0004, 0);
+            show(SCREEN_PEER_LIST);
+        }
+        addPeer(0xA1B2, 0.002 + 0.00002 * f, 0.001, (uint8_t)f);
+        t.menuIndex = f % 4;
+    }
+    void peerNav(int f) {
+        if (f == 0) {
+            t.activePeer = 0xA1B2;
+            show(SCREEN_PEER_NAV);
+        }
+        walk();
+        if (f % 2 == 0) addPeer(0xA1B2, 0.002, 0.001 - 0.00003 * f, (uint8_t)(20 + f));
+    }
+    void routeNav(int f) {
+        if (f == 0) {
+            for (int i = 0; i < 5; i++) {
+                route.points[i].latE7 = (int32_t)lround((lat + 0.0002 * (i + 1)) * 1e7);
+                route.points[i].lonE7 = (int32_t)lround((lon + 0.00024 * (i + 1)) * 1e7);
+                snprintf(route.points[i].name, ROUTE_NAME_LEN, "Leg %d", i + 1);
+            }
+            t.routeNav.start(route);
+            show(SCREEN_ROUTE_NAV);
+        }
+        walk();
+        t.routeNav.update(lat, lon);
+    }
+
+    void trailWalk(int f) {
+        if (f == 0) {
+            t.trail.reset();
+            t.trailZoom = 1;
+            show(SCREEN_TRAIL);
+        }
+        walk();
+        t.trail.add(lat, lon);
+    }
+    // Hours of wandering first: the map must cost no more than a short trail
+    void trailLong(int f) {
+        if (f == 0) {
+            t.trail.reset();
+            uint32_t seed = 12345;
+            double heading = 0.0;
+            for (int i = 0; i < 20000; i++) {
+                seed = seed * 1103515245u + 12345u;
+                heading += ((int)(seed >> 16 & 0xFF) - 128) / 400.0;
+                lat += 0.00003 * cos(heading);
+                lon += 0.00004 * sin(heading);
+                t.trail.add(lat, lon);
+            }
+            show(SCREEN_TRAIL);
+            t.forceScreenRedraw = true;      // Same screen as the last scenario
+        }
+        if (f == BENCH_FRAMES / 2) t.trailZoom = 4;
+        walk();
+        t.trail.add(lat, lon);
+    }
+
+    // An hour's hill walk first, then the totals tick on; climb page for the last frames
+    void tripWalk(int f) {
+        if (f == 0) {
+            t.trip.reset();
+            NavSnapshot snap;
+            memset(&snap, 0, sizeof(snap));
+            snap.hasPosition = snap.haveFix = snap.hasAltitude = true;
+            snap.hdop = 0.8f;
+            int steps = 3240;                  // A minute's rest every ten
+            for (int i = 0; i < 3600; i++) {
+                if (i % 600 < 540) steps--;
+                snap.fixMillis = millis() - 3600000UL + i * 1000UL;
+                snap.lat = lat - steps * 0.00001;
+                snap.lon = lon - steps * 0.000012;
+                snap.altitudeM = 408.0f + 150.0f * sinf(i / 1800.0f * (float)PI);
+                t.trip.update(snap);
+            }
+            show(SCREEN_TRIP);
+            t.tripPage = 0;
+        }
+        if (f == BENCH_FRAMES * 2 / 3) t.tripPage = 1;
+        walk();
+        NavSnapshot snap;
+        t.getNavSnapshot(snap);
+        t.trip.update(snap);
+    }
+
+    // Start inside a 30 m keep-out circle and walk out of it
+    void zoneAlert(int f) {
+        if (f == 0) {
+            ZoneHeader h;
+            memset(&h, 0, sizeof(h));
+            h.shape = ZONE_SHAPE_CIRCLE;
+            h.rule = ZONE_RULE_KEEP_OUT;
+            h.points = 1;
+            h.radiusM = 30;
+            strncpy(h.name, "Quarry", sizeof(h.name) - 1);
+            RoutePoint recs[2];
+            zoneHeaderToPoint(h, recs[0]);
+            memset(&recs[1], 0, sizeof(recs[1]));
+            recs[1].latE7 = (int32_t)lround(lat * 1e7);
+            recs[1].lonE7 = (int32_t)lround(lon * 1e7);
+
+            File file = LittleFS.open(ZONE_PATH, FILE_WRITE);
+            uint8_t raw[ROUTE_RECORD_BYTES];
+            uint32_t crc = 0;
+            for (int i = 0; i < 2; i++) {
+                routePackPoint(recs[i], raw);
+                crc = esp_rom_crc32_le(crc, raw, sizeof(raw));
+                file.write(raw, sizeof(raw));
+            }
+            RouteStore::makeIndex(raw, 2, crc);
+            file.write(raw, sizeof(raw));
+            file.close();
+            t.zones.load();
+            show(SCREEN_STATUS);
+        }
+        walk();
+        t.serviceZones();
+    }
+
+    St7735BusStats frame() {
+        hostAdvanceMs(HTITTracker::LCD_INTERVAL);
+        t.st7735.beginFrame();
+        t.updateLCD(battery);
+        return t.st7735.frameStats();
+    }
+
+    bool savePng(const std::string& path) { return t.st7735.writePng(path.c_str(), 2); }
+};
+
+typedef void (HostHarness::*SceneStep)(int frame);
+
+struct Scene {
+    const char* name;
+    SceneStep step;
+};
+
+static const Scene scenes[] = {
+    { "status_idle",     &HostHarness::statusIdle },
+    { "status_fix",      &HostHarness::statusFix },
+    { "navigation_walk", &HostHarness::navigationWalk },
+    { "main_menu",       &HostHarness::mainMenu },
+    { "waypoint_menu",   &HostHarness::waypointMenu },
+    { "waypoint_nav",    &HostHarness::waypointNav },
+    { "set_waypoint",    &HostHarness::setWaypoint },
+    { "waypoint_reset",  &HostHarness::waypointReset },
+    { "system_info",     &HostHarness::systemInfo },
+    { "power_menu",      &HostHarness::powerMenu },
+    { "diagnostics",     &HostHarness::diagnostics },
+    { "peer_list",       &HostHarness::peerList },
+    { "peer_nav",        &HostHarness::peerNav },
+    { "route_nav",       &HostHarness::routeNav },
+    { "trail_walk",      &HostHarness::trailWalk },
+    { "trail_long",      &HostHarness::trailLong },
+    { "zone_alert",      &HostHarness::zoneAlert },
+    { "trip",            &HostHarness::tripWalk },
+};
+
+static void addStats(St7735BusStats& sum, const St7735BusStats& s) {
+    sum.transactions += s.transactions;
+    sum.bytes += s.bytes;
+    sum.commands += s.commands;
+    sum.windows += s.windows;
+    sum.csToggles += s.csToggles;
+    sum.pixels += s.pixels;
+    sum.pixelsChanged += s.pixelsChanged;
+}
+
+// Baseline: "name entry_bytes steady_bytes_per_frame" per line, '#' comments
+static bool loadBaseline(const char* path, std::map<std::string, std::pair<uint32_t, uint32_t> >& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[128], name[64];
+    unsigned long entry, steady;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] != '#' && sscanf(line, "%63s %lu %lu", name, &entry, &steady) == 3) {
+            out[name] = std::make_pair((uint32_t)entry, (uint32_t)steady);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool saveBaseline(const char* path, const std::vector<SceneResult>& results) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# screenbench: SPI bytes on the first frame and per later frame (mean)\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const SceneResult& r = results[i];
+        fprintf(f, "%-16s %7u %7u\n", r.name.c_str(), r.entry.bytes,
+                r.steadyFrames ? r.steady.bytes / r.steadyFrames : 0);
+    }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* baselinePath = BENCH_BASELINE;
+    const char* pngDir = nullptr;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update-baseline") == 0) {
+            update = true;
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--png") == 0 && i + 1 < argc) {
+            pngDir = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--update-baseline] [--baseline FILE] [--png DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // 1) Play every scenario, one frame per LCD interval
+    HostHarness bench(tracker);
+    std::vector<SceneResult> results;
+    for (size_t s = 0; s < sizeof(scenes) / sizeof(scenes[0]); s++) {
+        SceneResult r;
+        r.name = scenes[s].name;
+        r.steadyFrames = 0;
+        r.maxBytes = 0;
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            (bench.*scenes[s].step)(f);
+            St7735BusStats st = bench.frame();
+            if (f == 0) {
+                r.entry = st;
+            } else {
+                addStats(r.steady, st);
+                r.steadyFrames++;
+            }
+            r.maxBytes = std::max(r.maxBytes, st.bytes);
+            if (pngDir && (f == 0 || f == BENCH_FRAMES - 1)) {
+                bench.savePng(std::string(pngDir) + "/" + r.name + (f == 0 ? "_first.png" : "_last.png"));
+            }
+        }
+        results.push_back(r);
+    }
+
+    // 2) Report: entry frame, then the mean of the frames after it
+    printf("%-16s %8s %8s %8s %6s %6s %8s %8s\n", "scenario", "entry B", "B/frame", "max B", "txn/f", "win/f",
+           "cs/f", "chg px/f");
+    for (size_t i = 0; i < results.size(); i++) {
+        const SceneResult& r = results[i];
+        uint32_t n = r.steadyFrames ? r.steadyFrames : 1;
+        printf("%-16s %8u %8u %8u %6u %6u %8u %8u\n", r.name.c_str(), r.entry.bytes, r.steady.bytes / n,
+               r.maxBytes, r.steady.transactions / n, r.steady.windows / n, r.steady.csToggles / n,
+               r.steady.pixelsChanged / n);
+    }
+
+    if (update) {
+        if (!saveBaseline(baselinePath, results)) {
+            perror(baselinePath);
+            return 2;
+        }
+        printf("baseline written to %s\n", baselinePath);
+        return 0;
+    }
+
+    // 3) Compare with the baseline
+    std::map<std::string, std::pair<uint32_t, uint32_t> > base;
+    if (!loadBaseline(baselinePath, base)) {
+        printf("no baseline at %s (run with --update-baseline)\n", baselinePath);
+        return 0;
+    }
+    int regressions = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const SceneResult& r = results[i];
+        uint32_t steady = r.steadyFrames ? r.steady.bytes / r.steadyFrames : 0;
+        std::map<std::string, std::pair<uint32_t, uint32_t> >::const_iterator b = base.find(r.name);
+        if (b == base.end()) {
+            printf("%-16s not in baseline\n", r.name.c_str());
+            continue;
+        }
+        if (r.entry.bytes > b->second.first || steady > b->second.second) {
+            printf("REGRESSION %-16s entry %u -> %u, per frame %u -> %u\n", r.name.c_str(), b->second.first,
+                   r.entry.bytes, b->second.second, steady);
+            regressions++;
+        } else if (r.entry.bytes < b->second.first || steady < b->second.second) {
+            printf("improved   %-16s entry %u -> %u, per frame %u -> %u\n", r.name.c_str(), b->second.first,
+                   r.entry.bytes, b->second.second, steady);
+        }
+    }
+    printf("screenbench: %s\n", regressions ? "FAIL" : "ok");
+    return regressions ? 1 : 0;
+}
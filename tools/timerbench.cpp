@@ -0,0 +1,252 @@
+// Host test for the LoRaMAC timer heap (driver/timer.c) on a fake clock.
+//
+// Build (from tools/):
+//   H="../.pio/libdeps/heltec_wifi_lora_32_V3/Heltec ESP32 Dev-Boards/src"
+//   g++ -std=gnu++11 -O2 -Ihost -I"$H" -o timerbench timerbench.cpp
+//
+// timer.c is compiled into this file so that it shares the host clock and
+// the fake esp_timer (tools/host/esp_timer.h).
+//  1) Order: TIMER_COUNT timers and random start, restart and stop calls,
+//     with the clock moving in between. Every timer must fire once per
+//     start, never early, never after a stop, and in expiry order, and
+//     TimerListHead must always be the earliest running timer.
+//  2) Full heap: with every slot taken, one more TimerStart must leave
+//     its timer stopped and raise TimerGetDropCount().
+//  3) Cost: with N timers running, restart a random one (TimerSetValue and
+//     TimerStart) and time it, for N from 8 to TIMER_HEAP_SIZE. The same
+//     calls on a sorted list, as timers were kept before, are timed too.
+//     The heap must not cost more than MAX_GROWTH times as much at the
+//     largest N as at the smallest.
+// Exit status 1 on any failure.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <Arduino.h>
+#include "driver/timer.c"
+
+#define TIMER_COUNT     TIMER_HEAP_SIZE
+#define ORDER_STEPS     200000
+#define COST_OPS        200000
+#define COST_ROUNDS     5           // Best of, against scheduler noise
+#define MAX_GROWTH      3.0
+
+void lora_printf(const char* format, ...) { (void)format; }
+
+static TimerEvent_t timers[TIMER_COUNT + 1];
+static bool running[TIMER_COUNT + 1];    // What the test expects
+static uint32_t due[TIMER_COUNT + 1];
+static unsigned long failures = 0, fires = 0;
+
+static uint32_t nowMs() { return (uint32_t)(hostMicros() / 1000); }
+
+static uint32_t rng = 12345;
+static uint32_t random32() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void fail(const char* what, int id) {
+    if (failures++ < 10) printf("  FAIL %s (timer %d, t=%lu ms)\n", what, id, (unsigned long)nowMs());
+}
+
+// Timer callbacks take no argument, so each timer gets its own
+static void fired(int id) {
+    fires++;
+    if (!running[id]) {
+        fail("fired while stopped", id);
+        return;
+    }
+    if ((int32_t)(nowMs() - due[id]) < 0) fail("fired early", id);
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (running[i] && i != id && (int32_t)(due[i] - due[id]) < 0) {
+            fail("fired out of order", id);
+            break;
+        }
+    }
+    running[id] = false;
+}
+
+template <int N> struct Callbacks {
+    static void fire() { fired(N - 1); }
+    static void fill(void (**table)()) {
+        table[N - 1] = fire;
+        Callbacks<N - 1>::fill(table);
+    }
+};
+template <> struct Callbacks<0> {
+    static void fill(void (**)()) {}
+};
+
+static void start(int id, uint32_t ms) {
+    TimerSetValue(&timers[id], ms);
+    TimerStart(&timers[id]);
+    running[id] = true;
+    due[id] = nowMs() + ms;
+}
+
+static void stop(int id) {
+    TimerStop(&timers[id]);
+    running[id] = false;
+}
+
+static void checkHead() {
+    int earliest = -1;
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (running[i] && (earliest < 0 || (int32_t)(due[i] - due[earliest]) < 0)) earliest = i;
+    }
+    if (earliest < 0 ? TimerListHead != NULL
+                     : TimerListHead == NULL || TimerListHead->Timestamp != due[earliest]) {
+        fail("TimerListHead is not the earliest timer", earliest);
+    }
+}
+
+static void orderPass() {
+    for (int step = 0; step < ORDER_STEPS; step++) {
+        int id = (int)(random32() % TIMER_COUNT);
+        uint32_t r = random32() % 100;
+        if (r < 50) {
+            start(id, 1 + random32() % 5000);
+        } else if (r < 65) {
+            stop(id);
+        } else {
+            hostAdvanceMs(random32() % 40);
+            hostRunTimers();
+            for (int i = 0; i < TIMER_COUNT; i++) {
+                if (running[i] && (int32_t)(nowMs() - due[i]) >= 0) fail("due but not fired", i);
+            }
+        }
+        checkHead();
+    }
+    // Let everything still running expire
+    for (int ms = 0; ms < 6000; ms += 10) {
+        hostAdvanceMs(10);
+        hostRunTimers();
+    }
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (running[i]) fail("never fired", i);
+    }
+    printf("order: %d steps over %d timers, %lu fired  %s\n", ORDER_STEPS, TIMER_COUNT, fires,
+           failures ? "FAIL" : "ok");
+}
+
+static void fullPass() {
+    unsigned long before = failures;
+    for (int i = 0; i < TIMER_COUNT; i++) start(i, 1000 + i);
+    uint32_t drops = TimerGetDropCount();
+    TimerSetValue(&timers[TIMER_COUNT], 10);
+    TimerStart(&timers[TIMER_COUNT]);
+    if (timers[TIMER_COUNT].IsRunning) fail("started with the heap full", TIMER_COUNT);
+    if (TimerGetDropCount() != drops + 1) fail("drop not counted", TIMER_COUNT);
+    if (TimerListHead != &timers[0]) fail("full heap lost its head", 0);
+
+    // A running timer can still move while the heap is full
+    start(TIMER_COUNT - 1, 1);
+    if (TimerListHead != &timers[TIMER_COUNT - 1]) fail("restart with the heap full", TIMER_COUNT - 1);
+    for (int i = 0; i < TIMER_COUNT; i++) stop(i);
+    printf("full heap: %d running, 1 refused, %lu dropped  %s\n", TIMER_COUNT,
+           (unsigned long)TimerGetDropCount(), failures == before ? "ok" : "FAIL");
+}
+
+// The sorted singly linked list timers used to be kept in
+struct ListTimer {
+    uint32_t timestamp;
+    bool running;
+    ListTimer* next;
+};
+static ListTimer* listHead = NULL;
+
+static void listStop(ListTimer* t) {
+    for (ListTimer** p = &listHead; *p; p = &(*p)->next) {
+        if (*p == t) {
+            *p = t->next;
+            break;
+        }
+    }
+    t->running = false;
+}
+
+static void listStart(ListTimer* t, uint32_t ms) {
+    if (t->running) listStop(t);
+    t->timestamp = nowMs() + ms;
+    ListTimer** p = &listHead;
+    while (*p && (int32_t)((*p)->timestamp - t->timestamp) <= 0) p = &(*p)->next;
+    t->next = *p;
+    *p = t;
+    t->running = true;
+}
+
+template <typename F> static double bestNs(F op) {
+    double best = 1e30;
+    for (int round = 0; round < COST_ROUNDS; round++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < COST_OPS; i++) op();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        if (ns / COST_OPS < best) best = ns / COST_OPS;
+    }
+    return best;
+}
+
+static bool costPass() {
+    static ListTimer list[TIMER_COUNT];
+    std::vector<uint32_t> ids(COST_OPS), values(COST_OPS);
+    esp_timer& hw = hostEspTimers().timers[0];
+    double first = 0, last = 0;
+
+    printf("\n%8s %12s %12s %12s\n", "running", "heap ns/op", "hw arms/op", "list ns/op");
+    for (int n = 8; n <= TIMER_COUNT; n *= 2) {
+        for (int i = 0; i < COST_OPS; i++) {
+            ids[i] = random32() % n;
+            values[i] = 1 + random32() % 5000;
+        }
+        for (int i = 0; i < n; i++) {
+            TimerSetValue(&timers[i], values[i]);
+            TimerStart(&timers[i]);
+            list[i].running = false;
+            listStart(&list[i], values[i]);
+        }
+
+        int k = 0;
+        uint32_t arms = hw.starts;
+        double heapNs = bestNs([&]() {
+            TimerSetValue(&timers[ids[k]], values[k]);
+            TimerStart(&timers[ids[k]]);
+            k = (k + 1) % COST_OPS;
+        });
+        double armsPerOp = (double)(hw.starts - arms) / (COST_OPS * COST_ROUNDS);
+        k = 0;
+        double listNs = bestNs([&]() {
+            listStart(&list[ids[k]], values[k]);
+            k = (k + 1) % COST_OPS;
+        });
+        printf("%8d %12.1f %12.3f %12.1f\n", n, heapNs, armsPerOp, listNs);
+
+        if (!first) first = heapNs;
+        last = heapNs;
+        for (int i = 0; i < n; i++) {
+            TimerStop(&timers[i]);
+            listStop(&list[i]);
+        }
+    }
+    bool ok = last <= first * MAX_GROWTH;
+    printf("heap cost at %d timers is %.1fx that at 8 (limit %.1fx)  %s\n", TIMER_COUNT, last / first,
+           MAX_GROWTH, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main() {
+    void (*callbacks[TIMER_COUNT + 1])();
+    Callbacks<TIMER_COUNT + 1>::fill(callbacks);
+    for (int i = 0; i <= TIMER_COUNT; i++) TimerInit(&timers[i], callbacks[i]);
+    hostAdvanceMs(1000);
+
+    orderPass();
+    fullPass();
+    bool costOk = costPass();
+    bool ok = failures == 0 && costOk;
+    printf("%s\n", ok ? "timerbench: ok" : "timerbench: FAILED");
+    return ok ? 0 : 1;
+}